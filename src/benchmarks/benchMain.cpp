@@ -1,10 +1,22 @@
 #define CATCH_CONFIG_RUNNER
 
 #include "catch2/catch_all.hpp"
+#include "pipeline_report.h"
+#include <fstream>
 
 int main(int argc, char* argv[]) {
-    //initialisation here
-    const auto returnCode = Catch::Session().run(argc, argv);
-    //cleanup here
+    Catch::Session session;
+    std::string jsonReportPath;
+    using Catch::Clara::Opt;
+    session.cli(session.cli()
+                | Opt(jsonReportPath, "file")["--json-report"]("write the results of the end-to-end pipeline benchmarks to this file as JSON"));
+    if (const auto commandLineResult = session.applyCommandLine(argc, argv); commandLineResult != 0) {
+        return commandLineResult;
+    }
+    const auto returnCode = session.run();
+    if (!jsonReportPath.empty()) {
+        std::ofstream stream(jsonReportPath);
+        bricksim::benchmark_tools::PipelineReport::get().writeJson(stream);
+    }
     return returnCode;
 }
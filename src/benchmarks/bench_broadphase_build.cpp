@@ -0,0 +1,81 @@
+#include <catch2/catch_all.hpp>
+#include <fcl/broadphase/broadphase_dynamic_AABB_tree.h>
+#include <fcl/geometry/shape/box.h>
+#include <fcl/narrowphase/collision_object.h>
+#include <random>
+
+namespace bricksim {
+    namespace {
+        ///boxes of the size of a 2x4 brick at random positions in a cube which is large enough that most don't overlap
+        std::vector<std::unique_ptr<fcl::CollisionObjectf>> createObjects(int count) {
+            std::mt19937 rng(count);
+            const auto range = 40.f * std::cbrt(static_cast<float>(count)) * 2;
+            std::uniform_real_distribution<float> position(0.f, range);
+            const auto box = std::make_shared<fcl::Boxf>(80.f, 28.f, 40.f);
+            std::vector<std::unique_ptr<fcl::CollisionObjectf>> objects;
+            for (int i = 0; i < count; ++i) {
+                objects.push_back(std::make_unique<fcl::CollisionObjectf>(box, fcl::Matrix3f::Identity(), fcl::Vector3f(position(rng), position(rng), position(rng))));
+            }
+            return objects;
+        }
+
+        std::vector<fcl::CollisionObjectf*> getRawPointers(const std::vector<std::unique_ptr<fcl::CollisionObjectf>>& objects) {
+            std::vector<fcl::CollisionObjectf*> result;
+            for (const auto& object: objects) {
+                result.push_back(object.get());
+            }
+            return result;
+        }
+
+        void moveObjects(const std::vector<fcl::CollisionObjectf*>& objects, float offset) {
+            for (auto* object: objects) {
+                object->setTranslation(object->getTranslation() + fcl::Vector3f(offset, 0.f, 0.f));
+                object->computeAABB();
+            }
+        }
+    }
+
+    TEST_CASE("broadphase_build") {
+        const auto count = GENERATE(1000, 10000, 50000);
+        const auto objects = createObjects(count);
+        const auto rawPointers = getRawPointers(objects);
+        const auto suffix = " (" + std::to_string(count) + " objects)";
+        //every 100th object, that's below the bulk build threshold of Engine
+        std::vector<fcl::CollisionObjectf*> fewObjects;
+        for (std::size_t i = 0; i < rawPointers.size(); i += 100) {
+            fewObjects.push_back(rawPointers[i]);
+        }
+
+        BENCHMARK("registerObject one by one" + suffix) {
+            fcl::DynamicAABBTreeCollisionManagerf manager;
+            for (auto* object: rawPointers) {
+                manager.registerObject(object);
+            }
+            manager.setup();
+            return manager.size();
+        };
+        BENCHMARK("registerObjects bulk build" + suffix) {
+            fcl::DynamicAABBTreeCollisionManagerf manager;
+            manager.registerObjects(rawPointers);
+            manager.setup();
+            return manager.size();
+        };
+
+        fcl::DynamicAABBTreeCollisionManagerf manager;
+        manager.registerObjects(rawPointers);
+        manager.setup();
+        float offset = 1.f;
+        BENCHMARK("update 1% of the objects one by one" + suffix) {
+            moveObjects(fewObjects, offset);
+            offset = -offset;
+            for (auto* object: fewObjects) {
+                manager.update(object);
+            }
+        };
+        BENCHMARK("update 1% of the objects as one batch" + suffix) {
+            moveObjects(fewObjects, offset);
+            offset = -offset;
+            manager.update(fewObjects);
+        };
+    }
+}
@@ -0,0 +1,46 @@
+#include "../connection/connection_check.h"
+#include "../connection/connector/cylindrical.h"
+#include <catch2/catch_all.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace bricksim {
+    namespace {
+        constexpr int GRID_SIZE = 32;
+
+        /**
+         * a GRID_SIZE x GRID_SIZE plate with a stud on top and an anti stud below every position
+         */
+        connection::connector_container_t createPlate() {
+            using namespace connection;
+            connector_container_t connectors;
+            for (int x = 0; x < GRID_SIZE; ++x) {
+                for (int z = 0; z < GRID_SIZE; ++z) {
+                    connectors.push_back(std::make_shared<CylindricalConnector>("", glm::vec3(x * 20, 0, z * 20), glm::vec3(0, -1, 0), "stud", Gender::M,
+                                                                                std::vector<CylindricalShapePart>{{CylindricalShapeType::ROUND, false, 6.f, 4.f}},
+                                                                                false, true, false));
+                    connectors.push_back(std::make_shared<CylindricalConnector>("", glm::vec3(x * 20, 8, z * 20), glm::vec3(0, 1, 0), "antistud", Gender::F,
+                                                                                std::vector<CylindricalShapePart>{{CylindricalShapeType::ROUND, false, 6.f, 4.f}},
+                                                                                true, false, false));
+                }
+            }
+            return connectors;
+        }
+    }
+
+    TEST_CASE("connection_check") {
+        const auto plate = createPlate();
+        const auto transfA = glm::mat4(1.f);
+        const auto transfB = glm::translate(glm::mat4(1.f), glm::vec3(0, -8, 0));
+
+        BENCHMARK("one container") {
+            connection::VectorPairCheckResultConsumer consumer;
+            connection::ConnectionCheck(consumer).checkForConnected(plate);
+            return consumer.getResult().size();
+        };
+        BENCHMARK("two stacked plates") {
+            connection::VectorPairCheckResultConsumer consumer;
+            connection::ConnectionCheck(consumer).checkForConnected(plate, plate, transfA, transfB);
+            return consumer.getResult().size();
+        };
+    }
+}
@@ -0,0 +1,133 @@
+#include "../connection/connection_check.h"
+#include "../connection/connector/cylindrical.h"
+#include "../connection/connector_spatial_hash.h"
+#include <catch2/catch_all.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace bricksim {
+    namespace {
+        constexpr int WALL_WIDTH = 25;
+        constexpr int WALL_DEPTH = 4;
+
+        /**
+         * the connectors of a 2x4 brick: 8 studs on top and 8 anti studs at the bottom
+         */
+        std::shared_ptr<connection::connector_container_t> createBrick() {
+            using namespace connection;
+            auto connectors = std::make_shared<connector_container_t>();
+            for (int x = 0; x < 4; ++x) {
+                for (int z = 0; z < 2; ++z) {
+                    connectors->push_back(std::make_shared<CylindricalConnector>("", glm::vec3(x * 20 - 30, 0, z * 20 - 10), glm::vec3(0, -1, 0), "stud", Gender::M,
+                                                                                 std::vector<CylindricalShapePart>{{CylindricalShapeType::ROUND, false, 6.f, 4.f}},
+                                                                                 false, true, false));
+                    connectors->push_back(std::make_shared<CylindricalConnector>("", glm::vec3(x * 20 - 30, 24, z * 20 - 10), glm::vec3(0, -1, 0), "antistud", Gender::F,
+                                                                                 std::vector<CylindricalShapePart>{{CylindricalShapeType::ROUND, false, 6.f, 4.f}},
+                                                                                 true, false, false));
+                }
+            }
+            return connectors;
+        }
+
+        /**
+         * walls of WALL_WIDTH x WALL_DEPTH bricks in running bond, so every brick is connected to two bricks below and two above.
+         * overlappingPairs are the pairs of bricks touching each other, like the bounding box tree of Engine reports them
+         */
+        struct SyntheticModel {
+            std::shared_ptr<connection::connector_container_t> brick = createBrick();
+            std::vector<glm::mat4> transformations;
+            std::vector<std::pair<std::size_t, std::size_t>> overlappingPairs;
+
+            explicit SyntheticModel(std::size_t brickCount) {
+                const auto layerSize = WALL_WIDTH * WALL_DEPTH;
+                const auto getIndex = [layerSize](std::size_t layer, int x, int z) {
+                    return layer * layerSize + z * WALL_WIDTH + x;
+                };
+                for (std::size_t i = 0; i < brickCount; ++i) {
+                    const auto layer = i / layerSize;
+                    const auto x = static_cast<int>(i % WALL_WIDTH);
+                    const auto z = static_cast<int>(i % layerSize / WALL_WIDTH);
+                    transformations.push_back(glm::translate(glm::mat4(1.f), glm::vec3(x * 80 + (layer % 2) * 40, layer * -24.f, z * 40)));
+                    if (x > 0) {
+                        overlappingPairs.emplace_back(getIndex(layer, x - 1, z), i);
+                    }
+                    if (z > 0) {
+                        overlappingPairs.emplace_back(getIndex(layer, x, z - 1), i);
+                    }
+                    if (layer > 0) {
+                        //the brick below is shifted by half a brick in the opposite direction every second layer
+                        const auto otherX = layer % 2 == 0 ? x : x + 1;
+                        for (const auto belowX: {otherX - 1, otherX}) {
+                            if (belowX >= 0 && belowX < WALL_WIDTH) {
+                                overlappingPairs.emplace_back(getIndex(layer - 1, belowX, z), i);
+                            }
+                        }
+                    }
+                }
+            }
+
+            [[nodiscard]] connection::ConnectorSpatialHash::owner_t getOwner(std::size_t i) const {
+                return &transformations[i];
+            }
+        };
+
+        std::size_t checkOverlappingPairs(const SyntheticModel& model) {
+            connection::VectorPairCheckResultConsumer consumer;
+            for (const auto& [a, b]: model.overlappingPairs) {
+                connection::ConnectionCheck(consumer).checkForConnected(*model.brick, *model.brick, model.transformations[a], model.transformations[b]);
+            }
+            return consumer.getResult().size();
+        }
+
+        void fillHash(const SyntheticModel& model, connection::ConnectorSpatialHash& hash) {
+            for (std::size_t i = 0; i < model.transformations.size(); ++i) {
+                hash.insert(model.getOwner(i), model.brick, model.transformations[i]);
+            }
+        }
+
+        ///every pair is found from both sides here, so only the side with the lower address is checked
+        std::size_t checkHashCandidates(const SyntheticModel& model, const connection::ConnectorSpatialHash& hash) {
+            connection::VectorPairCheckResultConsumer consumer;
+            std::vector<connection::ConnectorSpatialHash::Candidate> candidates;
+            for (std::size_t i = 0; i < model.transformations.size(); ++i) {
+                candidates.clear();
+                hash.findCandidates(model.getOwner(i), candidates);
+                for (const auto& candidate: candidates) {
+                    if (std::less<>()(model.getOwner(i), candidate.otherOwner)) {
+                        hash.checkCandidate(model.getOwner(i), candidate, consumer);
+                    }
+                }
+            }
+            return consumer.getResult().size();
+        }
+    }
+
+    TEST_CASE("connector_spatial_hash") {
+        const auto brickCount = GENERATE(1000, 10000, 50000);
+        const SyntheticModel model(brickCount);
+        const auto suffix = " (" + std::to_string(brickCount) + " bricks)";
+
+        connection::ConnectorSpatialHash hash;
+        fillHash(model, hash);
+        REQUIRE(checkHashCandidates(model, hash) == checkOverlappingPairs(model));
+
+        BENCHMARK("ConnectionCheck for each overlapping pair" + suffix) {
+            return checkOverlappingPairs(model);
+        };
+        BENCHMARK("build hash and look up all connectors" + suffix) {
+            connection::ConnectorSpatialHash freshHash;
+            fillHash(model, freshHash);
+            return checkHashCandidates(model, freshHash);
+        };
+        BENCHMARK("move one brick and look up its connectors" + suffix) {
+            const auto owner = model.getOwner(brickCount / 2);
+            hash.insert(owner, model.brick, model.transformations[brickCount / 2]);
+            std::vector<connection::ConnectorSpatialHash::Candidate> candidates;
+            hash.findCandidates(owner, candidates);
+            connection::VectorPairCheckResultConsumer consumer;
+            for (const auto& candidate: candidates) {
+                hash.checkCandidate(owner, candidate, consumer);
+            }
+            return consumer.getResult().size();
+        };
+    }
+}
@@ -0,0 +1,74 @@
+#include "../element_tree.h"
+#include "../graphics/mesh/instance_reader.h"
+#include "benchmark_tools.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <sstream>
+
+namespace bricksim {
+    namespace {
+        constexpr int GRID_SIZE = 100;
+
+        /**
+         * model with GRID_SIZE*GRID_SIZE 2x4 bricks in a grid
+         */
+        std::shared_ptr<ldr::File> generateSyntheticModel() {
+            std::stringstream content;
+            content << "0 Synthetic benchmark model\n0 Name: synthetic_reread_benchmark.ldr\n";
+            for (int x = 0; x < GRID_SIZE; ++x) {
+                for (int z = 0; z < GRID_SIZE; ++z) {
+                    content << "1 " << (x + z) % 16 << ' ' << x * 80 << " 0 " << z * 40 << " 1 0 0 0 1 0 0 0 1 3001.dat\n";
+                }
+            }
+            return ldr::file_repo::get().addLdrFileWithContent(nullptr, "synthetic_reread_benchmark.ldr", "", ldr::FileType::MODEL, content.str());
+        }
+    }
+
+    TEST_CASE("element tree reread") {
+        if (!benchmark_tools::initializeLibrary()) {
+            WARN("no LDraw library configured, skipping");
+            return;
+        }
+        const auto rootNode = std::make_shared<etree::RootNode>();
+        const auto modelNode = std::make_shared<etree::ModelNode>(generateSyntheticModel(), 1, rootNode);
+        rootNode->addChild(modelNode);
+        modelNode->createChildNodes();
+        modelNode->visible = true;
+        modelNode->incrementVersion();
+
+        const auto& children = modelNode->getChildren();
+        REQUIRE(children.size() == GRID_SIZE * GRID_SIZE);
+        const auto movedNode = children[children.size() / 2];
+        const auto originalTransformation = movedNode->getRelativeTransformation();
+        const auto movedTransformation = glm::transpose(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -24.0f, 0.0f))) * originalTransformation;
+        bool moved = false;
+        auto moveNode = [&]() {
+            moved = !moved;
+            movedNode->setRelativeTransformation(moved ? movedTransformation : originalTransformation);
+            movedNode->incrementVersion();
+        };
+
+        mesh::InstanceReader reader(0);
+        reader.read(rootNode);
+        //+1 for the instance of the model itself
+        CHECK(reader.getLastReadStats().recalculatedInstances == children.size() + 1);
+
+        moveNode();
+        const auto changedMeshKeys = reader.read(rootNode);
+        CHECK(changedMeshKeys.size() == 1);
+        CHECK(reader.getLastReadStats().recalculatedInstances == 2);
+        CHECK(reader.getLastReadStats().copiedInstances == children.size() - 1);
+        std::cout << "one moved part: " << reader.getLastReadStats().recalculatedInstances << " instances recalculated, "
+                  << reader.getLastReadStats().copiedInstances << " copied" << std::endl;
+
+        BENCHMARK("full reread") {
+            reader.clear();
+            return reader.read(rootNode).size();
+        };
+
+        BENCHMARK("one part moved") {
+            moveNode();
+            return reader.read(rootNode).size();
+        };
+    }
+}
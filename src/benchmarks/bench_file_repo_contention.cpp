@@ -0,0 +1,71 @@
+#include "benchmark_tools.h"
+#include <atomic>
+#include <iostream>
+#include <spdlog/fmt/fmt.h>
+#include <thread>
+
+namespace bricksim {
+    namespace {
+        void runOnThreads(unsigned int threadCount, const std::function<void(unsigned int)>& function) {
+            std::vector<std::thread> threads;
+            threads.reserve(threadCount);
+            for (unsigned int i = 0; i < threadCount; ++i) {
+                threads.emplace_back(function, i);
+            }
+            for (auto& t: threads) {
+                t.join();
+            }
+        }
+    }
+
+    TEST_CASE("ldr file repo contention") {
+        if (!benchmark_tools::initializeLibrary()) {
+            WARN("no LDraw library configured, skipping");
+            return;
+        }
+        std::vector<std::string> names;
+        for (const auto& name: db::fileList::getAllFiles()) {
+            if (name.ends_with(".dat")) {
+                names.push_back(name);
+            }
+        }
+        auto& fileRepo = ldr::file_repo::get();
+        //make sure every file is loaded once, so that the lookups below don't measure parsing
+        for (const auto& name: names) {
+            fileRepo.getFileOrNull(nullptr, name);
+        }
+        std::cout << names.size() << " library files" << std::endl;
+
+        const unsigned int threadCount = GENERATE(1u, 2u, 4u, 8u, 16u);
+
+        BENCHMARK(fmt::format("{} threads resolve the whole library", threadCount)) {
+            std::atomic<std::size_t> resolved = 0;
+            runOnThreads(threadCount, [&](unsigned int threadNum) {
+                //every thread starts at a different position so that they don't walk the stripes in lockstep
+                const auto offset = names.size() * threadNum / threadCount;
+                std::size_t count = 0;
+                for (std::size_t i = 0; i < names.size(); ++i) {
+                    if (fileRepo.getFileOrNull(nullptr, names[(i + offset) % names.size()]) != nullptr) {
+                        ++count;
+                    }
+                }
+                resolved += count;
+            });
+            return resolved.load();
+        };
+
+        BENCHMARK(fmt::format("{} threads reload the whole library", threadCount)) {
+            std::atomic<std::size_t> nextIndex = 0;
+            runOnThreads(threadCount, [&](unsigned int) {
+                while (true) {
+                    const auto i = nextIndex++;
+                    if (i >= names.size()) {
+                        break;
+                    }
+                    fileRepo.reloadFile(nullptr, names[i]);
+                }
+            });
+            return nextIndex.load();
+        };
+    }
+}
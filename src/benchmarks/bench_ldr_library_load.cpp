@@ -0,0 +1,142 @@
+#include "../ldr/element_arena.h"
+#include "../helpers/stringutil.h"
+#include "../ldr/file_reader.h"
+#include "../metrics.h"
+#include "benchmark_tools.h"
+#include "pipeline_report.h"
+#include <iostream>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    #include <malloc.h>
+    #define BRICKSIM_HAS_MALLINFO2
+#endif
+
+namespace bricksim {
+    namespace {
+        std::vector<std::string_view> splitNonEmptyLines(std::string_view content) {
+            std::vector<std::string_view> lines;
+            while (!content.empty()) {
+                const auto lineEnd = std::min(content.find('\n'), content.size());
+                const auto line = stringutil::trim(content.substr(0, lineEnd));
+                if (!line.empty()) {
+                    lines.push_back(line);
+                }
+                content.remove_prefix(std::min(lineEnd + 1, content.size()));
+            }
+            return lines;
+        }
+
+        ///@return bytes which malloc has handed out including its own per-chunk overhead, 0 if that can't be measured on this platform
+        uint64_t getHeapBytesInUse() {
+#ifdef BRICKSIM_HAS_MALLINFO2
+            return mallinfo2().uordblks;
+#else
+            return 0;
+#endif
+        }
+
+        /**
+         * parses every line of every file, with one ElementArena per file or with std::make_shared per element
+         */
+        std::vector<std::shared_ptr<ldr::FileElement>> parseAllLines(const std::vector<std::vector<std::string_view>>& linesPerFile, bool useArena) {
+            std::vector<std::shared_ptr<ldr::FileElement>> elements;
+            for (const auto& lines: linesPerFile) {
+                std::shared_ptr<ldr::ElementArena> arena;
+                if (useArena) {
+                    std::size_t textBytes = 0;
+                    for (const auto& line: lines) {
+                        textBytes += line.size() + 1;
+                    }
+                    arena = std::make_shared<ldr::ElementArena>(ldr::ElementArena::estimateBytesForContent(textBytes));
+                }
+                for (const auto& line: lines) {
+                    if (auto element = ldr::FileElement::parseLine(line, {}, arena); element != nullptr) {
+                        elements.push_back(std::move(element));
+                    }
+                }
+            }
+            return elements;
+        }
+    }
+
+    TEST_CASE("ldr full library load") {
+        if (!benchmark_tools::initializeLibrary()) {
+            WARN("no LDraw library configured, skipping");
+            return;
+        }
+        std::vector<std::pair<std::string, std::string>> contents;
+        size_t totalTextBytes = 0;
+        for (const auto& name: benchmark_tools::getAllLibraryLdrFileNames()) {
+            auto content = ldr::file_repo::get().getLibraryLdrFileContent(name);
+            totalTextBytes += content.size();
+            contents.emplace_back(name, std::move(content));
+        }
+
+        {
+            std::vector<std::shared_ptr<ldr::File>> files;
+            files.reserve(contents.size());
+            for (const auto& [name, content]: contents) {
+                files.push_back(ldr::readSimpleFile(nullptr, name, "", ldr::FileType::PART, content, {}));
+            }
+            std::cout << "parsed " << files.size() << " files (" << totalTextBytes << " bytes of text)" << std::endl;
+            std::cout << "element arena size: " << metrics::ldrElementArenaBytes << " bytes" << std::endl;
+        }
+
+        benchmark_tools::printThroughput("all library files", totalTextBytes, [&contents]() {
+            std::vector<std::shared_ptr<ldr::File>> files;
+            files.reserve(contents.size());
+            for (const auto& [name, content]: contents) {
+                files.push_back(ldr::readSimpleFile(nullptr, name, "", ldr::FileType::PART, content, {}));
+            }
+            return files;
+        });
+
+        BENCHMARK("parse all library files") {
+            std::vector<std::shared_ptr<ldr::File>> files;
+            files.reserve(contents.size());
+            for (const auto& [name, content]: contents) {
+                files.push_back(ldr::readSimpleFile(nullptr, name, "", ldr::FileType::PART, content, {}));
+            }
+            return files;
+        };
+    }
+
+    TEST_CASE("ldr element allocation: make_shared vs. arena") {
+        if (!benchmark_tools::initializeLibrary()) {
+            WARN("no LDraw library configured, skipping");
+            return;
+        }
+        std::vector<std::string> contents;
+        for (const auto& name: benchmark_tools::getAllLibraryLdrFileNames()) {
+            contents.push_back(ldr::file_repo::get().getLibraryLdrFileContent(name));
+        }
+        std::vector<std::vector<std::string_view>> linesPerFile;
+        linesPerFile.reserve(contents.size());
+        for (const auto& content: contents) {
+            linesPerFile.push_back(splitNonEmptyLines(content));
+        }
+
+        for (const bool useArena: {false, true}) {
+            const auto heapBefore = getHeapBytesInUse();
+            const auto allocationsBefore = benchmark_tools::getAllocationCounters();
+            const auto elements = parseAllLines(linesPerFile, useArena);
+            const auto allocationsAfter = benchmark_tools::getAllocationCounters();
+            const auto heapAfter = getHeapBytesInUse();
+            std::cout << (useArena ? "arena:       " : "make_shared: ")
+                      << elements.size() << " elements, "
+                      << allocationsAfter.count - allocationsBefore.count << " allocations, "
+                      << allocationsAfter.bytes - allocationsBefore.bytes << " bytes requested";
+            if (heapAfter > 0) {
+                std::cout << ", " << heapAfter - heapBefore << " bytes of heap in use";
+            }
+            std::cout << std::endl;
+        }
+
+        BENCHMARK("parse all library lines with make_shared") {
+            return parseAllLines(linesPerFile, false);
+        };
+        BENCHMARK("parse all library lines with an arena per file") {
+            return parseAllLines(linesPerFile, true);
+        };
+    }
+}
@@ -0,0 +1,64 @@
+#include "../ldr/file_reader.h"
+#include "../ldr/files.h"
+#include "benchmark_tools.h"
+#include <catch2/catch_all.hpp>
+#include <iostream>
+#include <random>
+#include <spdlog/fmt/fmt.h>
+
+namespace bricksim {
+    namespace {
+        /**
+         * a file which looks like a typical part: a header, some subfile references and a lot of geometry
+         */
+        std::string generatePartContent(std::size_t geometryLineCount) {
+            std::mt19937 rng(42);
+            std::uniform_real_distribution<float> coordinate(-40.f, 40.f);
+            std::string content = "0 Synthetic Benchmark Part\r\n"
+                                  "0 Name: benchmark.dat\r\n"
+                                  "0 Author: Benchmark\r\n"
+                                  "0 !LDRAW_ORG Unofficial_Part\r\n"
+                                  "0 BFC CERTIFY CCW\r\n"
+                                  "1 16 0 0 0 1 0 0 0 1 0 0 0 1 stud.dat\r\n"
+                                  "1 16 10 0 0 1 0 0 0 1 0 0 0 1 stud.dat\r\n";
+            for (std::size_t i = 0; i < geometryLineCount; ++i) {
+                const int type = 2 + static_cast<int>(i % 4);
+                content += std::to_string(type);
+                content += type == 2 || type == 5 ? " 24" : " 16";
+                const int numberCount = type == 2 ? 6 : (type == 3 ? 9 : 12);
+                for (int n = 0; n < numberCount; ++n) {
+                    content += fmt::format(" {:.4g}", coordinate(rng));
+                }
+                content += "\r\n";
+            }
+            return content;
+        }
+    }
+
+    TEST_CASE("ldr line parse") {
+        std::string line1 = "4 1 1.2 3.4 5.6 7.8 9.0 10.11 12.13 14.15 16.17 18.19 20.21 22.23";
+        std::string line1content = line1.substr(2);
+        BENCHMARK("parse quadrilateral through FileElement::parseLine") {
+            auto line = ldr::FileElement::parseLine(line1, {});
+            return line;
+        };
+        BENCHMARK("parse quadrilateral") {
+            auto line = ldr::Quadrilateral(line1content, ldr::WindingOrder::CCW);
+            return line;
+        };
+        BENCHMARK("parse subfile reference") {
+            auto line = ldr::SubfileReference("16 0 -24 0 1 0 0 0 1 0 0 0 1 s\\3001s01.dat", false);
+            return line;
+        };
+    }
+
+    TEST_CASE("ldr whole file parse") {
+        const auto content = generatePartContent(10000);
+        benchmark_tools::printThroughput("synthetic part file", content.size(), [&content]() {
+            return ldr::readSimpleFile(nullptr, "benchmark.dat", "", ldr::FileType::PART, content, {});
+        });
+        BENCHMARK("parse synthetic part file") {
+            return ldr::readSimpleFile(nullptr, "benchmark.dat", "", ldr::FileType::PART, content, {});
+        };
+    }
+}
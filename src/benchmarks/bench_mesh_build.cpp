@@ -0,0 +1,108 @@
+#include "../config/write.h"
+#include "../graphics/mesh/mesh.h"
+#include "../metrics.h"
+#include "benchmark_tools.h"
+#include <algorithm>
+#include <iostream>
+
+namespace bricksim {
+    namespace {
+        constexpr std::size_t PART_COUNT = 500;
+
+        std::vector<std::shared_ptr<ldr::File>> getParts() {
+            auto allNames = db::fileList::getAllFiles();
+            std::vector<std::string> names(allNames.begin(), allNames.end());
+            std::sort(names.begin(), names.end());
+            std::vector<std::shared_ptr<ldr::File>> parts;
+            for (const auto& name: names) {
+                if (parts.size() >= PART_COUNT) {
+                    break;
+                }
+                const auto file = ldr::file_repo::get().getFileOrNull(nullptr, name);
+                if (file != nullptr && file->metaInfo.type == ldr::FileType::PART) {
+                    parts.push_back(file);
+                }
+            }
+            return parts;
+        }
+
+        /**
+         * same as etree::LdrNode::addToMesh, without the element tree
+         */
+        void addPartToMesh(mesh::Mesh& mesh, const std::shared_ptr<ldr::File>& file, bool windingInversed) {
+            const auto dummyColor = ldr::color_repo::getInstanceDummyColor();
+            for (const auto& element: file->elements) {
+                if (element->hidden) {
+                    continue;
+                }
+                switch (element->getType()) {
+                    case 1:
+                        mesh.addLdrSubfileReference(file, dummyColor, std::static_pointer_cast<ldr::SubfileReference>(element), glm::mat4(1.0f), windingInversed, nullptr);
+                        break;
+                    case 2:
+                        mesh.addLdrLine(dummyColor, std::static_pointer_cast<ldr::Line>(element), glm::mat4(1.0f));
+                        break;
+                    case 3:
+                        mesh.addLdrTriangle(dummyColor, std::static_pointer_cast<ldr::Triangle>(element), glm::mat4(1.0f), windingInversed, nullptr);
+                        break;
+                    case 4:
+                        mesh.addLdrQuadrilateral(dummyColor, std::static_pointer_cast<ldr::Quadrilateral>(element), glm::mat4(1.0f), windingInversed, nullptr);
+                        break;
+                    case 5:
+                        mesh.addLdrOptionalLine(dummyColor, std::static_pointer_cast<ldr::OptionalLine>(element), glm::mat4(1.0f));
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+
+        /**
+         * builds the normal and the winding inversed mesh of every part
+         * @return total triangle count
+         */
+        std::size_t buildAllMeshes(const std::vector<std::shared_ptr<ldr::File>>& parts) {
+            std::size_t triangleCount = 0;
+            for (const auto& part: parts) {
+                for (const bool windingInversed: {false, true}) {
+                    mesh::Mesh mesh;
+                    addPartToMesh(mesh, part, windingInversed);
+                    triangleCount += mesh.getTriangleCount();
+                }
+            }
+            return triangleCount;
+        }
+    }
+
+    TEST_CASE("mesh build") {
+        if (!benchmark_tools::initializeLibrary()) {
+            WARN("no LDraw library configured, skipping");
+            return;
+        }
+        const auto parts = getParts();
+        std::cout << "building meshes of " << parts.size() << " parts" << std::endl;
+        auto& graphicsConfig = config::getMutable().graphics;
+        const auto cacheFlattenedGeometryBefore = graphicsConfig.cacheFlattenedGeometry;
+
+        graphicsConfig.cacheFlattenedGeometry = false;
+        const auto recursiveTriangleCount = buildAllMeshes(parts);
+        BENCHMARK("recursive addLdrFile") {
+            return buildAllMeshes(parts);
+        };
+
+        graphicsConfig.cacheFlattenedGeometry = true;
+        mesh::flattened_geometry_cache::clear();
+        CHECK(buildAllMeshes(parts) == recursiveTriangleCount);
+        std::cout << mesh::flattened_geometry_cache::getEntryCount() << " flattened files, "
+                  << metrics::flattenedGeometryCacheBytes << " bytes" << std::endl;
+        BENCHMARK("flattened geometry cache, cold") {
+            mesh::flattened_geometry_cache::clear();
+            return buildAllMeshes(parts);
+        };
+        BENCHMARK("flattened geometry cache, warm") {
+            return buildAllMeshes(parts);
+        };
+
+        graphicsConfig.cacheFlattenedGeometry = cacheFlattenedGeometryBefore;
+    }
+}
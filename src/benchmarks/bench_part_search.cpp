@@ -0,0 +1,30 @@
+#include "../part_finder.h"
+#include "benchmark_tools.h"
+
+namespace bricksim {
+    TEST_CASE("part search") {
+        if (!benchmark_tools::initializeLibrary()) {
+            WARN("no LDraw library configured, skipping");
+            return;
+        }
+        const auto entries = db::fileList::getAllEntries();
+
+        BENCHMARK("build index") {
+            return part_finder::SearchIndex(entries).getDocumentCount();
+        };
+
+        const part_finder::SearchIndex index(entries);
+        BENCHMARK("search \"brick 2 x 4\"") {
+            return index.search("brick 2 x 4", "");
+        };
+        BENCHMARK("search \"technic\" in category Technic") {
+            return index.search("technic", "Technic");
+        };
+        BENCHMARK("search \"1\"") {
+            return index.search("1", "");
+        };
+        BENCHMARK("search \"ound\"") {
+            return index.search("ound", "");
+        };
+    }
+}
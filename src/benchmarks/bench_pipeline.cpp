@@ -0,0 +1,174 @@
+#include "../connection/connection_check.h"
+#include "../connection/connector_data_provider.h"
+#include "../connection/connector_spatial_hash.h"
+#include "../connection/engine.h"
+#include "../element_tree.h"
+#include "../graphics/mesh/mesh_collection.h"
+#include "../ldr/file_writer.h"
+#include "benchmark_tools.h"
+#include "pipeline_report.h"
+#include "synthetic_models.h"
+#include <fstream>
+#include <glm/gtc/matrix_transform.hpp>
+#include <sstream>
+
+namespace bricksim {
+    namespace {
+        constexpr std::size_t SNAPPING_QUERY_COUNT = 1000;
+        constexpr scene_id_t PIPELINE_SCENE_ID = 0;
+
+        ///@param partsOnly if false, model instances are included too
+        std::vector<std::shared_ptr<etree::MeshNode>> getMeshNodes(const std::shared_ptr<etree::Node>& node, bool partsOnly) {
+            std::vector<std::shared_ptr<etree::MeshNode>> result;
+            std::vector<std::shared_ptr<etree::Node>> stack = {node};
+            while (!stack.empty()) {
+                const auto current = stack.back();
+                stack.pop_back();
+                const auto type = current->getType();
+                if (type == etree::NodeType::TYPE_PART || (!partsOnly && type == etree::NodeType::TYPE_MODEL_INSTANCE)) {
+                    result.push_back(std::dynamic_pointer_cast<etree::MeshNode>(current));
+                }
+                stack.insert(stack.end(), current->getChildren().begin(), current->getChildren().end());
+            }
+            return result;
+        }
+
+        std::shared_ptr<ldr::File> openModel(const std::filesystem::path& path, const std::string& name) {
+            std::ifstream stream(path, std::ios::binary);
+            std::stringstream content;
+            content << stream.rdbuf();
+            const auto file = ldr::file_repo::get().addLdrFileWithContent(nullptr, name, path, ldr::FileType::MODEL, content.str());
+            ldr::file_repo::get().preloadReferencedFiles(file);
+            return file;
+        }
+
+        /**
+         * builds the meshes like the editor does, with the mesh builder threads, optimization and picking BVH.
+         * OpenGL isn't initialized in the benchmarks, so nothing is uploaded to the GPU
+         */
+        void buildMeshes(mesh::SceneMeshCollection& meshCollection) {
+            meshCollection.rereadElementTreeIfNeeded();
+            //the first reread only starts the part meshes, this waits for them
+            meshCollection.setBuildMeshesAsynchronously(false);
+            meshCollection.rereadElementTreeIfNeeded();
+        }
+
+        /**
+         * drags parts one stud to the side and looks up the connectors they would connect to there.
+         * that is the connector query which snapping does for every cursor position
+         * @return number of connections found
+         */
+        std::size_t runSnappingQueries(const std::vector<std::shared_ptr<etree::MeshNode>>& parts) {
+            connection::ConnectorSpatialHash hash;
+            for (const auto& part: parts) {
+                hash.insert(part.get(), connection::getConnectorsOfNode(part), glm::transpose(part->getAbsoluteTransformation()));
+            }
+            connection::VectorPairCheckResultConsumer consumer;
+            std::vector<connection::ConnectorSpatialHash::Candidate> candidates;
+            const auto step = std::max<std::size_t>(1, parts.size() / SNAPPING_QUERY_COUNT);
+            for (std::size_t i = 0; i < parts.size(); i += step) {
+                const auto& part = parts[i];
+                const auto absTransformation = glm::transpose(part->getAbsoluteTransformation());
+                hash.insert(part.get(), connection::getConnectorsOfNode(part), glm::translate(glm::mat4(1.f), glm::vec3(20.f, 0.f, 0.f)) * absTransformation);
+                candidates.clear();
+                hash.findCandidates(part.get(), candidates);
+                for (const auto& candidate: candidates) {
+                    hash.checkCandidate(part.get(), candidate, consumer);
+                }
+                hash.insert(part.get(), connection::getConnectorsOfNode(part), absTransformation);
+            }
+            return consumer.getResult().size();
+        }
+
+        void writeModel(const std::shared_ptr<etree::RootNode>& rootNode, const std::shared_ptr<ldr::File>& mainFile, const std::filesystem::path& path) {
+            std::vector<std::shared_ptr<ldr::File>> subfiles;
+            for (const auto& child: rootNode->getChildren()) {
+                const auto model = std::dynamic_pointer_cast<etree::ModelNode>(child);
+                if (model != nullptr) {
+                    model->writeChangesToLdrFile();
+                    if (model->ldrFile != mainFile) {
+                        subfiles.push_back(model->ldrFile);
+                    }
+                }
+            }
+            ldr::writeFiles(mainFile, subfiles, path);
+        }
+
+        void runPipeline(const benchmark_tools::SyntheticModel& model) {
+            auto& report = benchmark_tools::PipelineReport::get();
+            const auto directory = std::filesystem::temp_directory_path();
+            const auto inputPath = directory / model.name;
+            const auto outputPath = directory / ("written_" + model.name);
+            {
+                std::ofstream stream(inputPath, std::ios::binary);
+                stream << model.content;
+            }
+            std::cout << model.name << ": " << model.partCount << " parts" << std::endl;
+
+            const auto file = report.measure(model.name, "model open", [&]() {
+                return openModel(inputPath, model.name);
+            });
+
+            const auto rootNode = std::make_shared<etree::RootNode>();
+            report.measure(model.name, "element tree", [&]() {
+                const auto modelNode = std::make_shared<etree::ModelNode>(file, 1, rootNode);
+                rootNode->addChild(modelNode);
+                modelNode->createChildNodes();
+                modelNode->visible = true;
+            });
+            const auto parts = getMeshNodes(rootNode, true);
+
+            //the meshes of the previous model would be reused otherwise
+            mesh::SceneMeshCollection::deleteAllMeshes();
+            mesh::SceneMeshCollection meshCollection(PIPELINE_SCENE_ID);
+            meshCollection.setRootNode(rootNode);
+            report.measure(model.name, "mesh generation", [&]() {
+                buildMeshes(meshCollection);
+            });
+            CHECK(mesh::SceneMeshCollection::getAbsoluteAABB(parts.front()).isDefined());
+
+            connection::Engine engine;
+            report.measure(model.name, "connection engine update", [&]() {
+                engine.update(rootNode);
+            });
+
+            const auto snappingConnections = report.measure(model.name, "snapping queries", [&]() {
+                return runSnappingQueries(parts);
+            });
+            std::cout << "snapping queries found " << snappingConnections << " connections" << std::endl;
+
+            report.measure(model.name, "ldr write", [&]() {
+                writeModel(rootNode, file, outputPath);
+            });
+            CHECK(std::filesystem::file_size(outputPath) > 0);
+
+            std::filesystem::remove(inputPath);
+            std::filesystem::remove(outputPath);
+        }
+    }
+
+    TEST_CASE("end-to-end pipeline", "[pipeline]") {
+        if (!benchmark_tools::initializeLibrary()) {
+            WARN("no LDraw library configured, skipping");
+            return;
+        }
+
+        SECTION("library index build") {
+            benchmark_tools::PipelineReport::get().measure("library", "index build", []() {
+                db::fileList::deleteAllEntries();
+                float progress;
+                ldr::file_repo::get().initialize(&progress);
+            });
+            CHECK(db::fileList::getSize() > 0);
+        }
+        SECTION("stud grid wall") {
+            runPipeline(benchmark_tools::generateStudGridWall(10000));
+        }
+        SECTION("technic beams") {
+            runPipeline(benchmark_tools::generateTechnicBeams(2000));
+        }
+        SECTION("nested submodels") {
+            runPipeline(benchmark_tools::generateNestedSubmodels(10));
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#include "../config/read.h"
+#include "../graphics/software_rasterizer/headless_renderer.h"
+#include "../ldr/file_repo.h"
+#include "benchmark_tools.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+namespace bricksim {
+    namespace {
+        constexpr std::size_t PART_COUNT = 200;
+        constexpr ldr::Color::code_t THUMBNAIL_COLOR = 4;
+
+        std::vector<graphics::ThumbnailRequest> getRequests() {
+            auto allNames = db::fileList::getAllFiles();
+            std::vector<std::string> names(allNames.begin(), allNames.end());
+            std::sort(names.begin(), names.end());
+            std::vector<graphics::ThumbnailRequest> requests;
+            for (const auto& name: names) {
+                if (requests.size() >= PART_COUNT) {
+                    break;
+                }
+                const auto file = ldr::file_repo::get().getFileOrNull(nullptr, name);
+                if (file != nullptr && file->metaInfo.type == ldr::FileType::PART) {
+                    requests.push_back({file, THUMBNAIL_COLOR, std::nullopt});
+                }
+            }
+            return requests;
+        }
+
+        /**
+         * every thread renders its share of the thumbnails with one rasterizer thread
+         */
+        void renderAll(const std::vector<graphics::ThumbnailRequest>& requests, software_rasterizer::MeshCache& meshCache, unsigned int threadCount) {
+            const int size = config::get().partPalette.thumbnailSize;
+            std::vector<std::thread> threads;
+            for (unsigned int i = 0; i < threadCount; ++i) {
+                threads.emplace_back([&, i]() {
+                    for (auto j = i; j < requests.size(); j += threadCount) {
+                        software_rasterizer::renderThumbnail(requests[j], size, meshCache, 1);
+                    }
+                });
+            }
+            for (auto& t: threads) {
+                t.join();
+            }
+        }
+
+        double measureThumbnailsPerSecond(const std::vector<graphics::ThumbnailRequest>& requests, software_rasterizer::MeshCache& meshCache, unsigned int threadCount) {
+            const auto before = std::chrono::steady_clock::now();
+            renderAll(requests, meshCache, threadCount);
+            const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - before;
+            return static_cast<double>(requests.size()) / duration.count();
+        }
+    }
+
+    TEST_CASE("software rasterizer thumbnails") {
+        if (!benchmark_tools::initializeLibrary()) {
+            WARN("no LDraw library configured, skipping");
+            return;
+        }
+        const auto requests = getRequests();
+        const auto coreCount = std::max(1u, std::thread::hardware_concurrency());
+        std::cout << "rendering thumbnails of " << requests.size() << " parts" << std::endl;
+
+        //the meshes are built in the first round, the other rounds only measure the rasterizer
+        software_rasterizer::MeshCache meshCache;
+        renderAll(requests, meshCache, coreCount);
+        std::cout << meshCache.getMeshCount() << " meshes cached" << std::endl;
+
+        const auto singleCore = measureThumbnailsPerSecond(requests, meshCache, 1);
+        const auto allCores = measureThumbnailsPerSecond(requests, meshCache, coreCount);
+        std::cout << singleCore << " thumbnails/s on one core, "
+                  << allCores << " thumbnails/s on " << coreCount << " cores ("
+                  << allCores / coreCount << " per core)" << std::endl;
+
+        BENCHMARK("one thumbnail per thread, 1 thread") {
+            renderAll(requests, meshCache, 1);
+        };
+        BENCHMARK("one thumbnail per thread, all cores") {
+            renderAll(requests, meshCache, coreCount);
+        };
+        BENCHMARK("tiles of one thumbnail on all cores") {
+            const int size = config::get().partPalette.thumbnailSize;
+            for (const auto& request: requests) {
+                software_rasterizer::renderThumbnail(request, size, meshCache, coreCount);
+            }
+        };
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../config/write.h"
+#include "../db.h"
+#include "../ldr/colors.h"
+#include "../ldr/file_repo.h"
+#include <catch2/catch_all.hpp>
+#include <chrono>
+#include <iostream>
+
+namespace bricksim::benchmark_tools {
+    /**
+     * initializes everything that is needed to read files from the configured LDraw library (without OpenGL)
+     * @return false if there's no valid library configured
+     */
+    inline bool initializeLibrary() {
+        static bool initialized = false;
+        if (!initialized) {
+            db::initialize();
+            config::initialize();
+            if (!ldr::file_repo::checkLdrawLibraryLocation()) {
+                return false;
+            }
+            float progress;
+            ldr::file_repo::get().initialize(&progress);
+            ldr::color_repo::initialize();
+            initialized = true;
+        }
+        return true;
+    }
+
+    /**
+     * @return path relative to the library root of every .dat file in the library
+     */
+    inline std::vector<std::string> getAllLibraryLdrFileNames() {
+        auto names = ldr::file_repo::get().listAllFileNames([](float) {});
+        std::erase_if(names, [](const std::string& name) { return !name.ends_with(".dat"); });
+        return names;
+    }
+
+    /**
+     * runs function a few times and prints the best throughput in MB/s.
+     * Catch2 only reports the time per run, this makes regressions in parsing speed comparable between inputs of different size
+     */
+    template<typename F>
+    void printThroughput(const std::string& name, std::size_t bytes, F&& function, int repetitions = 5) {
+        double bestSeconds = std::numeric_limits<double>::max();
+        for (int i = 0; i < repetitions; ++i) {
+            const auto before = std::chrono::steady_clock::now();
+            function();
+            const std::chrono::duration<double> duration = std::chrono::steady_clock::now() - before;
+            bestSeconds = std::min(bestSeconds, duration.count());
+        }
+        std::cout << name << ": " << bytes / bestSeconds / 1e6 << " MB/s (" << bytes << " bytes in " << bestSeconds * 1000 << " ms)" << std::endl;
+    }
+}
@@ -0,0 +1,92 @@
+#include "pipeline_report.h"
+#include "../constant_data/constants.h"
+#include "../helpers/platform_detection.h"
+#include "../helpers/thread_pool.h"
+#include <iostream>
+#include <rapidjson/ostreamwrapper.h>
+#include <rapidjson/prettywriter.h>
+
+#ifdef BRICKSIM_PLATFORM_WINDOWS
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+namespace bricksim::benchmark_tools {
+    uint64_t getPeakRss() {
+#ifdef BRICKSIM_PLATFORM_WINDOWS
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            return counters.PeakWorkingSetSize;
+        }
+        return 0;
+#else
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) != 0) {
+            return 0;
+        }
+    #ifdef BRICKSIM_PLATFORM_MACOS
+        return static_cast<uint64_t>(usage.ru_maxrss);
+    #else
+        //kilobytes on Linux
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+    #endif
+#endif
+    }
+
+    PipelineReport& PipelineReport::get() {
+        static PipelineReport report;
+        return report;
+    }
+
+    void PipelineReport::addResult(const std::string& model, const std::string& stage, std::chrono::steady_clock::time_point before, AllocationCounters allocationsBefore) {
+        const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - before;
+        const auto allocationsAfter = getAllocationCounters();
+        const auto& result = results.emplace_back(PipelineStageResult{
+                model,
+                stage,
+                duration.count(),
+                allocationsAfter.count - allocationsBefore.count,
+                allocationsAfter.bytes - allocationsBefore.bytes,
+                getPeakRss(),
+        });
+        std::cout << result.model << " / " << result.stage << ": " << result.milliseconds << " ms, "
+                  << result.allocationCount << " allocations (" << result.allocatedBytes << " bytes), peak RSS " << result.peakRssBytes / (1024 * 1024) << " MiB" << std::endl;
+    }
+
+    const std::vector<PipelineStageResult>& PipelineReport::getResults() const {
+        return results;
+    }
+
+    void PipelineReport::writeJson(std::ostream& stream) const {
+        rapidjson::OStreamWrapper wrapper(stream);
+        rapidjson::PrettyWriter<rapidjson::OStreamWrapper> writer(wrapper);
+        writer.StartObject();
+        writer.Key("version");
+        writer.String(constants::versionString);
+        writer.Key("threads");
+        writer.Uint(thread_pool::getWorkerCount() + 1);
+        writer.Key("results");
+        writer.StartArray();
+        for (const auto& result: results) {
+            writer.StartObject();
+            writer.Key("model");
+            writer.String(result.model.c_str());
+            writer.Key("stage");
+            writer.String(result.stage.c_str());
+            writer.Key("milliseconds");
+            writer.Double(result.milliseconds);
+            writer.Key("allocationCount");
+            writer.Uint64(result.allocationCount);
+            writer.Key("allocatedBytes");
+            writer.Uint64(result.allocatedBytes);
+            writer.Key("peakRssBytes");
+            writer.Uint64(result.peakRssBytes);
+            writer.EndObject();
+        }
+        writer.EndArray();
+        writer.EndObject();
+        stream << std::endl;
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace bricksim::benchmark_tools {
+    /**
+     * number of calls to operator new (including the array and aligned forms) and the bytes requested since the program started.
+     * counted by the replacement of the global operator new in allocation_counter.cpp, which is only linked into the benchmarks
+     */
+    struct AllocationCounters {
+        uint64_t count;
+        uint64_t bytes;
+    };
+    AllocationCounters getAllocationCounters();
+
+    ///@return the peak resident set size of the process in bytes
+    uint64_t getPeakRss();
+
+    struct PipelineStageResult {
+        std::string model;
+        std::string stage;
+        double milliseconds;
+        uint64_t allocationCount;
+        uint64_t allocatedBytes;
+        ///of the whole process after the stage, so it only grows
+        uint64_t peakRssBytes;
+    };
+
+    /**
+     * collects the results of the end-to-end pipeline benchmarks, benchMain writes them as JSON if --json-report is given.
+     * every stage runs exactly once: most stages change the state which the next stage needs, so they can't be repeated like a Catch BENCHMARK
+     */
+    class PipelineReport {
+    public:
+        static PipelineReport& get();
+
+        ///runs function once and records its time and allocations
+        template<typename F>
+        auto measure(const std::string& model, const std::string& stage, F&& function) {
+            const auto allocationsBefore = getAllocationCounters();
+            const auto before = std::chrono::steady_clock::now();
+            if constexpr (std::is_void_v<std::invoke_result_t<F>>) {
+                function();
+                addResult(model, stage, before, allocationsBefore);
+            } else {
+                auto result = function();
+                addResult(model, stage, before, allocationsBefore);
+                return result;
+            }
+        }
+
+        void addResult(const std::string& model, const std::string& stage, std::chrono::steady_clock::time_point before, AllocationCounters allocationsBefore);
+        [[nodiscard]] const std::vector<PipelineStageResult>& getResults() const;
+        void writeJson(std::ostream& stream) const;
+
+    private:
+        std::vector<PipelineStageResult> results;
+    };
+}
@@ -0,0 +1,93 @@
+#include "synthetic_models.h"
+#include <glm/glm.hpp>
+#include <spdlog/fmt/fmt.h>
+#include <vector>
+
+namespace bricksim::benchmark_tools {
+    namespace {
+        constexpr auto IDENTITY = "1 0 0 0 1 0 0 0 1";
+        ///rotation by 90 degrees around the y axis
+        constexpr auto ROTATION_Y90 = "0 0 1 0 1 0 -1 0 0";
+
+        void appendSubfileReference(std::string& content, int color, float x, float y, float z, const char* rotation, const std::string& fileName) {
+            content += fmt::format("1 {} {} {} {} {} {}\n", color, x, y, z, rotation, fileName);
+        }
+    }
+
+    SyntheticModel generateStudGridWall(std::size_t brickCount, int width, int depth) {
+        SyntheticModel model{fmt::format("synthetic_wall_{}.ldr", brickCount), "", brickCount};
+        model.content = fmt::format("0 Synthetic wall of {} bricks\n0 Name: {}\n", brickCount, model.name);
+        const auto layerSize = static_cast<std::size_t>(width * depth);
+        for (std::size_t i = 0; i < brickCount; ++i) {
+            const auto layer = static_cast<int>(i / layerSize);
+            const auto x = static_cast<int>(i % width);
+            const auto z = static_cast<int>(i % layerSize / width);
+            appendSubfileReference(model.content, (x + layer) % 16, x * 80.f + (layer % 2) * 40.f, static_cast<float>(-layer * 24), z * 40.f, IDENTITY, "3001.dat");
+        }
+        return model;
+    }
+
+    SyntheticModel generateTechnicBeams(std::size_t beamCount) {
+        //each layer has 4 beams which are 40 LDU apart, so they cross the beams of the next layer at every second hole
+        constexpr int BEAMS_PER_LAYER = 4;
+        constexpr float HOLE_DISTANCE = 20.f;
+        constexpr float BEAM_DISTANCE = 2 * HOLE_DISTANCE;
+        constexpr float BEAM_CENTER = 3 * HOLE_DISTANCE;
+        SyntheticModel model{fmt::format("synthetic_technic_{}.ldr", beamCount), "", beamCount};
+        model.content = fmt::format("0 Synthetic technic structure of {} beams\n0 Name: {}\n", beamCount, model.name);
+        for (std::size_t i = 0; i < beamCount; ++i) {
+            const auto layer = static_cast<int>(i / BEAMS_PER_LAYER);
+            const auto indexInLayer = static_cast<float>(i % BEAMS_PER_LAYER);
+            const auto y = static_cast<float>(-layer) * HOLE_DISTANCE;
+            if (layer % 2 == 0) {
+                appendSubfileReference(model.content, 4, BEAM_CENTER, y, indexInLayer * BEAM_DISTANCE, IDENTITY, "32524.dat");
+            } else {
+                appendSubfileReference(model.content, 0, indexInLayer * BEAM_DISTANCE, y, BEAM_CENTER, ROTATION_Y90, "32524.dat");
+            }
+            if (layer > 0) {
+                //one pin for each crossing with the layer below
+                for (int j = 0; j < BEAMS_PER_LAYER; ++j) {
+                    const auto along = static_cast<float>(j) * BEAM_DISTANCE;
+                    const auto pinY = y + HOLE_DISTANCE / 2;
+                    if (layer % 2 == 0) {
+                        appendSubfileReference(model.content, 1, along, pinY, indexInLayer * BEAM_DISTANCE, IDENTITY, "2780.dat");
+                    } else {
+                        appendSubfileReference(model.content, 1, indexInLayer * BEAM_DISTANCE, pinY, along, IDENTITY, "2780.dat");
+                    }
+                    ++model.partCount;
+                }
+            }
+        }
+        return model;
+    }
+
+    SyntheticModel generateNestedSubmodels(int depth, int leafSize) {
+        const auto leafPartCount = static_cast<std::size_t>(leafSize * leafSize);
+        SyntheticModel model{fmt::format("synthetic_nested_{}.mpd", depth), "", leafPartCount << depth};
+        const auto getSubmodelName = [](int level) {
+            return fmt::format("level_{}.ldr", level);
+        };
+        //the two instances are placed next to each other alternately in x and z direction, so they never overlap
+        std::vector<glm::vec2> sizes(depth + 1, glm::vec2(static_cast<float>(leafSize) * 40.f));
+        for (int level = depth - 1; level >= 0; --level) {
+            sizes[level] = sizes[level + 1];
+            sizes[level][level % 2] *= 2;
+        }
+
+        model.content = fmt::format("0 FILE {}\n0 Synthetic model with {} levels of submodels\n0 Name: {}\n", model.name, depth, model.name);
+        appendSubfileReference(model.content, 16, 0, 0, 0, IDENTITY, getSubmodelName(0));
+        for (int level = 0; level < depth; ++level) {
+            model.content += fmt::format("\n0 FILE {}\n0 Level {}\n0 Name: {}\n", getSubmodelName(level), level, getSubmodelName(level));
+            appendSubfileReference(model.content, 16, 0, 0, 0, IDENTITY, getSubmodelName(level + 1));
+            const auto offset = level % 2 == 0 ? glm::vec2(sizes[level + 1].x, 0) : glm::vec2(0, sizes[level + 1].y);
+            appendSubfileReference(model.content, 16, offset.x, 0, offset.y, IDENTITY, getSubmodelName(level + 1));
+        }
+        model.content += fmt::format("\n0 FILE {}\n0 Leaf\n0 Name: {}\n", getSubmodelName(depth), getSubmodelName(depth));
+        for (int x = 0; x < leafSize; ++x) {
+            for (int z = 0; z < leafSize; ++z) {
+                appendSubfileReference(model.content, (x + z) % 16, x * 40.f, 0, z * 40.f, IDENTITY, "3022.dat");
+            }
+        }
+        return model;
+    }
+}
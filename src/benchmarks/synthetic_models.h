@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+
+namespace bricksim::benchmark_tools {
+    struct SyntheticModel {
+        ///the name of the main file, with .ldr or .mpd extension
+        std::string name;
+        std::string content;
+        ///the number of parts in the fully expanded model
+        std::size_t partCount;
+    };
+
+    /**
+     * 2x4 bricks (3001.dat) in running bond, every brick is connected to two bricks below and two above.
+     * the wall is width bricks long, depth bricks thick and as high as needed for brickCount bricks
+     */
+    SyntheticModel generateStudGridWall(std::size_t brickCount, int width = 50, int depth = 2);
+
+    /**
+     * layers of 1x7 thick liftarms (32524.dat) which are crossed by the beams of the next layer,
+     * every crossing is held together by a friction pin (2780.dat)
+     */
+    SyntheticModel generateTechnicBeams(std::size_t beamCount);
+
+    /**
+     * MPD where every submodel contains two instances of the next deeper submodel side by side.
+     * the deepest submodel is a leafSize x leafSize grid of 2x2 plates (3022.dat), so there are 2^depth*leafSize^2 parts in total
+     */
+    SyntheticModel generateNestedSubmodels(int depth, int leafSize = 4);
+}
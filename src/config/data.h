@@ -115,6 +115,9 @@ namespace bricksim::config {
         bool vsync;
         bool faceCulling;
         bool deleteVertexDataAfterUploading;
+        bool cacheFlattenedGeometry;
+        bool optimizeMeshes;
+        bool cpuPicking;
         GraphicsDebug debug;
 
         Graphics() {
@@ -130,6 +133,9 @@ namespace bricksim::config {
                     & json_dto::optional("vsync", vsync, true)
                     & json_dto::optional("faceCulling", faceCulling, true)
                     & json_dto::optional("deleteVertexDataAfterUploading", deleteVertexDataAfterUploading, true)
+                    & json_dto::optional("cacheFlattenedGeometry", cacheFlattenedGeometry, true)
+                    & json_dto::optional("optimizeMeshes", optimizeMeshes, true)
+                    & json_dto::optional("cpuPicking", cpuPicking, true)
                     & json_dto::optional("debug", debug, GraphicsDebug{});
         }
 
@@ -140,6 +146,9 @@ namespace bricksim::config {
                    && lhs.vsync == rhs.vsync
                    && lhs.faceCulling == rhs.faceCulling
                    && lhs.deleteVertexDataAfterUploading == rhs.deleteVertexDataAfterUploading
+                   && lhs.cacheFlattenedGeometry == rhs.cacheFlattenedGeometry
+                   && lhs.optimizeMeshes == rhs.optimizeMeshes
+                   && lhs.cpuPicking == rhs.cpuPicking
                    && lhs.debug == rhs.debug;
         }
 
@@ -1,6 +1,7 @@
 #include "connection_check.h"
 #include "../helpers/geometry.h"
 #include "connector_data_provider.h"
+#include "connector_table.h"
 #include <magic_enum/magic_enum.hpp>
 #include "pair_checker.h"
 #include <spdlog/spdlog.h>
@@ -179,24 +180,21 @@ namespace bricksim::connection {
                                                        const glm::mat4& aTransf,
                                                        const glm::mat4& bTransf) {
         const auto iSmaller = aConns.size() < bConns.size() ? 0 : 1;
-        const auto& cSmaller = iSmaller == 0 ? aConns : bConns;
-        const auto& cLarger = iSmaller == 0 ? bConns : aConns;
-        const auto& transfSmaller = iSmaller == 0 ? aTransf : bTransf;
-        const auto& transfLarger = iSmaller == 0 ? bTransf : aTransf;
-        uomap_t<std::pair<int64_t, int64_t>, std::vector<std::pair<std::shared_ptr<Connector>, PairCheckData>>> connsByStart;//todo dedicated class for this, maybe also for non-axisaligned directions
+        const ConnectorTable smallerTable(iSmaller == 0 ? aConns : bConns);
+        const ConnectorTable largerTable(iSmaller == 0 ? bConns : aConns);
+        const TransformedConnectorTable smaller(smallerTable, iSmaller == 0 ? aTransf : bTransf);
+        const TransformedConnectorTable larger(largerTable, iSmaller == 0 ? bTransf : aTransf);
+        uomap_t<std::pair<int64_t, int64_t>, std::vector<uint32_t>> connsByStart;//todo dedicated class for this, maybe also for non-axisaligned directions
         const auto ia = directionIdx == 0 ? 1 : 0;
         const auto ib = directionIdx == 2 ? 1 : 2;
-        for (const auto& connSmaller: cSmaller) {
-            const auto absStart = transfSmaller * glm::vec4(connSmaller->start, 1.f);
-            const auto absDirection = transfSmaller * glm::vec4(connSmaller->direction, 0.f);
-            connsByStart[{absStart[ia], absStart[ib]}].emplace_back(connSmaller, PairCheckData(transfSmaller, connSmaller, absStart, absDirection));
-        }
-        for (const auto& connLarger: cLarger) {
-            const auto absStart = transfLarger * glm::vec4(connLarger->start, 1.f);
-            const auto absDirection = transfLarger * glm::vec4(connLarger->direction, 0.f);
-            PairCheckData lData(transfLarger, connLarger, absStart, absDirection);
-            if (const auto it0 = connsByStart.find({absStart[ia], absStart[ib]}); it0 != connsByStart.end()) {
-                for (const auto& [connSmaller, sData]: it0->second) {
+        for (std::size_t i = 0; i < smaller.size(); ++i) {
+            connsByStart[{smaller.absStart[ia][i], smaller.absStart[ib][i]}].push_back(static_cast<uint32_t>(i));
+        }
+        for (std::size_t l = 0; l < larger.size(); ++l) {
+            if (const auto it0 = connsByStart.find({larger.absStart[ia][l], larger.absStart[ib][l]}); it0 != connsByStart.end()) {
+                const PairCheckData lData(larger.transformation, largerTable.getConnector(l), larger.getAbsStart(l), larger.getAbsDirection(l));
+                for (const auto s: it0->second) {
+                    const PairCheckData sData(smaller.transformation, smallerTable.getConnector(s), smaller.getAbsStart(s), smaller.getAbsDirection(s));
                     PairChecker pc(lData, sData, result);
                     pc.findConnections();
                 }
@@ -205,10 +203,21 @@ namespace bricksim::connection {
     }
 
     void ConnectionCheck::checkBruteForceAvsA(const connector_container_t& conns) {
+        if (conns.size() < 2) {
+            return;
+        }
+        const ConnectorTable table(conns);
+        const TransformedConnectorTable transformed(table, glm::mat4(1.f));
+        std::vector<uint32_t> candidates;
         for (std::size_t i = 0; i < conns.size(); ++i) {
-            PairCheckData iData(glm::mat4(1.f), conns[i]);
-            for (std::size_t j = 0; j < i; ++j) {
-                PairCheckData jData(glm::mat4(1.f), conns[j]);
+            candidates.clear();
+            findPairCandidates(transformed, i, transformed, i, candidates);
+            if (candidates.empty()) {
+                continue;
+            }
+            const PairCheckData iData(transformed.transformation, conns[i], transformed.getAbsStart(i), transformed.getAbsDirection(i));
+            for (const auto j: candidates) {
+                const PairCheckData jData(transformed.transformation, conns[j], transformed.getAbsStart(j), transformed.getAbsDirection(j));
                 PairChecker pc(iData, jData, result);
                 pc.findConnections();
             }
@@ -220,10 +229,20 @@ namespace bricksim::connection {
                                               const glm::mat4& aTransf,
                                               const glm::mat4& bTransf) {
         if (!connsA.empty() && !connsB.empty()) {
-            for (const auto& a: connsA) {
-                PairCheckData aData(aTransf, a);
-                for (const auto& b: connsB) {
-                    PairCheckData bData(bTransf, b);
+            const ConnectorTable aTable(connsA);
+            const ConnectorTable bTable(connsB);
+            const TransformedConnectorTable a(aTable, aTransf);
+            const TransformedConnectorTable b(bTable, bTransf);
+            std::vector<uint32_t> candidates;
+            for (std::size_t i = 0; i < connsA.size(); ++i) {
+                candidates.clear();
+                findPairCandidates(a, i, b, connsB.size(), candidates);
+                if (candidates.empty()) {
+                    continue;
+                }
+                const PairCheckData aData(aTransf, connsA[i], a.getAbsStart(i), a.getAbsDirection(i));
+                for (const auto j: candidates) {
+                    const PairCheckData bData(bTransf, connsB[j], b.getAbsStart(j), b.getAbsDirection(j));
                     PairChecker pc(aData, bData, result);
                     pc.findConnections();
                 }
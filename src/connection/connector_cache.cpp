@@ -0,0 +1,211 @@
+#include "connector_cache.h"
+#include "../helpers/binary_io.h"
+#include "connector/clip.h"
+#include "connector/cylindrical.h"
+#include "connector/finger.h"
+#include "connector/generic.h"
+#include <spdlog/spdlog.h>
+
+namespace bricksim::connection {
+    namespace {
+        constexpr MappedBlobStore::magic_t MAGIC = {'B', 'S', 'C', 'O', 'N', 'N', 'E', 'C'};
+        //increment this when the serialization of the connectors or the result of ConnectorConversion changes
+        constexpr uint32_t FORMAT_VERSION = 1;
+
+        void writeBounding(BinaryWriter& writer, const bounding_variant_t& bounding) {
+            writer.put(static_cast<uint8_t>(bounding.index()));
+            if (const auto* box = std::get_if<BoundingBox>(&bounding)) {
+                writer.put(box->radius);
+            } else if (const auto* cube = std::get_if<BoundingCube>(&bounding)) {
+                writer.put(cube->radius);
+            } else if (const auto* cyl = std::get_if<BoundingCyl>(&bounding)) {
+                writer.put(cyl->radius);
+                writer.put(cyl->length);
+            } else if (const auto* sph = std::get_if<BoundingSph>(&bounding)) {
+                writer.put(sph->radius);
+            }
+        }
+
+        bounding_variant_t readBounding(BinaryReader& reader) {
+            switch (reader.get<uint8_t>()) {
+                case 0:
+                    return BoundingPnt{};
+                case 1:
+                    return BoundingBox{reader.get<glm::vec3>()};
+                case 2:
+                    return BoundingCube{reader.get<float>()};
+                case 3:
+                {
+                    const auto radius = reader.get<float>();
+                    return BoundingCyl{radius, reader.get<float>()};
+                }
+                case 4:
+                    return BoundingSph{reader.get<float>()};
+                default:
+                    throw std::invalid_argument("invalid bounding type");
+            }
+        }
+
+        void writeConnector(BinaryWriter& writer, const Connector& connector) {
+            writer.put(static_cast<uint8_t>(connector.type));
+            writer.putString(connector.group);
+            writer.put(connector.start);
+            writer.put(connector.direction);
+            writer.putString(connector.sourceTrace);
+            switch (connector.type) {
+                case Connector::Type::CYLINDRICAL:
+                {
+                    const auto& cyl = static_cast<const CylindricalConnector&>(connector);
+                    writer.put(static_cast<uint8_t>(cyl.gender));
+                    writer.put(cyl.openStart);
+                    writer.put(cyl.openEnd);
+                    writer.put(cyl.slide);
+                    writer.put(static_cast<uint32_t>(cyl.parts.size()));
+                    for (const auto& part: cyl.parts) {
+                        writer.put(static_cast<uint8_t>(part.type));
+                        writer.put(part.flexibleRadius);
+                        writer.put(part.radius);
+                        writer.put(part.length);
+                    }
+                    break;
+                }
+                case Connector::Type::CLIP:
+                {
+                    const auto& clip = static_cast<const ClipConnector&>(connector);
+                    writer.put(clip.radius);
+                    writer.put(clip.width);
+                    writer.put(clip.slide);
+                    writer.put(clip.openingDirection);
+                    break;
+                }
+                case Connector::Type::FINGER:
+                {
+                    const auto& finger = static_cast<const FingerConnector&>(connector);
+                    writer.put(static_cast<uint8_t>(finger.firstFingerGender));
+                    writer.put(finger.radius);
+                    writer.put(static_cast<uint32_t>(finger.fingerWidths.size()));
+                    for (const auto width: finger.fingerWidths) {
+                        writer.put(width);
+                    }
+                    break;
+                }
+                case Connector::Type::GENERIC:
+                {
+                    const auto& generic = static_cast<const GenericConnector&>(connector);
+                    writer.put(static_cast<uint8_t>(generic.gender));
+                    writeBounding(writer, generic.bounding);
+                    break;
+                }
+            }
+        }
+
+        std::shared_ptr<Connector> readConnector(BinaryReader& reader) {
+            const auto type = static_cast<Connector::Type>(reader.get<uint8_t>());
+            auto group = reader.getString();
+            const auto start = reader.get<glm::vec3>();
+            const auto direction = reader.get<glm::vec3>();
+            auto sourceTrace = reader.getString();
+            switch (type) {
+                case Connector::Type::CYLINDRICAL:
+                {
+                    const auto gender = static_cast<Gender>(reader.get<uint8_t>());
+                    const auto openStart = reader.get<bool>();
+                    const auto openEnd = reader.get<bool>();
+                    const auto slide = reader.get<bool>();
+                    std::vector<CylindricalShapePart> parts;
+                    const auto partCount = reader.get<uint32_t>();
+                    parts.reserve(partCount);
+                    for (uint32_t i = 0; i < partCount; ++i) {
+                        const auto partType = static_cast<CylindricalShapeType>(reader.get<uint8_t>());
+                        const auto flexibleRadius = reader.get<bool>();
+                        const auto radius = reader.get<float>();
+                        parts.emplace_back(partType, flexibleRadius, radius, reader.get<float>());
+                    }
+                    return std::make_shared<CylindricalConnector>(group, start, direction, std::move(sourceTrace), gender, std::move(parts), openStart, openEnd, slide);
+                }
+                case Connector::Type::CLIP:
+                {
+                    const auto radius = reader.get<float>();
+                    const auto width = reader.get<float>();
+                    const auto slide = reader.get<bool>();
+                    const auto openingDirection = reader.get<glm::vec3>();
+                    return std::make_shared<ClipConnector>(group, start, direction, std::move(sourceTrace), radius, width, slide, openingDirection);
+                }
+                case Connector::Type::FINGER:
+                {
+                    const auto firstFingerGender = static_cast<Gender>(reader.get<uint8_t>());
+                    const auto radius = reader.get<float>();
+                    std::vector<float> fingerWidths(reader.get<uint32_t>());
+                    for (auto& width: fingerWidths) {
+                        width = reader.get<float>();
+                    }
+                    return std::make_shared<FingerConnector>(group, start, direction, std::move(sourceTrace), firstFingerGender, radius, fingerWidths);
+                }
+                case Connector::Type::GENERIC:
+                {
+                    const auto gender = static_cast<Gender>(reader.get<uint8_t>());
+                    return std::make_shared<GenericConnector>(group, start, direction, std::move(sourceTrace), gender, readBounding(reader));
+                }
+                default:
+                    throw std::invalid_argument("invalid connector type");
+            }
+        }
+
+        std::vector<uint8_t> serialize(const connector_container_t& connectors) {
+            BinaryWriter writer;
+            writer.put(static_cast<uint32_t>(connectors.size()));
+            for (const auto& connector: connectors) {
+                writeConnector(writer, *connector);
+            }
+            return std::move(writer.buffer);
+        }
+
+        std::shared_ptr<connector_container_t> deserialize(std::span<const uint8_t> data) {
+            BinaryReader reader(data);
+            auto result = std::make_shared<connector_container_t>(reader.get<uint32_t>());
+            for (auto& connector: *result) {
+                connector = readConnector(reader);
+            }
+            if (!reader.isAtEnd()) {
+                throw std::invalid_argument("unexpected data after the last connector");
+            }
+            return result;
+        }
+    }
+
+    ConnectorCache::ConnectorCache(std::filesystem::path path, std::string libraryVersion) :
+        store(std::move(path), "connector cache", MAGIC, FORMAT_VERSION, {std::move(libraryVersion)}) {
+    }
+
+    std::shared_ptr<connector_container_t> ConnectorCache::read(const std::string& name, uint64_t fingerprint) const {
+        std::shared_lock<std::shared_mutex> lg(saveMtx);
+        const auto data = store.read(name, fingerprint);
+        if (data.empty()) {
+            return nullptr;
+        }
+        try {
+            return deserialize(data);
+        } catch (const std::exception& e) {
+            spdlog::warn("cannot read connectors of {} from connector cache: {}", name, e.what());
+            return nullptr;
+        }
+    }
+
+    bool ConnectorCache::contains(const std::string& name, uint64_t fingerprint) const {
+        std::shared_lock<std::shared_mutex> lg(saveMtx);
+        return !store.read(name, fingerprint).empty();
+    }
+
+    void ConnectorCache::put(const std::string& name, uint64_t fingerprint, const connector_container_t& connectors) {
+        store.put(name, fingerprint, serialize(connectors));
+    }
+
+    void ConnectorCache::save() {
+        std::unique_lock<std::shared_mutex> lg(saveMtx);
+        store.save();
+    }
+
+    std::size_t ConnectorCache::getEntryCount() const {
+        return store.getEntryCount();
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../helpers/mapped_blob_store.h"
+#include "connector/connector.h"
+#include <filesystem>
+#include <shared_mutex>
+
+namespace bricksim::connection {
+    /**
+     * converted connectors of library parts on disk, so a part doesn't have to go through ConnectorConversion again at the next start.
+     * the file is only valid for one library version, every entry additionally stores a fingerprint of all files
+     * and LDCad metas the connectors were converted from
+     */
+    class ConnectorCache {
+    public:
+        ConnectorCache(std::filesystem::path path, std::string libraryVersion);
+        ConnectorCache(const ConnectorCache&) = delete;
+        ConnectorCache& operator=(const ConnectorCache&) = delete;
+
+        /**
+         * thread safe
+         * @param name path relative to the library root, like the names in BinaryLibraryCache
+         * @return nullptr if name isn't cached or the fingerprint doesn't match
+         */
+        [[nodiscard]] std::shared_ptr<connector_container_t> read(const std::string& name, uint64_t fingerprint) const;
+        [[nodiscard]] bool contains(const std::string& name, uint64_t fingerprint) const;
+        ///thread safe
+        void put(const std::string& name, uint64_t fingerprint, const connector_container_t& connectors);
+        ///thread safe, blocks read() until the file is written
+        void save();
+
+        [[nodiscard]] std::size_t getEntryCount() const;
+
+    private:
+        MappedBlobStore store;
+        ///save() replaces the mapping which read() is using
+        mutable std::shared_mutex saveMtx;
+    };
+}
@@ -103,7 +103,7 @@ namespace bricksim::connection {
         if (includeSubfileReferences) {
             for (const auto& item: file->elements) {
                 if (item->getType() == 1) {
-                    convertSubfileReference(transformation, sourceTrace, file, std::dynamic_pointer_cast<ldr::SubfileReference>(item));
+                    convertSubfileReference(transformation, sourceTrace, file, std::static_pointer_cast<ldr::SubfileReference>(item));
                 }
             }
         }
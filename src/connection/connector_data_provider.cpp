@@ -1,14 +1,97 @@
 #include "connector_data_provider.h"
+#include "../helpers/stringutil.h"
+#include "../helpers/thread_pool.h"
+#include "../helpers/util.h"
 #include "../ldr/file_repo.h"
 #include "connection_check.h"
+#include "connector_cache.h"
 #include "spdlog/fmt/chrono.h"
 #include "spdlog/spdlog.h"
 #include "spdlog/stopwatch.h"
+#include <palanteer.h>
 
 namespace bricksim::connection {
     namespace {
+        constexpr auto CONNECTOR_CACHE_FILE_NAME = "connector_cache.bin";
+
         uomap_t<std::shared_ptr<ldr::FileNamespace>, uomap_t<std::string, std::shared_ptr<connector_container_t>>> cache;
         std::mutex cacheLock;
+
+        std::unique_ptr<ConnectorCache> persistentCache;
+        std::mutex persistentCacheLock;
+
+        uomap_t<std::shared_ptr<ldr::File>, uint64_t> fingerprints;
+        std::mutex fingerprintsLock;
+
+        ConnectorCache* getPersistentCache() {
+            std::lock_guard<std::mutex> lg(persistentCacheLock);
+            if (persistentCache == nullptr && ldr::file_repo::isInitialized()) {
+                persistentCache = std::make_unique<ConnectorCache>(CONNECTOR_CACHE_FILE_NAME, ldr::file_repo::get().getVersion());
+            }
+            return persistentCache.get();
+        }
+
+        bool isLibraryPart(const std::shared_ptr<ldr::File>& file) {
+            return file->nameSpace == nullptr
+                   && file->metaInfo.type != ldr::FileType::MODEL
+                   && file->metaInfo.type != ldr::FileType::MPD_SUBFILE;
+        }
+
+        /**
+         * the connectors of a part depend on the file itself, its LDCad metas (which mostly come from the shadow library)
+         * and the same of all files it references with line type 1 or SNAP_INCL
+         * @return 0 if one of these files is not from the library
+         */
+        uint64_t calculateFingerprint(const std::shared_ptr<ldr::File>& file, uoset_t<std::shared_ptr<ldr::File>>& visiting) {
+            {
+                std::lock_guard<std::mutex> lg(fingerprintsLock);
+                if (const auto it = fingerprints.find(file); it != fingerprints.end()) {
+                    return it->second;
+                }
+            }
+            if (file->nameSpace != nullptr || !visiting.insert(file).second) {
+                return 0;
+            }
+            uint64_t fingerprint = ldr::file_repo::get().getLibraryFileFingerprint(ldr::FileRepo::getPathRelativeToBase(file->metaInfo.type, file->metaInfo.name));
+            for (const auto& command: file->ldcadMetas) {
+                if (fingerprint == 0) {
+                    break;
+                }
+                fingerprint = util::combinedHash(fingerprint, command->to_string());
+                if (command->type == ldcad_meta::CommandType::SNAP_INCL) {
+                    const auto& ref = std::dynamic_pointer_cast<ldcad_meta::InclCommand>(command)->ref;
+                    const auto inclFingerprint = calculateFingerprint(ldr::file_repo::get().getFile(std::shared_ptr<ldr::FileNamespace>(), ref), visiting);
+                    fingerprint = inclFingerprint == 0 ? 0 : util::combinedHash(fingerprint, inclFingerprint);
+                }
+            }
+            for (const auto& element: file->elements) {
+                if (fingerprint != 0 && element->getType() == 1) {
+                    const auto subfileFingerprint = calculateFingerprint(std::static_pointer_cast<ldr::SubfileReference>(element)->getFile(file), visiting);
+                    fingerprint = subfileFingerprint == 0 ? 0 : util::combinedHash(fingerprint, subfileFingerprint);
+                }
+            }
+            visiting.erase(file);
+            if (fingerprint != 0) {
+                std::lock_guard<std::mutex> lg(fingerprintsLock);
+                fingerprints.emplace(file, fingerprint);
+            }
+            return fingerprint;
+        }
+
+        uint64_t calculateFingerprint(const std::shared_ptr<ldr::File>& file) {
+            uoset_t<std::shared_ptr<ldr::File>> visiting;
+            return calculateFingerprint(file, visiting);
+        }
+
+        std::shared_ptr<connector_container_t> convertPart(const std::string& name, const std::shared_ptr<ldr::File>& file) {
+            ConnectorConversion conversion;
+            conversion.createConnectors(file);
+            const auto duplicateCount = removeDuplicates(*conversion.getResult());
+            if (duplicateCount > 0) {
+                spdlog::warn("Part {} {} has {} duplicate connectors", name, file->metaInfo.title, duplicateCount);
+            }
+            return conversion.getResult();
+        }
     }
 
     void removeConnected(connector_container_t& connectors) {
@@ -73,7 +156,7 @@ namespace bricksim::connection {
             spdlog::stopwatch sw;
             for (const auto& item: file->elements) {
                 if (item->getType() == 1) {
-                    const auto sfReference = std::dynamic_pointer_cast<ldr::SubfileReference>(item);
+                    const auto sfReference = std::static_pointer_cast<ldr::SubfileReference>(item);
                     const auto sfReferenceTransformation = sfReference->getTransformationMatrixT();
                     const auto partResult = getConnectorsOfLdrFile(sfReference->getFile(file));
                     for (const auto& partConn: *partResult) {
@@ -88,14 +171,21 @@ namespace bricksim::connection {
                 const auto time = std::chrono::duration_cast<std::chrono::milliseconds>(sw.elapsed());
                 spdlog::debug("connector data provider: provided {} connectors for {} in {}", result->size(), name, time);
             }
-        } else {
-            ConnectorConversion conversion;
-            conversion.createConnectors(file);
-            const auto duplicateCount = removeDuplicates(*conversion.getResult());
-            if (duplicateCount > 0) {
-                spdlog::warn("Part {} {} has {} duplicate connectors", name, file->metaInfo.title, duplicateCount);
+        } else if (auto* const persistent = isLibraryPart(file) ? getPersistentCache() : nullptr; persistent != nullptr) {
+            const auto pathRelativeToBase = ldr::FileRepo::getPathRelativeToBase(file->metaInfo.type, file->metaInfo.name);
+            const auto fingerprint = calculateFingerprint(file);
+            //0 means that the part depends on a file which is not from the library, so it can't be cached
+            if (fingerprint != 0) {
+                result = persistent->read(pathRelativeToBase, fingerprint);
             }
-            result = conversion.getResult();
+            if (result == nullptr) {
+                result = convertPart(name, file);
+                if (fingerprint != 0) {
+                    persistent->put(pathRelativeToBase, fingerprint, *result);
+                }
+            }
+        } else {
+            result = convertPart(name, file);
         }
         {
             std::lock_guard<std::mutex> lg(cacheLock);
@@ -117,4 +207,67 @@ namespace bricksim::connection {
     std::shared_ptr<connector_container_t> getConnectorsOfLdrFile(const std::shared_ptr<ldr::File>& ldrFile) {
         return getConnectorsOfLdrFile(ldrFile->nameSpace, ldrFile->metaInfo.name);
     }
+
+    void precomputeLibraryConnectors(float* progress) {
+        plFunction();
+        auto* const persistent = getPersistentCache();
+        if (persistent == nullptr) {
+            return;
+        }
+        spdlog::stopwatch sw;
+        std::vector<std::string> partNames;
+        for (const auto& fileName: ldr::file_repo::get().listAllFileNames([progress](float p) { *progress = p; })) {
+            const auto lowerFileName = stringutil::asLower(fileName);
+            if (lowerFileName.starts_with("parts/") && !lowerFileName.starts_with("parts/s/")) {
+                partNames.push_back(fileName.substr(6));
+            }
+        }
+
+        std::atomic<std::size_t> doneCount = 0;
+        std::atomic<std::size_t> convertedCount = 0;
+        thread_pool::parallelFor(partNames.size(), 16, [&](std::size_t begin, std::size_t end) {
+            for (auto i = begin; i < end; ++i) {
+                if (thread_pool::isCurrentJobCancelled()) {
+                    return;
+                }
+                try {
+                    const auto file = ldr::file_repo::get().getFile(nullptr, partNames[i]);
+                    const auto pathRelativeToBase = ldr::FileRepo::getPathRelativeToBase(file->metaInfo.type, file->metaInfo.name);
+                    const auto fingerprint = calculateFingerprint(file);
+                    if (fingerprint != 0 && !persistent->contains(pathRelativeToBase, fingerprint)) {
+                        persistent->put(pathRelativeToBase, fingerprint, *convertPart(partNames[i], file));
+                        ++convertedCount;
+                    }
+                } catch (const std::exception& e) {
+                    spdlog::warn("cannot precompute connectors of {}: {}", partNames[i], e.what());
+                }
+            }
+            *progress = .5f + .5f * static_cast<float>(doneCount += end - begin) / static_cast<float>(partNames.size());
+        });
+        persistent->save();
+        const auto time = std::chrono::duration_cast<std::chrono::milliseconds>(sw.elapsed());
+        spdlog::info("converted connectors of {} of {} parts in {}", convertedCount.load(), partNames.size(), time);
+    }
+
+    void cleanupConnectorCache() {
+        std::lock_guard<std::mutex> lg(persistentCacheLock);
+        if (persistentCache != nullptr) {
+            persistentCache->save();
+        }
+        persistentCache = nullptr;
+    }
+
+    void removeLibraryFilesFromCache(const std::vector<std::shared_ptr<ldr::File>>& files) {
+        {
+            std::lock_guard<std::mutex> lg(fingerprintsLock);
+            fingerprints.clear();
+        }
+        std::lock_guard<std::mutex> lg(cacheLock);
+        //library files can also be resolved from the namespace of a model
+        for (auto& [fileNamespace, nsCache]: cache) {
+            for (const auto& file: files) {
+                nsCache.erase(file->metaInfo.name);
+            }
+        }
+    }
 }
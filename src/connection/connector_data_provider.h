@@ -10,4 +10,17 @@ namespace bricksim::connection {
     std::shared_ptr<connector_container_t> getConnectorsOfLdrFile(const std::shared_ptr<ldr::FileNamespace>& fileNamespace, const std::string& name);
     std::shared_ptr<connector_container_t> getConnectorsOfNode(const std::shared_ptr<etree::MeshNode>& node);
     std::shared_ptr<connector_container_t> getConnectorsOfLdrFile(const std::shared_ptr<ldr::File>& ldrFile);
+    /**
+     * converts the connectors of all parts in the library on all cores and stores them in the persistent connector cache,
+     * so the first engine update of a model doesn't have to convert anything
+     * @param progress from 0.0 to 1.0
+     */
+    void precomputeLibraryConnectors(float* progress);
+    ///writes the newly converted connectors to the persistent connector cache
+    void cleanupConnectorCache();
+    /**
+     * forgets the connectors of these files and all fingerprints in memory. has to be called when library files are replaced,
+     * the old connectors would be returned and the old File objects would be kept alive otherwise
+     */
+    void removeLibraryFilesFromCache(const std::vector<std::shared_ptr<ldr::File>>& files);
 }
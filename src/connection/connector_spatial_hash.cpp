@@ -0,0 +1,165 @@
+#include "connector_spatial_hash.h"
+#include "../helpers/geometry.h"
+#include <glm/gtx/norm.hpp>
+
+namespace bricksim::connection {
+    namespace {
+        constexpr float SEARCH_MARGIN_CELLS = ConnectorSpatialHash::SEARCH_MARGIN_LDU / ConnectorSpatialHash::CELL_SIZE_LDU;
+
+        bool canBeConnected(Connector::Type a, Connector::Type b) {
+            using Type = Connector::Type;
+            switch (a) {
+                case Type::CYLINDRICAL:
+                    return b == Type::CYLINDRICAL || b == Type::CLIP;
+                case Type::CLIP:
+                    return b == Type::CYLINDRICAL;
+                default:
+                    return a == b;
+            }
+        }
+    }
+
+    void ConnectorSpatialHash::insert(owner_t owner, std::shared_ptr<connector_container_t> connectors, const glm::mat4& absTransformation) {
+        auto [it, inserted] = owners.try_emplace(owner);
+        auto& data = it->second;
+        if (!inserted) {
+            removeFromCells(owner, data);
+        }
+        const auto count = connectors->size();
+        data.connectors = std::move(connectors);
+        data.absTransformation = absTransformation;
+        data.absStarts.resize(count);
+        data.absDirections.resize(count);
+        data.directionIndices.resize(count);
+        data.cellCoords.resize(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto& connector = (*data.connectors)[i];
+            const glm::vec3 absStart = absTransformation * glm::vec4(connector->start, 1.f);
+            const glm::vec3 absDirection = absTransformation * glm::vec4(connector->direction, 0.f);
+            data.absStarts[i] = absStart;
+            data.absDirections[i] = absDirection;
+            if (connector->type == Connector::Type::GENERIC) {
+                data.directionIndices[i] = POINT_DIRECTION;
+                data.cellCoords[i] = absStart / CELL_SIZE_LDU;
+            } else {
+                const auto dirIdx = getDirectionIndex(absDirection);
+                const auto& dir = directions[dirIdx];
+                data.directionIndices[i] = dirIdx;
+                data.cellCoords[i] = glm::vec3(glm::dot(absStart, dir.u), glm::dot(absStart, dir.v), 0.f) / CELL_SIZE_LDU;
+            }
+            cells[getCell(data.directionIndices[i], data.cellCoords[i])].push_back({owner, static_cast<uint32_t>(i), connector->type});
+        }
+    }
+
+    void ConnectorSpatialHash::remove(owner_t owner) {
+        const auto it = owners.find(owner);
+        if (it != owners.end()) {
+            removeFromCells(owner, it->second);
+            owners.erase(it);
+        }
+    }
+
+    void ConnectorSpatialHash::clear() {
+        cells.clear();
+        owners.clear();
+        directions.clear();
+    }
+
+    bool ConnectorSpatialHash::contains(owner_t owner) const {
+        return owners.contains(owner);
+    }
+
+    void ConnectorSpatialHash::findCandidates(owner_t owner, std::vector<Candidate>& candidates) const {
+        const auto it = owners.find(owner);
+        if (it == owners.end()) {
+            return;
+        }
+        const auto& data = it->second;
+        for (std::size_t i = 0; i < data.connectors->size(); ++i) {
+            const auto type = (*data.connectors)[i]->type;
+            const auto dirIdx = data.directionIndices[i];
+            const auto low = getCell(dirIdx, data.cellCoords[i] - SEARCH_MARGIN_CELLS);
+            const auto high = getCell(dirIdx, data.cellCoords[i] + SEARCH_MARGIN_CELLS);
+            connector_cell_key_t key{dirIdx, {}};
+            for (key.cell[0] = low.cell[0]; key.cell[0] <= high.cell[0]; ++key.cell[0]) {
+                for (key.cell[1] = low.cell[1]; key.cell[1] <= high.cell[1]; ++key.cell[1]) {
+                    for (key.cell[2] = low.cell[2]; key.cell[2] <= high.cell[2]; ++key.cell[2]) {
+                        const auto cellIt = cells.find(key);
+                        if (cellIt == cells.end()) {
+                            continue;
+                        }
+                        for (const auto& entry: cellIt->second) {
+                            if (entry.owner != owner && canBeConnected(type, entry.type)) {
+                                candidates.push_back({entry.owner, static_cast<uint32_t>(i), entry.connector});
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void ConnectorSpatialHash::checkCandidate(owner_t owner, const Candidate& candidate, PairCheckResultConsumer& consumer) const {
+        const auto& a = owners.find(owner)->second;
+        const auto& b = owners.find(candidate.otherOwner)->second;
+        const PairCheckData aData(a.absTransformation, (*a.connectors)[candidate.connector], a.absStarts[candidate.connector], a.absDirections[candidate.connector]);
+        const PairCheckData bData(b.absTransformation, (*b.connectors)[candidate.otherConnector], b.absStarts[candidate.otherConnector], b.absDirections[candidate.otherConnector]);
+        PairChecker(aData, bData, consumer).findConnections();
+    }
+
+    const connector_container_t& ConnectorSpatialHash::getConnectors(owner_t owner) const {
+        return *owners.find(owner)->second.connectors;
+    }
+
+    std::size_t ConnectorSpatialHash::getOwnerCount() const {
+        return owners.size();
+    }
+
+    std::size_t ConnectorSpatialHash::getCellCount() const {
+        return cells.size();
+    }
+
+    uint32_t ConnectorSpatialHash::getDirectionIndex(const glm::vec3& absDirection) {
+        for (std::size_t i = 0; i < directions.size(); ++i) {
+            if (geometry::isAlmostParallel(directions[i].direction, absDirection)) {
+                return static_cast<uint32_t>(i);
+            }
+        }
+        const auto length = glm::length(absDirection);
+        const auto direction = length > 0.f ? absDirection / length : glm::vec3(0, 1, 0);
+        //the axis which is the least parallel to direction
+        const auto absolute = glm::abs(direction);
+        glm::vec3 axis(0.f);
+        axis[absolute.x <= absolute.y && absolute.x <= absolute.z ? 0 : (absolute.y <= absolute.z ? 1 : 2)] = 1.f;
+        const auto u = glm::normalize(glm::cross(direction, axis));
+        directions.push_back({direction, u, glm::cross(direction, u)});
+        return static_cast<uint32_t>(directions.size() - 1);
+    }
+
+    connector_cell_key_t ConnectorSpatialHash::getCell(uint32_t directionIndex, const glm::vec3& cellCoords) {
+        return {
+                directionIndex,
+                {
+                        static_cast<int32_t>(std::floor(cellCoords.x)),
+                        static_cast<int32_t>(std::floor(cellCoords.y)),
+                        directionIndex == POINT_DIRECTION ? static_cast<int32_t>(std::floor(cellCoords.z)) : 0,
+                },
+        };
+    }
+
+    void ConnectorSpatialHash::removeFromCells(owner_t owner, const OwnerData& data) {
+        for (std::size_t i = 0; i < data.cellCoords.size(); ++i) {
+            const auto cellIt = cells.find(getCell(data.directionIndices[i], data.cellCoords[i]));
+            if (cellIt == cells.end()) {
+                continue;
+            }
+            auto& entries = cellIt->second;
+            std::erase_if(entries, [owner, i](const Entry& entry) {
+                return entry.owner == owner && entry.connector == i;
+            });
+            if (entries.empty()) {
+                cells.erase(cellIt);
+            }
+        }
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "../helpers/util.h"
+#include "../types.h"
+#include "connector/connector.h"
+#include "pair_checker.h"
+#include <array>
+#include <limits>
+#include <vector>
+
+namespace bricksim::connection {
+    struct connector_cell_key_t {
+        ///index in the direction list of the ConnectorSpatialHash or ConnectorSpatialHash::POINT_DIRECTION
+        uint32_t direction;
+        std::array<int32_t, 3> cell;
+
+        bool operator==(const connector_cell_key_t& other) const = default;
+    };
+}
+
+namespace std {
+    template<>
+    struct hash<bricksim::connection::connector_cell_key_t> {
+        std::size_t operator()(const bricksim::connection::connector_cell_key_t& value) const {
+            return bricksim::util::combinedHash(value.direction, value.cell[0], value.cell[1], value.cell[2]);
+        }
+    };
+}
+
+namespace bricksim::connection {
+    /**
+     * model-wide index of the absolute connector positions of all parts.
+     * directed connectors (cylindrical, clip, finger) are in the cell of the line they're on: the direction is replaced
+     * by the index of an almost parallel direction and the start is projected onto the plane perpendicular to that direction.
+     * generic connectors are in the cell of their start.
+     * connectors which can be connected are always in the same or in a neighboring cell, so the candidates for one
+     * connector are a few lookups instead of grouping the connectors of both parts for every pair of parts with overlapping bounding boxes.
+     * PairChecker makes the final decision for every candidate.
+     * insert and remove must not be called concurrently with anything else, all const methods can be called from multiple threads
+     */
+    class ConnectorSpatialHash {
+    public:
+        ///the hash never dereferences this, it's just the key of the connectors of a part
+        using owner_t = const void*;
+
+        static constexpr uint32_t POINT_DIRECTION = std::numeric_limits<uint32_t>::max();
+        static constexpr float CELL_SIZE_LDU = 2.f;
+        ///larger than COLINEARITY_TOLERANCE_LDU and POSITION_TOLERANCE_LDU,
+        ///the neighbor cell is searched too if a connector is closer than this to the border of its cell
+        static constexpr float SEARCH_MARGIN_LDU = .25f;
+
+        struct Candidate {
+            owner_t otherOwner;
+            uint32_t connector;
+            uint32_t otherConnector;
+        };
+
+        /**
+         * replaces the connectors of owner if it's already in the hash
+         * @param absTransformation like in PairCheckData (the transposed absolute transformation of the node)
+         */
+        void insert(owner_t owner, std::shared_ptr<connector_container_t> connectors, const glm::mat4& absTransformation);
+        void remove(owner_t owner);
+        void clear();
+        [[nodiscard]] bool contains(owner_t owner) const;
+
+        /**
+         * appends every connector of another owner which might be connected to a connector of owner.
+         * the pairs found from both sides are usually the same, but that's not guaranteed for pairs which are almost
+         * SEARCH_MARGIN_LDU apart, so callers have to handle a pair found from one side only
+         */
+        void findCandidates(owner_t owner, std::vector<Candidate>& candidates) const;
+        /**
+         * runs PairChecker for the candidate, the connector of owner is connectorA of the connections passed to consumer
+         */
+        void checkCandidate(owner_t owner, const Candidate& candidate, PairCheckResultConsumer& consumer) const;
+
+        [[nodiscard]] const connector_container_t& getConnectors(owner_t owner) const;
+        [[nodiscard]] std::size_t getOwnerCount() const;
+        [[nodiscard]] std::size_t getCellCount() const;
+
+    private:
+        struct Entry {
+            owner_t owner;
+            uint32_t connector;
+            Connector::Type type;
+        };
+
+        struct OwnerData {
+            std::shared_ptr<connector_container_t> connectors;
+            glm::mat4 absTransformation;
+            std::vector<glm::vec3> absStarts;
+            std::vector<glm::vec3> absDirections;
+            ///index in directions or POINT_DIRECTION
+            std::vector<uint32_t> directionIndices;
+            ///position in cell units, in the perpendicular plane for directed connectors (the third coordinate is 0)
+            std::vector<glm::vec3> cellCoords;
+        };
+
+        struct Direction {
+            glm::vec3 direction;
+            ///unit vectors perpendicular to direction and to each other
+            glm::vec3 u;
+            glm::vec3 v;
+        };
+
+        std::vector<Direction> directions;
+        uomap_t<connector_cell_key_t, std::vector<Entry>> cells;
+        uomap_t<owner_t, OwnerData> owners;
+
+        uint32_t getDirectionIndex(const glm::vec3& absDirection);
+        static connector_cell_key_t getCell(uint32_t directionIndex, const glm::vec3& cellCoords);
+        void removeFromCells(owner_t owner, const OwnerData& data);
+    };
+}
@@ -0,0 +1,234 @@
+#include "connector_table.h"
+#include "../types.h"
+#include "connection.h"
+#include "connector/clip.h"
+#include "connector/cylindrical.h"
+#include "connector/finger.h"
+#include "connector/generic.h"
+#include <bit>
+#include <mutex>
+#include <shared_mutex>
+
+#if defined(BRICKSIM_USE_OPTIMIZED_VARIANTS) && defined(__SSE2__)
+    #include <immintrin.h>
+    #define BRICKSIM_CONNECTOR_TABLE_SIMD
+#endif
+
+namespace bricksim::connection {
+    namespace {
+        //the filter must never reject a pair which PairChecker accepts, so it's slightly less strict
+        constexpr float FILTER_TOLERANCE_FACTOR = 1.01f;
+        constexpr float PARALLEL_LIMIT = PARALLELITY_ANGLE_TOLERANCE_SQUARED * FILTER_TOLERANCE_FACTOR;
+        constexpr float COLINEAR_LIMIT = COLINEARITY_TOLERANCE_LDU * COLINEARITY_TOLERANCE_LDU * FILTER_TOLERANCE_FACTOR;
+        constexpr float SAME_POSITION_LIMIT = POSITION_TOLERANCE_LDU * POSITION_TOLERANCE_LDU * FILTER_TOLERANCE_FACTOR;
+
+        uomap_t<std::string, group_id_t> groupIds;
+        std::shared_mutex groupIdsMtx;
+
+        enum class PairFilter {
+            ///cylindrical and clip connectors: parallel and on the same line. clips are only checked for parallelity
+            DIRECTED,
+            ///fingers: parallel, on the same line and in the same group
+            DIRECTED_SAME_GROUP,
+            ///generic connectors: same start, same group, different gender
+            UNDIRECTED,
+        };
+
+        PairFilter getFilter(Connector::Type type) {
+            switch (type) {
+                case Connector::Type::FINGER:
+                    return PairFilter::DIRECTED_SAME_GROUP;
+                case Connector::Type::GENERIC:
+                    return PairFilter::UNDIRECTED;
+                default:
+                    return PairFilter::DIRECTED;
+            }
+        }
+
+        bool isCandidate(const TransformedConnectorTable& a, std::size_t i, const TransformedConnectorTable& b, std::size_t j, PairFilter filter) {
+            const auto startDiff = b.getAbsStart(j) - a.getAbsStart(i);
+            if (filter == PairFilter::UNDIRECTED) {
+                return glm::dot(startDiff, startDiff) < SAME_POSITION_LIMIT
+                       && a.table.groups[i] == b.table.groups[j]
+                       && a.table.genders[i] != b.table.genders[j];
+            }
+            const auto aDirection = a.getAbsDirection(i);
+            const auto dirCross = glm::cross(aDirection, b.getAbsDirection(j));
+            const auto lineCross = glm::cross(startDiff, aDirection);
+            const bool parallel = glm::dot(dirCross, dirCross) < PARALLEL_LIMIT;
+            const bool colinear = glm::dot(lineCross, lineCross) < COLINEAR_LIMIT;
+            if (filter == PairFilter::DIRECTED_SAME_GROUP) {
+                return parallel && colinear && a.table.groups[i] == b.table.groups[j];
+            }
+            return parallel && (colinear || a.table.clipMasks[i] != 0 || b.table.clipMasks[j] != 0);
+        }
+    }
+
+    group_id_t getGroupId(const std::string& group) {
+        if (group.empty()) {
+            return 0;
+        }
+        {
+            std::shared_lock<std::shared_mutex> lg(groupIdsMtx);
+            if (const auto it = groupIds.find(group); it != groupIds.end()) {
+                return it->second;
+            }
+        }
+        std::unique_lock<std::shared_mutex> lg(groupIdsMtx);
+        return groupIds.try_emplace(group, static_cast<group_id_t>(groupIds.size() + 1)).first->second;
+    }
+
+    ConnectorTable::ConnectorTable(const connector_container_t& connectors) :
+        connectors(connectors) {
+        const auto count = connectors.size();
+        types.reserve(count);
+        genders.reserve(count);
+        groups.reserve(count);
+        clipMasks.reserve(count);
+        lengths.reserve(count);
+        for (int axis = 0; axis < 3; ++axis) {
+            start[axis].reserve(count);
+            direction[axis].reserve(count);
+        }
+        for (const auto& connector: connectors) {
+            auto gender = NO_GENDER;
+            float length = 0.f;
+            switch (connector->type) {
+                case Connector::Type::CYLINDRICAL:
+                {
+                    const auto& cyl = static_cast<const CylindricalConnector&>(*connector);
+                    gender = static_cast<int32_t>(cyl.gender);
+                    length = cyl.totalLength;
+                    break;
+                }
+                case Connector::Type::CLIP:
+                    length = static_cast<const ClipConnector&>(*connector).width;
+                    break;
+                case Connector::Type::FINGER:
+                    length = static_cast<const FingerConnector&>(*connector).totalWidth;
+                    break;
+                case Connector::Type::GENERIC:
+                    gender = static_cast<int32_t>(static_cast<const GenericConnector&>(*connector).gender);
+                    break;
+            }
+            types.push_back(connector->type);
+            genders.push_back(gender);
+            groups.push_back(getGroupId(connector->group));
+            clipMasks.push_back(connector->type == Connector::Type::CLIP ? ~0u : 0u);
+            lengths.push_back(length);
+            for (int axis = 0; axis < 3; ++axis) {
+                start[axis].push_back(connector->start[axis]);
+                direction[axis].push_back(connector->direction[axis]);
+            }
+        }
+    }
+
+    std::size_t ConnectorTable::size() const {
+        return types.size();
+    }
+
+    const std::shared_ptr<Connector>& ConnectorTable::getConnector(std::size_t i) const {
+        return connectors[i];
+    }
+
+    TransformedConnectorTable::TransformedConnectorTable(const ConnectorTable& table, const glm::mat4& transformation) :
+        table(table), transformation(transformation) {
+        const auto count = table.size();
+        for (int axis = 0; axis < 3; ++axis) {
+            absStart[axis].resize(count);
+            absDirection[axis].resize(count);
+        }
+        //one row of the matrix at a time over all connectors, the compiler vectorizes these loops
+        for (int row = 0; row < 3; ++row) {
+            const auto m0 = transformation[0][row];
+            const auto m1 = transformation[1][row];
+            const auto m2 = transformation[2][row];
+            const auto m3 = transformation[3][row];
+            auto* const startOut = absStart[row].data();
+            auto* const directionOut = absDirection[row].data();
+            const auto* const sx = table.start[0].data();
+            const auto* const sy = table.start[1].data();
+            const auto* const sz = table.start[2].data();
+            const auto* const dx = table.direction[0].data();
+            const auto* const dy = table.direction[1].data();
+            const auto* const dz = table.direction[2].data();
+            for (std::size_t i = 0; i < count; ++i) {
+                startOut[i] = m0 * sx[i] + m1 * sy[i] + m2 * sz[i] + m3;
+                directionOut[i] = m0 * dx[i] + m1 * dy[i] + m2 * dz[i];
+            }
+        }
+    }
+
+    std::size_t TransformedConnectorTable::size() const {
+        return table.size();
+    }
+
+    glm::vec3 TransformedConnectorTable::getAbsStart(std::size_t i) const {
+        return {absStart[0][i], absStart[1][i], absStart[2][i]};
+    }
+
+    glm::vec3 TransformedConnectorTable::getAbsDirection(std::size_t i) const {
+        return {absDirection[0][i], absDirection[1][i], absDirection[2][i]};
+    }
+
+    void findPairCandidates(const TransformedConnectorTable& a, std::size_t i, const TransformedConnectorTable& b, std::size_t bEnd, std::vector<uint32_t>& candidates) {
+        const auto filter = getFilter(a.table.types[i]);
+        std::size_t j = 0;
+#ifdef BRICKSIM_CONNECTOR_TABLE_SIMD
+        const __m128 sax = _mm_set1_ps(a.absStart[0][i]);
+        const __m128 say = _mm_set1_ps(a.absStart[1][i]);
+        const __m128 saz = _mm_set1_ps(a.absStart[2][i]);
+        const __m128 dax = _mm_set1_ps(a.absDirection[0][i]);
+        const __m128 day = _mm_set1_ps(a.absDirection[1][i]);
+        const __m128 daz = _mm_set1_ps(a.absDirection[2][i]);
+        const __m128i groupA = _mm_set1_epi32(static_cast<int>(a.table.groups[i]));
+        const __m128i genderA = _mm_set1_epi32(a.table.genders[i]);
+        const __m128 clipA = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(a.table.clipMasks[i])));
+        for (; j + 4 <= bEnd; j += 4) {
+            const __m128 diffX = _mm_sub_ps(_mm_loadu_ps(b.absStart[0].data() + j), sax);
+            const __m128 diffY = _mm_sub_ps(_mm_loadu_ps(b.absStart[1].data() + j), say);
+            const __m128 diffZ = _mm_sub_ps(_mm_loadu_ps(b.absStart[2].data() + j), saz);
+            const __m128i groupB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b.table.groups.data() + j));
+            const __m128 sameGroup = _mm_castsi128_ps(_mm_cmpeq_epi32(groupA, groupB));
+            __m128 mask;
+            if (filter == PairFilter::UNDIRECTED) {
+                const __m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(diffX, diffX), _mm_mul_ps(diffY, diffY)), _mm_mul_ps(diffZ, diffZ));
+                const __m128i genderB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b.table.genders.data() + j));
+                const __m128 sameGender = _mm_castsi128_ps(_mm_cmpeq_epi32(genderA, genderB));
+                mask = _mm_andnot_ps(sameGender, _mm_and_ps(sameGroup, _mm_cmplt_ps(distance2, _mm_set1_ps(SAME_POSITION_LIMIT))));
+            } else {
+                const __m128 dbx = _mm_loadu_ps(b.absDirection[0].data() + j);
+                const __m128 dby = _mm_loadu_ps(b.absDirection[1].data() + j);
+                const __m128 dbz = _mm_loadu_ps(b.absDirection[2].data() + j);
+                //cross(directionA, directionB)
+                const __m128 cx = _mm_sub_ps(_mm_mul_ps(day, dbz), _mm_mul_ps(daz, dby));
+                const __m128 cy = _mm_sub_ps(_mm_mul_ps(daz, dbx), _mm_mul_ps(dax, dbz));
+                const __m128 cz = _mm_sub_ps(_mm_mul_ps(dax, dby), _mm_mul_ps(day, dbx));
+                const __m128 parallel = _mm_cmplt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, cx), _mm_mul_ps(cy, cy)), _mm_mul_ps(cz, cz)), _mm_set1_ps(PARALLEL_LIMIT));
+                //cross(startB - startA, directionA)
+                const __m128 ex = _mm_sub_ps(_mm_mul_ps(diffY, daz), _mm_mul_ps(diffZ, day));
+                const __m128 ey = _mm_sub_ps(_mm_mul_ps(diffZ, dax), _mm_mul_ps(diffX, daz));
+                const __m128 ez = _mm_sub_ps(_mm_mul_ps(diffX, day), _mm_mul_ps(diffY, dax));
+                const __m128 colinear = _mm_cmplt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)), _mm_mul_ps(ez, ez)), _mm_set1_ps(COLINEAR_LIMIT));
+                if (filter == PairFilter::DIRECTED_SAME_GROUP) {
+                    mask = _mm_and_ps(_mm_and_ps(parallel, colinear), sameGroup);
+                } else {
+                    const __m128 clipB = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b.table.clipMasks.data() + j)));
+                    mask = _mm_and_ps(parallel, _mm_or_ps(colinear, _mm_or_ps(clipA, clipB)));
+                }
+            }
+            auto bits = _mm_movemask_ps(mask);
+            while (bits != 0) {
+                const auto lane = std::countr_zero(static_cast<unsigned int>(bits));
+                candidates.push_back(static_cast<uint32_t>(j + lane));
+                bits &= bits - 1;
+            }
+        }
+#endif
+        for (; j < bEnd; ++j) {
+            if (isCandidate(a, i, b, j, filter)) {
+                candidates.push_back(static_cast<uint32_t>(j));
+            }
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "connector/connector.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace bricksim::connection {
+    using group_id_t = uint32_t;
+
+    /**
+     * the same group string always gets the same id, the empty group gets 0. thread safe
+     */
+    group_id_t getGroupId(const std::string& group);
+
+    /**
+     * the connectors of a container in a structure of arrays layout, so the kernels in findPairCandidates can
+     * process 4 connectors per instruction. the Connector objects stay the primary representation,
+     * row i of the table is connectors[i] and getConnector(i) returns it
+     */
+    class ConnectorTable {
+    public:
+        static constexpr int32_t NO_GENDER = -1;
+
+        ///connectors must outlive the table
+        explicit ConnectorTable(const connector_container_t& connectors);
+
+        std::vector<Connector::Type> types;
+        ///Gender as int or NO_GENDER for fingers and clips
+        std::vector<int32_t> genders;
+        std::vector<group_id_t> groups;
+        ///0 or all bits set, so it can be used as a SIMD mask
+        std::vector<uint32_t> clipMasks;
+        ///totalLength of cylindrical connectors, width of clips, totalWidth of fingers, 0 for generic connectors
+        std::vector<float> lengths;
+        ///in the coordinate system of the part
+        std::array<std::vector<float>, 3> start;
+        std::array<std::vector<float>, 3> direction;
+
+        [[nodiscard]] std::size_t size() const;
+        [[nodiscard]] const std::shared_ptr<Connector>& getConnector(std::size_t i) const;
+
+    private:
+        const connector_container_t& connectors;
+    };
+
+    /**
+     * start and direction of all rows of a ConnectorTable transformed with one matrix in a single pass
+     */
+    class TransformedConnectorTable {
+    public:
+        TransformedConnectorTable(const ConnectorTable& table, const glm::mat4& transformation);
+
+        const ConnectorTable& table;
+        const glm::mat4 transformation;
+        std::array<std::vector<float>, 3> absStart;
+        std::array<std::vector<float>, 3> absDirection;
+
+        [[nodiscard]] std::size_t size() const;
+        [[nodiscard]] glm::vec3 getAbsStart(std::size_t i) const;
+        [[nodiscard]] glm::vec3 getAbsDirection(std::size_t i) const;
+    };
+
+    /**
+     * cheap pre-filter for PairChecker: appends all j < bEnd to candidates where b[j] could be connected to a[i].
+     * it uses the same parallelity, colinearity, position, group and gender conditions as PairChecker with a small margin,
+     * so a pair which isn't a candidate is never connected. PairChecker makes the final decision for the candidates
+     */
+    void findPairCandidates(const TransformedConnectorTable& a, std::size_t i, const TransformedConnectorTable& b, std::size_t bEnd, std::vector<uint32_t>& candidates);
+}
@@ -3,7 +3,8 @@
 #include "../editor/editor.h"
 #include "../helpers/custom_hash.h"
 #include "../helpers/glm_eigen_conversion.h"
-#include "connection_check.h"
+#include "../helpers/thread_pool.h"
+#include "connector_data_provider.h"
 #include "pair_checker.h"
 #include "spdlog/fmt/ostr.h"
 #include "spdlog/spdlog.h"
@@ -20,6 +21,7 @@ namespace bricksim::connection {
     void Engine::updateCollisionData(const std::shared_ptr<etree::Node>& rootNode, float* progress, float progressMultiplicator) {
         *progress = 0.f;
         updateNodeData(rootNode);//todo update progress
+        applyManagerChanges();
 
         *progress = progressMultiplicator;
     }
@@ -29,7 +31,7 @@ namespace bricksim::connection {
         if (it != nodeData.end()) {
             updateNodeData(node, it);
         } else {
-            std::unique_ptr<fcl::CollisionObjectf> collisionObject;
+            std::unique_ptr<CollisionData> collision;
             std::shared_ptr<etree::MeshNode> meshNode;
             if constexpr (partNodeCollsionOnly) {
                 meshNode = std::dynamic_pointer_cast<etree::PartNode>(node);
@@ -37,18 +39,17 @@ namespace bricksim::connection {
                 meshNode = std::dynamic_pointer_cast<etree::MeshNode>(node);
             }
             if (meshNode != nullptr) {
-                const auto aabb = scene.lock()->getMeshCollection().getAbsoluteAABB(meshNode);
-                const auto box = std::make_shared<fcl::Boxf>(glm2eigen(aabb.getSize()));
-                collisionObject = std::make_unique<fcl::CollisionObjectf>(box, fcl::Matrix3f::Identity(), glm2eigen(aabb.getCenter()));
-                collisionObject->setUserData(node.get());
-                manager.registerObject(collisionObject.get());
+                collision = std::make_unique<CollisionData>();
+                collision->node = meshNode;
+                collision->object = createCollisionObject(meshNode, collision.get());
+                pendingRegistrations.insert(collision->object.get());
                 outdatedInGraphs.insert(meshNode);
             }
             nodeData.emplace(node,
                              NodeData{
                                      node->getVersion(),
                                      node->getSelfVersion(),
-                                     std::move(collisionObject),
+                                     std::move(collision),
                                      {node->getChildren().cbegin(), node->getChildren().cend()},
                              });
             for (const auto& child: node->getChildren()) {
@@ -61,20 +62,21 @@ namespace bricksim::connection {
         //todo i think there has to be a separate fcl collision manager per rootNode (=ModelNode)
         auto& data = it->second;
         if (data.lastUpdatedSelfVersion != node->getSelfVersion()) {
-            const auto meshNode = std::dynamic_pointer_cast<etree::MeshNode>(node);
-            if (meshNode != nullptr) {
-                const auto aabb = scene.lock()->getMeshCollection().getAbsoluteAABB(meshNode);
-                const auto sizeDifference = std::dynamic_pointer_cast<const fcl::Boxf>(data.collisionObj->collisionGeometry())->side - glm2eigen(aabb.getSize());
+            if (data.collision != nullptr) {
+                const auto& meshNode = data.collision->node;
+                auto& object = data.collision->object;
+                const auto aabb = mesh::SceneMeshCollection::getAbsoluteAABB(meshNode);
+                const auto sizeDifference = std::dynamic_pointer_cast<const fcl::Boxf>(object->collisionGeometry())->side - glm2eigen(aabb.getSize());
                 if (sizeDifference.squaredNorm() > .01f) {
-                    manager.unregisterObject(data.collisionObj.get());
-                    const auto box = std::make_shared<fcl::Boxf>(glm2eigen(aabb.getSize()));
-                    data.collisionObj = std::make_unique<fcl::CollisionObjectf>(box, fcl::Matrix3f::Identity(), glm2eigen(aabb.getCenter()));//todo share this with initial obj creation
-                    data.collisionObj->setUserData(node.get());
-                    manager.registerObject(data.collisionObj.get());
+                    unregisterCollisionObject(object.get());
+                    object = createCollisionObject(meshNode, data.collision.get());
+                    pendingRegistrations.insert(object.get());
                 } else {
-                    data.collisionObj->setTranslation(glm2eigen(aabb.getCenter()));
-                    data.collisionObj->computeAABB();
-                    manager.update(data.collisionObj.get());
+                    object->setTranslation(glm2eigen(aabb.getCenter()));
+                    object->computeAABB();
+                    if (!pendingRegistrations.contains(object.get())) {
+                        pendingUpdates.insert(object.get());
+                    }
                 }
                 outdatedInGraphs.insert(meshNode);
             }
@@ -99,18 +101,67 @@ namespace bricksim::connection {
     void Engine::removeNodeData(const std::shared_ptr<etree::Node>& node) {
         const auto it = nodeData.find(node);
         if (it != nodeData.end()) {
-            if (it->second.collisionObj != nullptr) {
-                manager.unregisterObject(it->second.collisionObj.get());
-                outdatedInGraphs.insert(std::dynamic_pointer_cast<etree::MeshNode>(it->first));
+            if (it->second.collision != nullptr) {
+                unregisterCollisionObject(it->second.collision->object.get());
+                connectorIndex.remove(it->second.collision.get());
+                outdatedInGraphs.insert(it->second.collision->node);
             }
             nodeData.erase(it);
         }
     }
 
+    std::unique_ptr<fcl::CollisionObjectf> Engine::createCollisionObject(const std::shared_ptr<etree::MeshNode>& meshNode, CollisionData* userData) const {
+        const auto aabb = mesh::SceneMeshCollection::getAbsoluteAABB(meshNode);
+        const auto box = std::make_shared<fcl::Boxf>(glm2eigen(aabb.getSize()));
+        auto object = std::make_unique<fcl::CollisionObjectf>(box, fcl::Matrix3f::Identity(), glm2eigen(aabb.getCenter()));
+        object->setUserData(userData);
+        return object;
+    }
+
+    void Engine::unregisterCollisionObject(fcl::CollisionObjectf* object) {
+        pendingUpdates.erase(object);
+        if (pendingRegistrations.erase(object) == 0) {
+            manager.unregisterObject(object);
+        }
+    }
+
+    void Engine::applyManagerChanges() {
+        const auto changedCount = pendingRegistrations.size() + pendingUpdates.size();
+        if (changedCount == 0) {
+            return;
+        }
+        const auto totalCount = manager.size() + pendingRegistrations.size();
+        if (static_cast<float>(changedCount) > BULK_BUILD_FRACTION * static_cast<float>(totalCount)) {
+            //registerObjects builds the tree in one pass when the manager is empty
+            std::vector<fcl::CollisionObjectf*> objects;
+            objects.reserve(totalCount);
+            for (const auto& [node, data]: nodeData) {
+                if (data.collision != nullptr) {
+                    objects.push_back(data.collision->object.get());
+                }
+            }
+            manager.clear();
+            manager.registerObjects(objects);
+        } else {
+            for (auto* object: pendingRegistrations) {
+                manager.registerObject(object);
+            }
+            if (!pendingUpdates.empty()) {
+                manager.update(std::vector<fcl::CollisionObjectf*>(pendingUpdates.begin(), pendingUpdates.end()));
+            }
+        }
+        manager.setup();
+        pendingRegistrations.clear();
+        pendingUpdates.clear();
+    }
+
     void Engine::resetData() {
         manager.~DynamicAABBTreeCollisionManager();
         new(&manager) fcl::DynamicAABBTreeCollisionManagerf();
         nodeData.clear();
+        connectorIndex.clear();
+        pendingRegistrations.clear();
+        pendingUpdates.clear();
     }
 
     bool updateCallback(fcl::CollisionObjectf* o0, fcl::CollisionObjectf* o1, void* cdata) {
@@ -132,76 +183,76 @@ namespace bricksim::connection {
             const auto it = nodeData.find(item);
             if (it != nodeData.end()) {
                 const auto& data = it->second;
-                if (data.collisionObj != nullptr) {
-                    manager.collide(data.collisionObj.get(), static_cast<void*>(&newIntersections), updateCallback);
+                if (data.collision != nullptr) {
+                    manager.collide(data.collision->object.get(), static_cast<void*>(&newIntersections), updateCallback);
                 }
             }
         }
 
-        *progress = progressStart;
-        const auto threadCount = std::thread::hardware_concurrency();
-        const auto newIntersectionsCount = newIntersections.size();
-        if (newIntersectionsCount > threadCount * 100) {
-            std::mutex lock;
-            std::size_t nextStart = 0;
-
-            spdlog::debug("Using {} threads to handle {} detected part intersections", threadCount, newIntersectionsCount);
-
-            const auto getNewWorkUnit = [&lock, &nextStart, &progress, progressStart, newIntersectionsCount]() -> std::pair<std::size_t, std::size_t> {
-                std::lock_guard<std::mutex> lg(lock);
-                *progress = progressStart + (1.f - progressStart) * nextStart / newIntersectionsCount;
-                const auto start = nextStart;
-                nextStart = std::min(newIntersectionsCount, start + 100);
-                return {start, nextStart};
-            };
-
-            std::vector<std::thread> threads;
-            for (std::size_t i = 0; i < threadCount; ++i) {
-                threads.emplace_back([this,
-                            &i,
-                            &getNewWorkUnit,
-                            &newIntersections]() {
-                            std::string threadName = fmt::format("Narrowphase collision checker #{}", i);
-                            util::setThreadName(threadName.c_str());
-                            while (true) {
-                                const auto [iStart, iEnd] = getNewWorkUnit();
-                                if (iStart == iEnd) {
-                                    break;
-                                }
-                                auto it = newIntersections.begin() + iStart;
-                                const auto end = newIntersections.begin() + iEnd;
-                                while (it < end) {
-                                    handleNewIntersection(*it);
-                                    ++it;
-                                }
-                            }
-                        });
-            }
+        for (const auto& item: newIntersections) {
+            handleNewIntersection(item);
+        }
 
-            for (auto& t: threads) {
-                t.join();
-            }
-        } else {
-            std::size_t i = 0;
-            for (auto it = newIntersections.cbegin(); it != newIntersections.end(); ++i, ++it) {
-                handleNewIntersection(*it);
-                *progress = progressStart + (1.f - progressStart) * i / newIntersectionsCount;
+        *progress = progressStart;
+        const auto connectorCandidates = findConnectorCandidates();
+        const auto candidateCount = connectorCandidates.size();
+        std::mutex progressMtx;
+        std::size_t doneCount = 0;
+        thread_pool::parallelFor(candidateCount, 100, [&](std::size_t begin, std::size_t end) {
+            const auto candidatesBegin = connectorCandidates.begin();
+            for (auto it = candidatesBegin + begin; it < candidatesBegin + end; ++it) {
+                handleConnectorCandidates(*it);
             }
-        }
+            std::lock_guard<std::mutex> lg(progressMtx);
+            doneCount += end - begin;
+            *progress = progressStart + (1.f - progressStart) * doneCount / candidateCount;
+        });
         *progress = 1.f;
         outdatedInGraphs.clear();
     }
 
     void Engine::handleNewIntersection(const broadphase_collision_pair_t& item) {
-        const auto nodeA = std::dynamic_pointer_cast<etree::MeshNode>(convertRawNodePtr(item[0]->getUserData()));
-        const auto nodeB = std::dynamic_pointer_cast<etree::MeshNode>(convertRawNodePtr(item[1]->getUserData()));
+        intersections.addEdge(convertRawNodePtr(item[0]->getUserData()), convertRawNodePtr(item[1]->getUserData()));
+    }
 
-        //spdlog::debug("broadphase collision {} <--> {}", nodeA->displayName, nodeB->displayName);
+    connector_candidates_t Engine::findConnectorCandidates() {
+        //removed nodes are already removed from connectorIndex in removeNodeData
+        std::vector<const CollisionData*> outdatedOwners;
+        for (const auto& item: outdatedInGraphs) {
+            const auto it = nodeData.find(item);
+            if (it != nodeData.end() && it->second.collision != nullptr) {
+                const auto* owner = it->second.collision.get();
+                connectorIndex.insert(owner, getConnectorsOfNode(item), glm::transpose(item->getAbsoluteTransformation()));
+                outdatedOwners.push_back(owner);
+            }
+        }
+
+        //a pair of two outdated nodes is found from both sides, the sets remove the duplicates
+        connector_candidates_t result;
+        std::vector<ConnectorSpatialHash::Candidate> candidates;
+        for (const auto* owner: outdatedOwners) {
+            candidates.clear();
+            connectorIndex.findCandidates(owner, candidates);
+            for (const auto& candidate: candidates) {
+                if (std::less<>()(static_cast<ConnectorSpatialHash::owner_t>(owner), candidate.otherOwner)) {
+                    result[{owner, candidate.otherOwner}].insert(static_cast<uint64_t>(candidate.connector) << 32 | candidate.otherConnector);
+                } else {
+                    result[{candidate.otherOwner, owner}].insert(static_cast<uint64_t>(candidate.otherConnector) << 32 | candidate.connector);
+                }
+            }
+        }
+        return result;
+    }
+
+    void Engine::handleConnectorCandidates(const connector_candidates_t::value_type& item) {
+        const auto& [owners, connectorPairs] = item;
+        const auto& nodeA = convertRawNodePtr(owners[0]);
+        const auto& nodeB = convertRawNodePtr(owners[1]);
 
         ConnectionGraphPairCheckResultConsumer result(nodeA, nodeB, connections);
-        ConnectionCheck connCheck(result);
-        connCheck.checkForConnected(nodeA, nodeB);
-        intersections.addEdge(nodeA, nodeB);
+        for (const auto pair: connectorPairs) {
+            connectorIndex.checkCandidate(owners[0], {owners[1], static_cast<uint32_t>(pair >> 32), static_cast<uint32_t>(pair)}, result);
+        }
     }
 
     const ConnectionGraph& Engine::getConnections() const {
@@ -211,6 +262,8 @@ namespace bricksim::connection {
     void Engine::update(const std::shared_ptr<etree::Node>& rootNode, float* progress) {
         spdlog::stopwatch sw;
 
+        //the absolute transformations are read from multiple threads in updateGraph
+        rootNode->getTransformTable().update();
         updateCollisionData(rootNode, progress, .2f);
 
         const auto between = sw.elapsed();
@@ -224,10 +277,8 @@ namespace bricksim::connection {
                      std::chrono::duration_cast<std::chrono::microseconds>(after).count() / 1000.f);
     }
 
-    const std::shared_ptr<etree::Node>& Engine::convertRawNodePtr(void* rawPtr) const {
-        auto* typedPtr = static_cast<etree::Node*>(rawPtr);
-        std::shared_ptr<etree::Node> key0(typedPtr, [](auto*) {});
-        return nodeData.find(key0)->first;
+    const std::shared_ptr<etree::MeshNode>& Engine::convertRawNodePtr(const void* rawPtr) {
+        return static_cast<const CollisionData*>(rawPtr)->node;
     }
 
     void Engine::update(const std::shared_ptr<etree::Node>& rootNode) {
@@ -239,10 +290,6 @@ namespace bricksim::connection {
         return intersections;
     }
 
-    void Engine::setScene(const std::weak_ptr<graphics::Scene>& scene) {
-        Engine::scene = scene;
-    }
-
     bool rayIntersectionCallback(fcl::CollisionObjectf* o0, fcl::CollisionObjectf* o1, void* cdata) {
         auto nodes = static_cast<std::vector<void*>*>(cdata);
         if (o0->getUserData() != nullptr) {
@@ -268,7 +315,7 @@ namespace bricksim::connection {
 
         std::vector<std::pair<float, std::shared_ptr<etree::MeshNode>>> result;
         for (const auto& item: nodes) {
-            const auto node = std::dynamic_pointer_cast<etree::MeshNode>(convertRawNodePtr(item));
+            const auto& node = convertRawNodePtr(item);
             const glm::vec3 nodeCenter = glm::transpose(node->getAbsoluteTransformation()) * glm::vec4(0, 0, 0, 1);
             result.emplace_back(glm::distance2(ray.origin, nodeCenter), node);
         }
@@ -3,7 +3,9 @@
 #include "../graphics/mesh/mesh_collection.h"
 #include "../graphics/scene.h"
 #include "connection.h"
+#include "../helpers/custom_hash.h"
 #include "connection_graph.h"
+#include "connector_spatial_hash.h"
 #include "fcl/broadphase/broadphase_dynamic_AABB_tree.h"
 #include "fcl/narrowphase/collision_object.h"
 #include "intersection_graph.h"
@@ -14,34 +16,61 @@ namespace bricksim {
 
 namespace bricksim::connection {
     using broadphase_collision_pair_t = std::array<fcl::CollisionObjectf*, 2>;
+    ///the owners are ordered by address, the connector indices are packed as (first << 32) | second
+    using connector_candidates_t = uomap_t<std::array<ConnectorSpatialHash::owner_t, 2>, uoset_t<uint64_t>>;
 
     class Engine {
     private:
+        /**
+         * the user data of object points to this, so the node of a collision object is found without a lookup.
+         * the address stays the same as long as the node is in the manager, it's also the owner in connectorIndex
+         */
+        struct CollisionData {
+            std::shared_ptr<etree::MeshNode> node;
+            std::unique_ptr<fcl::CollisionObjectf> object;
+        };
+
         struct NodeData {
             etree::Node::version_t lastUpdatedVersion;
             etree::Node::version_t lastUpdatedSelfVersion;
-            std::unique_ptr<fcl::CollisionObjectf> collisionObj;
+            std::unique_ptr<CollisionData> collision;
             uoset_t<std::shared_ptr<etree::Node>> children;
         };
 
-        std::weak_ptr<graphics::Scene> scene;
         fcl::DynamicAABBTreeCollisionManagerf manager;
         uomap_t<std::shared_ptr<etree::Node>, NodeData> nodeData;
+        ConnectorSpatialHash connectorIndex;
         IntersectionGraph intersections;
         ConnectionGraph connections;
         uoset_t<ConnectionGraph::node_t> outdatedInGraphs;
+        ///registering and updating objects is collected while walking the element tree and applied in applyManagerChanges
+        uoset_t<fcl::CollisionObjectf*> pendingRegistrations;
+        uoset_t<fcl::CollisionObjectf*> pendingUpdates;
 
         static constexpr bool partNodeCollsionOnly = false;
+        ///if more than this fraction of the objects are new or moved, the whole tree is built again instead of inserting and refitting
+        static constexpr float BULK_BUILD_FRACTION = .25f;
 
         void updateCollisionData(const std::shared_ptr<etree::Node>& rootNode, float* progress, float progressMultiplicator);
         void updateGraph(float* progress, float progressStart);
 
         void handleNewIntersection(const broadphase_collision_pair_t& item);
+        /**
+         * updates the outdated nodes in connectorIndex and collects the connector pairs of outdated nodes which might be connected
+         */
+        connector_candidates_t findConnectorCandidates();
+        void handleConnectorCandidates(const connector_candidates_t::value_type& item);
 
         void resetData();
 
-        //todo try to improve manager.registerObject, manager.update and manager.unregisterObject calls
-        // so that the binary tree is only balanced once (check if performance is better)
+        std::unique_ptr<fcl::CollisionObjectf> createCollisionObject(const std::shared_ptr<etree::MeshNode>& meshNode, CollisionData* userData) const;
+        void unregisterCollisionObject(fcl::CollisionObjectf* object);
+        /**
+         * registers the pending objects and refits the moved ones, so the tree is only balanced once per update.
+         * on the initial load or for large batches the tree is built from all objects at once
+         */
+        void applyManagerChanges();
+
         /**
          * updates @param node in the manager recursively
          */
@@ -56,13 +85,11 @@ namespace bricksim::connection {
          */
         void removeNodeData(const std::shared_ptr<etree::Node>& node);
 
-        const std::shared_ptr<etree::Node>& convertRawNodePtr(void* rawPtr) const;
+        static const std::shared_ptr<etree::MeshNode>& convertRawNodePtr(const void* rawPtr);
 
     public:
         Engine();
 
-        void setScene(const std::weak_ptr<graphics::Scene>& scene);
-
         void update(const std::shared_ptr<etree::Node>& rootNode, float* progress);
         void update(const std::shared_ptr<etree::Node>& rootNode);
 
@@ -75,7 +75,9 @@ namespace bricksim::connection::visualization {
                 const auto filename = thumbnailRequest.getFilename();
                 const auto path = result.tmpDirectory / filename;
                 if (!std::filesystem::exists(path)) {
-                    thumbnailGenerator->getThumbnail(thumbnailRequest)->saveToFile(path);
+                    if (!util::writeImage(path.string().c_str(), thumbnailGenerator->getThumbnailImage(thumbnailRequest))) {
+                        throw std::invalid_argument(fmt::format("cannot write thumbnail to {}", path.string()));
+                    }
                 }
                 labelLines.push_back(fmt::format("<img src=\"{}\" />", filename));
             }
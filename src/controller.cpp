@@ -3,6 +3,7 @@
 #include "controller.h"
 #include "config/read.h"
 #include "config/write.h"
+#include "connection/connector_data_provider.h"
 #include "db.h"
 #include "errors/exceptions.h"
 #include "graphics/connection_visualization.h"
@@ -50,6 +51,7 @@ namespace bricksim::controller {
         bool userWantsToExit = false;
 
         uomap_t<unsigned int, Task> backgroundTasks;
+        unsigned int nextBackgroundTaskId = 0;
         std::queue<Task> foregroundTasks;
         std::shared_ptr<gui::modals::Modal> foregroundTaskWaitModal = nullptr;
 
@@ -410,6 +412,9 @@ namespace bricksim::controller {
             auto& bgTasks = getBackgroundTasks();
             if (!bgTasks.empty()) {
                 spdlog::info("waiting for {} background threads to finish...", bgTasks.size());
+                for (auto& bgTask: bgTasks) {
+                    bgTask.second.cancel();
+                }
                 for (auto& bgTask: bgTasks) {
                     bgTask.second.joinThread();
                 }
@@ -431,6 +436,10 @@ namespace bricksim::controller {
             editors.clear();
             mesh::SceneMeshCollection::deleteAllMeshes();
             graphics::scenes::deleteAll();
+            if (thumbnailGenerator != nullptr) {
+                thumbnailGenerator->cleanup();
+            }
+            connection::cleanupConnectorCache();
             thumbnailGenerator = nullptr;
             if (config::get().system.clearRenderingTmpDirectoryOnExit) {
                 const auto renderingTmpDirectory = util::replaceSpecialPaths(config::get().system.renderingTmpDirectory);
@@ -559,10 +568,7 @@ namespace bricksim::controller {
             gui::endFrame();
 
             thumbnailGenerator->discardOldestImages(0);
-            bool moreWork;
-            do {
-                moreWork = thumbnailGenerator->workOnRenderQueue();
-            } while (glfwGetTime() - loopStart < 1.0 / 60 && moreWork);
+            thumbnailGenerator->workOnRenderQueue(1.0 / 60 - (glfwGetTime() - loopStart));
 
             auto after = std::chrono::high_resolution_clock::now();
             lastFrameTimes[lastFrameTimesStartIdx] = static_cast<float>(std::chrono::duration_cast<std::chrono::microseconds>(after - before).count()) / 1000.0f;
@@ -636,10 +642,12 @@ namespace bricksim::controller {
         return backgroundTasks;
     }
 
-    void addBackgroundTask(std::string name, const std::function<void()>& function) {
-        static unsigned int sId = 0;
-        backgroundTasks.emplace(sId, Task(std::move(name), function)).first->second.startThread();
-        ++sId;
+    void addBackgroundTask(std::string name, const std::function<void()>& function, bool ownThread) {
+        backgroundTasks.emplace(nextBackgroundTaskId++, Task(std::move(name), function)).first->second.startThread(thread_pool::Priority::BACKGROUND, ownThread);
+    }
+
+    void addBackgroundTask(std::string name, const std::function<void(float*)>& function, bool ownThread) {
+        backgroundTasks.emplace(nextBackgroundTaskId++, Task(std::move(name), function)).first->second.startThread(thread_pool::Priority::BACKGROUND, ownThread);
     }
 
     std::queue<Task>& getForegroundTasks() {
@@ -674,6 +682,10 @@ namespace bricksim::controller {
         }
     }
 
+    bool isOpenGlInitialized() {
+        return openGlInitialized;
+    }
+
     void toggleTransformGizmoRotationState() {
         //todo implement
     }
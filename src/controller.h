@@ -57,9 +57,13 @@ namespace bricksim::controller {
     snap::Handler& getSnapHandler();
 
     void executeOpenGL(std::function<void()> const& functor);
+    ///@return false before the window is created and after it is destroyed, executeOpenGL throws in that case
+    [[nodiscard]] bool isOpenGlInitialized();
 
     uomap_t<unsigned int, Task>& getBackgroundTasks();
-    void addBackgroundTask(std::string name, const std::function<void()>& function);
+    ///@param ownThread true for tasks which mostly wait for the network, so they don't block the thread pool
+    void addBackgroundTask(std::string name, const std::function<void()>& function, bool ownThread = false);
+    void addBackgroundTask(std::string name, const std::function<void(float*)>& function, bool ownThread = false);
 
     std::queue<Task>& getForegroundTasks();
 
@@ -1,6 +1,7 @@
 #include "db.h"
 #include "palanteer.h"
 #include <SQLiteCpp/Database.h>
+#include <SQLiteCpp/Transaction.h>
 #include <filesystem>
 #include <spdlog/spdlog.h>
 
@@ -8,7 +9,7 @@ namespace bricksim::db {
     namespace {
         std::optional<SQLite::Database> cacheDb;
 
-        constexpr int NEWEST_CACHE_DB_VERSION = 3;
+        constexpr int NEWEST_CACHE_DB_VERSION = 5;
 
         const char* getUpdateScript(const int newVersion) {
             switch (newVersion) {
@@ -28,6 +29,21 @@ namespace bricksim::db {
                         value TEXT NOT NULL
                     );
                     )SQL";
+                case 4:
+                    return R"SQL(
+                    create table "fileFingerprints"
+                    (
+                        path        TEXT PRIMARY KEY COLLATE NOCASE,
+                        fingerprint INTEGER NOT NULL
+                    );
+                    )SQL";
+                case 5:
+                    //the list is filled again at the next start to get the keywords of all files
+                    return R"SQL(
+                    alter table files add column keywords TEXT NOT NULL DEFAULT '';
+                    delete from files;
+                    delete from fileFingerprints;
+                    )SQL";
                 default:
                     return "";
             }
@@ -37,8 +53,8 @@ namespace bricksim::db {
             spdlog::info("Upgrading cache.db3 to version {}", newVersion);
             const char* updateScript = getUpdateScript(newVersion);
             if (std::strlen(updateScript) > 0) {
-                SQLite::Statement updateStatement(cacheDb.value(), updateScript);
-                updateStatement.exec();
+                //exec instead of a SQLite::Statement because a script can contain multiple statements
+                cacheDb.value().exec(updateScript);
             }
             SQLite::Statement stmt(cacheDb.value(), "UPDATE meta SET version=?");
             stmt.bind(1, newVersion);
@@ -232,6 +248,18 @@ namespace bricksim::db {
             return result;
         }
 
+        std::vector<Entry> getAllEntries() {
+            SQLite::Statement stmt(cacheDb.value(), "SELECT name, title, category, keywords FROM files;");
+            std::vector<Entry> result;
+            while (stmt.executeStep()) {
+                result.push_back({stmt.getColumn(0),
+                                  stmt.getColumn(1),
+                                  stmt.getColumn(2),
+                                  stmt.getColumn(3)});
+            }
+            return result;
+        }
+
         oset_t<std::string> getAllPartsForCategory(const std::string& category) {
             SQLite::Statement stmt(cacheDb.value(), "SELECT name FROM files WHERE category=? ORDER BY title;");
             stmt.bind(1, category);
@@ -267,23 +295,28 @@ namespace bricksim::db {
             if (entries.empty()) {
                 return;
             }
-            std::string command = "INSERT INTO files (name, title, category) VALUES ";
+            std::string command = "INSERT INTO files (name, title, category, keywords) VALUES ";
             std::string name;
             std::string title;
             std::string category;
+            std::string keywords;
             for (const auto& entry: entries) {
                 name = entry.name;
                 title = entry.title;
                 category = entry.category;
+                keywords = entry.keywords;
                 escapeSqlStringLiterals(name);
                 escapeSqlStringLiterals(title);
                 escapeSqlStringLiterals(category);
+                escapeSqlStringLiterals(keywords);
                 command += "('";
                 command += name;
                 command += "','";
                 command += title;
                 command += "','";
                 command += category;
+                command += "','";
+                command += keywords;
                 command += "'),";
             }
             command.pop_back();//last comma
@@ -295,6 +328,52 @@ namespace bricksim::db {
         void deleteAllEntries() {
             SQLite::Statement stmt(cacheDb.value(), "DELETE FROM files;");
             stmt.exec();
+            SQLite::Statement fingerprintsStmt(cacheDb.value(), "DELETE FROM fileFingerprints;");
+            fingerprintsStmt.exec();
+        }
+
+        void deleteEntries(const std::vector<std::string>& names) {
+            SQLite::Transaction transaction(cacheDb.value());
+            SQLite::Statement stmt(cacheDb.value(), "DELETE FROM files WHERE name=?;");
+            for (const auto& name: names) {
+                stmt.bind(1, name);
+                stmt.exec();
+                stmt.reset();
+            }
+            transaction.commit();
+        }
+
+        uomap_t<std::string, uint64_t> getAllFingerprints() {
+            SQLite::Statement stmt(cacheDb.value(), "SELECT path, fingerprint FROM fileFingerprints;");
+            uomap_t<std::string, uint64_t> result;
+            while (stmt.executeStep()) {
+                result.emplace(stmt.getColumn(0).getString(), static_cast<uint64_t>(stmt.getColumn(1).getInt64()));
+            }
+            return result;
+        }
+
+        void putFingerprints(const std::vector<std::pair<std::string, uint64_t>>& fingerprints) {
+            SQLite::Transaction transaction(cacheDb.value());
+            SQLite::Statement stmt(cacheDb.value(), "REPLACE INTO fileFingerprints (path, fingerprint) VALUES (?, ?);");
+            for (const auto& [path, fingerprint]: fingerprints) {
+                stmt.bind(1, path);
+                //sqlite has no unsigned integers, the bits are stored as they are
+                stmt.bind(2, static_cast<int64_t>(fingerprint));
+                stmt.exec();
+                stmt.reset();
+            }
+            transaction.commit();
+        }
+
+        void deleteFingerprints(const std::vector<std::string>& paths) {
+            SQLite::Transaction transaction(cacheDb.value());
+            SQLite::Statement stmt(cacheDb.value(), "DELETE FROM fileFingerprints WHERE path=?;");
+            for (const auto& path: paths) {
+                stmt.bind(1, path);
+                stmt.exec();
+                stmt.reset();
+            }
+            transaction.commit();
         }
     }
 
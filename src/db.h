@@ -27,6 +27,8 @@ namespace bricksim::db {
             std::string name;
             std::string title;
             std::string category;
+            ///the keywords and the theme of the file, separated by commas
+            std::string keywords;
         };
 
         int getSize();
@@ -34,10 +36,20 @@ namespace bricksim::db {
         void put(const std::vector<Entry>& entries);
         oset_t<std::string> getAllCategories();
         uoset_t<std::string> getAllFiles();
+        std::vector<Entry> getAllEntries();
         oset_t<std::string> getAllPartsForCategory(const std::string& category);
         std::optional<std::string> containsFile(const std::string& name);
         std::optional<Entry> findFile(const std::string& name);
         void deleteAllEntries();
+        void deleteEntries(const std::vector<std::string>& names);
+
+        /**
+         * the fingerprint (FileRepo::getLibraryFileFingerprint) of every indexed file, the key is the path relative to the library root.
+         * used to find the files which changed since the list was filled
+         */
+        uomap_t<std::string, uint64_t> getAllFingerprints();
+        void putFingerprints(const std::vector<std::pair<std::string, uint64_t>>& fingerprints);
+        void deleteFingerprints(const std::vector<std::string>& paths);
     }
 
     namespace valueCache {
@@ -39,6 +39,7 @@ namespace bricksim {
     }
 
     void Editor::init(const std::shared_ptr<ldr::File>& ldrFile) {
+        ldr::file_repo::get().preloadReferencedFiles(ldrFile);
         rootNode = std::make_shared<etree::RootNode>();
         rootNode->displayName = ldrFile->metaInfo.name;
         editingModel = std::make_shared<etree::ModelNode>(ldrFile, 1, rootNode);
@@ -58,8 +59,6 @@ namespace bricksim {
         camera = std::make_shared<graphics::CadCamera>();
         scene->setCamera(camera);
 
-        connectionEngine.setScene(scene);
-
         if (filePath.has_value()) {
             efsw::WatchID watchId = controller::getFileWatcher()->addWatch(filePath->parent_path().string(), this);
             if (magic_enum::enum_contains<efsw::Error>(static_cast<std::underlying_type_t<efsw::Errors::Error>>(watchId))) {
@@ -400,11 +399,13 @@ namespace bricksim {
     void Editor::hideSelectedElements() {
         for (const auto& item: selectedNodes) {
             item.first->visible = false;
+            item.first->incrementVersion();
         }
     }
 
     void unhideElementRecursively(const std::shared_ptr<etree::Node>& node) {
         node->visible = false;
+        node->incrementVersion();
         for (const auto& child: node->getChildren()) {
             unhideElementRecursively(child);
         }
@@ -473,6 +474,9 @@ namespace bricksim {
             if (filePath.has_value() && fullPath == filePath.value()) {
                 spdlog::info(R"(editor file change detected: {} fullPath="{}" oldFilename="{}")",
                              magic_enum::enum_name(action), fullPath.string(), oldFilename);
+                if (reloadFileIncrementally()) {
+                    return;
+                }
                 rootNode->removeChild(editingModel);//todo check if this works for MPD files (shouldn't all models be deleted?)
                 editingModel = std::make_shared<etree::ModelNode>(ldr::file_repo::get().reloadFile(fileNamespace, filePath->string()), 1, rootNode);
                 editingModelHistory.clear();
@@ -485,6 +489,38 @@ namespace bricksim {
         }
     }
 
+    bool Editor::reloadFileIncrementally() {
+        plFunction();
+        const auto result = ldr::file_repo::get().reloadFileIncrementally(fileNamespace, filePath->filename().string());
+        if (!result.has_value()) {
+            return false;
+        }
+
+        const auto changedMeshes = rootNode->applyFileDiffs(result->changedFiles);
+        const uoset_t<std::shared_ptr<ldr::File>> removedFiles(result->removedFiles.begin(), result->removedFiles.end());
+        rootNode->removeChildIf([this, &removedFiles](const std::shared_ptr<etree::Node>& child) {
+            const auto modelNode = std::dynamic_pointer_cast<etree::ModelNode>(child);
+            return modelNode != nullptr && modelNode != editingModel && removedFiles.contains(modelNode->ldrFile);
+        });
+        if (!changedMeshes.empty()) {
+            mesh::SceneMeshCollection::deleteMeshes(changedMeshes);
+        }
+
+        //nodes of removed lines can't stay selected
+        for (auto it = selectedNodes.begin(); it != selectedNodes.end();) {
+            const auto parent = it->first->parent.lock();
+            if (parent == nullptr || std::find(parent->getChildren().begin(), parent->getChildren().end(), it->first) == parent->getChildren().end()) {
+                it->first->selected = false;
+                it = selectedNodes.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        updateSelectionVisualization();
+        rootNode->incrementVersion();
+        return true;
+    }
+
     void Editor::updateSelectionVisualization() {
         if (selectedNodes.empty()) {
             if (selectionVisualizationNode != nullptr && selectionVisualizationNode->visible) {
@@ -100,6 +100,8 @@ namespace bricksim {
         void handleFileAction(efsw::WatchID watchid, const std::string& dir, const std::string& filename,
                               efsw::Action action, std::string oldFilename) override;
 
+        ///@return false if the file couldn't be reloaded incrementally and has to be reloaded completely
+        bool reloadFileIncrementally();
         void updateSelectionVisualization();
 
         static std::string getNameForNewLdrFile();
@@ -14,28 +14,77 @@
 #endif
 
 namespace bricksim::etree {
+    namespace {
+        /**
+         * @return true if file references one of files directly or through other files of its namespace.
+         * library files can't reference files of a namespace, so they are not searched
+         */
+        bool referencesAnyFile(const std::shared_ptr<ldr::File>& file, const uoset_t<std::shared_ptr<ldr::File>>& files, uomap_t<std::shared_ptr<ldr::File>, bool>& cache) {
+            if (const auto it = cache.find(file); it != cache.end()) {
+                return it->second;
+            }
+            //against reference cycles
+            cache.emplace(file, false);
+            bool result = false;
+            for (const auto& element: file->elements) {
+                if (element->getType() == 1) {
+                    const auto subFile = std::static_pointer_cast<ldr::SubfileReference>(element)->getFile(file);
+                    if (files.contains(subFile) || (subFile->nameSpace != nullptr && referencesAnyFile(subFile, files, cache))) {
+                        result = true;
+                        break;
+                    }
+                }
+            }
+            cache[file] = result;
+            return result;
+        }
+
+        void collectMeshesWithPatchedFiles(const std::shared_ptr<Node>& node, const uoset_t<std::shared_ptr<ldr::File>>& patchedFiles, uomap_t<std::shared_ptr<ldr::File>, bool>& cache, uoset_t<mesh_identifier_t>& changedMeshes) {
+            if (node->getType() == NodeType::TYPE_PART) {
+                const auto partNode = std::static_pointer_cast<PartNode>(node);
+                const auto& file = partNode->ldrFile;
+                if (patchedFiles.contains(file) || (file->nameSpace != nullptr && referencesAnyFile(file, patchedFiles, cache))) {
+                    changedMeshes.insert(partNode->getMeshIdentifier());
+                }
+            } else if (node->getType() == NodeType::TYPE_MODEL) {
+                //only the references without their own node are part of the mesh of a model
+                const auto modelNode = std::static_pointer_cast<ModelNode>(node);
+                for (const auto& element: modelNode->ldrFile->elements) {
+                    if (element->getType() != 1 || element->hidden) {
+                        continue;
+                    }
+                    const auto sfElement = std::static_pointer_cast<ldr::SubfileReference>(element);
+                    if (modelNode->childrenWithOwnNode.contains(sfElement)) {
+                        continue;
+                    }
+                    const auto subFile = sfElement->getFile(modelNode->ldrFile);
+                    if (patchedFiles.contains(subFile) || (subFile->nameSpace != nullptr && referencesAnyFile(subFile, patchedFiles, cache))) {
+                        changedMeshes.insert(modelNode->getMeshIdentifier());
+                        break;
+                    }
+                }
+            }
+            for (const auto& child: node->getChildren()) {
+                collectMeshesWithPatchedFiles(child, patchedFiles, cache, changedMeshes);
+            }
+        }
+    }
+
     const glm::mat4& Node::getRelativeTransformation() const {
         return relativeTransformation;
     }
 
     void Node::setRelativeTransformation(const glm::mat4& newValue) {
         relativeTransformation = newValue;
-        invalidateAbsoluteTransformation();
+        transformTable->setRelative(transformId, newValue);
     }
 
-    void Node::invalidateAbsoluteTransformation() {
-        absoluteTransformationValid = false;
-        for (const auto& child: children) {
-            child->invalidateAbsoluteTransformation();
-        }
+    glm::mat4 Node::getAbsoluteTransformation() const {
+        return transformTable->getAbsolute(transformId);
     }
 
-    const glm::mat4& Node::getAbsoluteTransformation() const {
-        if (!absoluteTransformationValid) {
-            absoluteTransformation = relativeTransformation * parent.lock()->getAbsoluteTransformation();
-            absoluteTransformationValid = true;
-        }
-        return absoluteTransformation;
+    TransformTable& Node::getTransformTable() const {
+        return *transformTable;
     }
 
     NodeType Node::getType() const {
@@ -43,7 +92,9 @@ namespace bricksim::etree {
     }
 
     Node::Node(const std::shared_ptr<Node>& parent) :
-        parent(parent) {
+        parent(parent),
+        transformTable(parent != nullptr ? parent->transformTable : std::make_shared<TransformTable>()),
+        transformId(transformTable->allocate(parent != nullptr ? parent->transformId : TransformTable::NO_ID, relativeTransformation)) {
         type = NodeType::TYPE_OTHER;
     }
 
@@ -76,6 +127,25 @@ namespace bricksim::etree {
         return parentLocked == possibleParent || (parentLocked != nullptr && parentLocked->isChildOf(possibleParent));
     }
 
+    void Node::setParent(const std::shared_ptr<Node>& newParent) {
+        parent = newParent;
+        if (newParent != nullptr && newParent->transformTable != transformTable) {
+            moveToTransformTable(newParent->transformTable, newParent->transformId);
+        } else {
+            transformTable->setParent(transformId, newParent != nullptr ? newParent->transformId : TransformTable::NO_ID);
+        }
+    }
+
+    void Node::moveToTransformTable(const std::shared_ptr<TransformTable>& newTable, TransformTable::id_t parentId) {
+        const auto version = transformTable->getVersion(transformId);
+        transformTable->release(transformId);
+        transformTable = newTable;
+        transformId = transformTable->allocate(parentId, relativeTransformation, version);
+        for (const auto& child: children) {
+            child->moveToTransformTable(newTable, transformId);
+        }
+    }
+
     std::shared_ptr<RootNode> Node::getRoot() {
         const auto parentSp = parent.lock();
         return parentSp == nullptr
@@ -84,15 +154,11 @@ namespace bricksim::etree {
     }
 
     Node::version_t Node::getVersion() const {
-        return version;
+        return transformTable->getVersion(transformId);
     }
 
     void Node::incrementVersion() {
-        Node* node = this;
-        do {
-            ++node->version;
-            node = node->parent.lock().get();
-        } while (node != nullptr);
+        transformTable->incrementVersion(transformId);
         ++selfVersion;
     }
 
@@ -108,7 +174,9 @@ namespace bricksim::etree {
         return selfVersion;
     }
 
-    Node::~Node() = default;
+    Node::~Node() {
+        transformTable->release(transformId);
+    }
 
     bool MeshNode::isColorUserEditable() const {
         return true;
@@ -125,23 +193,23 @@ namespace bricksim::etree {
                     break;
                 case 1:
                 {
-                    auto sfElement = std::dynamic_pointer_cast<ldr::SubfileReference>(element);
+                    auto sfElement = std::static_pointer_cast<ldr::SubfileReference>(element);
                     if (childrenWithOwnNode.find(sfElement) == childrenWithOwnNode.end()) {
                         mesh->addLdrSubfileReference(ldrFile, dummyColor, sfElement, glm::mat4(1.0f), windingInversed, texmap);
                     }
                 }
                 break;
                 case 2:
-                    mesh->addLdrLine(dummyColor, std::dynamic_pointer_cast<ldr::Line>(element), glm::mat4(1.0f));
+                    mesh->addLdrLine(dummyColor, std::static_pointer_cast<ldr::Line>(element), glm::mat4(1.0f));
                     break;
                 case 3:
-                    mesh->addLdrTriangle(dummyColor, std::dynamic_pointer_cast<ldr::Triangle>(element), glm::mat4(1.0f), windingInversed, texmap);
+                    mesh->addLdrTriangle(dummyColor, std::static_pointer_cast<ldr::Triangle>(element), glm::mat4(1.0f), windingInversed, texmap);
                     break;
                 case 4:
-                    mesh->addLdrQuadrilateral(dummyColor, std::dynamic_pointer_cast<ldr::Quadrilateral>(element), glm::mat4(1.0f), windingInversed, texmap);
+                    mesh->addLdrQuadrilateral(dummyColor, std::static_pointer_cast<ldr::Quadrilateral>(element), glm::mat4(1.0f), windingInversed, texmap);
                     break;
                 case 5:
-                    mesh->addLdrOptionalLine(dummyColor, std::dynamic_pointer_cast<ldr::OptionalLine>(element), glm::mat4(1.0f));
+                    mesh->addLdrOptionalLine(dummyColor, std::static_pointer_cast<ldr::OptionalLine>(element), glm::mat4(1.0f));
                     break;
             }
         }
@@ -177,30 +245,106 @@ namespace bricksim::etree {
         plFunction();
         if (!childNodesCreated) {
             for (const auto& element: ldrFile->elements) {
-                if (element->hidden) {
-                    continue;
-                }
-                if (element->getType() == 0) {
-                    const auto texmapStartCommand = dynamic_pointer_cast<ldr::TexmapStartCommand>(element);
-                    if (texmapStartCommand != nullptr) {
-                        children.push_back(std::make_shared<TexmapNode>(ldrFile->nameSpace, texmapStartCommand, shared_from_this()));
-                    }
-                } else if (element->getType() == 1) {
-                    auto sfElement = std::dynamic_pointer_cast<ldr::SubfileReference>(element);
-                    auto subFile = sfElement->getFile(ldrFile);
-
-                    if (subFile->metaInfo.type == ldr::FileType::MPD_SUBFILE || subFile->metaInfo.type == ldr::FileType::MODEL || subFile->metaInfo.type == ldr::FileType::PART) {
-                        const auto newNode = addModelInstanceNode(subFile, sfElement->color);
-                        newNode->setRelativeTransformation(sfElement->getTransformationMatrixT());
-                        subfileRefChildNodeSaveInfos.emplace(newNode, ChildNodeSaveInfo{newNode->getVersion(), element});
-                        childrenWithOwnNode.emplace(sfElement);
-                    }
+                if (!element->hidden) {
+                    createChildNode(element);
                 }
             }
             childNodesCreated = true;
         }
     }
 
+    std::shared_ptr<Node> LdrNode::createChildNode(const std::shared_ptr<ldr::FileElement>& element) {
+        std::shared_ptr<Node> newNode;
+        if (element->getType() == 0) {
+            const auto texmapStartCommand = dynamic_pointer_cast<ldr::TexmapStartCommand>(element);
+            if (texmapStartCommand != nullptr) {
+                newNode = std::make_shared<TexmapNode>(ldrFile->nameSpace, texmapStartCommand, shared_from_this());
+                children.push_back(newNode);
+            }
+        } else if (element->getType() == 1) {
+            auto sfElement = std::static_pointer_cast<ldr::SubfileReference>(element);
+            auto subFile = sfElement->getFile(ldrFile);
+
+            if (subFile->metaInfo.type == ldr::FileType::MPD_SUBFILE || subFile->metaInfo.type == ldr::FileType::MODEL || subFile->metaInfo.type == ldr::FileType::PART) {
+                const auto meshNode = addModelInstanceNode(subFile, sfElement->color);
+                meshNode->setRelativeTransformation(sfElement->getTransformationMatrixT());
+                subfileRefChildNodeSaveInfos.emplace(meshNode, ChildNodeSaveInfo{meshNode->getVersion(), element});
+                childrenWithOwnNode.emplace(sfElement);
+                newNode = meshNode;
+            }
+        }
+        if (newNode != nullptr) {
+            childNodesByElement.emplace(element, newNode);
+        }
+        return newNode;
+    }
+
+    bool LdrNode::applyFileDiff(const ldr::FileDiff& diff) {
+        plFunction();
+        bool meshChanged = false;
+        for (const auto& element: diff.removedElements) {
+            if (const auto it = childNodesByElement.find(element); it != childNodesByElement.end()) {
+                subfileRefChildNodeSaveInfos.erase(it->second);
+                removeChild(it->second);
+                if (element->getType() == 1) {
+                    childrenWithOwnNode.erase(std::static_pointer_cast<ldr::SubfileReference>(element));
+                }
+                childNodesByElement.erase(it);
+            } else if (element->getType() != 0 && !element->hidden) {
+                meshChanged = true;
+            }
+        }
+        for (const auto& element: diff.addedElements) {
+            if (!element->hidden && createChildNode(element) == nullptr && element->getType() != 0) {
+                meshChanged = true;
+            }
+        }
+
+        //the new nodes were appended, but the children should be in the same order as the elements
+        uoset_t<std::shared_ptr<Node>> remainingChildren(children.begin(), children.end());
+        std::vector<std::shared_ptr<Node>> orderedChildren;
+        orderedChildren.reserve(children.size());
+        for (const auto& element: ldrFile->elements) {
+            const auto it = childNodesByElement.find(element);
+            if (it != childNodesByElement.end() && remainingChildren.erase(it->second) > 0) {
+                orderedChildren.push_back(it->second);
+            }
+        }
+        //nodes which don't belong to an element of the file (yet) stay at the end
+        for (const auto& child: children) {
+            if (remainingChildren.contains(child)) {
+                orderedChildren.push_back(child);
+            }
+        }
+        children = std::move(orderedChildren);
+
+        if (diff.metaInfoChanged) {
+            displayName = ldrFile->getDescription();
+        }
+        incrementVersion();
+        return meshChanged;
+    }
+
+    void LdrNode::replaceInvalidatedFiles(const uoset_t<std::shared_ptr<ldr::File>>& invalidatedFiles) {
+        for (const auto& [child, saveInfo]: subfileRefChildNodeSaveInfos) {
+            const auto sfElement = std::static_pointer_cast<ldr::SubfileReference>(saveInfo.ldrElement);
+            if (child->getType() == NodeType::TYPE_PART) {
+                const auto partNode = std::static_pointer_cast<PartNode>(child);
+                if (invalidatedFiles.contains(partNode->ldrFile)) {
+                    partNode->ldrFile = sfElement->getFile(ldrFile);
+                    partNode->displayName = partNode->ldrFile->getDescription();
+                    partNode->incrementVersion();
+                }
+            } else if (child->getType() == NodeType::TYPE_MODEL_INSTANCE) {
+                const auto instanceNode = std::static_pointer_cast<ModelInstanceNode>(child);
+                if (invalidatedFiles.contains(instanceNode->modelNode->ldrFile)) {
+                    instanceNode->modelNode = getRoot()->getModelNode(sfElement->getFile(ldrFile));
+                    instanceNode->incrementVersion();
+                }
+            }
+        }
+    }
+
     std::shared_ptr<MeshNode> LdrNode::addModelInstanceNode(const std::shared_ptr<ldr::File>& subFile, ldr::ColorReference instanceColor) {
         std::shared_ptr<MeshNode> newNode;
         if (subFile->metaInfo.type == ldr::FileType::PART) {
@@ -214,7 +358,7 @@ namespace bricksim::etree {
     }
 
     void LdrNode::writeChangesToLdrFile() {
-        if (version != lastSaveToLdrFileVersion) {
+        if (getVersion() != lastSaveToLdrFileVersion) {
             for (const auto& item: children) {
                 if (item->getType() == NodeType::TYPE_PART || item->getType() == NodeType::TYPE_MODEL_INSTANCE) {
                     auto saveInfos = subfileRefChildNodeSaveInfos.find(item);
@@ -246,10 +390,11 @@ namespace bricksim::etree {
                         subfileRefElement->step = ldrFile->elements.back()->step;
                         ldrFile->elements.push_back(subfileRefElement);
                         subfileRefChildNodeSaveInfos.emplace(item, ChildNodeSaveInfo{item->getVersion(), subfileRefElement});
+                        childNodesByElement.emplace(subfileRefElement, item);
                     }
                 }
             }
-            lastSaveToLdrFileVersion = version;
+            lastSaveToLdrFileVersion = getVersion();
         }
     }
 
@@ -257,8 +402,6 @@ namespace bricksim::etree {
         Node(nullptr) {
         type = NodeType::TYPE_ROOT;
         displayName = "Root";
-        absoluteTransformation = relativeTransformation;
-        absoluteTransformationValid = true;
     }
 
     bool RootNode::isDisplayNameUserEditable() const {
@@ -286,6 +429,47 @@ namespace bricksim::etree {
         return false;
     }
 
+    void RootNode::replaceInvalidatedFiles(const uoset_t<std::shared_ptr<ldr::File>>& invalidatedFiles) {
+        plFunction();
+        //getModelNode can add children
+        const auto modelNodes = children;
+        for (const auto& child: modelNodes) {
+            if (child->getType() == NodeType::TYPE_MODEL) {
+                std::static_pointer_cast<ModelNode>(child)->replaceInvalidatedFiles(invalidatedFiles);
+            }
+        }
+        //the instances use the ModelNodes of the new files now
+        removeChildIf([&invalidatedFiles](const std::shared_ptr<Node>& child) {
+            return child->getType() == NodeType::TYPE_MODEL && invalidatedFiles.contains(std::static_pointer_cast<ModelNode>(child)->ldrFile);
+        });
+        incrementVersion();
+    }
+
+    uoset_t<mesh_identifier_t> RootNode::applyFileDiffs(const std::vector<ldr::FileDiff>& diffs) {
+        plFunction();
+        uoset_t<std::shared_ptr<ldr::File>> patchedFiles;
+        uoset_t<mesh_identifier_t> changedMeshes;
+        for (const auto& diff: diffs) {
+            patchedFiles.insert(diff.file);
+            //applyFileDiff can add ModelNodes for new instances
+            const auto modelNodes = children;
+            for (const auto& child: modelNodes) {
+                if (child->getType() == NodeType::TYPE_MODEL) {
+                    const auto modelNode = std::static_pointer_cast<ModelNode>(child);
+                    if (modelNode->ldrFile == diff.file && modelNode->applyFileDiff(diff)) {
+                        changedMeshes.insert(modelNode->getMeshIdentifier());
+                    }
+                }
+            }
+        }
+        //PartNodes of patched MPD subfiles and models which contain patched subparts don't get a diff, but their mesh is outdated too
+        uomap_t<std::shared_ptr<ldr::File>, bool> referencesPatchedFileCache;
+        for (const auto& child: children) {
+            collectMeshesWithPatchedFiles(child, patchedFiles, referencesPatchedFileCache, changedMeshes);
+        }
+        return changedMeshes;
+    }
+
     mesh_identifier_t ModelInstanceNode::getMeshIdentifier() const {
         return modelNode->getMeshIdentifier();
     }
@@ -5,6 +5,8 @@
 #include "graphics/mesh/mesh.h"
 #include "helpers/color.h"
 #include "ldr/colors.h"
+#include "ldr/file_diff.h"
+#include "transform_table.h"
 #include <memory>
 
 namespace bricksim::etree {
@@ -39,7 +41,9 @@ namespace bricksim::etree {
 
         [[nodiscard]] const glm::mat4& getRelativeTransformation() const;
         void setRelativeTransformation(const glm::mat4& newValue);
-        const glm::mat4& getAbsoluteTransformation() const;
+        [[nodiscard]] glm::mat4 getAbsoluteTransformation() const;
+        ///the table is shared by all nodes of the tree
+        [[nodiscard]] TransformTable& getTransformTable() const;
         [[nodiscard]] virtual bool isTransformationUserEditable() const;
 
         NodeType getType() const;
@@ -51,6 +55,8 @@ namespace bricksim::etree {
         void addChild(const std::shared_ptr<Node>& newChild);
         void addChild(std::vector<std::shared_ptr<Node>>::difference_type position, const std::shared_ptr<Node>& newChild);
         bool isChildOf(const std::shared_ptr<Node>& possibleParent) const;
+        ///moves this node and its subtree into the TransformTable of newParent. doesn't add this to the children of newParent
+        void setParent(const std::shared_ptr<Node>& newParent);
         void removeChild(const std::shared_ptr<Node>& childToDelete);
         void removeChildIf(std::function<bool(const std::shared_ptr<Node>&)> predicate);
         virtual bool isDirectChildOfTypeAllowed(NodeType potentialChildType) const;
@@ -66,12 +72,13 @@ namespace bricksim::etree {
     protected:
         std::vector<std::shared_ptr<Node>> children;
         glm::mat4 relativeTransformation = glm::mat4(1.0f);
-        mutable glm::mat4 absoluteTransformation;
-        mutable bool absoluteTransformationValid = false;
-        version_t version = 0;
+        ///the absolute transformation and the version are stored in here
+        std::shared_ptr<TransformTable> transformTable;
+        TransformTable::id_t transformId;
         version_t selfVersion = 0;
 
-        void invalidateAbsoluteTransformation();
+    private:
+        void moveToTransformTable(const std::shared_ptr<TransformTable>& newTable, TransformTable::id_t parentId);
     };
 
     class ModelNode;
@@ -84,6 +91,17 @@ namespace bricksim::etree {
         bool isDirectChildOfTypeAllowed(NodeType type) const override;
         std::shared_ptr<ModelNode> getModelNode(const std::shared_ptr<ldr::File>& ldrFile);
         bool isTransformationUserEditable() const override;
+        /**
+         * lets the nodes which use one of invalidatedFiles use the current version of the file from the file repo.
+         * the nodes stay the same objects, ModelNodes of invalidated files are replaced.
+         * call this after FileRepo::invalidateLibraryFiles and before the meshes of the files are deleted
+         */
+        void replaceInvalidatedFiles(const uoset_t<std::shared_ptr<ldr::File>>& invalidatedFiles);
+        /**
+         * applies the diffs from FileRepo::reloadFileIncrementally to the ModelNodes of the patched files.
+         * @return the mesh identifiers of all nodes whose mesh contains a patched file, including PartNodes of MPD subfiles
+         */
+        uoset_t<mesh_identifier_t> applyFileDiffs(const std::vector<ldr::FileDiff>& diffs);
     };
 
     class MeshNode : public Node {
@@ -126,9 +144,21 @@ namespace bricksim::etree {
          */
         std::shared_ptr<MeshNode> addModelInstanceNode(const std::shared_ptr<ldr::File>& subFile, ldr::ColorReference instanceColor);
         void writeChangesToLdrFile();
+        /**
+         * updates the child nodes after ldrFile was changed by ldr::patchFile.
+         * only the nodes of removed elements are deleted and only the added elements get new nodes, all other nodes stay as they are
+         * @return true if the mesh of this node has to be rebuilt because an element without its own node changed
+         */
+        bool applyFileDiff(const ldr::FileDiff& diff);
+        ///resolves the files of the child nodes which use one of invalidatedFiles again
+        void replaceInvalidatedFiles(const uoset_t<std::shared_ptr<ldr::File>>& invalidatedFiles);
 
     private:
         bool childNodesCreated = false;
+        uomap_t<std::shared_ptr<ldr::FileElement>, std::shared_ptr<Node>> childNodesByElement;
+
+        ///@return the new child node or nullptr if the element doesn't get its own node
+        std::shared_ptr<Node> createChildNode(const std::shared_ptr<ldr::FileElement>& element);
 
         struct ChildNodeSaveInfo {
             uint64_t lastSaveToLdrFileVersion = 0;
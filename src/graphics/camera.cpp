@@ -169,6 +169,10 @@ namespace bricksim::graphics {
     void FitContentCamera::setRootNode(const std::shared_ptr<etree::MeshNode>& node) {
         std::vector<glm::vec3> points;
         collectPoints(points, node, glm::mat4(1.f));
+        fitPoints(points);
+    }
+
+    void FitContentCamera::fitPoints(const std::vector<glm::vec3>& points) {
         Seb::Smallest_enclosing_ball<float, glm::vec3> seb(3, points);
 
         const auto center = seb.center_begin();
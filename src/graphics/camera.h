@@ -55,6 +55,11 @@ namespace bricksim::graphics {
     class FitContentCamera : public Camera {
     public:
         void setRootNode(const std::shared_ptr<etree::MeshNode>& node);
+        /**
+         * looks at the minimal enclosing ball of points from the same direction as setRootNode
+         * @param points in LDU
+         */
+        void fitPoints(const std::vector<glm::vec3>& points);
         [[nodiscard]] const glm::mat4& getViewMatrix() const override;
         [[nodiscard]] const glm::vec3& getCameraPos() const override;
         [[nodiscard]] const glm::vec3& getTargetPos() const override;
@@ -0,0 +1,261 @@
+#include "flattened_geometry.h"
+#include "../../helpers/geometry.h"
+#include "../../metrics.h"
+#include <array>
+#include <glm/gtx/normal.hpp>
+#include <mutex>
+#include <palanteer.h>
+
+namespace bricksim::mesh {
+    namespace {
+        bool isFlattenable(const std::shared_ptr<ldr::File>& file) {
+            return file->metaInfo.type != ldr::FileType::MODEL && file->metaInfo.type != ldr::FileType::MPD_SUBFILE;
+        }
+
+        ldr::ColorReference resolveColor(const ldr::ColorReference color, const ldr::ColorReference mainColor) {
+            return color.code == ldr::Color::MAIN_COLOR_CODE ? mainColor : color;
+        }
+
+        void addTriangle(FlattenedGeometry& geometry, const std::shared_ptr<ldr::Triangle>& triangle, bool windingInversed) {
+            auto p1 = glm::vec3(triangle->x1(), triangle->y1(), triangle->z1());
+            auto p2 = glm::vec3(triangle->x2(), triangle->y2(), triangle->z2());
+            auto p3 = glm::vec3(triangle->x3(), triangle->y3(), triangle->z3());
+            const auto normal = glm::triangleNormal(p1, p2, p3);
+            if (windingInversed) {
+                std::swap(p2, p3);
+            }
+            auto& group = geometry.getTriangleGroup(triangle->color);
+            const auto idx = static_cast<unsigned int>(group.vertices.size());
+            group.vertices.emplace_back(p1, normal);
+            group.vertices.emplace_back(p2, normal);
+            group.vertices.emplace_back(p3, normal);
+            group.indices.insert(group.indices.end(), {idx, idx + 1, idx + 2});
+        }
+
+        void addQuadrilateral(FlattenedGeometry& geometry, const std::shared_ptr<ldr::Quadrilateral>& quadrilateral, bool windingInversed) {
+            auto p1 = glm::vec3(quadrilateral->x1(), quadrilateral->y1(), quadrilateral->z1());
+            auto p2 = glm::vec3(quadrilateral->x2(), quadrilateral->y2(), quadrilateral->z2());
+            auto p3 = glm::vec3(quadrilateral->x3(), quadrilateral->y3(), quadrilateral->z3());
+            auto p4 = glm::vec3(quadrilateral->x4(), quadrilateral->y4(), quadrilateral->z4());
+            const auto normal = glm::triangleNormal(p1, p2, p3);
+            if (windingInversed) {
+                std::swap(p2, p4);
+            }
+            auto& group = geometry.getTriangleGroup(quadrilateral->color);
+            const auto idx = static_cast<unsigned int>(group.vertices.size());
+            group.vertices.emplace_back(p1, normal);
+            group.vertices.emplace_back(p2, normal);
+            group.vertices.emplace_back(p3, normal);
+            group.vertices.emplace_back(p4, normal);
+            group.indices.insert(group.indices.end(), {idx, idx + 1, idx + 2, idx + 2, idx + 3, idx});
+        }
+
+        void addLine(std::vector<FlattenedGeometry::LineGroup>& groups, const ldr::ColorReference color, const float* coords, const std::size_t pointCount) {
+            auto& group = color.code == ldr::Color::LINE_COLOR_CODE
+                                  ? FlattenedGeometry::getLineGroup(groups, ldr::Color::MAIN_COLOR_CODE, true)
+                                  : FlattenedGeometry::getLineGroup(groups, color, false);
+            for (std::size_t i = 0; i < pointCount; ++i) {
+                group.positions.emplace_back(coords[3 * i], coords[3 * i + 1], coords[3 * i + 2]);
+            }
+        }
+
+        std::shared_ptr<FlattenedGeometry> build(const std::shared_ptr<ldr::File>& file, bool windingInversed) {
+            auto result = std::make_shared<FlattenedGeometry>();
+            for (const auto& element: file->elements) {
+                if (element->hidden) {
+                    continue;
+                }
+                if (element->directTexmap != nullptr) {
+                    return nullptr;
+                }
+                switch (element->getType()) {
+                    case 1: {
+                        const auto sfElement = std::static_pointer_cast<ldr::SubfileReference>(element);
+                        const auto subFile = sfElement->getFile(file);
+                        if (subFile == nullptr) {
+                            return nullptr;
+                        }
+                        const auto subTransformation = sfElement->getTransformationMatrixT();
+                        const bool subWindingInversed = windingInversed ^ sfElement->bfcInverted ^ geometry::doesTransformationInverseWindingOrder(subTransformation);
+                        const auto subGeometry = flattened_geometry_cache::get(subFile, subWindingInversed);
+                        if (subGeometry == nullptr) {
+                            return nullptr;
+                        }
+                        result->append(*subGeometry, sfElement->color, subTransformation);
+                        break;
+                    }
+                    case 2: {
+                        const auto line = std::static_pointer_cast<ldr::Line>(element);
+                        addLine(result->lineGroups, line->color, line->coords.data(), 2);
+                        break;
+                    }
+                    case 3:
+                        addTriangle(*result, std::static_pointer_cast<ldr::Triangle>(element), windingInversed);
+                        break;
+                    case 4:
+                        addQuadrilateral(*result, std::static_pointer_cast<ldr::Quadrilateral>(element), windingInversed);
+                        break;
+                    case 5: {
+                        const auto optionalLine = std::static_pointer_cast<ldr::OptionalLine>(element);
+                        //same order as in Mesh::addLdrOptionalLine: control point 1, line, control point 2
+                        const std::array<float, 12> coords = {
+                                optionalLine->controlX1(), optionalLine->controlY1(), optionalLine->controlZ1(),
+                                optionalLine->x1(), optionalLine->y1(), optionalLine->z1(),
+                                optionalLine->x2(), optionalLine->y2(), optionalLine->z2(),
+                                optionalLine->controlX2(), optionalLine->controlY2(), optionalLine->controlZ2(),
+                        };
+                        addLine(result->optionalLineGroups, optionalLine->color, coords.data(), 4);
+                        break;
+                    }
+                    default:
+                        break;
+                }
+            }
+            return result;
+        }
+
+        struct CacheEntry {
+            std::weak_ptr<ldr::File> file;
+            std::shared_ptr<const FlattenedGeometry> geometry;
+        };
+
+        std::mutex cacheMtx;
+        ///index 0: normal winding, index 1: inversed winding
+        std::array<uomap_t<const ldr::File*, CacheEntry>, 2> cache;
+    }
+
+    FlattenedGeometry::TriangleGroup& FlattenedGeometry::getTriangleGroup(const ldr::ColorReference color) {
+        for (auto& group: triangleGroups) {
+            if (group.color == color) {
+                return group;
+            }
+        }
+        triangleGroups.push_back({color, {}, {}});
+        return triangleGroups.back();
+    }
+
+    FlattenedGeometry::LineGroup& FlattenedGeometry::getLineGroup(std::vector<LineGroup>& groups, const ldr::ColorReference color, const bool complement) {
+        for (auto& group: groups) {
+            if (group.color == color && group.complement == complement) {
+                return group;
+            }
+        }
+        groups.push_back({color, complement, {}});
+        return groups.back();
+    }
+
+    void FlattenedGeometry::append(const FlattenedGeometry& other, const ldr::ColorReference mainColor, const glm::mat4& transformation) {
+        for (const auto& otherGroup: other.triangleGroups) {
+            auto& group = getTriangleGroup(resolveColor(otherGroup.color, mainColor));
+            const auto baseIndex = static_cast<unsigned int>(group.vertices.size());
+            group.vertices.resize(baseIndex + otherGroup.vertices.size(), {{}, {}});
+            transformTriangleVertices(otherGroup.vertices.data(), group.vertices.data() + baseIndex, otherGroup.vertices.size(), transformation);
+            group.indices.reserve(group.indices.size() + otherGroup.indices.size());
+            for (const auto idx: otherGroup.indices) {
+                group.indices.push_back(baseIndex + idx);
+            }
+        }
+        for (auto [groups, otherGroups]: {std::pair{&lineGroups, &other.lineGroups}, std::pair{&optionalLineGroups, &other.optionalLineGroups}}) {
+            for (const auto& otherGroup: *otherGroups) {
+                auto& group = getLineGroup(*groups, resolveColor(otherGroup.color, mainColor), otherGroup.complement);
+                const auto oldSize = group.positions.size();
+                group.positions.resize(oldSize + otherGroup.positions.size());
+                transformPositions(otherGroup.positions.data(), group.positions.data() + oldSize, otherGroup.positions.size(), transformation);
+            }
+        }
+    }
+
+    std::size_t FlattenedGeometry::getMemoryUsage() const {
+        std::size_t result = sizeof(FlattenedGeometry);
+        for (const auto& group: triangleGroups) {
+            result += sizeof(TriangleGroup) + group.vertices.capacity() * sizeof(TriangleVertex) + group.indices.capacity() * sizeof(unsigned int);
+        }
+        for (const auto& group: lineGroups) {
+            result += sizeof(LineGroup) + group.positions.capacity() * sizeof(glm::vec3);
+        }
+        for (const auto& group: optionalLineGroups) {
+            result += sizeof(LineGroup) + group.positions.capacity() * sizeof(glm::vec3);
+        }
+        return result;
+    }
+
+    namespace flattened_geometry_cache {
+        std::shared_ptr<const FlattenedGeometry> get(const std::shared_ptr<ldr::File>& file, bool windingInversed) {
+            if (!isFlattenable(file)) {
+                return nullptr;
+            }
+            auto& map = cache[windingInversed ? 1 : 0];
+            {
+                std::scoped_lock<std::mutex> lg(cacheMtx);
+                const auto it = map.find(file.get());
+                //the address can be reused by another file after the cached one was deleted
+                if (it != map.end() && it->second.file.lock() == file) {
+                    return it->second.geometry;
+                }
+            }
+
+            //not holding the lock while building because the geometry of the subfiles is requested recursively
+            plFunction();
+            std::shared_ptr<const FlattenedGeometry> geometry = build(file, windingInversed);
+            std::scoped_lock<std::mutex> lg(cacheMtx);
+            auto& entry = map[file.get()];
+            if (entry.geometry != nullptr) {
+                metrics::flattenedGeometryCacheBytes -= entry.geometry->getMemoryUsage();
+            }
+            if (geometry != nullptr) {
+                metrics::flattenedGeometryCacheBytes += geometry->getMemoryUsage();
+            }
+            entry.file = file;
+            entry.geometry = geometry;
+            return geometry;
+        }
+
+        void clear() {
+            std::scoped_lock<std::mutex> lg(cacheMtx);
+            for (auto& map: cache) {
+                map.clear();
+            }
+            metrics::flattenedGeometryCacheBytes = 0;
+        }
+
+        std::size_t getEntryCount() {
+            std::scoped_lock<std::mutex> lg(cacheMtx);
+            return cache[0].size() + cache[1].size();
+        }
+    }
+
+    void transformPositions(const glm::vec3* in, glm::vec3* out, const std::size_t count, const glm::mat4& transformation) {
+        //vec4 * mat4 is a dot product with each column. the columns are copied into locals so that
+        //the compiler can keep them in registers and vectorize the loop
+        const glm::vec4 c0 = transformation[0];
+        const glm::vec4 c1 = transformation[1];
+        const glm::vec4 c2 = transformation[2];
+        for (std::size_t i = 0; i < count; ++i) {
+            const glm::vec3 p = in[i];
+            out[i] = {
+                    p.x * c0.x + p.y * c0.y + p.z * c0.z + c0.w,
+                    p.x * c1.x + p.y * c1.y + p.z * c1.z + c1.w,
+                    p.x * c2.x + p.y * c2.y + p.z * c2.z + c2.w,
+            };
+        }
+    }
+
+    void transformTriangleVertices(const TriangleVertex* in, TriangleVertex* out, const std::size_t count, const glm::mat4& transformation) {
+        const glm::vec4 c0 = transformation[0];
+        const glm::vec4 c1 = transformation[1];
+        const glm::vec4 c2 = transformation[2];
+        for (std::size_t i = 0; i < count; ++i) {
+            const glm::vec3 p = in[i].position;
+            const glm::vec3 n = in[i].normal;
+            out[i].position = {
+                    p.x * c0.x + p.y * c0.y + p.z * c0.z + c0.w,
+                    p.x * c1.x + p.y * c1.y + p.z * c1.z + c1.w,
+                    p.x * c2.x + p.y * c2.y + p.z * c2.z + c2.w,
+            };
+            out[i].normal = glm::normalize(glm::vec3(
+                    n.x * c0.x + n.y * c0.y + n.z * c0.z,
+                    n.x * c1.x + n.y * c1.y + n.z * c1.z,
+                    n.x * c2.x + n.y * c2.y + n.z * c2.z));
+        }
+    }
+}
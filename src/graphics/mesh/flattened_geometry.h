@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../../ldr/files.h"
+#include "mesh_simple_classes.h"
+#include <memory>
+#include <vector>
+
+namespace bricksim::mesh {
+    /**
+     * All triangles and lines of a file including the ones of its subfiles, already transformed into the coordinate system of the file
+     * and already in the final winding order.
+     * Colors which depend on the main color of the caller (16 and 24) are kept as placeholders and resolved when the geometry is used.
+     */
+    struct FlattenedGeometry {
+        struct TriangleGroup {
+            ///MAIN_COLOR_CODE means the main color of the caller
+            ldr::ColorReference color;
+            std::vector<TriangleVertex> vertices;
+            std::vector<unsigned int> indices;
+        };
+
+        struct LineGroup {
+            ///MAIN_COLOR_CODE means the main color of the caller
+            ldr::ColorReference color;
+            ///false: the edge color of color is used, true: the color is calculated from the value of color (LINE_COLOR_CODE)
+            bool complement;
+            std::vector<glm::vec3> positions;
+        };
+
+        std::vector<TriangleGroup> triangleGroups;
+        std::vector<LineGroup> lineGroups;
+        std::vector<LineGroup> optionalLineGroups;
+
+        TriangleGroup& getTriangleGroup(ldr::ColorReference color);
+        static LineGroup& getLineGroup(std::vector<LineGroup>& groups, ldr::ColorReference color, bool complement);
+
+        /**
+         * appends other transformed by transformation. groups of other with the main color get the color mainColor
+         */
+        void append(const FlattenedGeometry& other, ldr::ColorReference mainColor, const glm::mat4& transformation);
+
+        [[nodiscard]] std::size_t getMemoryUsage() const;
+    };
+
+    namespace flattened_geometry_cache {
+        /**
+         * The geometry is built once per file and winding order, higher level files compose it from the geometry of their subfiles.
+         * Only library files are cached because their content doesn't change while they are in memory.
+         * @return nullptr if the geometry of file can't be flattened, for example because it is a model or uses texmaps
+         */
+        std::shared_ptr<const FlattenedGeometry> get(const std::shared_ptr<ldr::File>& file, bool windingInversed);
+        void clear();
+        std::size_t getEntryCount();
+    }
+
+    /**
+     * out[i] = glm::vec4(in[i], 1.0f) * transformation
+     */
+    void transformPositions(const glm::vec3* in, glm::vec3* out, std::size_t count, const glm::mat4& transformation);
+    /**
+     * like transformPositions, the normals are transformed with out[i].normal = glm::normalize(glm::vec4(in[i].normal, 0.0f) * transformation)
+     */
+    void transformTriangleVertices(const TriangleVertex* in, TriangleVertex* out, std::size_t count, const glm::mat4& transformation);
+}
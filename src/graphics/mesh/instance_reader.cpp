@@ -0,0 +1,234 @@
+#include "instance_reader.h"
+#include "../../helpers/geometry.h"
+#include "../texmap_projection.h"
+#include "mesh_collection.h"
+#include <algorithm>
+#include <palanteer.h>
+
+namespace bricksim::mesh {
+    InstanceReader::InstanceReader(scene_id_t scene) :
+        scene(scene) {}
+
+    std::vector<mesh_key_t> InstanceReader::read(const std::shared_ptr<etree::Node>& rootNode) {
+        plFunction();
+        std::swap(records, lastRecords);
+        std::swap(elementsSortedById, lastElementsSortedById);
+        records.clear();
+        elementsSortedById.clear();
+        elementsSortedById.push_back(nullptr);
+        lastReadStats = {};
+        ++readId;
+
+        const Offsets rootBegin{0, 1};
+        const OldPosition oldRoot{rootBegin, readId - 1};
+        readNode(rootNode, nullptr, glm::mat4(1.0f), std::nullopt, std::nullopt, nullptr, &oldRoot, rootBegin, true);
+        lastRecords.clear();
+        lastElementsSortedById.clear();
+
+        uomap_t<mesh_key_t, MeshInstances> newMeshInstances;
+        newMeshInstances.reserve(meshInstances.size());
+        layersInUse.clear();
+        for (auto& record: records) {
+            record.instance.selected = record.meshNode->selected;
+            layersInUse.emplace(record.instance.layer);
+            auto& group = newMeshInstances[record.meshKey];
+            if (group.node == nullptr) {
+                group.node = std::static_pointer_cast<etree::MeshNode>(record.meshNode->shared_from_this());
+                group.texmap = record.texmap;
+            }
+            group.instances.push_back(record.instance);
+        }
+
+        std::vector<mesh_key_t> changedMeshKeys;
+        for (auto& [meshKey, group]: newMeshInstances) {
+            std::stable_sort(group.instances.begin(), group.instances.end(), [](const auto& a, const auto& b) {
+                return a.layer > b.layer;
+            });
+            const auto oldIt = meshInstances.find(meshKey);
+            if (oldIt == meshInstances.end() || oldIt->second.instances != group.instances) {
+                changedMeshKeys.push_back(meshKey);
+            }
+        }
+        for (const auto& [meshKey, group]: meshInstances) {
+            if (!newMeshInstances.contains(meshKey)) {
+                changedMeshKeys.push_back(meshKey);
+            }
+        }
+        meshInstances = std::move(newMeshInstances);
+
+        if (subtreeCache.size() > 2 * (elementsSortedById.size() + 1024)) {
+            removeExpiredCacheEntries();
+        }
+        return changedMeshKeys;
+    }
+
+    bool InstanceReader::readNode(const std::shared_ptr<etree::Node>& node,
+                                  const etree::Node* parent,
+                                  const glm::mat4& parentAbsoluteTransformation,
+                                  std::optional<ldr::ColorReference> parentColor,
+                                  std::optional<unsigned int> selectionTargetElementId,
+                                  const std::shared_ptr<ldr::TexmapStartCommand>& parentTexmap,
+                                  const OldPosition* oldParent,
+                                  const Offsets& newParentBegin,
+                                  bool cacheable) {
+        const Offsets newBegin{records.size(), elementsSortedById.size()};
+        std::optional<OldPosition> oldPosition;
+        if (cacheable && oldParent != nullptr) {
+            const auto it = subtreeCache.find(node.get());
+            //the entry is only usable if it was written while the last records of the parent were calculated
+            if (it != subtreeCache.end()
+                && it->second.parent == parent
+                && it->second.writtenReadId == oldParent->calculatedReadId
+                && it->second.node.lock() == node) {
+                auto& entry = it->second;
+                oldPosition = OldPosition{{oldParent->begin.record + entry.offset.record, oldParent->begin.element + entry.offset.element}, entry.calculatedReadId};
+                if (entry.copyable
+                    && parentTexmap == nullptr
+                    && entry.version == node->getVersion()
+                    && entry.parentColor == parentColor
+                    && entry.parentAbsoluteTransformation == parentAbsoluteTransformation) {
+                    copyFromLastRead(oldPosition->begin, entry.count);
+                    entry.offset = {newBegin.record - newParentBegin.record, newBegin.element - newParentBegin.element};
+                    entry.writtenReadId = readId;
+                    return false;
+                }
+            }
+        }
+
+        bool containsUncopyable = parentTexmap != nullptr;
+        std::shared_ptr<etree::Node> nodeToParseChildren = node;
+        glm::mat4 absoluteTransformation = parentAbsoluteTransformation * node->getRelativeTransformation();
+        std::shared_ptr<ldr::TexmapStartCommand> texmap = parentTexmap != nullptr ? graphics::texmap_projection::transformTexmapStartCommand(parentTexmap, node->getRelativeTransformation()) : nullptr;
+        if (node->visible) {
+            if ((static_cast<uint32_t>(node->getType()) & static_cast<uint32_t>(etree::NodeType::TYPE_MESH)) > 0) {
+                std::shared_ptr<etree::MeshNode> meshNode;
+                ldr::ColorReference color;
+                std::shared_ptr<etree::MeshNode> nodeToGetColorFrom;
+                if (node->getType() == etree::NodeType::TYPE_MODEL_INSTANCE) {
+                    const auto instanceNode = std::dynamic_pointer_cast<etree::ModelInstanceNode>(node);
+                    meshNode = instanceNode->modelNode;
+                    absoluteTransformation = instanceNode->getRelativeTransformation() * parentAbsoluteTransformation;
+                    nodeToGetColorFrom = instanceNode;
+                    nodeToParseChildren = meshNode;
+                    containsUncopyable = true;
+                    cacheable = false;
+                } else {
+                    meshNode = std::dynamic_pointer_cast<etree::MeshNode>(node);
+                    absoluteTransformation = node->getRelativeTransformation() * parentAbsoluteTransformation;
+                    nodeToGetColorFrom = meshNode;
+                }
+                if (nodeToGetColorFrom->getElementColor().get()->code == ldr::Color::MAIN_COLOR_CODE && parentColor.has_value()) {
+                    color = parentColor.value();
+                } else {
+                    color = nodeToGetColorFrom->getDisplayColor();
+                }
+
+                if (meshNode->getDirectTexmap() != nullptr) {
+                    texmap = meshNode->getDirectTexmap();
+                }
+                if (texmap != nullptr) {
+                    texmap = graphics::texmap_projection::transformTexmapStartCommand(texmap, glm::transpose(node->getRelativeTransformation()));
+                    containsUncopyable = true;
+                }
+
+                if (node->getType() == etree::NodeType::TYPE_MODEL_INSTANCE) {
+                    parentColor = color;
+                }
+
+                const auto meshKey = SceneMeshCollection::getMeshKey(meshNode, geometry::doesTransformationInverseWindingOrder(absoluteTransformation), texmap);
+                unsigned int elementId;
+                if (selectionTargetElementId.has_value()) {
+                    elementId = selectionTargetElementId.value();
+                } else {
+                    elementId = static_cast<unsigned int>(elementsSortedById.size());
+                    if (node->getType() == etree::NodeType::TYPE_MODEL_INSTANCE) {
+                        selectionTargetElementId = elementId;//for the children
+                    }
+                }
+                elementsSortedById.push_back(node);
+                records.push_back({
+                        meshKey,
+                        meshNode.get(),
+                        texmap,
+                        MeshInstance{color, absoluteTransformation, elementId, meshNode->selected, node->layer, scene},
+                });
+                ++lastReadStats.recalculatedInstances;
+            }
+            const OldPosition* oldPositionPtr = oldPosition.has_value() ? &oldPosition.value() : nullptr;
+            for (const auto& child: nodeToParseChildren->getChildren()) {
+                if (child->visible) {
+                    containsUncopyable |= readNode(child, nodeToParseChildren.get(), absoluteTransformation, parentColor, selectionTargetElementId, texmap, oldPositionPtr, newBegin, cacheable);
+                }
+            }
+        }
+
+        if (cacheable) {
+            //not using a reference from the lookup above because the recursive calls can insert entries
+            subtreeCache[node.get()] = SubtreeCacheEntry{
+                    node,
+                    parent,
+                    node->getVersion(),
+                    parentAbsoluteTransformation,
+                    parentColor,
+                    !containsUncopyable,
+                    {newBegin.record - newParentBegin.record, newBegin.element - newParentBegin.element},
+                    {records.size() - newBegin.record, elementsSortedById.size() - newBegin.element},
+                    readId,
+                    readId,
+            };
+        }
+        return containsUncopyable;
+    }
+
+    void InstanceReader::copyFromLastRead(const Offsets& oldBegin, const Offsets& count) {
+        //copyable subtrees don't contain model instances, so all element ids of the records are inside of the subtree
+        const auto newElementBegin = static_cast<unsigned int>(elementsSortedById.size());
+        const auto oldElementBegin = static_cast<unsigned int>(oldBegin.element);
+        const auto recordsBegin = lastRecords.cbegin() + static_cast<std::ptrdiff_t>(oldBegin.record);
+        const auto firstNewRecord = records.insert(records.end(), recordsBegin, recordsBegin + static_cast<std::ptrdiff_t>(count.record));
+        for (auto it = firstNewRecord; it != records.end(); ++it) {
+            it->instance.elementId = it->instance.elementId - oldElementBegin + newElementBegin;
+        }
+        const auto elementsBegin = lastElementsSortedById.cbegin() + static_cast<std::ptrdiff_t>(oldBegin.element);
+        elementsSortedById.insert(elementsSortedById.end(), elementsBegin, elementsBegin + static_cast<std::ptrdiff_t>(count.element));
+        lastReadStats.copiedInstances += count.record;
+    }
+
+    void InstanceReader::removeExpiredCacheEntries() {
+        std::vector<const etree::Node*> expired;
+        for (const auto& [node, entry]: subtreeCache) {
+            if (entry.node.expired()) {
+                expired.push_back(node);
+            }
+        }
+        for (const auto* node: expired) {
+            subtreeCache.erase(node);
+        }
+    }
+
+    void InstanceReader::clear() {
+        records.clear();
+        lastRecords.clear();
+        elementsSortedById.clear();
+        lastElementsSortedById.clear();
+        subtreeCache.clear();
+        meshInstances.clear();
+        layersInUse.clear();
+    }
+
+    const uomap_t<mesh_key_t, InstanceReader::MeshInstances>& InstanceReader::getMeshInstances() const {
+        return meshInstances;
+    }
+
+    const std::vector<std::shared_ptr<etree::Node>>& InstanceReader::getElementsSortedById() const {
+        return elementsSortedById;
+    }
+
+    const oset_t<layer_t>& InstanceReader::getLayersInUse() const {
+        return layersInUse;
+    }
+
+    const InstanceReader::ReadStats& InstanceReader::getLastReadStats() const {
+        return lastReadStats;
+    }
+}
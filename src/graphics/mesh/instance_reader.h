@@ -0,0 +1,135 @@
+#pragma once
+
+#include "../../element_tree.h"
+#include "../../helpers/util.h"
+#include "mesh_simple_classes.h"
+#include <optional>
+#include <vector>
+
+namespace bricksim::mesh {
+    struct mesh_key_t {
+        mesh_identifier_t meshIdentifier;
+        bool windingInversed;
+        size_t texmapHash;
+        bool operator==(const mesh_key_t& rhs) const = default;
+    };
+}
+
+namespace std {
+    template<>
+    struct hash<bricksim::mesh::mesh_key_t> {
+        std::size_t operator()(bricksim::mesh::mesh_key_t value) const {
+            return bricksim::util::combinedHash(value.meshIdentifier, value.windingInversed, value.texmapHash);
+        }
+    };
+}
+
+namespace bricksim::mesh {
+    /**
+     * collects the mesh instances of an element tree.
+     * subtrees whose version, transformation and color didn't change since the last read are not walked again,
+     * their instances are copied from the result of the last read instead.
+     * model instances are always read again because the version of a ModelInstanceNode doesn't change when its ModelNode is edited.
+     * this class doesn't create meshes and doesn't use OpenGL
+     */
+    class InstanceReader {
+    public:
+        struct MeshInstances {
+            std::shared_ptr<etree::MeshNode> node;
+            std::shared_ptr<ldr::TexmapStartCommand> texmap;
+            ///ordered by layer (descending)
+            std::vector<MeshInstance> instances;
+        };
+
+        struct ReadStats {
+            size_t recalculatedInstances;
+            size_t copiedInstances;
+        };
+
+        explicit InstanceReader(scene_id_t scene);
+        InstanceReader& operator=(InstanceReader&) = delete;
+        InstanceReader(const InstanceReader&) = delete;
+
+        /**
+         * @return the keys of the meshes whose instances are different than after the last read, including the ones which don't have instances anymore
+         */
+        std::vector<mesh_key_t> read(const std::shared_ptr<etree::Node>& rootNode);
+        /**
+         * forgets the last read, the next read walks the whole tree and returns all mesh keys
+         */
+        void clear();
+
+        [[nodiscard]] const uomap_t<mesh_key_t, MeshInstances>& getMeshInstances() const;
+        ///index 0 is nullptr
+        [[nodiscard]] const std::vector<std::shared_ptr<etree::Node>>& getElementsSortedById() const;
+        [[nodiscard]] const oset_t<layer_t>& getLayersInUse() const;
+        [[nodiscard]] const ReadStats& getLastReadStats() const;
+
+    private:
+        struct InstanceRecord {
+            mesh_key_t meshKey;
+            ///the selected flag of this node is copied into instance on every read because selecting a node doesn't change its version
+            etree::MeshNode* meshNode;
+            std::shared_ptr<ldr::TexmapStartCommand> texmap;
+            MeshInstance instance;
+        };
+
+        struct Offsets {
+            size_t record;
+            size_t element;
+        };
+
+        struct OldPosition {
+            Offsets begin;
+            uint64_t calculatedReadId;
+        };
+
+        /**
+         * the records and elements of a subtree are contiguous. the offsets are relative to the subtree of the parent,
+         * so they stay valid when the parent subtree is copied as a whole
+         */
+        struct SubtreeCacheEntry {
+            std::weak_ptr<etree::Node> node;
+            const etree::Node* parent;
+            etree::Node::version_t version;
+            glm::mat4 parentAbsoluteTransformation;
+            std::optional<ldr::ColorReference> parentColor;
+            ///false if the subtree contains model instances or texmaps
+            bool copyable;
+            Offsets offset;
+            Offsets count;
+            ///the read in which offset was written
+            uint64_t writtenReadId;
+            ///the read in which the records of the subtree were calculated
+            uint64_t calculatedReadId;
+        };
+
+        scene_id_t scene;
+        uint64_t readId = 0;
+        std::vector<InstanceRecord> records;
+        std::vector<InstanceRecord> lastRecords;
+        std::vector<std::shared_ptr<etree::Node>> elementsSortedById;
+        std::vector<std::shared_ptr<etree::Node>> lastElementsSortedById;
+        uomap_t<const etree::Node*, SubtreeCacheEntry> subtreeCache;
+        uomap_t<mesh_key_t, MeshInstances> meshInstances;
+        oset_t<layer_t> layersInUse;
+        ReadStats lastReadStats{};
+
+        /**
+         * @param oldParent the position of the parent subtree in lastRecords, nullptr if unknown
+         * @param cacheable false inside of model instances
+         * @return true if the subtree contains something that prevents copying it
+         */
+        bool readNode(const std::shared_ptr<etree::Node>& node,
+                      const etree::Node* parent,
+                      const glm::mat4& parentAbsoluteTransformation,
+                      std::optional<ldr::ColorReference> parentColor,
+                      std::optional<unsigned int> selectionTargetElementId,
+                      const std::shared_ptr<ldr::TexmapStartCommand>& parentTexmap,
+                      const OldPosition* oldParent,
+                      const Offsets& newParentBegin,
+                      bool cacheable);
+        void copyFromLastRead(const Offsets& oldBegin, const Offsets& count);
+        void removeExpiredCacheEntries();
+    };
+}
@@ -7,6 +7,8 @@
 #include "../opengl_native_or_replacement.h"
 #include "../texmap_projection.h"
 #include "Seb.h"
+#include "flattened_geometry.h"
+#include "mesh_builder.h"
 #include "mesh_line_data.h"
 #include <glad/glad.h>
 #include <glm/gtc/type_ptr.hpp>
@@ -15,6 +17,14 @@
 
 namespace bricksim::mesh {
     void Mesh::addLdrFile(ldr::ColorReference mainColor, const std::shared_ptr<ldr::File>& file, const glm::mat4& transformation, bool bfcInverted, const std::shared_ptr<ldr::TexmapStartCommand>& texmap) {
+        if (texmap == nullptr && config::get().graphics.cacheFlattenedGeometry && !config::get().graphics.debug.showNormals) {
+            const auto windingInversed = geometry::doesTransformationInverseWindingOrder(transformation) ^ bfcInverted;
+            const auto flattened = flattened_geometry_cache::get(file, windingInversed);
+            if (flattened != nullptr) {
+                addFlattenedGeometry(mainColor, *flattened, transformation);
+                return;
+            }
+        }
         for (const auto& element: file->elements) {
             if (element->hidden) {
                 continue;
@@ -23,24 +33,46 @@ namespace bricksim::mesh {
                 case 0:
                     break;
                 case 1:
-                    addLdrSubfileReference(file, mainColor, std::dynamic_pointer_cast<ldr::SubfileReference>(element), transformation, bfcInverted, texmap);
+                    addLdrSubfileReference(file, mainColor, std::static_pointer_cast<ldr::SubfileReference>(element), transformation, bfcInverted, texmap);
                     break;
                 case 2:
-                    addLdrLine(mainColor, std::dynamic_pointer_cast<ldr::Line>(element), transformation);
+                    addLdrLine(mainColor, std::static_pointer_cast<ldr::Line>(element), transformation);
                     break;
                 case 3:
-                    addLdrTriangle(mainColor, std::dynamic_pointer_cast<ldr::Triangle>(element), transformation, bfcInverted, texmap);
+                    addLdrTriangle(mainColor, std::static_pointer_cast<ldr::Triangle>(element), transformation, bfcInverted, texmap);
                     break;
                 case 4:
-                    addLdrQuadrilateral(mainColor, std::dynamic_pointer_cast<ldr::Quadrilateral>(element), transformation, bfcInverted, texmap);
+                    addLdrQuadrilateral(mainColor, std::static_pointer_cast<ldr::Quadrilateral>(element), transformation, bfcInverted, texmap);
                     break;
                 case 5:
-                    addLdrOptionalLine(mainColor, std::dynamic_pointer_cast<ldr::OptionalLine>(element), transformation);
+                    addLdrOptionalLine(mainColor, std::static_pointer_cast<ldr::OptionalLine>(element), transformation);
                     break;
             }
         }
     }
 
+    void Mesh::addFlattenedGeometry(const ldr::ColorReference mainColor, const FlattenedGeometry& flattened, const glm::mat4& transformation) {
+        for (const auto& group: flattened.triangleGroups) {
+            auto& data = getTriangleData(group.color.code == ldr::Color::MAIN_COLOR_CODE ? mainColor : group.color);
+            data.addTransformedVertices(group.vertices, group.indices, transformation);
+        }
+
+        std::vector<glm::vec3> transformedPositions;
+        for (auto [data, groups]: {std::pair{&lineData, &flattened.lineGroups}, std::pair{&optionalLineData, &flattened.optionalLineGroups}}) {
+            for (const auto& group: *groups) {
+                const auto colorLocked = (group.color.code == ldr::Color::MAIN_COLOR_CODE ? mainColor : group.color).get();
+                const auto color = group.complement
+                                           ? glm::vec3(1 - util::vectorSum(colorLocked->value.asGlmVector()) / 3)
+                                           : colorLocked->edge.asGlmVector();
+                transformedPositions.resize(group.positions.size());
+                transformPositions(group.positions.data(), transformedPositions.data(), group.positions.size(), transformation);
+                for (const auto& position: transformedPositions) {
+                    data->addVertex({position, color});
+                }
+            }
+        }
+    }
+
     void Mesh::addLdrSubfileReference(const std::shared_ptr<ldr::File>& file,
                                       ldr::ColorReference mainColor,
                                       const std::shared_ptr<ldr::SubfileReference>& sfElement,
@@ -72,7 +104,7 @@ namespace bricksim::mesh {
         };
 
         const auto& appliedTexmap = triangleElement->directTexmap != nullptr ? triangleElement->directTexmap : texmapOfParent;
-        if (appliedTexmap == nullptr) {
+        if (appliedTexmap == nullptr || mesh_builder::areTexmapsIgnored()) {
             auto& data = getTriangleData(color);
             for (const auto& tp: transformedPoints) {
                 data.addVertexWithIndex({tp, transformedNormal});
@@ -92,6 +124,10 @@ namespace bricksim::mesh {
     }
 
     void Mesh::calculateAndAddTexmapVertices(const ldr::ColorReference& color, const std::shared_ptr<ldr::TexmapStartCommand>& appliedTexmap, std::vector<glm::vec3>& transformedPoints) {
+        if (mesh_builder::isWorkerThread()) {
+            //textures are cached and uploaded on the main thread
+            throw mesh_builder::MainThreadRequired();
+        }
         const auto pointCount = transformedPoints.size();
         std::vector<glm::vec2> UVs;
         UVs.reserve(pointCount);
@@ -161,7 +197,7 @@ namespace bricksim::mesh {
         };
 
         const auto& appliedTexmap = quadrilateral->directTexmap != nullptr ? quadrilateral->directTexmap : texmapOfParent;
-        if (appliedTexmap == nullptr) {
+        if (appliedTexmap == nullptr || mesh_builder::areTexmapsIgnored()) {
             auto& data = getTriangleData(color);
             const auto idx = static_cast<unsigned int>(data.getVertexCount());
             for (const auto& tp: transformedPoints) {
@@ -228,14 +264,31 @@ namespace bricksim::mesh {
         optionalLineData.addVertex(cv2);
     }
 
+    void Mesh::finishGeometry() {
+        if (geometryFinished) {
+            return;
+        }
+        if (!outerDimensions.has_value()) {
+            calculateOuterDimensions();
+        }
+        if (config::get().graphics.debug.drawMinimalEnclosingBallLines) {
+            addMinEnclosingBallLines();
+        }
+        if (config::get().graphics.optimizeMeshes) {
+            optimizeGeometry();
+        }
+        if (config::get().graphics.cpuPicking) {
+            buildPickingBvh();
+        }
+        geometryFinished = true;
+    }
+
     void Mesh::writeGraphicsData() {
         plFunction();
         if (!alreadyInitialized) {
-            if (!outerDimensions.has_value()) {
-                calculateOuterDimensions();
-            }
-            if (config::get().graphics.debug.drawMinimalEnclosingBallLines) {
-                addMinEnclosingBallLines();
+            finishGeometry();
+            if (!controller::isOpenGlInitialized()) {
+                return;
             }
 
             for (auto& item: triangleData) {
@@ -247,7 +300,7 @@ namespace bricksim::mesh {
                 item.second.initBuffers(instancesForTexturedTriangleData);
             }
 
-            const std::vector<glm::mat4> instancesForLineData = getInstancesForLineData();
+            const std::vector<glm::mat4> instancesForLineData = getInstancesForLineData(instances);
             lineData.initBuffers(instancesForLineData);
             optionalLineData.initBuffers(instancesForLineData);
 
@@ -257,6 +310,51 @@ namespace bricksim::mesh {
         }
     }
 
+    bool Mesh::isGraphicsDataWritten() const {
+        return alreadyInitialized;
+    }
+
+    void Mesh::optimizeGeometry() {
+        plFunction();
+        for (auto& item: triangleData) {
+            item.second.optimize();
+        }
+    }
+
+    void Mesh::buildPickingBvh() {
+        plFunction();
+        if (pickingBvh != nullptr) {
+            return;
+        }
+        auto bvh = std::make_shared<picking::TriangleBvh>();
+        for (const auto& item: triangleData) {
+            bvh->addTriangles(item.second.getVertices(), item.second.getIndices());
+        }
+        for (const auto& item: texturedTriangleData) {
+            bvh->addTriangles(item.second.getVertices());
+        }
+        bvh->build();
+        metrics::pickingBvhBytes += bvh->getMemoryUsage();
+        pickingBvh = std::move(bvh);
+    }
+
+    const std::shared_ptr<const picking::TriangleBvh>& Mesh::getPickingBvh() const {
+        return pickingBvh;
+    }
+
+    void Mesh::clearGeometry() {
+        triangleData.clear();
+        texturedTriangleData.clear();
+        lineData.clear();
+        optionalLineData.clear();
+        outerDimensions.reset();
+        geometryFinished = false;
+        if (pickingBvh != nullptr) {
+            metrics::pickingBvhBytes -= pickingBvh->getMemoryUsage();
+            pickingBvh = nullptr;
+        }
+    }
+
     void Mesh::addMinEnclosingBallLines() {
         auto center = outerDimensions.value().minEnclosingBallCenter;
         auto radius = outerDimensions.value().minEnclosingBallRadius;
@@ -272,7 +370,7 @@ namespace bricksim::mesh {
         if (instancesHaveChanged) {
             //todo just clear buffer data when no instances
             controller::executeOpenGL([this]() {
-                std::vector<glm::mat4> lineInstances = getInstancesForLineData();
+                std::vector<glm::mat4> lineInstances = getInstancesForLineData(instances);
                 lineData.rewriteInstanceBuffer(lineInstances);
                 optionalLineData.rewriteInstanceBuffer(lineInstances);
 
@@ -292,7 +390,7 @@ namespace bricksim::mesh {
         }
     }
 
-    std::vector<glm::mat4> Mesh::getInstancesForLineData() {
+    std::vector<glm::mat4> Mesh::getInstancesForLineData(const std::vector<MeshInstance>& instances) {
         std::vector<glm::mat4> instancesArray;
         instancesArray.resize(instances.size());
         for (size_t i = 0; i < instances.size(); ++i) {
@@ -322,7 +420,11 @@ namespace bricksim::mesh {
         optionalLineData.freeBuffers();
     }
 
-    Mesh::~Mesh() = default;
+    Mesh::~Mesh() {
+        if (pickingBvh != nullptr) {
+            metrics::pickingBvhBytes -= pickingBvh->getMemoryUsage();
+        }
+    }
 
     std::vector<TexturedTriangleInstance> Mesh::getInstancesForTexturedTriangleData() const {
         std::vector<TexturedTriangleInstance> array;
@@ -3,7 +3,9 @@
 #include "../../ldr/colors.h"
 #include "../../ldr/files.h"
 #include "../../types.h"
+#include "../picking/bvh.h"
 #include "../texture.h"
+#include "flattened_geometry.h"
 #include "mesh_line_data.h"
 #include "mesh_simple_classes.h"
 #include "mesh_textured_triangle_data.h"
@@ -51,13 +53,41 @@ namespace bricksim::mesh {
         Mesh(const Mesh&) = delete;
 
         void addLdrFile(ldr::ColorReference mainColor, const std::shared_ptr<ldr::File>& file, const glm::mat4& transformation, bool bfcInverted, const std::shared_ptr<ldr::TexmapStartCommand>& texmap);
+        /**
+         * adds the already flattened geometry of a file (including all subfiles) with one batched transformation per color
+         */
+        void addFlattenedGeometry(ldr::ColorReference mainColor, const FlattenedGeometry& flattened, const glm::mat4& transformation);
         void addLdrSubfileReference(const std::shared_ptr<ldr::File>& file, ldr::ColorReference mainColor, const std::shared_ptr<ldr::SubfileReference>& sfElement, const glm::mat4& transformation, bool bfcInverted, const std::shared_ptr<ldr::TexmapStartCommand>& texmap);
         void addLdrLine(ldr::ColorReference mainColor, const std::shared_ptr<ldr::Line>& lineElement, const glm::mat4& transformation);
         void addLdrTriangle(ldr::ColorReference mainColor, const std::shared_ptr<ldr::Triangle>& triangleElement, const glm::mat4& transformation, bool bfcInverted, const std::shared_ptr<ldr::TexmapStartCommand>& texmapOfParent);
         void addLdrQuadrilateral(ldr::ColorReference mainColor, const std::shared_ptr<ldr::Quadrilateral>& quadrilateral, const glm::mat4& transformation, bool bfcInverted, const std::shared_ptr<ldr::TexmapStartCommand>& texmapOfParent);
         void addLdrOptionalLine(ldr::ColorReference mainColor, const std::shared_ptr<ldr::OptionalLine>& optionalLineElement, const glm::mat4& transformation);
 
+        /**
+         * finishes the geometry (outer dimensions, optimization, picking BVH) and uploads it to the GPU.
+         * if OpenGL isn't initialized (benchmarks, tests), only the geometry is finished and isGraphicsDataWritten stays false
+         */
         void writeGraphicsData();
+        [[nodiscard]] bool isGraphicsDataWritten() const;
+        /**
+         * removes all vertices. only allowed before the graphics data is written
+         */
+        void clearGeometry();
+        /**
+         * welds the vertices of the triangle data and optimizes the index order for the GPU. only allowed before the graphics data is written
+         */
+        void optimizeGeometry();
+        /**
+         * copies the triangles into a BVH for picking on the CPU. only allowed before the graphics data is written, does nothing if already built
+         */
+        void buildPickingBvh();
+        ///nullptr if buildPickingBvh wasn't called
+        [[nodiscard]] const std::shared_ptr<const picking::TriangleBvh>& getPickingBvh() const;
+
+        /**
+         * the instance data as it's uploaded to the instance buffers of the line data. the selected flag is stored in the last row
+         */
+        [[nodiscard]] static std::vector<glm::mat4> getInstancesForLineData(const std::vector<MeshInstance>& instances);
 
         void drawTriangleGraphics(scene_id_t sceneId, layer_t layer);
         void drawTexturedTriangleGraphics(scene_id_t sceneId, layer_t layer);
@@ -76,13 +106,15 @@ namespace bricksim::mesh {
 
 
         bool alreadyInitialized = false;
+        bool geometryFinished = false;
 
+        void finishGeometry();
         void addMinEnclosingBallLines();
         void calculateOuterDimensions();
         std::optional<OuterDimensions> outerDimensions = {};
+        std::shared_ptr<const picking::TriangleBvh> pickingBvh;
 
         void appendNewSceneInstancesAtEnd(scene_id_t sceneId, const std::vector<MeshInstance>& newSceneInstances);
-        std::vector<glm::mat4> getInstancesForLineData();
         std::vector<TexturedTriangleInstance> getInstancesForTexturedTriangleData() const;
         void rewriteInstanceBuffer();
         void calculateAndAddTexmapVertices(const ldr::ColorReference& color, const std::shared_ptr<ldr::TexmapStartCommand>& appliedTexmap, std::vector<glm::vec3>& transformedPoints);
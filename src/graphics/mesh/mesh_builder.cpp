@@ -0,0 +1,39 @@
+#include "mesh_builder.h"
+#include "../../helpers/util.h"
+
+namespace bricksim::mesh::mesh_builder {
+    namespace {
+        thread_local bool workerThread = false;
+        thread_local bool texmapsIgnored = false;
+    }
+
+    MainThreadRequired::MainThreadRequired() :
+        std::runtime_error("this part of the mesh has to be built on the main thread") {}
+
+    std::shared_ptr<thread_pool::Job> submit(std::function<void()> job) {
+        return thread_pool::submit(
+                [job = std::move(job)]() {
+                    //exceptions are stored in the job and rethrown by Job::wait
+                    util::ScopeVarBackup<bool> workerThreadBackup(workerThread, true);
+                    job();
+                },
+                thread_pool::Priority::FOREGROUND);
+    }
+
+    bool isWorkerThread() {
+        return workerThread;
+    }
+
+    IgnoreTexmapsScope::IgnoreTexmapsScope() :
+        valueBefore(texmapsIgnored) {
+        texmapsIgnored = true;
+    }
+
+    IgnoreTexmapsScope::~IgnoreTexmapsScope() {
+        texmapsIgnored = valueBefore;
+    }
+
+    bool areTexmapsIgnored() {
+        return texmapsIgnored;
+    }
+}
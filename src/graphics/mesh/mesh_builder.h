@@ -0,0 +1,45 @@
+#pragma once
+
+#include "../../helpers/thread_pool.h"
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+namespace bricksim::mesh::mesh_builder {
+    /**
+     * thrown when something that needs the main thread (for example loading a texture) is needed while a mesh is built on a worker thread.
+     * the mesh is built again on the main thread in this case
+     */
+    class MainThreadRequired : public std::runtime_error {
+    public:
+        MainThreadRequired();
+    };
+
+    /**
+     * runs job on the shared thread pool with FOREGROUND priority.
+     * wait for it with Job::wait, which runs other queued jobs when called on a worker, so a worker can't block on a job queued behind it
+     */
+    std::shared_ptr<thread_pool::Job> submit(std::function<void()> job);
+
+    /**
+     * @return true if the calling thread is currently running a job which was submitted here
+     */
+    bool isWorkerThread();
+
+    /**
+     * while an instance exists, meshes built on the calling thread use the plain color for texmapped triangles instead of loading the textures.
+     * for renderers which run without OpenGL
+     */
+    class IgnoreTexmapsScope {
+    public:
+        IgnoreTexmapsScope();
+        IgnoreTexmapsScope(const IgnoreTexmapsScope&) = delete;
+        IgnoreTexmapsScope& operator=(const IgnoreTexmapsScope&) = delete;
+        ~IgnoreTexmapsScope();
+
+    private:
+        bool valueBefore;
+    };
+
+    bool areTexmapsIgnored();
+}
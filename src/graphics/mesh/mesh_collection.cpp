@@ -1,14 +1,31 @@
 #include "mesh_collection.h"
+#include "../../config/read.h"
 #include "../../controller.h"
 #include "../../helpers/geometry.h"
 #include "../../metrics.h"
-#include "../texmap_projection.h"
+#include "mesh_builder.h"
 #include <glm/gtx/string_cast.hpp>
 #include <palanteer.h>
 #include <spdlog/spdlog.h>
 
 namespace bricksim::mesh {
+    namespace {
+        ///the meshes of these jobs are deleted anyway, so failed jobs don't matter
+        void waitForJobs(const std::vector<std::shared_ptr<thread_pool::Job>>& jobs) {
+            for (const auto& job: jobs) {
+                try {
+                    job->wait();
+                } catch (...) {
+                }
+            }
+        }
+    }
+
     uomap_t<mesh_key_t, std::shared_ptr<Mesh>> SceneMeshCollection::allMeshes;
+    std::mutex SceneMeshCollection::allMeshesMtx;
+    uomap_t<std::shared_ptr<Mesh>, SceneMeshCollection::MeshBuildJob> SceneMeshCollection::meshBuildJobs;
+    std::mutex SceneMeshCollection::meshBuildJobsMtx;
+    uint64_t SceneMeshCollection::allMeshesGeneration = 0;
 
     mesh_key_t SceneMeshCollection::getMeshKey(const std::shared_ptr<etree::MeshNode>& node, bool windingOrderInverse, const std::shared_ptr<ldr::TexmapStartCommand>& texmap) {
         return {
@@ -21,26 +38,171 @@ namespace bricksim::mesh {
     }
 
     std::shared_ptr<Mesh> SceneMeshCollection::getMesh(mesh_key_t key, const std::shared_ptr<etree::MeshNode>& node, const std::shared_ptr<ldr::TexmapStartCommand>& texmap) {
-        auto it = allMeshes.find(key);
-        if (it == allMeshes.end()) {
-            plScope("node->addToMesh");
-            auto mesh = std::make_shared<Mesh>();
-            allMeshes[key] = mesh;
-            mesh->name = node->getDescription();
-            node->addToMesh(mesh, key.windingInversed, texmap);
-            mesh->writeGraphicsData();
+        if (auto mesh = findMesh(key)) {
+            finishMeshBuildJob(mesh, true);
             return mesh;
         }
-        return it->second;
+        plScope("node->addToMesh");
+        auto mesh = std::make_shared<Mesh>();
+        mesh->name = node->getDescription();
+        node->addToMesh(mesh, key.windingInversed, texmap);
+        mesh->writeGraphicsData();
+        //other threads only see the mesh when it's complete
+        std::scoped_lock<std::mutex> lg(allMeshesMtx);
+        allMeshes[key] = mesh;
+        return mesh;
+    }
+
+    std::shared_ptr<Mesh> SceneMeshCollection::getOrStartMesh(mesh_key_t key, const std::shared_ptr<etree::MeshNode>& node, const std::shared_ptr<ldr::TexmapStartCommand>& texmap) {
+        if (auto mesh = findMesh(key)) {
+            return mesh;
+        }
+        //only library parts are built in the background, the files of models can be changed by the editor at any time
+        if (!buildMeshesAsynchronously
+            || !config::get().system.enableThreading
+            || node->getType() != etree::NodeType::TYPE_PART) {
+            return getMesh(key, node, texmap);
+        }
+        auto mesh = std::make_shared<Mesh>();
+        mesh->name = node->getDescription();
+        {
+            std::scoped_lock<std::mutex> lg(meshBuildJobsMtx);
+            auto job = mesh_builder::submit([mesh, node, windingInversed = key.windingInversed, texmap]() {
+                plScope("node->addToMesh");
+                node->addToMesh(mesh, windingInversed, texmap);
+                mesh->getOuterDimensions();
+                if (config::get().graphics.optimizeMeshes) {
+                    mesh->optimizeGeometry();
+                }
+                if (config::get().graphics.cpuPicking) {
+                    mesh->buildPickingBvh();
+                }
+            });
+            meshBuildJobs.emplace(mesh, MeshBuildJob{std::move(job), node, key.windingInversed, texmap});
+        }
+        //the job is registered before the mesh can be found, so other threads wait for it instead of reading a half built mesh
+        std::scoped_lock<std::mutex> lg(allMeshesMtx);
+        allMeshes[key] = mesh;
+        return mesh;
+    }
+
+    std::shared_ptr<Mesh> SceneMeshCollection::findMesh(mesh_key_t key) {
+        std::scoped_lock<std::mutex> lg(allMeshesMtx);
+        const auto it = allMeshes.find(key);
+        return it != allMeshes.end() ? it->second : nullptr;
+    }
+
+    bool SceneMeshCollection::finishMeshBuildJob(const std::shared_ptr<Mesh>& mesh, bool wait) {
+        std::shared_ptr<thread_pool::Job> job;
+        {
+            std::scoped_lock<std::mutex> lg(meshBuildJobsMtx);
+            const auto it = meshBuildJobs.find(mesh);
+            if (it == meshBuildJobs.end()) {
+                return true;
+            }
+            job = it->second.job;
+        }
+        if (!wait && !job->isDone()) {
+            return false;
+        }
+        const bool mainThread = util::isMainThread();
+
+        //the lock is released while waiting. on a worker thread, Job::wait runs other queued jobs, which may include this one
+        bool mainThreadRequired = false;
+        try {
+            job->wait();
+        } catch (const mesh_builder::MainThreadRequired&) {
+            mainThreadRequired = true;
+        } catch (const std::exception& e) {
+            spdlog::error("building mesh {} failed: {}", mesh->name, e.what());
+        }
+
+        if (!mainThread) {
+            //writing the graphics data and the texmap rebuild need OpenGL, the main thread does that in moveFinishedMeshesToUsed
+            return !mainThreadRequired;
+        }
+
+        MeshBuildJob buildJob;
+        {
+            std::scoped_lock<std::mutex> lg(meshBuildJobsMtx);
+            const auto it = meshBuildJobs.find(mesh);
+            if (it == meshBuildJobs.end() || it->second.job != job) {
+                //another thread finished it in the meantime
+                return true;
+            }
+            buildJob = it->second;
+        }
+        //the job stays registered until the geometry is final. until then, other threads see the unfinished job
+        //and don't read the mesh while it's rebuilt or optimized by writeGraphicsData
+        if (mainThreadRequired) {
+            plScope("node->addToMesh");
+            mesh->clearGeometry();
+            buildJob.node->addToMesh(mesh, buildJob.windingInversed, buildJob.texmap);
+        }
+        mesh->writeGraphicsData();
+        {
+            std::scoped_lock<std::mutex> lg(meshBuildJobsMtx);
+            const auto it = meshBuildJobs.find(mesh);
+            if (it != meshBuildJobs.end() && it->second.job == job) {
+                meshBuildJobs.erase(it);
+            }
+        }
+        return true;
+    }
+
+    void SceneMeshCollection::moveFinishedMeshesToUsed() {
+        std::vector<std::shared_ptr<Mesh>> finishedMeshes;
+        for (const auto& mesh: meshesWithoutGraphicsData) {
+            if (finishMeshBuildJob(mesh, !buildMeshesAsynchronously)) {
+                finishedMeshes.push_back(mesh);
+            }
+        }
+        for (const auto& mesh: finishedMeshes) {
+            meshesWithoutGraphicsData.erase(mesh);
+            usedMeshes.insert(mesh);
+        }
+        if (!finishedMeshes.empty()) {
+            ++drawableMeshesVersion;
+            pickerOutdated = true;
+        }
+    }
+
+    uint64_t SceneMeshCollection::getDrawableMeshesVersion() const {
+        return drawableMeshesVersion;
+    }
+
+    void SceneMeshCollection::setBuildMeshesAsynchronously(bool value) {
+        buildMeshesAsynchronously = value;
     }
 
     std::shared_ptr<etree::Node> SceneMeshCollection::getElementById(element_id_t id) const {
+        const auto& elementsSortedById = instanceReader.getElementsSortedById();
         if (elementsSortedById.size() > id) {
             return elementsSortedById[id];
         }
         return nullptr;
     }
 
+    const picking::ScenePicker& SceneMeshCollection::getPicker() {
+        if (pickerOutdated) {
+            plScope("rebuild picker");
+            std::vector<picking::ScenePicker::Instance> pickerInstances;
+            for (const auto& [meshKey, group]: instanceReader.getMeshInstances()) {
+                const auto meshIt = sceneMeshes.find(meshKey);
+                if (meshIt == sceneMeshes.end() || !usedMeshes.contains(meshIt->second)) {
+                    continue;
+                }
+                const auto& bvh = meshIt->second->getPickingBvh();
+                for (const auto& instance: group.instances) {
+                    pickerInstances.push_back({bvh, instance.transformation, instance.elementId, instance.layer});
+                }
+            }
+            picker.setInstances(pickerInstances);
+            pickerOutdated = false;
+        }
+        return picker;
+    }
+
     void SceneMeshCollection::drawLineGraphics(const layer_t layer) const {
         for (const auto& mesh: usedMeshes) {
             mesh->getLineData().draw(mesh->getSceneLayerInstanceRange(scene, layer));
@@ -66,95 +228,39 @@ namespace bricksim::mesh {
     }
 
     SceneMeshCollection::SceneMeshCollection(scene_id_t scene) :
-        scene(scene) {}
-
-    void SceneMeshCollection::readElementTree(const std::shared_ptr<etree::Node>& node,
-                                              const glm::mat4& parentAbsoluteTransformation,
-                                              std::optional<ldr::ColorReference> parentColor,
-                                              std::optional<unsigned int> selectionTargetElementId,
-                                              const std::shared_ptr<ldr::TexmapStartCommand>& parentTexmap) {
-        std::shared_ptr<etree::Node> nodeToParseChildren = node;
-        glm::mat4 absoluteTransformation = parentAbsoluteTransformation * node->getRelativeTransformation();
-        std::shared_ptr<ldr::TexmapStartCommand> texmap = parentTexmap != nullptr ? graphics::texmap_projection::transformTexmapStartCommand(parentTexmap, node->getRelativeTransformation()) : nullptr;
-        if (node->visible) {
-            if ((static_cast<uint32_t>(node->getType()) & static_cast<uint32_t>(etree::NodeType::TYPE_MESH)) > 0) {
-                std::shared_ptr<etree::MeshNode> meshNode;
-                ldr::ColorReference color;
-                std::shared_ptr<etree::MeshNode> nodeToGetColorFrom;
-                if (node->getType() == etree::NodeType::TYPE_MODEL_INSTANCE) {
-                    const auto instanceNode = std::dynamic_pointer_cast<etree::ModelInstanceNode>(node);
-                    meshNode = instanceNode->modelNode;
-                    absoluteTransformation = instanceNode->getRelativeTransformation() * parentAbsoluteTransformation;
-                    nodeToGetColorFrom = instanceNode;
-                    nodeToParseChildren = meshNode;
-                } else {
-                    meshNode = std::dynamic_pointer_cast<etree::MeshNode>(node);
-                    absoluteTransformation = node->getRelativeTransformation() * parentAbsoluteTransformation;
-                    nodeToGetColorFrom = meshNode;
-                }
-                if (nodeToGetColorFrom->getElementColor().get()->code == ldr::Color::MAIN_COLOR_CODE && parentColor.has_value()) {
-                    color = parentColor.value();
-                } else {
-                    color = nodeToGetColorFrom->getDisplayColor();
-                }
-
-                if (meshNode->getDirectTexmap() != nullptr) {
-                    texmap = meshNode->getDirectTexmap();
-                }
-                if (texmap != nullptr) {
-                    texmap = graphics::texmap_projection::transformTexmapStartCommand(texmap, glm::transpose(node->getRelativeTransformation()));
-                }
-
-                if (node->getType() == etree::NodeType::TYPE_MODEL_INSTANCE) {
-                    parentColor = color;
-                }
-
-                //spdlog::debug("getting mesh key for {}", meshNode->getDescription());
-                auto meshKey = getMeshKey(meshNode, geometry::doesTransformationInverseWindingOrder(absoluteTransformation), texmap);
-                auto mesh = getMesh(meshKey, meshNode, texmap);
-                unsigned int elementId;
-                if (selectionTargetElementId.has_value()) {
-                    elementId = selectionTargetElementId.value();
-                } else {
-                    elementId = static_cast<unsigned int>(elementsSortedById.size());
-                    if (node->getType() == etree::NodeType::TYPE_MODEL_INSTANCE) {
-                        selectionTargetElementId = elementId;//for the children
-                    }
-                }
-                MeshInstance newInstance{color, absoluteTransformation, elementId, meshNode->selected, node->layer, this->scene};
-                layersInUse.emplace(node->layer);
-                usedMeshes.insert(mesh);
-                elementsSortedById.push_back(node);
-                newMeshInstances[meshKey].push_back(newInstance);
-            }
-            for (const auto& child: nodeToParseChildren->getChildren()) {
-                if (child->visible) {
-                    readElementTree(child, absoluteTransformation, parentColor, selectionTargetElementId, texmap);
-                }
-            }
-            nodesWithChildrenAlreadyVisited.insert(nodeToParseChildren);
-        }
-    }
+        scene(scene), instanceReader(scene) {}
 
     void SceneMeshCollection::rereadElementTreeIfNeeded() {
         plFunction();
-        if (lastElementTreeReadVersion == rootNode->getVersion()) {
+        moveFinishedMeshesToUsed();
+        if (lastElementTreeReadVersion == rootNode->getVersion() && lastElementTreeReadMeshesGeneration == allMeshesGeneration) {
             return;
         }
-        elementsSortedById.clear();
-        elementsSortedById.push_back(nullptr);
-        layersInUse.clear();
         auto before = std::chrono::high_resolution_clock::now();
-        lastUsedMeshes = usedMeshes;
-        usedMeshes.clear();
-        readElementTree(rootNode, glm::mat4(1.0f), {}, std::nullopt, nullptr);
-        updateMeshInstances();
-        nodesWithChildrenAlreadyVisited.clear();
-        for (const auto& mesh: usedMeshes) {
-            mesh->writeGraphicsData();
+        if (lastElementTreeReadMeshesGeneration != allMeshesGeneration) {
+            //the meshes of the last read don't exist anymore
+            instanceReader.clear();
+            sceneMeshes.clear();
+            usedMeshes.clear();
+            meshesWithoutGraphicsData.clear();
+            lastElementTreeReadMeshesGeneration = allMeshesGeneration;
+        }
+        auto changedMeshKeys = instanceReader.read(rootNode);
+        if (instanceReaderCleared) {
+            //the reader doesn't know the keys of the last read anymore
+            for (const auto& [meshKey, mesh]: sceneMeshes) {
+                if (!instanceReader.getMeshInstances().contains(meshKey)) {
+                    changedMeshKeys.push_back(meshKey);
+                }
+            }
+            instanceReaderCleared = false;
         }
-        for (const auto& mesh: lastUsedMeshes) {
-            mesh->writeGraphicsData();
+        updateMeshInstances(changedMeshKeys);
+        //getAbsoluteAABB and the connection engine read the absolute transformations from the table later
+        rootNode->getTransformTable().update();
+        pickerOutdated = true;
+        if (!buildMeshesAsynchronously) {
+            moveFinishedMeshesToUsed();
         }
         auto after = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::microseconds>(after - before).count();
@@ -162,37 +268,49 @@ namespace bricksim::mesh {
         lastElementTreeReadVersion = rootNode->getVersion();
     }
 
-    void SceneMeshCollection::updateMeshInstances() {
-        for (auto& [meshKey, newInstancesOfThisScene]: newMeshInstances) {
-            auto mesh = allMeshes[meshKey];
-
-            std::sort(newInstancesOfThisScene.begin(), newInstancesOfThisScene.end(), [](const auto& a, const auto& b) {
-                return a.layer > b.layer;
-            });
-
-            mesh->updateInstancesOfScene(scene, newInstancesOfThisScene);
-            lastUsedMeshes.erase(mesh);
-        }
-        for (const auto& notUsedAnymoreMesh: lastUsedMeshes) {
-            notUsedAnymoreMesh->deleteInstancesOfScene(scene);
+    void SceneMeshCollection::updateMeshInstances(const std::vector<mesh_key_t>& changedMeshKeys) {
+        const auto& meshInstances = instanceReader.getMeshInstances();
+        for (const auto& meshKey: changedMeshKeys) {
+            const auto instancesIt = meshInstances.find(meshKey);
+            if (instancesIt != meshInstances.end()) {
+                const auto& [node, texmap, instances] = instancesIt->second;
+                auto mesh = getOrStartMesh(meshKey, node, texmap);
+                sceneMeshes[meshKey] = mesh;
+                mesh->updateInstancesOfScene(scene, instances);
+                if (mesh->isGraphicsDataWritten()) {
+                    usedMeshes.insert(mesh);
+                    mesh->writeGraphicsData();
+                } else {
+                    //the graphics data of meshes which are still built is written with all instances when they are ready
+                    meshesWithoutGraphicsData.insert(mesh);
+                }
+            } else if (const auto meshIt = sceneMeshes.find(meshKey); meshIt != sceneMeshes.end()) {
+                const auto mesh = meshIt->second;
+                sceneMeshes.erase(meshIt);
+                mesh->deleteInstancesOfScene(scene);
+                if (mesh->isGraphicsDataWritten()) {
+                    mesh->writeGraphicsData();
+                }
+                usedMeshes.erase(mesh);
+                meshesWithoutGraphicsData.erase(mesh);
+            }
         }
-        newMeshInstances.clear();
     }
 
-    aabb::AABB SceneMeshCollection::getAbsoluteAABB(const std::shared_ptr<const etree::MeshNode>& node) const {
+    aabb::AABB SceneMeshCollection::getAbsoluteAABB(const std::shared_ptr<const etree::MeshNode>& node) {
         return getRelativeAABB(node).transform(glm::transpose(node->getAbsoluteTransformation()));
     }
 
-    aabb::AABB SceneMeshCollection::getRelativeAABB(const std::shared_ptr<const etree::MeshNode>& node) const {
+    aabb::AABB SceneMeshCollection::getRelativeAABB(const std::shared_ptr<const etree::MeshNode>& node) {
         //todo something here is wrong for subfile instances
-        auto it = allMeshes.find({node->getMeshIdentifier(), false});
-        if (it == allMeshes.end()) {
-            it = allMeshes.find({node->getMeshIdentifier(), true});
+        auto mesh = findMesh({node->getMeshIdentifier(), false});
+        if (mesh == nullptr) {
+            mesh = findMesh({node->getMeshIdentifier(), true});
         }
         aabb::AABB aabb;
         bool first = true;
-        if (it != allMeshes.end()) {
-            const auto& mesh = it->second;
+        //the vertex data of meshes which have to be rebuilt on the main thread is incomplete until then
+        if (mesh != nullptr && finishMeshBuildJob(mesh, true)) {
             const auto& outerDimensions = mesh->getOuterDimensions();
             aabb.includeAABB(outerDimensions.aabb);
         }
@@ -212,7 +330,7 @@ namespace bricksim::mesh {
         return aabb;
     }
 
-    std::optional<aabb::OBB> SceneMeshCollection::getAbsoluteRotatedBBox(const std::shared_ptr<const etree::MeshNode>& node) const {
+    std::optional<aabb::OBB> SceneMeshCollection::getAbsoluteRotatedBBox(const std::shared_ptr<const etree::MeshNode>& node) {
         const auto relativeAABB = getRelativeAABB(node);
         if (relativeAABB.isDefined()) {
             const auto nodeAbsTransf = glm::transpose(node->getAbsoluteTransformation());
@@ -225,7 +343,7 @@ namespace bricksim::mesh {
         return std::nullopt;
     }
 
-    std::optional<aabb::OBB> SceneMeshCollection::getRelativeRotatedBBox(const std::shared_ptr<const etree::MeshNode>& node) const {
+    std::optional<aabb::OBB> SceneMeshCollection::getRelativeRotatedBBox(const std::shared_ptr<const etree::MeshNode>& node) {
         const auto relativeAABB = getRelativeAABB(node);
         if (relativeAABB.isDefined()) {
             const auto nodeRelTransf = glm::transpose(node->getRelativeTransformation());
@@ -239,7 +357,7 @@ namespace bricksim::mesh {
     }
 
     const oset_t<layer_t>& SceneMeshCollection::getLayersInUse() const {
-        return layersInUse;
+        return instanceReader.getLayersInUse();
     }
 
     const std::shared_ptr<etree::Node>& SceneMeshCollection::getRootNode() const {
@@ -247,12 +365,62 @@ namespace bricksim::mesh {
     }
 
     void SceneMeshCollection::setRootNode(const std::shared_ptr<etree::Node>& newRootNode) {
+        if (rootNode != newRootNode) {
+            instanceReader.clear();
+            instanceReaderCleared = true;
+        }
         rootNode = newRootNode;
         lastElementTreeReadVersion = rootNode->getVersion() - 1;
     }
 
     void SceneMeshCollection::deleteAllMeshes() {
-        allMeshes.clear();
+        std::vector<std::shared_ptr<thread_pool::Job>> jobs;
+        {
+            std::scoped_lock<std::mutex> lg(meshBuildJobsMtx);
+            for (auto& [mesh, buildJob]: meshBuildJobs) {
+                jobs.push_back(std::move(buildJob.job));
+            }
+            meshBuildJobs.clear();
+        }
+        waitForJobs(jobs);
+        {
+            std::scoped_lock<std::mutex> lg(allMeshesMtx);
+            allMeshes.clear();
+        }
+        ++allMeshesGeneration;
+        flattened_geometry_cache::clear();
+    }
+
+    void SceneMeshCollection::deleteMeshes(const uoset_t<mesh_identifier_t>& meshIdentifiers) {
+        std::vector<std::shared_ptr<Mesh>> meshesToDelete;
+        {
+            std::scoped_lock<std::mutex> lg(allMeshesMtx);
+            std::vector<mesh_key_t> keysToDelete;
+            for (const auto& [key, mesh]: allMeshes) {
+                if (meshIdentifiers.contains(key.meshIdentifier)) {
+                    keysToDelete.push_back(key);
+                    meshesToDelete.push_back(mesh);
+                }
+            }
+            for (const auto& key: keysToDelete) {
+                allMeshes.erase(key);
+            }
+        }
+        if (meshesToDelete.empty()) {
+            return;
+        }
+        std::vector<std::shared_ptr<thread_pool::Job>> jobs;
+        {
+            std::scoped_lock<std::mutex> lg(meshBuildJobsMtx);
+            for (const auto& mesh: meshesToDelete) {
+                if (const auto it = meshBuildJobs.find(mesh); it != meshBuildJobs.end()) {
+                    jobs.push_back(std::move(it->second.job));
+                    meshBuildJobs.erase(it);
+                }
+            }
+        }
+        waitForJobs(jobs);
+        ++allMeshesGeneration;
     }
 
     const uoset_t<std::shared_ptr<Mesh>>& SceneMeshCollection::getUsedMeshes() const {
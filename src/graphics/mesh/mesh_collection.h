@@ -1,28 +1,14 @@
 #pragma once
 
 #include "../../element_tree.h"
+#include "../../helpers/thread_pool.h"
 #include "mesh.h"
 #include "../../helpers/util.h"
+#include "../picking/scene_picker.h"
+#include "instance_reader.h"
+#include <mutex>
 #include <set>
 
-namespace bricksim::mesh {
-    struct mesh_key_t {
-        mesh_identifier_t meshIdentifier;
-        bool windingInversed;
-        size_t texmapHash;
-        bool operator==(const mesh_key_t& rhs) const = default;
-    };
-}
-
-namespace std {
-    template<>
-    struct hash<bricksim::mesh::mesh_key_t> {
-        std::size_t operator()(bricksim::mesh::mesh_key_t value) const {
-            return bricksim::util::combinedHash(value.meshIdentifier, value.windingInversed, value.texmapHash);
-        }
-    };
-}
-
 namespace bricksim::mesh {
     /**
  * the purpose of this class is to manage the meshInstances of a Scene object
@@ -30,25 +16,54 @@ namespace bricksim::mesh {
     class SceneMeshCollection {
     private:
         uoset_t<std::shared_ptr<Mesh>> usedMeshes;
-        uoset_t<std::shared_ptr<Mesh>> lastUsedMeshes;
-        oset_t<layer_t> layersInUse;
         scene_id_t scene;
         std::shared_ptr<etree::Node> rootNode;
 
-        uomap_t<mesh_key_t, std::vector<MeshInstance>> newMeshInstances;
-        uoset_t<std::shared_ptr<etree::Node>> nodesWithChildrenAlreadyVisited;
-        std::vector<std::shared_ptr<etree::Node>> elementsSortedById;
+        InstanceReader instanceReader;
+        ///the meshes which have instances of this scene
+        uomap_t<mesh_key_t, std::shared_ptr<Mesh>> sceneMeshes;
 
         uint64_t lastElementTreeReadVersion = 0;
+        uint64_t lastElementTreeReadMeshesGeneration = 0;
+        bool instanceReaderCleared = false;
+
+        ///used meshes whose vertex data is still being generated on a worker thread. they are moved to usedMeshes when they are ready
+        uoset_t<std::shared_ptr<Mesh>> meshesWithoutGraphicsData;
+        uint64_t drawableMeshesVersion = 0;
+        bool buildMeshesAsynchronously = true;
 
-        void updateMeshInstances();
-        void readElementTree(const std::shared_ptr<etree::Node>& node,
-                             const glm::mat4& parentAbsoluteTransformation,
-                             std::optional<ldr::ColorReference> parentColor,
-                             std::optional<unsigned int> selectionTargetElementId,
-                             const std::shared_ptr<ldr::TexmapStartCommand>& parentTexmap);
+        picking::ScenePicker picker;
+        bool pickerOutdated = true;
+        void moveFinishedMeshesToUsed();
+        std::shared_ptr<Mesh> getOrStartMesh(mesh_key_t key, const std::shared_ptr<etree::MeshNode>& node, const std::shared_ptr<ldr::TexmapStartCommand>& texmap);
+
+        void updateMeshInstances(const std::vector<mesh_key_t>& changedMeshKeys);
 
         static uomap_t<mesh_key_t, std::shared_ptr<Mesh>> allMeshes;
+        ///getRelativeAABB reads allMeshes on connection engine threads while the main thread inserts
+        static std::mutex allMeshesMtx;
+        static std::shared_ptr<Mesh> findMesh(mesh_key_t key);
+        ///incremented by deleteAllMeshes and deleteMeshes
+        static uint64_t allMeshesGeneration;
+
+        struct MeshBuildJob {
+            std::shared_ptr<thread_pool::Job> job;
+            std::shared_ptr<etree::MeshNode> node;
+            bool windingInversed;
+            std::shared_ptr<ldr::TexmapStartCommand> texmap;
+        };
+        ///a mesh is removed from here by the main thread after its geometry is final and its graphics data is written
+        static uomap_t<std::shared_ptr<Mesh>, MeshBuildJob> meshBuildJobs;
+        ///getAbsoluteAABB is also called by the connection engine on other threads. never wait for a job while holding this
+        static std::mutex meshBuildJobsMtx;
+        /**
+         * writes the graphics data of mesh if its build job is done.
+         * on other threads than the main thread, this only waits for the vertex data. writing the graphics data
+         * and rebuilding meshes which threw MainThreadRequired is left to the main thread
+         * @param wait true to block until the job is done
+         * @return true if the mesh has no unfinished build job anymore (on other threads: if its vertex data is complete)
+         */
+        static bool finishMeshBuildJob(const std::shared_ptr<Mesh>& mesh, bool wait);
 
     public:
         explicit SceneMeshCollection(scene_id_t scene);
@@ -56,14 +71,27 @@ namespace bricksim::mesh {
         SceneMeshCollection(const SceneMeshCollection&) = delete;
 
         void rereadElementTreeIfNeeded();
+        /**
+         * incremented every time a mesh whose vertex data was generated in the background becomes drawable
+         */
+        [[nodiscard]] uint64_t getDrawableMeshesVersion() const;
+        /**
+         * @param value false to build the missing meshes on the calling thread before rereadElementTreeIfNeeded returns (for thumbnails)
+         */
+        void setBuildMeshesAsynchronously(bool value);
         //void updateSelectionContainerBoxIfNeeded();
 
-        [[nodiscard]] aabb::AABB getAbsoluteAABB(const std::shared_ptr<const etree::MeshNode>& node) const;
-        [[nodiscard]] aabb::AABB getRelativeAABB(const std::shared_ptr<const etree::MeshNode>& node) const;
-        [[nodiscard]] std::optional<aabb::OBB> getAbsoluteRotatedBBox(const std::shared_ptr<const etree::MeshNode>& node) const;
-        [[nodiscard]] std::optional<aabb::OBB> getRelativeRotatedBBox(const std::shared_ptr<const etree::MeshNode>& node) const;
+        ///the bounding boxes only depend on the meshes, which are shared by all scenes
+        [[nodiscard]] static aabb::AABB getAbsoluteAABB(const std::shared_ptr<const etree::MeshNode>& node);
+        [[nodiscard]] static aabb::AABB getRelativeAABB(const std::shared_ptr<const etree::MeshNode>& node);
+        [[nodiscard]] static std::optional<aabb::OBB> getAbsoluteRotatedBBox(const std::shared_ptr<const etree::MeshNode>& node);
+        [[nodiscard]] static std::optional<aabb::OBB> getRelativeRotatedBBox(const std::shared_ptr<const etree::MeshNode>& node);
         [[nodiscard]] const oset_t<layer_t>& getLayersInUse() const;
         [[nodiscard]] std::shared_ptr<etree::Node> getElementById(element_id_t id) const;
+        /**
+         * contains the instances of the meshes which are drawable. rereadElementTreeIfNeeded should be called before
+         */
+        [[nodiscard]] const picking::ScenePicker& getPicker();
         [[nodiscard]] const std::shared_ptr<etree::Node>& getRootNode() const;
         void setRootNode(const std::shared_ptr<etree::Node>& newRootNode);
 
@@ -73,8 +101,16 @@ namespace bricksim::mesh {
         void drawOptionalLineGraphics(layer_t layer) const;
 
         static mesh_key_t getMeshKey(const std::shared_ptr<etree::MeshNode>& node, bool windingOrderInverse, const std::shared_ptr<ldr::TexmapStartCommand>& texmap);
+        /**
+         * @return the mesh with the vertex data and graphics data ready. waits if the mesh is currently built on another thread
+         */
         static std::shared_ptr<Mesh> getMesh(mesh_key_t key, const std::shared_ptr<etree::MeshNode>& node, const std::shared_ptr<ldr::TexmapStartCommand>& texmap);
         [[nodiscard]] const uoset_t<std::shared_ptr<Mesh>>& getUsedMeshes() const;
         static void deleteAllMeshes();
+        /**
+         * deletes the meshes of these identifiers, all scenes read their element tree again.
+         * for example after some library files changed
+         */
+        static void deleteMeshes(const uoset_t<mesh_identifier_t>& meshIdentifiers);
     };
 }
@@ -93,6 +93,11 @@ namespace bricksim::mesh {
         vertices.push_back(vertex);
     }
 
+    void LineData::clear() {
+        vertices.clear();
+        indices.clear();
+    }
+
     void LineData::rewriteInstanceBuffer(const std::vector<glm::mat4>& instances) const {
         controller::executeOpenGL([this, &instances]() {
             constexpr size_t instance_size = sizeof(glm::mat4);
@@ -111,4 +116,12 @@ namespace bricksim::mesh {
     size_t LineData::getIndexCount() const {
         return dataAlreadyDeleted ? uploadedIndexCount : indices.size();
     }
+
+    const std::vector<LineVertex>& LineData::getVertices() const {
+        return vertices;
+    }
+
+    const std::vector<unsigned int>& LineData::getIndices() const {
+        return indices;
+    }
 }
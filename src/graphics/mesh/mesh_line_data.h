@@ -12,7 +12,11 @@ namespace bricksim::mesh {
         void freeBuffers() const;
         void draw(const std::optional<InstanceRange>& sceneLayerInstanceRange) const;
         void addVertex(const LineVertex& vertex);
+        ///only allowed before initBuffers
+        void clear();
         void rewriteInstanceBuffer(const std::vector<glm::mat4>& instances) const;
+        [[nodiscard]] const std::vector<LineVertex>& getVertices() const;
+        [[nodiscard]] const std::vector<unsigned int>& getIndices() const;
 
     private:
         std::vector<LineVertex> vertices;
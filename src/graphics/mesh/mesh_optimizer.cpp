@@ -0,0 +1,233 @@
+#include "mesh_optimizer.h"
+#include "../../types.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <palanteer.h>
+
+namespace bricksim::mesh::mesh_optimizer {
+    namespace {
+        struct QuantizedVertex {
+            std::array<int64_t, 6> values;
+            bool operator==(const QuantizedVertex& other) const = default;
+        };
+
+        struct QuantizedVertexHash {
+            using is_avalanching = void;
+
+            uint64_t operator()(const QuantizedVertex& value) const noexcept {
+                return ankerl::unordered_dense::detail::wyhash::hash(value.values.data(), sizeof(value.values));
+            }
+        };
+
+        QuantizedVertex quantize(const TriangleVertex& vertex, const float positionFactor, const float normalFactor) {
+            return {{
+                    std::llround(vertex.position.x * positionFactor),
+                    std::llround(vertex.position.y * positionFactor),
+                    std::llround(vertex.position.z * positionFactor),
+                    std::llround(vertex.normal.x * normalFactor),
+                    std::llround(vertex.normal.y * normalFactor),
+                    std::llround(vertex.normal.z * normalFactor),
+            }};
+        }
+
+        float calculateVertexScore(const int cachePosition, const unsigned int remainingTriangles) {
+            //constants from the paper
+            constexpr float CACHE_DECAY_POWER = 1.5f;
+            constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+            constexpr float VALENCE_BOOST_SCALE = 2.0f;
+            constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+            if (remainingTriangles == 0) {
+                return -1.0f;
+            }
+            float score = 0.0f;
+            if (cachePosition >= 0) {
+                if (cachePosition < 3) {
+                    //the vertices of the last triangle get a fixed score so that the next triangle doesn't use them over and over again
+                    score = LAST_TRIANGLE_SCORE;
+                } else {
+                    constexpr float scaler = 1.0f / (VERTEX_CACHE_SIZE - 3);
+                    score = std::pow(1.0f - static_cast<float>(cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+                }
+            }
+            //vertices with few remaining triangles are preferred so that they can leave the cache sooner
+            score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingTriangles), -VALENCE_BOOST_POWER);
+            return score;
+        }
+    }
+
+    void weldVertices(std::vector<TriangleVertex>& vertices, std::vector<unsigned int>& indices, const float positionTolerance, const float normalTolerance) {
+        plFunction();
+        const float positionFactor = 1.0f / positionTolerance;
+        const float normalFactor = 1.0f / normalTolerance;
+
+        ankerl::unordered_dense::map<QuantizedVertex, unsigned int, QuantizedVertexHash> weldedIndices;
+        weldedIndices.reserve(vertices.size());
+        std::vector<unsigned int> remap(vertices.size());
+        std::vector<TriangleVertex> welded;
+        welded.reserve(vertices.size());
+        for (std::size_t i = 0; i < vertices.size(); ++i) {
+            const auto [it, inserted] = weldedIndices.try_emplace(quantize(vertices[i], positionFactor, normalFactor), static_cast<unsigned int>(welded.size()));
+            if (inserted) {
+                welded.push_back(vertices[i]);
+            }
+            remap[i] = it->second;
+        }
+
+        std::size_t newIndexCount = 0;
+        for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+            const auto a = remap[indices[i]];
+            const auto b = remap[indices[i + 1]];
+            const auto c = remap[indices[i + 2]];
+            if (a != b && b != c && c != a) {
+                indices[newIndexCount++] = a;
+                indices[newIndexCount++] = b;
+                indices[newIndexCount++] = c;
+            }
+        }
+        indices.resize(newIndexCount);
+        vertices = std::move(welded);
+    }
+
+    void optimizeVertexCache(std::vector<unsigned int>& indices, const std::size_t vertexCount) {
+        plFunction();
+        const std::size_t triangleCount = indices.size() / 3;
+        if (triangleCount < 2) {
+            return;
+        }
+
+        //triangles of each vertex in one array, the triangles of vertex v are in [firstTriangle[v], firstTriangle[v+1])
+        std::vector<unsigned int> firstTriangle(vertexCount + 1, 0);
+        for (std::size_t i = 0; i < triangleCount * 3; ++i) {
+            ++firstTriangle[indices[i] + 1];
+        }
+        for (std::size_t v = 0; v < vertexCount; ++v) {
+            firstTriangle[v + 1] += firstTriangle[v];
+        }
+        std::vector<unsigned int> trianglesOfVertex(triangleCount * 3);
+        {
+            std::vector<unsigned int> fillPosition(firstTriangle.begin(), firstTriangle.end() - 1);
+            for (std::size_t i = 0; i < triangleCount * 3; ++i) {
+                trianglesOfVertex[fillPosition[indices[i]]++] = static_cast<unsigned int>(i / 3);
+            }
+        }
+
+        std::vector<unsigned int> remainingTriangles(vertexCount);
+        std::vector<int> cachePosition(vertexCount, -1);
+        std::vector<float> vertexScore(vertexCount);
+        for (std::size_t v = 0; v < vertexCount; ++v) {
+            remainingTriangles[v] = firstTriangle[v + 1] - firstTriangle[v];
+            vertexScore[v] = calculateVertexScore(-1, remainingTriangles[v]);
+        }
+
+        std::vector<float> triangleScore(triangleCount);
+        std::vector<bool> triangleAdded(triangleCount, false);
+        for (std::size_t t = 0; t < triangleCount; ++t) {
+            triangleScore[t] = vertexScore[indices[3 * t]] + vertexScore[indices[3 * t + 1]] + vertexScore[indices[3 * t + 2]];
+        }
+
+        std::vector<unsigned int> result;
+        result.reserve(triangleCount * 3);
+        std::vector<unsigned int> cache;
+        std::vector<unsigned int> newCache;
+        cache.reserve(VERTEX_CACHE_SIZE + 3);
+        newCache.reserve(VERTEX_CACHE_SIZE + 3);
+
+        std::size_t nextUnaddedTriangle = 0;
+        auto bestTriangle = static_cast<std::size_t>(std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+        while (result.size() < triangleCount * 3) {
+            triangleAdded[bestTriangle] = true;
+            const auto* triangleIndices = &indices[3 * bestTriangle];
+            result.insert(result.end(), triangleIndices, triangleIndices + 3);
+
+            newCache.clear();
+            for (int k = 0; k < 3; ++k) {
+                const auto v = triangleIndices[k];
+                --remainingTriangles[v];
+                if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()) {
+                    newCache.push_back(v);
+                }
+            }
+            for (const auto v: cache) {
+                if (std::find(newCache.begin(), newCache.end(), v) == newCache.end()) {
+                    newCache.push_back(v);
+                }
+            }
+
+            for (std::size_t i = 0; i < newCache.size(); ++i) {
+                const auto v = newCache[i];
+                cachePosition[v] = i < VERTEX_CACHE_SIZE ? static_cast<int>(i) : -1;
+                vertexScore[v] = calculateVertexScore(cachePosition[v], remainingTriangles[v]);
+            }
+
+            //only the triangles of the vertices which were in the cache can have a changed score
+            float bestScore = -1.0f;
+            bool bestFound = false;
+            for (const auto v: newCache) {
+                for (auto i = firstTriangle[v]; i < firstTriangle[v + 1]; ++i) {
+                    const auto t = trianglesOfVertex[i];
+                    if (triangleAdded[t]) {
+                        continue;
+                    }
+                    triangleScore[t] = vertexScore[indices[3 * t]] + vertexScore[indices[3 * t + 1]] + vertexScore[indices[3 * t + 2]];
+                    if (triangleScore[t] > bestScore) {
+                        bestScore = triangleScore[t];
+                        bestTriangle = t;
+                        bestFound = true;
+                    }
+                }
+            }
+
+            if (newCache.size() > VERTEX_CACHE_SIZE) {
+                newCache.resize(VERTEX_CACHE_SIZE);
+            }
+            std::swap(cache, newCache);
+
+            if (!bestFound) {
+                //no triangle shares a vertex with the cache, continue with the next unconnected part of the mesh
+                while (nextUnaddedTriangle < triangleCount && triangleAdded[nextUnaddedTriangle]) {
+                    ++nextUnaddedTriangle;
+                }
+                bestTriangle = nextUnaddedTriangle;
+            }
+        }
+
+        std::copy(result.begin(), result.end(), indices.begin());
+    }
+
+    void optimizeVertexFetch(std::vector<TriangleVertex>& vertices, std::vector<unsigned int>& indices) {
+        plFunction();
+        constexpr auto UNUSED = std::numeric_limits<unsigned int>::max();
+        std::vector<unsigned int> remap(vertices.size(), UNUSED);
+        std::vector<TriangleVertex> reordered;
+        reordered.reserve(vertices.size());
+        for (auto& idx: indices) {
+            if (remap[idx] == UNUSED) {
+                remap[idx] = static_cast<unsigned int>(reordered.size());
+                reordered.push_back(vertices[idx]);
+            }
+            idx = remap[idx];
+        }
+        vertices = std::move(reordered);
+    }
+
+    float calculateACMR(const std::vector<unsigned int>& indices, const std::size_t cacheSize) {
+        const std::size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0) {
+            return 0.0f;
+        }
+        std::vector<unsigned int> fifo(cacheSize, std::numeric_limits<unsigned int>::max());
+        std::size_t fifoHead = 0;
+        std::size_t misses = 0;
+        for (std::size_t i = 0; i < triangleCount * 3; ++i) {
+            if (std::find(fifo.begin(), fifo.end(), indices[i]) == fifo.end()) {
+                fifo[fifoHead] = indices[i];
+                fifoHead = (fifoHead + 1) % cacheSize;
+                ++misses;
+            }
+        }
+        return static_cast<float>(misses) / static_cast<float>(triangleCount);
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "mesh_simple_classes.h"
+#include <vector>
+
+namespace bricksim::mesh::mesh_optimizer {
+    ///positions are in LDU
+    constexpr float WELD_POSITION_TOLERANCE = 1e-3f;
+    constexpr float WELD_NORMAL_TOLERANCE = 1e-3f;
+    ///size of the simulated post-transform vertex cache
+    constexpr std::size_t VERTEX_CACHE_SIZE = 32;
+
+    /**
+     * merges vertices whose position and normal are equal within the tolerances and removes the triangles which become degenerate by that.
+     * the first vertex of every group of merged vertices is kept
+     */
+    void weldVertices(std::vector<TriangleVertex>& vertices, std::vector<unsigned int>& indices, float positionTolerance, float normalTolerance);
+
+    /**
+     * reorders the triangles so that vertices are reused while they are still in the post-transform cache of the GPU.
+     * Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+     */
+    void optimizeVertexCache(std::vector<unsigned int>& indices, std::size_t vertexCount);
+
+    /**
+     * reorders the vertices in the order they're first used by indices and removes the unused ones
+     */
+    void optimizeVertexFetch(std::vector<TriangleVertex>& vertices, std::vector<unsigned int>& indices);
+
+    /**
+     * @return average cache miss ratio (transformed vertices per triangle) of a FIFO cache with cacheSize entries.
+     * 3.0 is the worst value, 0.5 is about the best value for regular grids
+     */
+    float calculateACMR(const std::vector<unsigned int>& indices, std::size_t cacheSize);
+}
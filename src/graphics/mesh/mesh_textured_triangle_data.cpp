@@ -114,6 +114,10 @@ namespace bricksim::mesh {
         }
     }
 
+    const std::vector<TexturedTriangleVertex>& TexturedTriangleData::getVertices() const {
+        return vertices;
+    }
+
     void TexturedTriangleData::addVertex(const TexturedTriangleVertex& vertex) {
         vertices.push_back(vertex);
     }
@@ -17,6 +17,7 @@ namespace bricksim::mesh {
         [[nodiscard]] size_t getVertexCount() const;
         void addVerticesForOuterDimensions(std::vector<glm::dvec3>& coords) const;
         void addVertex(const TexturedTriangleVertex& vertex);
+        [[nodiscard]] const std::vector<TexturedTriangleVertex>& getVertices() const;
 
     private:
         std::shared_ptr<graphics::Texture> texture;
@@ -3,7 +3,10 @@
 #include "../../controller.h"
 #include "../../metrics.h"
 #include "../opengl_native_or_replacement.h"
+#include "flattened_geometry.h"
+#include "mesh_optimizer.h"
 #include "glm/gtx/rotate_vector.inl"
+#include <limits>
 
 namespace bricksim::mesh {
     void TriangleData::initBuffers(const std::vector<MeshInstance>& instances) {
@@ -64,8 +67,19 @@ namespace bricksim::mesh {
         //ebo
         glGenBuffers(1, &EBO);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>((sizeof(unsigned int) * indices.size())), indices.data(), GL_STATIC_DRAW);
-        metrics::vramUsageBytes += sizeof(unsigned int) * indices.size();
+        shortIndices = vertices.size() <= std::numeric_limits<uint16_t>::max() + 1ull;
+        if (shortIndices) {
+            const std::vector<uint16_t> shortIndexArray(indices.begin(), indices.end());
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>((sizeof(uint16_t) * shortIndexArray.size())), shortIndexArray.data(), GL_STATIC_DRAW);
+        } else {
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>((sizeof(unsigned int) * indices.size())), indices.data(), GL_STATIC_DRAW);
+        }
+        metrics::vramUsageBytes += getIndexSize() * indices.size();
+
+        const auto vertexCountBefore = optimizationStats.has_value() ? optimizationStats->vertexCountBefore : vertices.size();
+        const auto indexCountBefore = optimizationStats.has_value() ? optimizationStats->indexCountBefore : indices.size();
+        metrics::vramSavedByMeshOptimization += vertexCountBefore * vertex_size + indexCountBefore * sizeof(unsigned int)
+                                                - vertices.size() * vertex_size - indices.size() * getIndexSize();
 
         if (config::get().graphics.deleteVertexDataAfterUploading) {
             dataAlreadyDeleted = true;
@@ -94,7 +108,7 @@ namespace bricksim::mesh {
             glBindVertexArray(VAO);
             graphics::opengl_native_or_replacement::drawElementsInstancedBaseInstance(GL_TRIANGLES,
                                                                                       static_cast<GLsizei>(getIndexCount()),
-                                                                                      GL_UNSIGNED_INT,
+                                                                                      shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT,
                                                                                       nullptr,
                                                                                       static_cast<GLsizei>(sceneLayerInstanceRange->count),
                                                                                       sceneLayerInstanceRange->start,
@@ -170,12 +184,49 @@ namespace bricksim::mesh {
         vertices.push_back(vertex);
     }
 
+    void TriangleData::addTransformedVertices(const std::vector<TriangleVertex>& newVertices, const std::vector<unsigned int>& newIndices, const glm::mat4& transformation) {
+        const auto baseIndex = static_cast<unsigned int>(vertices.size());
+        vertices.resize(vertices.size() + newVertices.size(), {{}, {}});
+        transformTriangleVertices(newVertices.data(), vertices.data() + baseIndex, newVertices.size(), transformation);
+        indices.reserve(indices.size() + newIndices.size());
+        for (const auto idx: newIndices) {
+            indices.push_back(baseIndex + idx);
+        }
+    }
+
     void TriangleData::addVerticesForOuterDimensions(std::vector<glm::dvec3>& coords) const {
         for (auto& item: vertices) {
             coords.push_back(item.position);
         }
     }
 
+    void TriangleData::optimize() {
+        if (dataAlreadyDeleted || optimizationStats.has_value()) {
+            return;
+        }
+        OptimizationStats stats{
+                .vertexCountBefore = vertices.size(),
+                .indexCountBefore = indices.size(),
+                .acmrBefore = mesh_optimizer::calculateACMR(indices, mesh_optimizer::VERTEX_CACHE_SIZE),
+                .acmrAfter = 0.0f,
+        };
+        mesh_optimizer::weldVertices(vertices, indices, mesh_optimizer::WELD_POSITION_TOLERANCE, mesh_optimizer::WELD_NORMAL_TOLERANCE);
+        mesh_optimizer::optimizeVertexCache(indices, vertices.size());
+        mesh_optimizer::optimizeVertexFetch(vertices, indices);
+        stats.acmrAfter = mesh_optimizer::calculateACMR(indices, mesh_optimizer::VERTEX_CACHE_SIZE);
+        vertices.shrink_to_fit();
+        indices.shrink_to_fit();
+        optimizationStats = stats;
+    }
+
+    const std::optional<TriangleData::OptimizationStats>& TriangleData::getOptimizationStats() const {
+        return optimizationStats;
+    }
+
+    size_t TriangleData::getIndexSize() const {
+        return shortIndices ? sizeof(uint16_t) : sizeof(unsigned int);
+    }
+
     const std::vector<TriangleVertex>& TriangleData::getVertices() const {
         return vertices;
     }
@@ -200,7 +251,9 @@ namespace bricksim::mesh {
         lastInstanceBufferSize(other.lastInstanceBufferSize),
         dataAlreadyDeleted(other.dataAlreadyDeleted),
         uploadedVertexCount(other.uploadedVertexCount),
-        uploadedIndexCount(other.uploadedIndexCount) {}
+        uploadedIndexCount(other.uploadedIndexCount),
+        shortIndices(other.shortIndices),
+        optimizationStats(other.optimizationStats) {}
 
     TriangleData& TriangleData::operator=(TriangleData&& other) noexcept {
         color = other.color;
@@ -215,6 +268,8 @@ namespace bricksim::mesh {
         dataAlreadyDeleted = other.dataAlreadyDeleted;
         uploadedVertexCount = other.uploadedVertexCount;
         uploadedIndexCount = other.uploadedIndexCount;
+        shortIndices = other.shortIndices;
+        optimizationStats = other.optimizationStats;
         return *this;
     }
 }
@@ -1,10 +1,18 @@
 #pragma once
 
 #include "mesh_simple_classes.h"
+#include <optional>
 
 namespace bricksim::mesh {
     class TriangleData {
     public:
+        struct OptimizationStats {
+            size_t vertexCountBefore;
+            size_t indexCountBefore;
+            float acmrBefore;
+            float acmrAfter;
+        };
+
         explicit TriangleData(const ldr::ColorReference& color);
         TriangleData(const TriangleData&) = delete;
         TriangleData(TriangleData&& other) noexcept;
@@ -16,14 +24,27 @@ namespace bricksim::mesh {
         unsigned int addRawVertex(const TriangleVertex& vertex);
         void addRawIndex(unsigned int index);
         void addVertexWithIndex(const TriangleVertex& vertex);
+        /**
+         * appends vertices transformed by transformation and indices relative to the first appended vertex
+         */
+        void addTransformedVertices(const std::vector<TriangleVertex>& newVertices, const std::vector<unsigned int>& newIndices, const glm::mat4& transformation);
         void rewriteInstanceBuffer(const std::vector<MeshInstance>& instances);
         [[nodiscard]] size_t getVertexCount() const;
         [[nodiscard]] size_t getIndexCount() const;
         void addVerticesForOuterDimensions(std::vector<glm::dvec3>& coords) const;
+        /**
+         * welds equal vertices and reorders the triangles and vertices for the GPU caches. only allowed before initBuffers, does nothing if already optimized
+         */
+        void optimize();
+        [[nodiscard]] const std::optional<OptimizationStats>& getOptimizationStats() const;
+        ///2 if the vertex count allows 16-bit indices, 4 otherwise. only valid after initBuffers
+        [[nodiscard]] size_t getIndexSize() const;
 
         [[nodiscard]] bool isDataAlreadyDeleted() const;
         [[nodiscard]] const std::vector<TriangleVertex>& getVertices() const;
         [[nodiscard]] const std::vector<unsigned int>& getIndices() const;
+        ///the instance data as it's uploaded to the instance buffer
+        [[nodiscard]] std::vector<TriangleInstance> generateInstancesArray(const std::vector<MeshInstance>& instances) const;
 
     private:
         ldr::ColorReference color;
@@ -33,13 +54,14 @@ namespace bricksim::mesh {
         unsigned int vertexVBO;
         unsigned int instanceVBO;
         unsigned int EBO;
-        std::vector<TriangleInstance> generateInstancesArray(const std::vector<MeshInstance>& instances) const;
 
         size_t instanceCount;
         size_t lastInstanceBufferSize = 0;
         bool dataAlreadyDeleted = false;
         size_t uploadedVertexCount;
         size_t uploadedIndexCount;
+        bool shortIndices = false;
+        std::optional<OptimizationStats> optimizationStats;
         void initBuffersImpl(const std::vector<MeshInstance>& instances);
     };
 }
@@ -0,0 +1,279 @@
+#include "bvh.h"
+#include "../../helpers/util.h"
+#include <algorithm>
+#include <numeric>
+#include <palanteer.h>
+
+namespace bricksim::picking {
+    namespace bvh {
+        namespace {
+            struct Bin {
+                aabb::AABB bounds;
+                uint32_t count = 0;
+            };
+
+            void setNodeBounds(Node& node, const aabb::AABB& bounds) {
+                node.pMin = bounds.pMin;
+                node.pMax = bounds.pMax;
+            }
+
+            float getSurfaceAreaOrZero(const aabb::AABB& bounds) {
+                return bounds.isDefined() ? bounds.getSurfaceArea() : 0.f;
+            }
+        }
+
+        std::vector<Node> build(const std::vector<aabb::AABB>& primitiveBounds, std::vector<uint32_t>& primitiveOrder, const uint32_t maxLeafSize) {
+            std::vector<Node> nodes;
+            primitiveOrder.resize(primitiveBounds.size());
+            std::iota(primitiveOrder.begin(), primitiveOrder.end(), 0);
+            if (primitiveBounds.empty()) {
+                return nodes;
+            }
+            std::vector<glm::vec3> centroids;
+            centroids.reserve(primitiveBounds.size());
+            for (const auto& bounds: primitiveBounds) {
+                centroids.push_back(bounds.getCenter());
+            }
+
+            nodes.reserve(2 * primitiveBounds.size() / maxLeafSize + 1);
+            nodes.push_back({{}, 0, {}, static_cast<uint32_t>(primitiveBounds.size())});
+            std::vector<std::pair<uint32_t, uint32_t>> stack{{0, 0}};
+            while (!stack.empty()) {
+                const auto [nodeIdx, depth] = stack.back();
+                stack.pop_back();
+                const auto first = nodes[nodeIdx].leftOrFirst;
+                const auto count = nodes[nodeIdx].primitiveCount;
+
+                aabb::AABB bounds;
+                aabb::AABB centroidBounds;
+                for (uint32_t i = first; i < first + count; ++i) {
+                    bounds.includeAABB(primitiveBounds[primitiveOrder[i]]);
+                    centroidBounds.includePoint(centroids[primitiveOrder[i]]);
+                }
+                setNodeBounds(nodes[nodeIdx], bounds);
+                if (count <= maxLeafSize || depth >= MAX_DEPTH) {
+                    continue;
+                }
+
+                //find the cheapest split plane between the bins of all three axes
+                const auto centroidSize = centroidBounds.getSize();
+                float bestCost = getSurfaceAreaOrZero(bounds) * static_cast<float>(count);
+                int bestAxis = -1;
+                int bestSplit = 0;
+                for (int axis = 0; axis < 3; ++axis) {
+                    if (centroidSize[axis] <= 0.f) {
+                        continue;
+                    }
+                    const float scale = SAH_BIN_COUNT / centroidSize[axis];
+                    std::array<Bin, SAH_BIN_COUNT> bins;
+                    for (uint32_t i = first; i < first + count; ++i) {
+                        const auto prim = primitiveOrder[i];
+                        const int binIdx = std::min(SAH_BIN_COUNT - 1, static_cast<int>((centroids[prim][axis] - centroidBounds.pMin[axis]) * scale));
+                        bins[binIdx].bounds.includeAABB(primitiveBounds[prim]);
+                        ++bins[binIdx].count;
+                    }
+                    std::array<float, SAH_BIN_COUNT - 1> leftCost{};
+                    aabb::AABB leftBounds;
+                    uint32_t leftCount = 0;
+                    for (int i = 0; i < SAH_BIN_COUNT - 1; ++i) {
+                        leftBounds.includeAABB(bins[i].bounds);
+                        leftCount += bins[i].count;
+                        leftCost[i] = getSurfaceAreaOrZero(leftBounds) * static_cast<float>(leftCount);
+                    }
+                    aabb::AABB rightBounds;
+                    uint32_t rightCount = 0;
+                    for (int i = SAH_BIN_COUNT - 1; i > 0; --i) {
+                        rightBounds.includeAABB(bins[i].bounds);
+                        rightCount += bins[i].count;
+                        const float cost = leftCost[i - 1] + getSurfaceAreaOrZero(rightBounds) * static_cast<float>(rightCount);
+                        if (cost < bestCost && rightCount > 0 && rightCount < count) {
+                            bestCost = cost;
+                            bestAxis = axis;
+                            bestSplit = i;
+                        }
+                    }
+                }
+
+                auto middle = primitiveOrder.begin() + first;
+                if (bestAxis >= 0) {
+                    const float scale = SAH_BIN_COUNT / centroidSize[bestAxis];
+                    middle = std::partition(primitiveOrder.begin() + first, primitiveOrder.begin() + first + count, [&](uint32_t prim) {
+                        return std::min(SAH_BIN_COUNT - 1, static_cast<int>((centroids[prim][bestAxis] - centroidBounds.pMin[bestAxis]) * scale)) < bestSplit;
+                    });
+                } else if (count > 4 * maxLeafSize) {
+                    //splitting isn't cheaper, but big leaves make the traversal slow, so split in the middle of the longest axis
+                    const auto axis = static_cast<int>(std::max_element(&centroidSize[0], &centroidSize[0] + 3) - &centroidSize[0]);
+                    middle = primitiveOrder.begin() + first + count / 2;
+                    std::nth_element(primitiveOrder.begin() + first, middle, primitiveOrder.begin() + first + count, [&](uint32_t a, uint32_t b) {
+                        return centroids[a][axis] < centroids[b][axis];
+                    });
+                } else {
+                    continue;
+                }
+                const auto leftCount = static_cast<uint32_t>(middle - (primitiveOrder.begin() + first));
+                const auto leftIdx = static_cast<uint32_t>(nodes.size());
+                nodes.push_back({{}, first, {}, leftCount});
+                nodes.push_back({{}, first + leftCount, {}, count - leftCount});
+                nodes[nodeIdx].leftOrFirst = leftIdx;
+                nodes[nodeIdx].primitiveCount = 0;
+                stack.emplace_back(leftIdx, depth + 1);
+                stack.emplace_back(leftIdx + 1, depth + 1);
+            }
+            return nodes;
+        }
+
+        std::optional<float> intersectRayAABB(const glm::vec3& origin, const glm::vec3& inverseDirection, const glm::vec3& pMin, const glm::vec3& pMax, const float maxDistance) {
+            const auto t0 = (pMin - origin) * inverseDirection;
+            const auto t1 = (pMax - origin) * inverseDirection;
+            const auto tSmaller = util::cwiseMin(t0, t1);
+            const auto tBigger = util::cwiseMax(t0, t1);
+            const float tEnter = std::max(std::max(tSmaller.x, tSmaller.y), std::max(tSmaller.z, 0.f));
+            const float tExit = std::min(std::min(tBigger.x, tBigger.y), std::min(tBigger.z, maxDistance));
+            if (tEnter <= tExit) {
+                return tEnter;
+            }
+            return std::nullopt;
+        }
+
+        std::optional<float> intersectRayTriangle(const Ray3& ray, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+            constexpr float EPSILON = 1e-9f;
+            const auto edge1 = b - a;
+            const auto edge2 = c - a;
+            const auto pvec = glm::cross(ray.direction, edge2);
+            const float det = glm::dot(edge1, pvec);
+            if (std::abs(det) < EPSILON) {
+                return std::nullopt;
+            }
+            const float inverseDet = 1.f / det;
+            const auto tvec = ray.origin - a;
+            const float u = glm::dot(tvec, pvec) * inverseDet;
+            if (u < 0.f || u > 1.f) {
+                return std::nullopt;
+            }
+            const auto qvec = glm::cross(tvec, edge1);
+            const float v = glm::dot(ray.direction, qvec) * inverseDet;
+            if (v < 0.f || u + v > 1.f) {
+                return std::nullopt;
+            }
+            const float t = glm::dot(edge2, qvec) * inverseDet;
+            if (t < 0.f) {
+                return std::nullopt;
+            }
+            return t;
+        }
+    }
+
+    void TriangleBvh::addTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+        triangles.push_back({a, b, c});
+    }
+
+    void TriangleBvh::addTriangles(const std::vector<mesh::TriangleVertex>& vertices, const std::vector<unsigned int>& indices) {
+        triangles.reserve(triangles.size() + indices.size() / 3);
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            addTriangle(vertices[indices[i]].position, vertices[indices[i + 1]].position, vertices[indices[i + 2]].position);
+        }
+    }
+
+    void TriangleBvh::addTriangles(const std::vector<mesh::TexturedTriangleVertex>& vertices) {
+        triangles.reserve(triangles.size() + vertices.size() / 3);
+        for (size_t i = 0; i + 2 < vertices.size(); i += 3) {
+            addTriangle(vertices[i].position, vertices[i + 1].position, vertices[i + 2].position);
+        }
+    }
+
+    void TriangleBvh::build() {
+        plFunction();
+        std::vector<aabb::AABB> triangleBounds;
+        triangleBounds.reserve(triangles.size());
+        for (const auto& triangle: triangles) {
+            aabb::AABB& box = triangleBounds.emplace_back();
+            for (const auto& p: triangle) {
+                box.includePoint(p);
+            }
+        }
+        std::vector<uint32_t> order;
+        nodes = bvh::build(triangleBounds, order, bvh::MAX_LEAF_SIZE);
+
+        //store the triangles in leaf order so that a leaf references a contiguous range
+        std::vector<std::array<glm::vec3, 3>> sortedTriangles;
+        sortedTriangles.reserve(triangles.size());
+        for (const auto idx: order) {
+            sortedTriangles.push_back(triangles[idx]);
+        }
+        triangles = std::move(sortedTriangles);
+        nodes.shrink_to_fit();
+        bounds = nodes.empty() ? aabb::AABB() : aabb::AABB(nodes[0].pMin, nodes[0].pMax);
+        built = true;
+    }
+
+    std::optional<TriangleBvh::Hit> TriangleBvh::intersectRay(const Ray3& ray, float maxDistance) const {
+        if (nodes.empty()) {
+            return std::nullopt;
+        }
+        const auto inverseDirection = 1.f / ray.direction;
+        std::optional<Hit> result;
+        std::array<uint32_t, bvh::MAX_DEPTH + 2> stack;
+        size_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0) {
+            const auto& node = nodes[stack[--stackSize]];
+            if (!bvh::intersectRayAABB(ray.origin, inverseDirection, node.pMin, node.pMax, maxDistance).has_value()) {
+                continue;
+            }
+            if (node.isLeaf()) {
+                for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.primitiveCount; ++i) {
+                    const auto& [a, b, c] = triangles[i];
+                    const auto t = bvh::intersectRayTriangle(ray, a, b, c);
+                    if (t.has_value() && *t < maxDistance) {
+                        maxDistance = *t;
+                        result = Hit{*t, {}, i};
+                    }
+                }
+            } else {
+                const auto& left = nodes[node.leftOrFirst];
+                const auto& right = nodes[node.leftOrFirst + 1];
+                const auto tLeft = bvh::intersectRayAABB(ray.origin, inverseDirection, left.pMin, left.pMax, maxDistance);
+                const auto tRight = bvh::intersectRayAABB(ray.origin, inverseDirection, right.pMin, right.pMax, maxDistance);
+                //push the farther child first so that the nearer one is visited first
+                if (tLeft.has_value() && tRight.has_value()) {
+                    const bool leftFirst = *tLeft <= *tRight;
+                    stack[stackSize++] = leftFirst ? node.leftOrFirst + 1 : node.leftOrFirst;
+                    stack[stackSize++] = leftFirst ? node.leftOrFirst : node.leftOrFirst + 1;
+                } else if (tLeft.has_value()) {
+                    stack[stackSize++] = node.leftOrFirst;
+                } else if (tRight.has_value()) {
+                    stack[stackSize++] = node.leftOrFirst + 1;
+                }
+            }
+        }
+        if (result.has_value()) {
+            const auto& [a, b, c] = triangles[result->triangle];
+            auto normal = glm::normalize(glm::cross(b - a, c - a));
+            if (glm::dot(normal, ray.direction) > 0.f) {
+                normal = -normal;
+            }
+            result->normal = normal;
+        }
+        return result;
+    }
+
+    bool TriangleBvh::isBuilt() const {
+        return built;
+    }
+
+    const aabb::AABB& TriangleBvh::getBounds() const {
+        return bounds;
+    }
+
+    size_t TriangleBvh::getTriangleCount() const {
+        return triangles.size();
+    }
+
+    size_t TriangleBvh::getNodeCount() const {
+        return nodes.size();
+    }
+
+    size_t TriangleBvh::getMemoryUsage() const {
+        return triangles.capacity() * sizeof(triangles[0]) + nodes.capacity() * sizeof(bvh::Node);
+    }
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "../../helpers/bounding_volumes.h"
+#include "../../helpers/ray.h"
+#include "../mesh/mesh_simple_classes.h"
+#include <array>
+#include <optional>
+#include <vector>
+
+namespace bricksim::picking {
+    namespace bvh {
+        struct Node {
+            glm::vec3 pMin;
+            ///index of the first child for inner nodes (the second one is leftOrFirst+1), index of the first primitive for leaves
+            uint32_t leftOrFirst;
+            glm::vec3 pMax;
+            ///0 for inner nodes
+            uint32_t primitiveCount;
+
+            [[nodiscard]] bool isLeaf() const {
+                return primitiveCount > 0;
+            }
+        };
+
+        enum class NodeDecision {
+            SKIP,
+            DESCEND,
+            ///the subtree contains a triangle which matches, the traversal stops
+            ACCEPT,
+        };
+
+        constexpr uint32_t MAX_LEAF_SIZE = 4;
+        constexpr int SAH_BIN_COUNT = 12;
+        ///nodes at this depth are always leaves, so traversal stacks of MAX_DEPTH+2 entries are enough
+        constexpr uint32_t MAX_DEPTH = 62;
+
+        /**
+         * builds a BVH over primitives with a binned surface area heuristic.
+         * @param primitiveOrder is filled with the primitive indices in leaf order
+         * @return the nodes, the root is at index 0. empty if there are no primitives
+         */
+        std::vector<Node> build(const std::vector<aabb::AABB>& primitiveBounds, std::vector<uint32_t>& primitiveOrder, uint32_t maxLeafSize);
+
+        /**
+         * @param inverseDirection 1/ray.direction (component-wise)
+         * @return the distance where the ray enters the box or nullopt if it doesn't hit it before maxDistance
+         */
+        std::optional<float> intersectRayAABB(const glm::vec3& origin, const glm::vec3& inverseDirection, const glm::vec3& pMin, const glm::vec3& pMax, float maxDistance);
+
+        /**
+         * two-sided Möller-Trumbore intersection
+         * @return the distance in units of ray.direction
+         */
+        std::optional<float> intersectRayTriangle(const Ray3& ray, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+    }
+
+    /**
+     * bounding volume hierarchy over the triangles of a mesh in mesh coordinates.
+     * it keeps its own copy of the positions, so it stays usable after the vertex data of the mesh was deleted
+     */
+    class TriangleBvh {
+    public:
+        struct Hit {
+            ///in units of the ray direction
+            float distance;
+            ///geometric normal of the triangle, normalized and facing against the ray
+            glm::vec3 normal;
+            uint32_t triangle;
+        };
+
+        TriangleBvh() = default;
+
+        void addTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+        void addTriangles(const std::vector<mesh::TriangleVertex>& vertices, const std::vector<unsigned int>& indices);
+        ///every three vertices are a triangle
+        void addTriangles(const std::vector<mesh::TexturedTriangleVertex>& vertices);
+        /**
+         * builds the tree over the triangles which were added. triangles can't be added anymore after that
+         */
+        void build();
+
+        [[nodiscard]] std::optional<Hit> intersectRay(const Ray3& ray, float maxDistance) const;
+
+        /**
+         * walks the tree until nodeVisitor accepts a node or triangleVisitor returns true
+         * @param nodeVisitor bvh::NodeDecision(const glm::vec3& pMin, const glm::vec3& pMax)
+         * @param triangleVisitor bool(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+         * @return true if a node was accepted or triangleVisitor returned true for any triangle
+         */
+        template<typename NodeVisitor, typename TriangleVisitor>
+        bool findTriangle(NodeVisitor nodeVisitor, TriangleVisitor triangleVisitor) const {
+            if (nodes.empty()) {
+                return false;
+            }
+            std::array<uint32_t, bvh::MAX_DEPTH + 2> stack;
+            size_t stackSize = 0;
+            stack[stackSize++] = 0;
+            while (stackSize > 0) {
+                const auto& node = nodes[stack[--stackSize]];
+                const auto decision = nodeVisitor(node.pMin, node.pMax);
+                if (decision == bvh::NodeDecision::ACCEPT) {
+                    return true;
+                }
+                if (decision == bvh::NodeDecision::SKIP) {
+                    continue;
+                }
+                if (node.isLeaf()) {
+                    for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.primitiveCount; ++i) {
+                        if (triangleVisitor(triangles[i][0], triangles[i][1], triangles[i][2])) {
+                            return true;
+                        }
+                    }
+                } else {
+                    stack[stackSize++] = node.leftOrFirst + 1;
+                    stack[stackSize++] = node.leftOrFirst;
+                }
+            }
+            return false;
+        }
+
+        [[nodiscard]] bool isBuilt() const;
+        [[nodiscard]] const aabb::AABB& getBounds() const;
+        [[nodiscard]] size_t getTriangleCount() const;
+        [[nodiscard]] size_t getNodeCount() const;
+        [[nodiscard]] size_t getMemoryUsage() const;
+
+    private:
+        std::vector<std::array<glm::vec3, 3>> triangles;
+        std::vector<bvh::Node> nodes;
+        aabb::AABB bounds;
+        bool built = false;
+    };
+}
@@ -0,0 +1,343 @@
+#include "scene_picker.h"
+#include "../../helpers/util.h"
+#include <algorithm>
+#include <map>
+#include <palanteer.h>
+
+namespace bricksim::picking {
+    namespace {
+        constexpr uint32_t INSTANCE_LEAF_SIZE = 2;
+        ///points with a smaller clip space w are treated as behind the camera
+        constexpr float MIN_CLIP_W = 1e-6f;
+
+        float cross2d(const glm::vec2& a, const glm::vec2& b) {
+            return a.x * b.y - a.y * b.x;
+        }
+
+        float orientation(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c) {
+            return cross2d(b - a, c - a);
+        }
+
+        bool isOnSegment(const glm::vec2& a, const glm::vec2& b, const glm::vec2& p) {
+            return std::min(a.x, b.x) <= p.x && p.x <= std::max(a.x, b.x)
+                   && std::min(a.y, b.y) <= p.y && p.y <= std::max(a.y, b.y);
+        }
+
+        bool doSegmentsIntersect(const glm::vec2& a1, const glm::vec2& a2, const glm::vec2& b1, const glm::vec2& b2) {
+            const float d1 = orientation(b1, b2, a1);
+            const float d2 = orientation(b1, b2, a2);
+            const float d3 = orientation(a1, a2, b1);
+            const float d4 = orientation(a1, a2, b2);
+            if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))) {
+                return true;
+            }
+            return (d1 == 0 && isOnSegment(b1, b2, a1))
+                   || (d2 == 0 && isOnSegment(b1, b2, a2))
+                   || (d3 == 0 && isOnSegment(a1, a2, b1))
+                   || (d4 == 0 && isOnSegment(a1, a2, b2));
+        }
+
+        bool isPointInTriangle2d(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c, const glm::vec2& p) {
+            const float d1 = orientation(a, b, p);
+            const float d2 = orientation(b, c, p);
+            const float d3 = orientation(c, a, p);
+            const bool hasNegative = d1 < 0 || d2 < 0 || d3 < 0;
+            const bool hasPositive = d1 > 0 || d2 > 0 || d3 > 0;
+            return !(hasNegative && hasPositive);
+        }
+
+        class ScreenProjection {
+        public:
+            ScreenProjection(const glm::mat4& toClip, const glm::vec2& screenSize) :
+                toClip(toClip), screenSize(screenSize) {}
+
+            ///@return nullopt if the point is behind the camera
+            [[nodiscard]] std::optional<glm::vec2> projectPoint(const glm::vec3& point) const {
+                const auto clip = toClip * glm::vec4(point, 1.f);
+                if (clip.w < MIN_CLIP_W) {
+                    return std::nullopt;
+                }
+                const glm::vec2 ndc = glm::vec2(clip) / clip.w;
+                return glm::vec2((ndc.x + 1.f) * .5f * screenSize.x, (1.f - ndc.y) * .5f * screenSize.y);
+            }
+
+            [[nodiscard]] bvh::NodeDecision decideBox(const SelectionPolygon& polygon, const glm::vec3& pMin, const glm::vec3& pMax) const {
+                glm::vec2 rectMin(INFINITY);
+                glm::vec2 rectMax(-INFINITY);
+                int cornersBehind = 0;
+                for (int i = 0; i < 8; ++i) {
+                    const glm::vec3 corner(i & 1 ? pMax.x : pMin.x, i & 2 ? pMax.y : pMin.y, i & 4 ? pMax.z : pMin.z);
+                    const auto projected = projectPoint(corner);
+                    if (projected.has_value()) {
+                        rectMin = util::cwiseMin(rectMin, *projected);
+                        rectMax = util::cwiseMax(rectMax, *projected);
+                    } else {
+                        ++cornersBehind;
+                    }
+                }
+                if (cornersBehind == 8) {
+                    return bvh::NodeDecision::SKIP;
+                }
+                if (cornersBehind > 0) {
+                    //the projection of the box is unbounded
+                    return bvh::NodeDecision::DESCEND;
+                }
+                if (!polygon.mayOverlapRectangle(rectMin, rectMax)) {
+                    return bvh::NodeDecision::SKIP;
+                }
+                //every node contains at least one triangle, and the triangles are inside the projected box
+                if (polygon.containsRectangle(rectMin, rectMax)) {
+                    return bvh::NodeDecision::ACCEPT;
+                }
+                return bvh::NodeDecision::DESCEND;
+            }
+
+            [[nodiscard]] bool isTriangleInside(const SelectionPolygon& polygon, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) const {
+                const auto pa = projectPoint(a);
+                const auto pb = projectPoint(b);
+                const auto pc = projectPoint(c);
+                //triangles which cross the camera plane are ignored
+                return pa.has_value() && pb.has_value() && pc.has_value() && polygon.intersectsTriangle(*pa, *pb, *pc);
+            }
+
+        private:
+            glm::mat4 toClip;
+            glm::vec2 screenSize;
+        };
+    }
+
+    SelectionPolygon::SelectionPolygon(std::vector<glm::vec2> points) :
+        points(std::move(points)), pMin(INFINITY), pMax(-INFINITY) {
+        for (const auto& p: this->points) {
+            pMin = util::cwiseMin(pMin, p);
+            pMax = util::cwiseMax(pMax, p);
+        }
+    }
+
+    SelectionPolygon SelectionPolygon::rectangle(const glm::vec2& cornerA, const glm::vec2& cornerB) {
+        const auto rectMin = util::cwiseMin(cornerA, cornerB);
+        const auto rectMax = util::cwiseMax(cornerA, cornerB);
+        SelectionPolygon result({rectMin, {rectMax.x, rectMin.y}, rectMax, {rectMin.x, rectMax.y}});
+        result.isAxisAlignedRectangle = true;
+        return result;
+    }
+
+    bool SelectionPolygon::containsPoint(const glm::vec2& point) const {
+        if (point.x < pMin.x || point.y < pMin.y || point.x > pMax.x || point.y > pMax.y) {
+            return false;
+        }
+        if (isAxisAlignedRectangle) {
+            return true;
+        }
+        bool inside = false;
+        for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++) {
+            const auto& pi = points[i];
+            const auto& pj = points[j];
+            if ((pi.y > point.y) != (pj.y > point.y)
+                && point.x < (pj.x - pi.x) * (point.y - pi.y) / (pj.y - pi.y) + pi.x) {
+                inside = !inside;
+            }
+        }
+        return inside;
+    }
+
+    bool SelectionPolygon::intersectsSegment(const glm::vec2& a, const glm::vec2& b) const {
+        for (size_t i = 0, j = points.size() - 1; i < points.size(); j = i++) {
+            if (doSegmentsIntersect(points[j], points[i], a, b)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool SelectionPolygon::intersectsTriangle(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c) const {
+        if (points.size() < 3 || !mayOverlapRectangle(util::cwiseMin(a, util::cwiseMin(b, c)), util::cwiseMax(a, util::cwiseMax(b, c)))) {
+            return false;
+        }
+        if (containsPoint(a) || containsPoint(b) || containsPoint(c)) {
+            return true;
+        }
+        //the polygon is completely inside the triangle
+        if (isPointInTriangle2d(a, b, c, points[0])) {
+            return true;
+        }
+        return intersectsSegment(a, b) || intersectsSegment(b, c) || intersectsSegment(c, a);
+    }
+
+    bool SelectionPolygon::mayOverlapRectangle(const glm::vec2& rectMin, const glm::vec2& rectMax) const {
+        return rectMin.x <= pMax.x && rectMax.x >= pMin.x && rectMin.y <= pMax.y && rectMax.y >= pMin.y;
+    }
+
+    bool SelectionPolygon::containsRectangle(const glm::vec2& rectMin, const glm::vec2& rectMax) const {
+        if (rectMin.x < pMin.x || rectMin.y < pMin.y || rectMax.x > pMax.x || rectMax.y > pMax.y) {
+            return false;
+        }
+        if (isAxisAlignedRectangle) {
+            return true;
+        }
+        const glm::vec2 corner1(rectMax.x, rectMin.y);
+        const glm::vec2 corner3(rectMin.x, rectMax.y);
+        return containsPoint(rectMin) && containsPoint(corner1) && containsPoint(rectMax) && containsPoint(corner3)
+               && !intersectsSegment(rectMin, corner1) && !intersectsSegment(corner1, rectMax)
+               && !intersectsSegment(rectMax, corner3) && !intersectsSegment(corner3, rectMin);
+    }
+
+    const std::vector<glm::vec2>& SelectionPolygon::getPoints() const {
+        return points;
+    }
+
+    void ScenePicker::setInstances(const std::vector<Instance>& newInstances) {
+        plFunction();
+        std::map<layer_t, LayerTree, std::greater<>> newLayers;
+        instanceCount = 0;
+        for (const auto& instance: newInstances) {
+            if (instance.bvh == nullptr || instance.bvh->getTriangleCount() == 0) {
+                continue;
+            }
+            const auto localToWorld = glm::transpose(instance.transformation);
+            if (std::abs(glm::determinant(localToWorld)) < 1e-12f) {
+                continue;
+            }
+            auto& layer = newLayers[instance.layer];
+            layer.layer = instance.layer;
+            layer.instances.push_back({instance.bvh, localToWorld, glm::inverse(localToWorld), instance.elementId});
+            ++instanceCount;
+        }
+
+        layers.clear();
+        layers.reserve(newLayers.size());
+        for (auto& [layerId, layer]: newLayers) {
+            std::vector<aabb::AABB> instanceBounds;
+            instanceBounds.reserve(layer.instances.size());
+            for (const auto& instance: layer.instances) {
+                instanceBounds.push_back(instance.bvh->getBounds().transform(instance.localToWorld));
+            }
+            std::vector<uint32_t> order;
+            layer.nodes = bvh::build(instanceBounds, order, INSTANCE_LEAF_SIZE);
+            std::vector<PreparedInstance> sortedInstances;
+            sortedInstances.reserve(order.size());
+            for (const auto idx: order) {
+                sortedInstances.push_back(std::move(layer.instances[idx]));
+            }
+            layer.instances = std::move(sortedInstances);
+            layers.push_back(std::move(layer));
+        }
+    }
+
+    void ScenePicker::clear() {
+        layers.clear();
+        instanceCount = 0;
+    }
+
+    std::optional<ScenePicker::RayHit> ScenePicker::pickRay(const Ray3& ray) const {
+        plFunction();
+        for (const auto& layer: layers) {
+            const auto hit = pickRayInLayer(layer, ray);
+            if (hit.has_value()) {
+                return hit;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::optional<ScenePicker::RayHit> ScenePicker::pickRayInLayer(const LayerTree& layer, const Ray3& ray) {
+        if (layer.nodes.empty()) {
+            return std::nullopt;
+        }
+        const auto inverseDirection = 1.f / ray.direction;
+        float maxDistance = INFINITY;
+        const PreparedInstance* hitInstance = nullptr;
+        TriangleBvh::Hit localHit{};
+
+        std::array<uint32_t, bvh::MAX_DEPTH + 2> stack;
+        size_t stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0) {
+            const auto& node = layer.nodes[stack[--stackSize]];
+            if (!bvh::intersectRayAABB(ray.origin, inverseDirection, node.pMin, node.pMax, maxDistance).has_value()) {
+                continue;
+            }
+            if (node.isLeaf()) {
+                for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.primitiveCount; ++i) {
+                    const auto& instance = layer.instances[i];
+                    //the transformation is affine, so the distance along the ray is the same in both spaces
+                    const Ray3 localRay(instance.worldToLocal * glm::vec4(ray.origin, 1.f), instance.worldToLocal * glm::vec4(ray.direction, 0.f));
+                    const auto hit = instance.bvh->intersectRay(localRay, maxDistance);
+                    if (hit.has_value()) {
+                        maxDistance = hit->distance;
+                        hitInstance = &instance;
+                        localHit = *hit;
+                    }
+                }
+            } else {
+                stack[stackSize++] = node.leftOrFirst + 1;
+                stack[stackSize++] = node.leftOrFirst;
+            }
+        }
+
+        if (hitInstance == nullptr) {
+            return std::nullopt;
+        }
+        //normals are transformed with the inverse transpose
+        auto normal = glm::normalize(glm::vec3(glm::transpose(hitInstance->worldToLocal) * glm::vec4(localHit.normal, 0.f)));
+        if (glm::dot(normal, ray.direction) > 0.f) {
+            normal = -normal;
+        }
+        return RayHit{
+                hitInstance->elementId,
+                ray.origin + ray.direction * localHit.distance,
+                normal,
+                localHit.distance,
+        };
+    }
+
+    std::vector<element_id_t> ScenePicker::findElementsInPolygon(const SelectionPolygon& polygon, const glm::mat4& worldToClip, const glm::vec2& screenSize) const {
+        plFunction();
+        uoset_t<element_id_t> found;
+        const ScreenProjection worldProjection(worldToClip, screenSize);
+        for (const auto& layer: layers) {
+            if (layer.nodes.empty()) {
+                continue;
+            }
+            std::array<uint32_t, bvh::MAX_DEPTH + 2> stack;
+            size_t stackSize = 0;
+            stack[stackSize++] = 0;
+            while (stackSize > 0) {
+                const auto& node = layer.nodes[stack[--stackSize]];
+                //instance bounding boxes can be bigger than the geometry, so they are never accepted as a whole
+                if (worldProjection.decideBox(polygon, node.pMin, node.pMax) == bvh::NodeDecision::SKIP) {
+                    continue;
+                }
+                if (node.isLeaf()) {
+                    for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.primitiveCount; ++i) {
+                        const auto& instance = layer.instances[i];
+                        if (found.contains(instance.elementId)) {
+                            continue;
+                        }
+                        const ScreenProjection localProjection(worldToClip * instance.localToWorld, screenSize);
+                        const bool inside = instance.bvh->findTriangle(
+                                [&](const glm::vec3& pMin, const glm::vec3& pMax) {
+                                    return localProjection.decideBox(polygon, pMin, pMax);
+                                },
+                                [&](const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+                                    return localProjection.isTriangleInside(polygon, a, b, c);
+                                });
+                        if (inside) {
+                            found.insert(instance.elementId);
+                        }
+                    }
+                } else {
+                    stack[stackSize++] = node.leftOrFirst + 1;
+                    stack[stackSize++] = node.leftOrFirst;
+                }
+            }
+        }
+        std::vector<element_id_t> result(found.begin(), found.end());
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    size_t ScenePicker::getInstanceCount() const {
+        return instanceCount;
+    }
+}
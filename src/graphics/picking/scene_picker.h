@@ -0,0 +1,99 @@
+#pragma once
+
+#include "../../types.h"
+#include "bvh.h"
+#include <memory>
+
+namespace bricksim::picking {
+    /**
+     * closed polygon in screen coordinates (pixels, origin in the top left corner like the cursor position)
+     */
+    class SelectionPolygon {
+    public:
+        explicit SelectionPolygon(std::vector<glm::vec2> points);
+        static SelectionPolygon rectangle(const glm::vec2& cornerA, const glm::vec2& cornerB);
+
+        ///even-odd rule, so self-intersecting lassos work too
+        [[nodiscard]] bool containsPoint(const glm::vec2& point) const;
+        [[nodiscard]] bool intersectsTriangle(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c) const;
+        ///conservative, can return true for rectangles which only overlap the bounding box of the polygon
+        [[nodiscard]] bool mayOverlapRectangle(const glm::vec2& rectMin, const glm::vec2& rectMax) const;
+        [[nodiscard]] bool containsRectangle(const glm::vec2& rectMin, const glm::vec2& rectMax) const;
+        [[nodiscard]] const std::vector<glm::vec2>& getPoints() const;
+
+    private:
+        std::vector<glm::vec2> points;
+        glm::vec2 pMin;
+        glm::vec2 pMax;
+        bool isAxisAlignedRectangle = false;
+        [[nodiscard]] bool intersectsSegment(const glm::vec2& a, const glm::vec2& b) const;
+    };
+
+    /**
+     * two-level bounding volume hierarchy over the mesh instances of a scene: one TriangleBvh per mesh
+     * and one tree per layer over the transformed bounding boxes of the instances.
+     * all coordinates are in LDU. this class doesn't use OpenGL
+     */
+    class ScenePicker {
+    public:
+        struct Instance {
+            std::shared_ptr<const TriangleBvh> bvh;
+            ///like MeshInstance::transformation (row vector convention)
+            glm::mat4 transformation;
+            element_id_t elementId;
+            layer_t layer;
+        };
+
+        struct RayHit {
+            element_id_t elementId;
+            glm::vec3 point;
+            ///normalized, facing against the ray
+            glm::vec3 normal;
+            ///in units of the ray direction
+            float distance;
+        };
+
+        ScenePicker() = default;
+        ScenePicker& operator=(ScenePicker&) = delete;
+        ScenePicker(const ScenePicker&) = delete;
+
+        /**
+         * replaces all instances and rebuilds the instance trees. instances without triangles are ignored
+         */
+        void setInstances(const std::vector<Instance>& newInstances);
+        void clear();
+
+        /**
+         * elements in higher layers are in front of elements in lower layers, like in the rendered image
+         */
+        [[nodiscard]] std::optional<RayHit> pickRay(const Ray3& ray) const;
+        /**
+         * @param worldToClip projection*view matrix from LDU world coordinates to clip space (column vector convention)
+         * @return the ids of the elements with at least one triangle inside or crossing the polygon, sorted and unique
+         */
+        [[nodiscard]] std::vector<element_id_t> findElementsInPolygon(const SelectionPolygon& polygon, const glm::mat4& worldToClip, const glm::vec2& screenSize) const;
+
+        [[nodiscard]] size_t getInstanceCount() const;
+
+    private:
+        struct PreparedInstance {
+            std::shared_ptr<const TriangleBvh> bvh;
+            ///column vector convention
+            glm::mat4 localToWorld;
+            glm::mat4 worldToLocal;
+            element_id_t elementId;
+        };
+
+        struct LayerTree {
+            layer_t layer;
+            std::vector<PreparedInstance> instances;
+            std::vector<bvh::Node> nodes;
+        };
+
+        ///ordered by layer (descending)
+        std::vector<LayerTree> layers;
+        size_t instanceCount = 0;
+
+        static std::optional<RayHit> pickRayInLayer(const LayerTree& layer, const Ray3& ray);
+    };
+}
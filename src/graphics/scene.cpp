@@ -1,9 +1,11 @@
 #include "scene.h"
 #include "../config/read.h"
+#include "../constant_data/constants.h"
 #include "../controller.h"
 #include "../metrics.h"
 #include "shaders.h"
 #include <palanteer.h>
+#include <chrono>
 #include <glad/glad.h>
 #include <glm/ext/matrix_clip_space.hpp>
 #include <spdlog/spdlog.h>
@@ -133,6 +135,10 @@ namespace bricksim::graphics {
         }
 
         meshCollection.rereadElementTreeIfNeeded();
+        if (selectionImageDrawableMeshesVersion != meshCollection.getDrawableMeshesVersion()) {
+            selectionImageDrawableMeshesVersion = meshCollection.getDrawableMeshesVersion();
+            needRender = true;
+        }
         std::array<GLubyte, 3> middlePixel{};
 
         if (!needRender) {
@@ -218,6 +224,10 @@ namespace bricksim::graphics {
         }
 
         meshCollection.rereadElementTreeIfNeeded();
+        if (imageDrawableMeshesVersion != meshCollection.getDrawableMeshesVersion()) {
+            imageDrawableMeshesVersion = meshCollection.getDrawableMeshesVersion();
+            needRender = true;
+        }
 
         bool imageSizeChanged = imageSize != image.getSize();
         if (imageSizeChanged) {
@@ -339,6 +349,10 @@ namespace bricksim::graphics {
         return meshCollection;
     }
 
+    mesh::SceneMeshCollection& Scene::getMeshCollection() {
+        return meshCollection;
+    }
+
     overlay2d::ElementCollection& Scene::getOverlayCollection() {
         return overlayCollection;
     }
@@ -365,6 +379,21 @@ namespace bricksim::graphics {
         return {cameraPos, glm::normalize(glm::vec3(worldPos) - cameraPos)};
     }
 
+    std::optional<picking::ScenePicker::RayHit> Scene::pickElement(glm::usvec2 screenCoords) {
+        meshCollection.rereadElementTreeIfNeeded();
+        const auto before = std::chrono::high_resolution_clock::now();
+        const auto hit = meshCollection.getPicker().pickRay(screenCoordinatesToWorldRay(screenCoords) * constants::OPENGL_TO_LDU);
+        const auto after = std::chrono::high_resolution_clock::now();
+        metrics::lastPickTimeMs = static_cast<float>(std::chrono::duration_cast<std::chrono::microseconds>(after - before).count()) / 1000.f;
+        return hit;
+    }
+
+    std::vector<element_id_t> Scene::getElementsInScreenPolygon(const picking::SelectionPolygon& polygon) {
+        meshCollection.rereadElementTreeIfNeeded();
+        const auto worldToClip = projectionMatrix * camera->getViewMatrix() * glm::transpose(constants::LDU_TO_OPENGL);
+        return meshCollection.getPicker().findElementsInPolygon(polygon, worldToClip, imageSize);
+    }
+
     [[nodiscard]] bool* Scene::isDrawTriangles() {
         return &drawTriangles;
     }
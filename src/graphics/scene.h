@@ -63,6 +63,8 @@ namespace bricksim::graphics {
         glm::mat4 currentSelectionImageViewMatrix;
         uint64_t imageEtreeVersion = 0;
         uint64_t selectionImageEtreeVersion = 0;
+        uint64_t imageDrawableMeshesVersion = 0;
+        uint64_t selectionImageDrawableMeshesVersion = 0;
         bool drawTriangles = true;
         bool drawLines = true;
         bool currentImageDrawTriangles = true;
@@ -76,6 +78,15 @@ namespace bricksim::graphics {
         void updateImage();
         [[nodiscard]] glm::vec3 worldToScreenCoordinates(glm::vec3 worldCoords) const;
         [[nodiscard]] Ray3 screenCoordinatesToWorldRay(glm::usvec2 screenCoords) const;
+        /**
+         * finds the element under screenCoords on the CPU without rendering the selection image
+         * @return the hit point and normal are in LDU
+         */
+        std::optional<picking::ScenePicker::RayHit> pickElement(glm::usvec2 screenCoords);
+        /**
+         * @return the ids of the elements which are at least partially inside the polygon, including the ones which are hidden behind others
+         */
+        std::vector<element_id_t> getElementsInScreenPolygon(const picking::SelectionPolygon& polygon);
 
         [[nodiscard]] const std::shared_ptr<etree::Node>& getRootNode() const;
         void setRootNode(const std::shared_ptr<etree::Node>& newRootNode);
@@ -86,6 +97,7 @@ namespace bricksim::graphics {
         [[nodiscard]] const CompleteFramebuffer& getImage() const;
         [[nodiscard]] const std::optional<CompleteFramebuffer>& getSelectionImage() const;
         [[nodiscard]] const mesh::SceneMeshCollection& getMeshCollection() const;
+        [[nodiscard]] mesh::SceneMeshCollection& getMeshCollection();
         [[nodiscard]] overlay2d::ElementCollection& getOverlayCollection();
         [[nodiscard]] bool* isDrawTriangles();
         [[nodiscard]] bool* isDrawLines();
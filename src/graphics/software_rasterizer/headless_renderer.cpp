@@ -0,0 +1,170 @@
+#include "headless_renderer.h"
+#include "../../config/read.h"
+#include "../mesh/mesh_builder.h"
+#include <glm/ext/matrix_clip_space.hpp>
+#include <palanteer.h>
+#include <spdlog/spdlog.h>
+
+namespace bricksim::software_rasterizer {
+    namespace {
+        ///the instances are only used inside of this renderer, so the scene id doesn't matter
+        constexpr scene_id_t HEADLESS_SCENE_ID = 0;
+
+        /**
+         * instance data of an element tree in the layout the rasterizer needs. has to stay alive until the rasterizer is done
+         */
+        class PreparedTree {
+        public:
+            PreparedTree(const std::shared_ptr<etree::Node>& rootNode, MeshCache& meshCache) :
+                reader(HEADLESS_SCENE_ID) {
+                plFunction();
+                reader.read(rootNode);
+                for (const auto& [key, meshInstances]: reader.getMeshInstances()) {
+                    if (meshInstances.instances.empty()) {
+                        continue;
+                    }
+                    const auto mesh = meshCache.getMesh(key, meshInstances.node, meshInstances.texmap);
+                    const auto& outerDimensions = mesh->getOuterDimensions();
+                    const auto& instances = meshInstances.instances;
+                    for (size_t begin = 0; begin < instances.size();) {
+                        auto end = begin + 1;
+                        while (end < instances.size() && instances[end].layer == instances[begin].layer) {
+                            ++end;
+                        }
+                        auto& meshLayer = meshLayers.emplace_back();
+                        meshLayer.mesh = mesh;
+                        meshLayer.layer = instances[begin].layer;
+                        const std::vector<mesh::MeshInstance> layerInstances(instances.begin() + begin, instances.begin() + end);
+                        for (const auto& [color, data]: mesh->getAllTriangleData()) {
+                            meshLayer.triangleInstances.emplace_back(&data, data.generateInstancesArray(layerInstances));
+                        }
+                        meshLayer.lineInstances = mesh::Mesh::getInstancesForLineData(layerInstances);
+                        begin = end;
+                    }
+                    //like collectPoints in camera.cpp
+                    for (const auto& instance: instances) {
+                        for (int axis = 0; axis < 3; ++axis) {
+                            for (int sign = -1; sign < 2; sign += 2) {
+                                glm::vec4 point(outerDimensions.minEnclosingBallCenter, 1.f);
+                                point[axis] += outerDimensions.minEnclosingBallRadius * static_cast<float>(sign);
+                                boundingPoints.emplace_back(point * instance.transformation);
+                            }
+                        }
+                    }
+                }
+            }
+
+            void addTo(Rasterizer& rasterizer) const {
+                for (const auto& meshLayer: meshLayers) {
+                    for (const auto& [data, instances]: meshLayer.triangleInstances) {
+                        rasterizer.addTriangles(data->getVertices(), data->getIndices(), instances, meshLayer.layer);
+                    }
+                    const auto& lineData = meshLayer.mesh->getLineData();
+                    rasterizer.addLines(lineData.getVertices(), lineData.getIndices(), meshLayer.lineInstances, meshLayer.layer);
+                    const auto& optionalLineData = meshLayer.mesh->getOptionalLineData();
+                    rasterizer.addOptionalLines(optionalLineData.getVertices(), optionalLineData.getIndices(), meshLayer.lineInstances, meshLayer.layer);
+                }
+            }
+
+            ///in LDU, includes the minimal enclosing balls of all instances
+            [[nodiscard]] const std::vector<glm::vec3>& getBoundingPoints() const {
+                return boundingPoints;
+            }
+
+        private:
+            struct MeshLayer {
+                std::shared_ptr<mesh::Mesh> mesh;
+                layer_t layer;
+                std::vector<std::pair<const mesh::TriangleData*, std::vector<mesh::TriangleInstance>>> triangleInstances;
+                std::vector<glm::mat4> lineInstances;
+            };
+
+            mesh::InstanceReader reader;
+            std::vector<MeshLayer> meshLayers;
+            std::vector<glm::vec3> boundingPoints;
+        };
+
+        util::RawImage render(const PreparedTree& tree, const Settings& settings) {
+            Rasterizer rasterizer(settings);
+            tree.addTo(rasterizer);
+            return rasterizer.render();
+        }
+
+        Settings createSettings(const graphics::Camera& camera, const glm::usvec2& imageSize, const color::RGB& background, unsigned int threadCount) {
+            Settings settings;
+            settings.imageSize = imageSize;
+            settings.projectionView = getProjectionMatrix(imageSize) * camera.getViewMatrix();
+            settings.cameraPos = camera.getCameraPos();
+            settings.backgroundColor = background.asGlmVector();
+            settings.faceCulling = config::get().graphics.faceCulling;
+            settings.threadCount = threadCount;
+            return settings;
+        }
+    }
+
+    std::shared_ptr<mesh::Mesh> MeshCache::getMesh(const mesh::mesh_key_t& key, const std::shared_ptr<etree::MeshNode>& node, const std::shared_ptr<ldr::TexmapStartCommand>& texmap) {
+        {
+            std::scoped_lock<std::mutex> lg(mtx);
+            const auto it = meshes.find(key);
+            if (it != meshes.end()) {
+                return it->second;
+            }
+        }
+        //built without holding the lock, if two threads build the same mesh at the same time the first one wins
+        auto mesh = std::make_shared<mesh::Mesh>();
+        mesh->name = node->getDescription();
+        {
+            plScope("node->addToMesh");
+            mesh_builder::IgnoreTexmapsScope ignoreTexmaps;
+            node->addToMesh(mesh, key.windingInversed, texmap);
+        }
+        //calculated now because the meshes are shared between threads
+        mesh->getOuterDimensions();
+        std::scoped_lock<std::mutex> lg(mtx);
+        return meshes.emplace(key, mesh).first->second;
+    }
+
+    void MeshCache::clear() {
+        std::scoped_lock<std::mutex> lg(mtx);
+        meshes.clear();
+    }
+
+    size_t MeshCache::getMeshCount() const {
+        std::scoped_lock<std::mutex> lg(mtx);
+        return meshes.size();
+    }
+
+    glm::mat4 getProjectionMatrix(const glm::usvec2& imageSize) {
+        return glm::perspective(glm::radians(50.0f), (float)imageSize.x / (float)imageSize.y, 0.01f, 1000.0f);
+    }
+
+    util::RawImage renderElementTree(const std::shared_ptr<etree::Node>& rootNode, const graphics::Camera& camera, const glm::usvec2& imageSize, const color::RGB& background, MeshCache& meshCache, unsigned int threadCount) {
+        plFunction();
+        const PreparedTree tree(rootNode, meshCache);
+        return render(tree, createSettings(camera, imageSize, background, threadCount));
+    }
+
+    util::RawImage renderThumbnail(const graphics::ThumbnailRequest& request, int size, MeshCache& meshCache, unsigned int threadCount) {
+        plFunction();
+        spdlog::debug("rendering thumbnail {} {} in {} on the CPU", request.ldrFile->metaInfo.name, request.ldrFile->getDescription(), request.color.get()->name);
+        const auto thumbnailTree = graphics::createThumbnailTree(request);
+        const PreparedTree tree(thumbnailTree.root, meshCache);
+        graphics::FitContentCamera camera;
+        if (tree.getBoundingPoints().empty()) {
+            camera.fitPoints({glm::vec3(0.f)});
+        } else {
+            camera.fitPoints(tree.getBoundingPoints());
+        }
+        const auto background = request.backgroundColor.value_or(config::get().graphics.background);
+        const glm::usvec2 imageSize(size, size);
+        return render(tree, createSettings(camera, imageSize, background, threadCount));
+    }
+
+    void saveImage(const util::RawImage& image, const std::filesystem::path& path) {
+        spdlog::info("saveImage(\"{}\")", path.string());
+        const bool success = util::writeImage(path.string().c_str(), image);
+        if (!success) {
+            throw std::invalid_argument("util::writeImage did not succeed");
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "../../element_tree.h"
+#include "../camera.h"
+#include "../mesh/instance_reader.h"
+#include "../thumbnail/thumbnail.h"
+#include "rasterizer.h"
+#include <filesystem>
+#include <mutex>
+
+namespace bricksim::software_rasterizer {
+    /**
+     * meshes for the software rasterizer. they are built without OpenGL (texmaps are drawn in the plain color)
+     * and they are separate from the meshes of SceneMeshCollection because those don't keep their vertex data after uploading it.
+     * thread safe
+     */
+    class MeshCache {
+    public:
+        MeshCache() = default;
+        MeshCache& operator=(MeshCache&) = delete;
+        MeshCache(const MeshCache&) = delete;
+
+        /**
+         * builds the mesh on the calling thread if it isn't in the cache yet
+         */
+        std::shared_ptr<mesh::Mesh> getMesh(const mesh::mesh_key_t& key, const std::shared_ptr<etree::MeshNode>& node, const std::shared_ptr<ldr::TexmapStartCommand>& texmap);
+        void clear();
+        [[nodiscard]] size_t getMeshCount() const;
+
+    private:
+        mutable std::mutex mtx;
+        uomap_t<mesh::mesh_key_t, std::shared_ptr<mesh::Mesh>> meshes;
+    };
+
+    ///same projection as Scene::setImageSize
+    glm::mat4 getProjectionMatrix(const glm::usvec2& imageSize);
+
+    /**
+     * renders the element tree like Scene::updateImage, but on the CPU
+     * @param threadCount 0 to use all cores
+     */
+    util::RawImage renderElementTree(const std::shared_ptr<etree::Node>& rootNode, const graphics::Camera& camera, const glm::usvec2& imageSize, const color::RGB& background, MeshCache& meshCache, unsigned int threadCount = 0);
+
+    /**
+     * renders the same image as ThumbnailGenerator::getThumbnail, but on the CPU
+     * @param threadCount 0 to use all cores
+     */
+    util::RawImage renderThumbnail(const graphics::ThumbnailRequest& request, int size, MeshCache& meshCache, unsigned int threadCount = 0);
+
+    /**
+     * writes an image from render* like CompleteFramebuffer::saveImage writes the framebuffer
+     * @throws std::invalid_argument if the image can't be written
+     */
+    void saveImage(const util::RawImage& image, const std::filesystem::path& path);
+}
@@ -0,0 +1,738 @@
+#include "rasterizer.h"
+#include "../../helpers/thread_pool.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <palanteer.h>
+#include <thread>
+
+namespace bricksim::software_rasterizer {
+    namespace {
+        ///vertex positions are snapped to 1/16 pixel, the edge functions are exact 64 bit integers
+        constexpr int SUBPIXEL_BITS = 4;
+        constexpr int64_t SUBPIXEL_STEPS = 1 << SUBPIXEL_BITS;
+        ///primitives are clipped this far outside of the image so the fixed point coordinates can't overflow
+        constexpr float GUARD_BAND_PIXELS = 8192.f;
+        ///lines are moved towards the camera by this fraction of the remaining depth range, otherwise they would fight with the triangles they lie on
+        constexpr float LINE_DEPTH_BIAS = .004f;
+        ///a polygon clipped against 5 planes has at most 3+5 vertices
+        constexpr size_t MAX_CLIPPED_VERTICES = 8;
+
+        //same light as in Scene::updateImage
+        constexpr float LIGHT_DIFFUSE = .5f;
+        constexpr float LIGHT_AMBIENT = LIGHT_DIFFUSE * 1.3f;
+        constexpr float LIGHT_SPECULAR = 1.f;
+
+        using fixed_vec2 = glm::vec<2, int64_t>;
+
+        struct ClipVertex {
+            glm::vec4 clip;
+            glm::vec3 world;
+            glm::vec3 normal;
+        };
+
+        struct SetupTriangle {
+            ///fixed point screen coordinates
+            std::array<fixed_vec2, 3> position;
+            std::array<float, 3> depth;
+            std::array<float, 3> invW;
+            std::array<glm::vec3, 3> world;
+            std::array<glm::vec3, 3> normal;
+            ///inclusive pixel bounding box, inside of the image
+            glm::ivec2 min;
+            glm::ivec2 max;
+            const mesh::TriangleInstance* material;
+        };
+
+        struct SetupLine {
+            ///screen coordinates along the longer axis of the line and along the other axis
+            float major0;
+            float major1;
+            float minor0;
+            float minor1;
+            bool xMajor;
+            ///already biased
+            float depth0;
+            float depth1;
+            glm::vec3 color0;
+            glm::vec3 color1;
+            ///pixels along the major axis, the end is exclusive
+            int firstPixel;
+            int endPixel;
+        };
+
+        struct TileRect {
+            glm::ivec2 min;
+            ///exclusive
+            glm::ivec2 max;
+        };
+
+        /**
+         * primitives of one thread sorted by tile (compressed sparse rows)
+         */
+        class TileLists {
+        public:
+            void clear() {
+                entries.clear();
+            }
+
+            void add(uint32_t tile, uint32_t primitive) {
+                entries.push_back({tile, primitive});
+            }
+
+            ///stable, so the primitives of a tile stay in submission order
+            void sort(size_t tileCount) {
+                offsets.assign(tileCount + 1, 0);
+                for (const auto& entry: entries) {
+                    ++offsets[entry.tile + 1];
+                }
+                for (size_t i = 1; i < offsets.size(); ++i) {
+                    offsets[i] += offsets[i - 1];
+                }
+                items.resize(entries.size());
+                auto next = offsets;
+                for (const auto& entry: entries) {
+                    items[next[entry.tile]++] = entry.primitive;
+                }
+            }
+
+            [[nodiscard]] std::span<const uint32_t> getTile(size_t tile) const {
+                return {items.data() + offsets[tile], items.data() + offsets[tile + 1]};
+            }
+
+        private:
+            struct Entry {
+                uint32_t tile;
+                uint32_t primitive;
+            };
+            std::vector<Entry> entries;
+            std::vector<uint32_t> offsets;
+            std::vector<uint32_t> items;
+        };
+
+        struct ThreadOutput {
+            std::vector<SetupTriangle> triangles;
+            std::vector<SetupLine> lines;
+            TileLists triangleTiles;
+            TileLists lineTiles;
+
+            void clear() {
+                triangles.clear();
+                lines.clear();
+                triangleTiles.clear();
+                lineTiles.clear();
+            }
+        };
+
+        /**
+         * the primitives of one command in the order in which OpenGL draws them (instance by instance)
+         */
+        struct PrimitiveRange {
+            size_t command;
+            uint64_t primitivesPerInstance;
+            uint64_t instanceCount;
+            ///index of the first primitive in the layer
+            uint64_t start;
+        };
+
+        struct LayerWork {
+            layer_t layer;
+            std::vector<PrimitiveRange> triangles;
+            uint64_t triangleCount = 0;
+            std::vector<PrimitiveRange> lines;
+            uint64_t lineCount = 0;
+        };
+
+        /**
+         * calls function(command, instance, primitive) for the primitives with an index in [begin, end)
+         */
+        template<typename F>
+        void forEachPrimitive(const std::vector<PrimitiveRange>& ranges, uint64_t begin, uint64_t end, F&& function) {
+            auto it = std::upper_bound(ranges.begin(), ranges.end(), begin, [](uint64_t value, const PrimitiveRange& range) {
+                return value < range.start;
+            });
+            if (it == ranges.begin()) {
+                return;
+            }
+            --it;
+            for (; it != ranges.end() && it->start < end; ++it) {
+                const auto rangeEnd = it->start + it->primitivesPerInstance * it->instanceCount;
+                const auto localBegin = std::max(begin, it->start) - it->start;
+                const auto localEnd = std::min(end, rangeEnd) - it->start;
+                if (localBegin >= localEnd) {
+                    continue;
+                }
+                auto instance = localBegin / it->primitivesPerInstance;
+                auto primitive = localBegin % it->primitivesPerInstance;
+                for (auto i = localBegin; i < localEnd; ++i) {
+                    function(it->command, instance, primitive);
+                    if (++primitive == it->primitivesPerInstance) {
+                        primitive = 0;
+                        ++instance;
+                    }
+                }
+            }
+        }
+
+        ///calls function once for each index in [0, threadCount), the calls run in parallel on the thread pool
+        template<typename F>
+        void runOnThreads(unsigned int threadCount, F&& function) {
+            thread_pool::parallelFor(threadCount, 1, [&function](std::size_t begin, std::size_t end) {
+                for (auto i = begin; i < end; ++i) {
+                    function(static_cast<unsigned int>(i));
+                }
+            });
+        }
+
+        ///@return true if all points are on the negative side of one of the planes
+        template<size_t N>
+        bool isTriviallyOutside(const std::array<glm::vec4, N>& clip) {
+            for (int axis = 0; axis < 3; ++axis) {
+                bool allBelow = true;
+                bool allAbove = true;
+                for (const auto& p: clip) {
+                    allBelow &= p[axis] < -p.w;
+                    allAbove &= p[axis] > p.w;
+                }
+                if (allBelow || allAbove) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        ///shading of triangle_shader.fsh
+        glm::vec3 shade(const mesh::TriangleInstance& material, const glm::vec3& fragPos, const glm::vec3& normal, const glm::vec3& cameraPos) {
+            const auto ambient = LIGHT_AMBIENT * material.diffuseColor * material.ambientFactor;
+            const auto norm = glm::normalize(normal);
+            const auto lightDir = glm::normalize(cameraPos - fragPos);
+            const float cosine = glm::dot(norm, lightDir);
+            const auto diffuse = LIGHT_DIFFUSE * std::max(cosine, 0.f) * material.diffuseColor;
+            //the light is at the camera, so viewDir==lightDir and dot(viewDir, reflect(-lightDir, norm)) is 2*cosine^2-1
+            const float spec = std::pow(std::max(2.f * cosine * cosine - 1.f, 0.f), material.shininess);
+            return ambient + diffuse + glm::vec3(LIGHT_SPECULAR * spec * material.specularBrightness);
+        }
+
+        uint8_t toByte(float value) {
+            //written this way so NaN becomes 0
+            const float clamped = value > 0.f ? (value < 1.f ? value : 1.f) : 0.f;
+            return static_cast<uint8_t>(clamped * 255.f + .5f);
+        }
+
+        class Renderer {
+        public:
+            Renderer(const Settings& settings, std::vector<float>& depthBuffer, util::RawImage& image) :
+                settings(settings),
+                width(settings.imageSize.x),
+                height(settings.imageSize.y),
+                tilesX((width + TILE_SIZE - 1) / TILE_SIZE),
+                tilesY((height + TILE_SIZE - 1) / TILE_SIZE),
+                depthBuffer(depthBuffer),
+                image(image),
+                guardBand(1.f + 2.f * GUARD_BAND_PIXELS / static_cast<float>(width), 1.f + 2.f * GUARD_BAND_PIXELS / static_cast<float>(height)),
+                clipPlanes({
+                        glm::vec4(0, 0, 1, 1),
+                        glm::vec4(1, 0, 0, guardBand.x),
+                        glm::vec4(-1, 0, 0, guardBand.x),
+                        glm::vec4(0, 1, 0, guardBand.y),
+                        glm::vec4(0, -1, 0, guardBand.y),
+                }) {}
+
+            [[nodiscard]] size_t getTileCount() const {
+                return static_cast<size_t>(tilesX) * tilesY;
+            }
+
+            void setupTriangle(ThreadOutput& output, const std::array<ClipVertex, 3>& vertices, const mesh::TriangleInstance* material) const {
+                if (isTriviallyOutside(std::array{vertices[0].clip, vertices[1].clip, vertices[2].clip})) {
+                    return;
+                }
+                std::array<ClipVertex, MAX_CLIPPED_VERTICES> polygon;
+                std::copy(vertices.begin(), vertices.end(), polygon.begin());
+                size_t count = 3;
+                for (const auto& plane: clipPlanes) {
+                    bool allInside = true;
+                    for (size_t i = 0; i < count; ++i) {
+                        allInside &= glm::dot(plane, polygon[i].clip) >= 0.f;
+                    }
+                    if (!allInside) {
+                        count = clipPolygon(polygon, count, plane);
+                        if (count < 3) {
+                            return;
+                        }
+                    }
+                }
+                for (size_t i = 1; i + 1 < count; ++i) {
+                    addScreenTriangle(output, polygon[0], polygon[i], polygon[i + 1], material);
+                }
+            }
+
+            void setupLine(ThreadOutput& output, ClipVertex a, ClipVertex b, const glm::vec3& colorA, const glm::vec3& colorB) const {
+                if (isTriviallyOutside(std::array{a.clip, b.clip})) {
+                    return;
+                }
+                float tA = 0.f;
+                float tB = 1.f;
+                for (const auto& plane: clipPlanes) {
+                    const float dA = glm::dot(plane, a.clip);
+                    const float dB = glm::dot(plane, b.clip);
+                    if (dA < 0.f && dB < 0.f) {
+                        return;
+                    }
+                    if (dA < 0.f) {
+                        tA = std::max(tA, dA / (dA - dB));
+                    } else if (dB < 0.f) {
+                        tB = std::min(tB, dA / (dA - dB));
+                    }
+                }
+                if (tA >= tB) {
+                    return;
+                }
+                const auto clipA = glm::mix(a.clip, b.clip, tA);
+                const auto clipB = glm::mix(a.clip, b.clip, tB);
+                const auto screenA = toScreen(clipA);
+                const auto screenB = toScreen(clipB);
+
+                SetupLine line{};
+                line.xMajor = std::abs(screenB.x - screenA.x) >= std::abs(screenB.y - screenA.y);
+                const int majorAxis = line.xMajor ? 0 : 1;
+                line.major0 = screenA[majorAxis];
+                line.major1 = screenB[majorAxis];
+                line.minor0 = screenA[1 - majorAxis];
+                line.minor1 = screenB[1 - majorAxis];
+                line.depth0 = screenA.z - (1.f - screenA.z) * LINE_DEPTH_BIAS;
+                line.depth1 = screenB.z - (1.f - screenB.z) * LINE_DEPTH_BIAS;
+                line.color0 = glm::mix(colorA, colorB, tA);
+                line.color1 = glm::mix(colorA, colorB, tB);
+                const int majorSize = line.xMajor ? width : height;
+                line.firstPixel = std::max(0, static_cast<int>(std::ceil(std::min(line.major0, line.major1) - .5f)));
+                line.endPixel = std::min(majorSize, static_cast<int>(std::ceil(std::max(line.major0, line.major1) - .5f)));
+                if (line.firstPixel >= line.endPixel) {
+                    return;
+                }
+
+                const auto lineIndex = static_cast<uint32_t>(output.lines.size());
+                output.lines.push_back(line);
+                const int minorTiles = line.xMajor ? tilesY : tilesX;
+                const int minorSize = line.xMajor ? height : width;
+                for (int majorTile = line.firstPixel / TILE_SIZE; majorTile * TILE_SIZE < line.endPixel; ++majorTile) {
+                    const int first = std::max(line.firstPixel, majorTile * TILE_SIZE);
+                    const int last = std::min(line.endPixel, (majorTile + 1) * TILE_SIZE) - 1;
+                    const int minorFirst = getMinorPixel(line, first);
+                    const int minorLast = getMinorPixel(line, last);
+                    const int minorTileBegin = std::clamp(std::min(minorFirst, minorLast), 0, minorSize - 1) / TILE_SIZE;
+                    const int minorTileEnd = std::clamp(std::max(minorFirst, minorLast), 0, minorSize - 1) / TILE_SIZE;
+                    for (int minorTile = minorTileBegin; minorTile <= minorTileEnd && minorTile < minorTiles; ++minorTile) {
+                        const int tileX = line.xMajor ? majorTile : minorTile;
+                        const int tileY = line.xMajor ? minorTile : majorTile;
+                        output.lineTiles.add(static_cast<uint32_t>(tileY * tilesX + tileX), lineIndex);
+                    }
+                }
+            }
+
+            void drawTile(size_t tile, bool firstLayer, const std::vector<ThreadOutput>& outputs) const {
+                const int tileX = static_cast<int>(tile % tilesX);
+                const int tileY = static_cast<int>(tile / tilesX);
+                const TileRect rect{
+                        {tileX * TILE_SIZE, tileY * TILE_SIZE},
+                        {std::min(width, (tileX + 1) * TILE_SIZE), std::min(height, (tileY + 1) * TILE_SIZE)},
+                };
+                for (int y = rect.min.y; y < rect.max.y; ++y) {
+                    std::fill(depthBuffer.begin() + y * width + rect.min.x, depthBuffer.begin() + y * width + rect.max.x, 1.f);
+                    if (firstLayer) {
+                        for (int x = rect.min.x; x < rect.max.x; ++x) {
+                            writeColor(x, y, settings.backgroundColor);
+                        }
+                    }
+                }
+                for (const auto& output: outputs) {
+                    for (const auto index: output.triangleTiles.getTile(tile)) {
+                        drawTriangle(output.triangles[index], rect);
+                    }
+                }
+                for (const auto& output: outputs) {
+                    for (const auto index: output.lineTiles.getTile(tile)) {
+                        drawLine(output.lines[index], rect);
+                    }
+                }
+            }
+
+            void fillBackground() const {
+                for (int y = 0; y < height; ++y) {
+                    for (int x = 0; x < width; ++x) {
+                        writeColor(x, y, settings.backgroundColor);
+                    }
+                }
+            }
+
+        private:
+            const Settings& settings;
+            const int width;
+            const int height;
+            const int tilesX;
+            const int tilesY;
+            std::vector<float>& depthBuffer;
+            util::RawImage& image;
+            const glm::vec2 guardBand;
+            ///near plane and guard band, all points with dot(plane, clip)>=0 are inside
+            const std::array<glm::vec4, 5> clipPlanes;
+
+            ///@return screen x and y in pixels and the depth in normalized device coordinates
+            [[nodiscard]] glm::vec3 toScreen(const glm::vec4& clip) const {
+                const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+                return {(ndc.x * .5f + .5f) * static_cast<float>(width), (ndc.y * .5f + .5f) * static_cast<float>(height), ndc.z};
+            }
+
+            static size_t clipPolygon(std::array<ClipVertex, MAX_CLIPPED_VERTICES>& polygon, size_t count, const glm::vec4& plane) {
+                std::array<ClipVertex, MAX_CLIPPED_VERTICES> result;
+                size_t resultCount = 0;
+                for (size_t i = 0; i < count; ++i) {
+                    const auto& current = polygon[i];
+                    const auto& next = polygon[(i + 1) % count];
+                    const float dCurrent = glm::dot(plane, current.clip);
+                    const float dNext = glm::dot(plane, next.clip);
+                    if (dCurrent >= 0.f) {
+                        result[resultCount++] = current;
+                    }
+                    if ((dCurrent >= 0.f) != (dNext >= 0.f)) {
+                        const float t = dCurrent / (dCurrent - dNext);
+                        result[resultCount++] = {
+                                glm::mix(current.clip, next.clip, t),
+                                glm::mix(current.world, next.world, t),
+                                glm::mix(current.normal, next.normal, t),
+                        };
+                    }
+                }
+                polygon = result;
+                return resultCount;
+            }
+
+            static int64_t edgeFunction(const fixed_vec2& a, const fixed_vec2& b, const fixed_vec2& p) {
+                return (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x);
+            }
+
+            void addScreenTriangle(ThreadOutput& output, const ClipVertex& v0, const ClipVertex& v1, const ClipVertex& v2, const mesh::TriangleInstance* material) const {
+                SetupTriangle triangle{};
+                const std::array<const ClipVertex*, 3> vertices = {&v0, &v1, &v2};
+                glm::vec2 screenMin(INFINITY);
+                glm::vec2 screenMax(-INFINITY);
+                for (int i = 0; i < 3; ++i) {
+                    const auto screen = toScreen(vertices[i]->clip);
+                    triangle.position[i] = {std::llround(screen.x * SUBPIXEL_STEPS), std::llround(screen.y * SUBPIXEL_STEPS)};
+                    triangle.depth[i] = screen.z;
+                    triangle.invW[i] = 1.f / vertices[i]->clip.w;
+                    triangle.world[i] = vertices[i]->world;
+                    triangle.normal[i] = vertices[i]->normal;
+                    screenMin = glm::min(screenMin, glm::vec2(screen));
+                    screenMax = glm::max(screenMax, glm::vec2(screen));
+                }
+                //counter-clockwise triangles have a positive area (y axis up, like the OpenGL window coordinates)
+                const auto area = edgeFunction(triangle.position[1], triangle.position[2], triangle.position[0]);
+                if (area == 0 || (area < 0 && settings.faceCulling)) {
+                    return;
+                }
+                if (area < 0) {
+                    std::swap(triangle.position[1], triangle.position[2]);
+                    std::swap(triangle.depth[1], triangle.depth[2]);
+                    std::swap(triangle.invW[1], triangle.invW[2]);
+                    std::swap(triangle.world[1], triangle.world[2]);
+                    std::swap(triangle.normal[1], triangle.normal[2]);
+                }
+                triangle.min = glm::max(glm::ivec2(glm::floor(screenMin)), glm::ivec2(0));
+                triangle.max = glm::min(glm::ivec2(glm::ceil(screenMax)), glm::ivec2(width - 1, height - 1));
+                if (triangle.min.x > triangle.max.x || triangle.min.y > triangle.max.y) {
+                    return;
+                }
+                triangle.material = material;
+
+                const auto triangleIndex = static_cast<uint32_t>(output.triangles.size());
+                output.triangles.push_back(triangle);
+                for (int tileY = triangle.min.y / TILE_SIZE; tileY <= triangle.max.y / TILE_SIZE; ++tileY) {
+                    for (int tileX = triangle.min.x / TILE_SIZE; tileX <= triangle.max.x / TILE_SIZE; ++tileX) {
+                        if (mayOverlapTile(triangle, tileX, tileY)) {
+                            output.triangleTiles.add(static_cast<uint32_t>(tileY * tilesX + tileX), triangleIndex);
+                        }
+                    }
+                }
+            }
+
+            ///false if one of the edges has the whole tile on its outer side
+            static bool mayOverlapTile(const SetupTriangle& triangle, int tileX, int tileY) {
+                const fixed_vec2 tileMin(tileX * TILE_SIZE * SUBPIXEL_STEPS, tileY * TILE_SIZE * SUBPIXEL_STEPS);
+                const fixed_vec2 tileMax = tileMin + TILE_SIZE * SUBPIXEL_STEPS;
+                for (int i = 0; i < 3; ++i) {
+                    const auto& a = triangle.position[(i + 1) % 3];
+                    const auto& b = triangle.position[(i + 2) % 3];
+                    //the corner of the tile which is the furthest inside of this edge
+                    const fixed_vec2 corner(b.y > a.y ? tileMin.x : tileMax.x, b.x > a.x ? tileMax.y : tileMin.y);
+                    if (edgeFunction(a, b, corner) < 0) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            void drawTriangle(const SetupTriangle& triangle, const TileRect& rect) const {
+                const glm::ivec2 min = glm::max(triangle.min, rect.min);
+                const glm::ivec2 max = glm::min(triangle.max, rect.max - 1);
+                if (min.x > max.x || min.y > max.y) {
+                    return;
+                }
+                const fixed_vec2 start(min.x * SUBPIXEL_STEPS + SUBPIXEL_STEPS / 2, min.y * SUBPIXEL_STEPS + SUBPIXEL_STEPS / 2);
+                std::array<int64_t, 3> rowValue;
+                std::array<int64_t, 3> stepX;
+                std::array<int64_t, 3> stepY;
+                for (int i = 0; i < 3; ++i) {
+                    const auto& a = triangle.position[(i + 1) % 3];
+                    const auto& b = triangle.position[(i + 2) % 3];
+                    const auto d = b - a;
+                    //top-left rule: pixel centers exactly on an edge belong to the triangle only if it's a top or left edge
+                    const bool topLeft = d.y < 0 || (d.y == 0 && d.x < 0);
+                    rowValue[i] = edgeFunction(a, b, start) - (topLeft ? 0 : 1);
+                    stepX[i] = -d.y * SUBPIXEL_STEPS;
+                    stepY[i] = d.x * SUBPIXEL_STEPS;
+                }
+                const float invArea = 1.f / static_cast<float>(edgeFunction(triangle.position[1], triangle.position[2], triangle.position[0]));
+                const auto& material = *triangle.material;
+
+                for (int y = min.y; y <= max.y; ++y) {
+                    auto e = rowValue;
+                    for (int x = min.x; x <= max.x; ++x) {
+                        if ((e[0] | e[1] | e[2]) >= 0) {
+                            const float b0 = static_cast<float>(e[0]) * invArea;
+                            const float b1 = static_cast<float>(e[1]) * invArea;
+                            const float b2 = static_cast<float>(e[2]) * invArea;
+                            const float depth = b0 * triangle.depth[0] + b1 * triangle.depth[1] + b2 * triangle.depth[2];
+                            auto& storedDepth = depthBuffer[y * width + x];
+                            if (depth < storedDepth) {
+                                //perspective correct interpolation
+                                const float w0 = b0 * triangle.invW[0];
+                                const float w1 = b1 * triangle.invW[1];
+                                const float w2 = b2 * triangle.invW[2];
+                                const float invSum = 1.f / (w0 + w1 + w2);
+                                const auto fragPos = (w0 * triangle.world[0] + w1 * triangle.world[1] + w2 * triangle.world[2]) * invSum;
+                                const auto normal = w0 * triangle.normal[0] + w1 * triangle.normal[1] + w2 * triangle.normal[2];
+                                storedDepth = depth;
+                                writeColor(x, y, shade(material, fragPos, normal, settings.cameraPos));
+                            }
+                        }
+                        e[0] += stepX[0];
+                        e[1] += stepX[1];
+                        e[2] += stepX[2];
+                    }
+                    rowValue[0] += stepY[0];
+                    rowValue[1] += stepY[1];
+                    rowValue[2] += stepY[2];
+                }
+            }
+
+            ///pixels along the minor axis are the ones whose row (or column) contains the line at the center of the major pixel
+            static int getMinorPixel(const SetupLine& line, int majorPixel) {
+                const float t = (static_cast<float>(majorPixel) + .5f - line.major0) / (line.major1 - line.major0);
+                return static_cast<int>(std::floor(line.minor0 + t * (line.minor1 - line.minor0)));
+            }
+
+            void drawLine(const SetupLine& line, const TileRect& rect) const {
+                const int majorAxis = line.xMajor ? 0 : 1;
+                const int first = std::max(line.firstPixel, rect.min[majorAxis]);
+                const int end = std::min(line.endPixel, rect.max[majorAxis]);
+                for (int major = first; major < end; ++major) {
+                    const float t = (static_cast<float>(major) + .5f - line.major0) / (line.major1 - line.major0);
+                    const int minor = static_cast<int>(std::floor(line.minor0 + t * (line.minor1 - line.minor0)));
+                    if (minor < rect.min[1 - majorAxis] || minor >= rect.max[1 - majorAxis]) {
+                        continue;
+                    }
+                    const int x = line.xMajor ? major : minor;
+                    const int y = line.xMajor ? minor : major;
+                    const float depth = line.depth0 + t * (line.depth1 - line.depth0);
+                    auto& storedDepth = depthBuffer[y * width + x];
+                    if (depth < storedDepth) {
+                        storedDepth = depth;
+                        writeColor(x, y, glm::mix(line.color0, line.color1, t));
+                    }
+                }
+            }
+
+            void writeColor(int x, int y, const glm::vec3& color) const {
+                auto* pixel = image.data.data() + (static_cast<size_t>(y) * width + x) * 3;
+                pixel[0] = toByte(color.r);
+                pixel[1] = toByte(color.g);
+                pixel[2] = toByte(color.b);
+            }
+        };
+
+        ///transformations of the current instance, recalculated only when the instance changes
+        struct InstanceCache {
+            const void* instance = nullptr;
+            glm::mat4 toClip;
+            glm::mat4 toWorld;
+            glm::mat3 normalMatrix;
+            glm::vec3 overrideColor;
+            bool hasOverrideColor;
+        };
+    }
+
+    Rasterizer::Rasterizer(const Settings& settings) :
+        settings(settings) {}
+
+    void Rasterizer::addTriangles(const std::vector<mesh::TriangleVertex>& vertices, const std::vector<unsigned int>& indices, std::span<const mesh::TriangleInstance> instances, layer_t layer) {
+        if (!indices.empty() && !instances.empty()) {
+            triangleCommands.push_back({&vertices, &indices, instances, layer});
+        }
+    }
+
+    void Rasterizer::addLines(const std::vector<mesh::LineVertex>& vertices, const std::vector<unsigned int>& indices, std::span<const glm::mat4> instances, layer_t layer) {
+        if (!indices.empty() && !instances.empty()) {
+            lineCommands.push_back({&vertices, &indices, instances, layer, false});
+        }
+    }
+
+    void Rasterizer::addOptionalLines(const std::vector<mesh::LineVertex>& vertices, const std::vector<unsigned int>& indices, std::span<const glm::mat4> instances, layer_t layer) {
+        if (!indices.empty() && !instances.empty()) {
+            lineCommands.push_back({&vertices, &indices, instances, layer, true});
+        }
+    }
+
+    void Rasterizer::clear() {
+        triangleCommands.clear();
+        lineCommands.clear();
+    }
+
+    util::RawImage Rasterizer::render() {
+        plFunction();
+        const int width = settings.imageSize.x;
+        const int height = settings.imageSize.y;
+        util::RawImage image{width, height, 3, {}};
+        image.data.resize(static_cast<size_t>(width) * height * 3);
+        depthBuffer.assign(static_cast<size_t>(width) * height, 1.f);
+        if (width == 0 || height == 0) {
+            return image;
+        }
+        Renderer renderer(settings, depthBuffer, image);
+
+        std::vector<LayerWork> layers;
+        const auto getLayerWork = [&layers](layer_t layer) -> LayerWork& {
+            auto it = std::lower_bound(layers.begin(), layers.end(), layer, [](const LayerWork& work, layer_t value) {
+                return work.layer < value;
+            });
+            if (it == layers.end() || it->layer != layer) {
+                it = layers.insert(it, LayerWork{layer});
+            }
+            return *it;
+        };
+        if (settings.drawTriangles) {
+            for (size_t i = 0; i < triangleCommands.size(); ++i) {
+                const auto& command = triangleCommands[i];
+                auto& work = getLayerWork(command.layer);
+                work.triangles.push_back({i, command.indices->size() / 3, command.instances.size(), work.triangleCount});
+                work.triangleCount += work.triangles.back().primitivesPerInstance * command.instances.size();
+            }
+        }
+        if (settings.drawLines) {
+            for (size_t i = 0; i < lineCommands.size(); ++i) {
+                const auto& command = lineCommands[i];
+                auto& work = getLayerWork(command.layer);
+                work.lines.push_back({i, command.indices->size() / (command.optional ? 4 : 2), command.instances.size(), work.lineCount});
+                work.lineCount += work.lines.back().primitivesPerInstance * command.instances.size();
+            }
+        }
+        if (layers.empty()) {
+            renderer.fillBackground();
+            return image;
+        }
+
+        const auto threadCount = settings.threadCount > 0 ? settings.threadCount : std::max(1u, std::thread::hardware_concurrency());
+        const auto& projectionView = settings.projectionView;
+        std::vector<ThreadOutput> outputs(threadCount);
+        for (size_t layerIndex = 0; layerIndex < layers.size(); ++layerIndex) {
+            const auto& work = layers[layerIndex];
+            runOnThreads(threadCount, [&](unsigned int thread) {
+                plScope("software rasterizer setup");
+                auto& output = outputs[thread];
+                output.clear();
+                InstanceCache cache;
+
+                const auto triangleBegin = work.triangleCount * thread / threadCount;
+                const auto triangleEnd = work.triangleCount * (thread + 1) / threadCount;
+                forEachPrimitive(work.triangles, triangleBegin, triangleEnd, [&](size_t commandIndex, uint64_t instanceIndex, uint64_t primitive) {
+                    const auto& command = triangleCommands[commandIndex];
+                    const auto& instance = command.instances[instanceIndex];
+                    if (cache.instance != &instance) {
+                        cache.instance = &instance;
+                        cache.toWorld = instance.transformation;
+                        cache.toClip = projectionView * instance.transformation;
+                        cache.normalMatrix = glm::mat3(glm::transpose(glm::inverse(instance.transformation)));
+                    }
+                    std::array<ClipVertex, 3> vertices;
+                    for (int i = 0; i < 3; ++i) {
+                        const auto& vertex = (*command.vertices)[(*command.indices)[primitive * 3 + i]];
+                        const glm::vec4 position(vertex.position, 1.f);
+                        vertices[i] = {cache.toClip * position, glm::vec3(cache.toWorld * position), cache.normalMatrix * vertex.normal};
+                    }
+                    renderer.setupTriangle(output, vertices, &instance);
+                });
+
+                cache = {};
+                const auto lineBegin = work.lineCount * thread / threadCount;
+                const auto lineEnd = work.lineCount * (thread + 1) / threadCount;
+                forEachPrimitive(work.lines, lineBegin, lineEnd, [&](size_t commandIndex, uint64_t instanceIndex, uint64_t primitive) {
+                    const auto& command = lineCommands[commandIndex];
+                    const auto& instance = command.instances[instanceIndex];
+                    if (cache.instance != &instance) {
+                        //like line_shader.vsh
+                        cache.instance = &instance;
+                        cache.overrideColor = {instance[0][3], instance[1][3], instance[2][3]};
+                        cache.hasOverrideColor = cache.overrideColor.r > 0 || cache.overrideColor.g > 0 || cache.overrideColor.b > 0;
+                        auto transformation = instance;
+                        transformation[0][3] = 0;
+                        transformation[1][3] = 0;
+                        transformation[2][3] = 0;
+                        cache.toClip = projectionView * transformation;
+                    }
+                    const auto vertexCount = command.optional ? 4 : 2;
+                    std::array<glm::vec4, 4> clip;
+                    std::array<glm::vec3, 4> colors;
+                    for (int i = 0; i < vertexCount; ++i) {
+                        const auto& vertex = (*command.vertices)[(*command.indices)[primitive * vertexCount + i]];
+                        clip[i] = cache.toClip * glm::vec4(vertex.position, 1.f);
+                        colors[i] = cache.hasOverrideColor ? cache.overrideColor : vertex.color;
+                    }
+                    if (command.optional) {
+                        //like optional_line_shader.gsh: only drawn if both control points are on the same side of the line
+                        if (clip[0].w == 0.f || clip[1].w == 0.f || clip[2].w == 0.f || clip[3].w == 0.f) {
+                            return;
+                        }
+                        const glm::vec2 c1 = glm::vec2(clip[0]) / clip[0].w;
+                        const glm::vec2 a = glm::vec2(clip[1]) / clip[1].w;
+                        const glm::vec2 b = glm::vec2(clip[2]) / clip[2].w;
+                        const glm::vec2 c2 = glm::vec2(clip[3]) / clip[3].w;
+                        const float determinant1 = (b.x - a.x) * (c1.y - a.y) - (b.y - a.y) * (c1.x - a.x);
+                        const float determinant2 = (b.x - a.x) * (c2.y - a.y) - (b.y - a.y) * (c2.x - a.x);
+                        if (determinant1 * determinant2 > 0) {
+                            renderer.setupLine(output, {clip[1], {}, {}}, {clip[2], {}, {}}, colors[0], colors[0]);
+                        }
+                    } else {
+                        renderer.setupLine(output, {clip[0], {}, {}}, {clip[1], {}, {}}, colors[0], colors[1]);
+                    }
+                });
+
+                output.triangleTiles.sort(renderer.getTileCount());
+                output.lineTiles.sort(renderer.getTileCount());
+            });
+
+            std::atomic<size_t> nextTile = 0;
+            const bool firstLayer = layerIndex == 0;
+            runOnThreads(threadCount, [&](unsigned int) {
+                plScope("software rasterizer tiles");
+                for (auto tile = nextTile++; tile < renderer.getTileCount(); tile = nextTile++) {
+                    renderer.drawTile(tile, firstLayer, outputs);
+                }
+            });
+        }
+        return image;
+    }
+
+    const std::vector<float>& Rasterizer::getDepthBuffer() const {
+        return depthBuffer;
+    }
+}
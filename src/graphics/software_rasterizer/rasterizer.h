@@ -0,0 +1,89 @@
+#pragma once
+
+#include "../../helpers/util.h"
+#include "../../types.h"
+#include "../mesh/mesh_simple_classes.h"
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+
+namespace bricksim::software_rasterizer {
+    ///width and height of the screen tiles in pixels
+    constexpr int TILE_SIZE = 32;
+
+    struct Settings {
+        glm::usvec2 imageSize;
+        ///projection * view, from OpenGL world coordinates to clip space
+        glm::mat4 projectionView;
+        ///in OpenGL world coordinates. the light is at the camera position like in Scene::updateImage
+        glm::vec3 cameraPos;
+        glm::vec3 backgroundColor;
+        bool faceCulling = true;
+        bool drawTriangles = true;
+        bool drawLines = true;
+        ///0 to use all cores
+        unsigned int threadCount = 0;
+    };
+
+    /**
+     * tile based rasterizer which draws the same vertex and instance data as the OpenGL path on the CPU,
+     * so images can be rendered without an OpenGL context.
+     * the shading matches triangle_shader, line_shader and optional_line_shader. there is no multisampling and no textures.
+     *
+     * rendering happens in two phases for every layer: every thread transforms, clips and culls an equal share of the primitives
+     * and sorts them into per-tile lists, then the threads take whole tiles and draw the primitives of all lists into them.
+     * the lists are read in submission order, so the result doesn't depend on the thread count
+     */
+    class Rasterizer {
+    public:
+        explicit Rasterizer(const Settings& settings);
+        Rasterizer(const Rasterizer&) = delete;
+        Rasterizer& operator=(const Rasterizer&) = delete;
+
+        /**
+         * the vectors and instances are not copied, they have to stay alive until render returns
+         * @param instances like TriangleData uploads them (TriangleData::generateInstancesArray)
+         */
+        void addTriangles(const std::vector<mesh::TriangleVertex>& vertices, const std::vector<unsigned int>& indices, std::span<const mesh::TriangleInstance> instances, layer_t layer);
+        /**
+         * @param instances like LineData uploads them (Mesh::getInstancesForLineData), a non-zero last row is the override color of a selected instance
+         */
+        void addLines(const std::vector<mesh::LineVertex>& vertices, const std::vector<unsigned int>& indices, std::span<const glm::mat4> instances, layer_t layer);
+        /**
+         * every four indices are control point 1, line point 1, line point 2 and control point 2 like in GL_LINES_ADJACENCY mode
+         */
+        void addOptionalLines(const std::vector<mesh::LineVertex>& vertices, const std::vector<unsigned int>& indices, std::span<const glm::mat4> instances, layer_t layer);
+        void clear();
+
+        /**
+         * layers are drawn in ascending order, the depth buffer is cleared before each layer
+         * @return RGB image with the rows from bottom to top like glReadPixels returns them
+         */
+        [[nodiscard]] util::RawImage render();
+        /**
+         * @return the depth buffer after the last layer of the last render call (normalized device coordinates, 1 where nothing was drawn)
+         */
+        [[nodiscard]] const std::vector<float>& getDepthBuffer() const;
+
+    private:
+        struct TriangleCommand {
+            const std::vector<mesh::TriangleVertex>* vertices;
+            const std::vector<unsigned int>* indices;
+            std::span<const mesh::TriangleInstance> instances;
+            layer_t layer;
+        };
+
+        struct LineCommand {
+            const std::vector<mesh::LineVertex>* vertices;
+            const std::vector<unsigned int>* indices;
+            std::span<const glm::mat4> instances;
+            layer_t layer;
+            bool optional;
+        };
+
+        Settings settings;
+        std::vector<TriangleCommand> triangleCommands;
+        std::vector<LineCommand> lineCommands;
+        std::vector<float> depthBuffer;
+    };
+}
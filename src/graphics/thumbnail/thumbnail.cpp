@@ -41,4 +41,19 @@ namespace bricksim::graphics {
                                                 ? backgroundColor->asHtmlCode()
                                                 : ""));
     }
+
+    ThumbnailTree createThumbnailTree(const ThumbnailRequest& request) {
+        auto rootNode = std::make_shared<etree::RootNode>();
+        std::shared_ptr<etree::LdrNode> ldrNode;
+        if (request.ldrFile->metaInfo.type == ldr::FileType::MODEL || request.ldrFile->metaInfo.type == ldr::FileType::MPD_SUBFILE) {
+            ldrNode = std::make_shared<etree::ModelNode>(request.ldrFile, request.color, nullptr);
+            ldrNode->visible = true;
+        } else {
+            ldrNode = std::make_shared<etree::PartNode>(request.ldrFile, request.color, nullptr, nullptr);
+        }
+        rootNode->addChild(ldrNode);
+        ldrNode->setParent(rootNode);
+        ldrNode->createChildNodes();
+        return {rootNode, ldrNode};
+    }
 }
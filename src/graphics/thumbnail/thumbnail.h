@@ -1,6 +1,7 @@
 #pragma once
 
 #include <optional>
+#include "../../element_tree.h"
 #include "../../ldr/files.h"
 
 namespace bricksim::graphics {
@@ -25,6 +26,17 @@ namespace bricksim::graphics {
     };
 
     using thumbnail_file_key_t = ThumbnailRequest;
+
+    struct ThumbnailTree {
+        std::shared_ptr<etree::RootNode> root;
+        ///the only child of root
+        std::shared_ptr<etree::LdrNode> node;
+    };
+
+    /**
+     * creates the element tree which is rendered for a thumbnail
+     */
+    ThumbnailTree createThumbnailTree(const ThumbnailRequest& request);
 }
 
 namespace std {
@@ -1,9 +1,121 @@
 #include "thumbnail_cache.h"
+#include "../../controller.h"
+#include "../../metrics.h"
 #include "../hardware_properties.h"
+#include <spdlog/spdlog.h>
 
 namespace bricksim::graphics {
+    namespace {
+        constexpr MappedBlobStore::magic_t MAGIC = {'B', 'S', 'T', 'H', 'U', 'M', 'B', 'S'};
+        //increment this when the layout of the file or the rendering of the thumbnails changes
+        constexpr uint32_t FORMAT_VERSION = 2;
+        ///bigger pages would only waste VRAM for the last, partially used page
+        constexpr unsigned int MAX_ATLAS_PAGE_SIZE = 4096;
+    }
+
+    std::string ThumbnailAtlasKey::getId() const {
+        return fmt::format("{}|{}|{},{},{}|{}",
+                           name,
+                           color,
+                           rotation.x, rotation.y, rotation.z,
+                           background.has_value() ? background->asHtmlCode() : "");
+    }
+
     ThumbnailAtlas::ThumbnailAtlas(const unsigned int thumbnailSize) :
-            thumbnailSize(thumbnailSize), thumbnailsPerRow(getHardwareProperties().maxTextureSize / thumbnailSize) {
-        texture = std::make_shared<Texture>(thumbnailSize * thumbnailsPerRow, thumbnailSize * thumbnailsPerRow, 3);
+        thumbnailSize(thumbnailSize),
+        thumbnailsPerRow(std::max(1u, std::min(static_cast<unsigned int>(getHardwareProperties().maxTextureSize), MAX_ATLAS_PAGE_SIZE) / thumbnailSize)) {
+    }
+
+    ThumbnailAtlasLocation ThumbnailAtlas::allocate() {
+        for (unsigned int i = 0; i < pages.size(); ++i) {
+            if (!pages[i].freeSlots.empty()) {
+                const auto slot = pages[i].freeSlots.back();
+                pages[i].freeSlots.pop_back();
+                return {i, slot};
+            }
+        }
+
+        const auto pageSize = static_cast<int>(thumbnailSize * thumbnailsPerRow);
+        texture_id_t textureId;
+        controller::executeOpenGL([&textureId, pageSize]() {
+            glGenTextures(1, &textureId);
+            glBindTexture(GL_TEXTURE_2D, textureId);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, pageSize, pageSize, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        });
+        auto& page = pages.emplace_back();
+        page.texture = std::make_shared<Texture>(textureId, pageSize, pageSize, 3);
+        //reversed so the slots are used from the bottom left corner
+        for (unsigned int slot = capacity(); slot > 1; --slot) {
+            page.freeSlots.push_back(slot - 1);
+        }
+        metrics::thumbnailBufferUsageBytes += getPageSizeBytes();
+        spdlog::debug("created thumbnail atlas page {} ({}x{} px)", pages.size() - 1, pageSize, pageSize);
+        return {static_cast<unsigned int>(pages.size() - 1), 0};
+    }
+
+    void ThumbnailAtlas::release(const ThumbnailAtlasLocation& location) {
+        pages[location.page].freeSlots.push_back(location.slot);
+    }
+
+    void ThumbnailAtlas::upload(const ThumbnailAtlasLocation& location, const uint8_t* pixels) {
+        const auto x = static_cast<GLint>(location.slot % thumbnailsPerRow * thumbnailSize);
+        const auto y = static_cast<GLint>(location.slot / thumbnailsPerRow * thumbnailSize);
+        const auto size = static_cast<GLsizei>(thumbnailSize);
+        const auto& texture = pages[location.page].texture;
+        controller::executeOpenGL([&texture, x, y, size, pixels]() {
+            glBindTexture(GL_TEXTURE_2D, texture->getID());
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, size, size, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        });
+    }
+
+    ThumbnailTexture ThumbnailAtlas::get(const ThumbnailAtlasLocation& location) const {
+        const auto pageSize = static_cast<float>(thumbnailSize * thumbnailsPerRow);
+        const glm::vec2 min(static_cast<float>(location.slot % thumbnailsPerRow * thumbnailSize) / pageSize,
+                            static_cast<float>(location.slot / thumbnailsPerRow * thumbnailSize) / pageSize);
+        return {pages[location.page].texture, min, min + static_cast<float>(thumbnailSize) / pageSize};
+    }
+
+    std::size_t ThumbnailAtlas::getPageCount() const {
+        return pages.size();
+    }
+
+    std::size_t ThumbnailAtlas::getPageSizeBytes() const {
+        const std::size_t pageSize = thumbnailSize * thumbnailsPerRow;
+        return pageSize * pageSize * 3;
+    }
+
+    ThumbnailCache::ThumbnailCache(std::filesystem::path path, std::string libraryVersion, unsigned int thumbnailSize) :
+        thumbnailSize(thumbnailSize),
+        store(std::move(path), "thumbnail cache", MAGIC, FORMAT_VERSION, {std::move(libraryVersion), std::to_string(thumbnailSize)}) {
+    }
+
+    std::span<const uint8_t> ThumbnailCache::read(const ThumbnailAtlasKey& key) const {
+        const auto pixels = store.read(key.getId(), key.fileFingerprint);
+        return pixels.size() == getImageSizeBytes() ? pixels : std::span<const uint8_t>();
+    }
+
+    void ThumbnailCache::put(const ThumbnailAtlasKey& key, std::vector<uint8_t> pixels) {
+        if (pixels.size() != getImageSizeBytes()) {
+            return;
+        }
+        store.put(key.getId(), key.fileFingerprint, std::move(pixels));
+    }
+
+    void ThumbnailCache::save() {
+        store.save();
+    }
+
+    std::size_t ThumbnailCache::getEntryCount() const {
+        return store.getEntryCount();
+    }
+
+    std::size_t ThumbnailCache::getImageSizeBytes() const {
+        return static_cast<std::size_t>(thumbnailSize) * thumbnailSize * 3;
     }
 }
@@ -2,27 +2,107 @@
 
 #include "../texture.h"
 
-#include <string>
+#include "../../helpers/mapped_blob_store.h"
 #include "../../ldr/colors.h"
+#include <optional>
+#include <span>
+#include <string>
 
 namespace bricksim::graphics {
+    /**
+     * identifies a thumbnail across program starts. the library version and the thumbnail size are stored once per ThumbnailCache
+     */
     struct ThumbnailAtlasKey {
+        ///path relative to the library root, like the names in BinaryLibraryCache
+        std::string name;
+        ///ldr::FileRepo::getLibraryFileFingerprint of the file
+        uint64_t fileFingerprint;
+        ldr::Color::code_t color;
+        ///in whole degrees
+        glm::ivec3 rotation;
+        std::optional<color::RGB> background;
+
+        ///everything except the fingerprint, which decides whether an entry is still valid
+        [[nodiscard]] std::string getId() const;
+    };
+
+    ///where a thumbnail is in the atlas
+    struct ThumbnailAtlasLocation {
+        unsigned int page;
+        unsigned int slot;
+    };
+
+    ///a part of an atlas page
+    struct ThumbnailTexture {
+        std::shared_ptr<Texture> texture;
+        ///the image is stored bottom to top like glReadPixels returns it, so uvMin is the bottom left corner
+        glm::vec2 uvMin;
+        glm::vec2 uvMax;
     };
 
+    /**
+     * thumbnails packed into a few big textures (pages) instead of one texture per thumbnail.
+     * pages are created when all slots are used and kept until the atlas is destroyed, freed slots are reused
+     */
     class ThumbnailAtlas {
         const unsigned int thumbnailSize;
         const unsigned int thumbnailsPerRow;
-        //uomap_t<std::string, unsigned int> indices;
-        std::shared_ptr<Texture> texture;
+
+        struct Page {
+            std::shared_ptr<Texture> texture;
+            std::vector<unsigned int> freeSlots;
+        };
+        std::vector<Page> pages;
 
     public:
         explicit ThumbnailAtlas(unsigned int thumbnailSize);
+        ThumbnailAtlas& operator=(ThumbnailAtlas&) = delete;
+        ThumbnailAtlas(const ThumbnailAtlas&) = delete;
 
-        unsigned int capacity() const {
+        [[nodiscard]] unsigned int capacity() const {
             return thumbnailsPerRow * thumbnailsPerRow;
         }
+
+        ThumbnailAtlasLocation allocate();
+        void release(const ThumbnailAtlasLocation& location);
+        /**
+         * @param pixels RGB, thumbnailSize*thumbnailSize pixels, rows from bottom to top
+         */
+        void upload(const ThumbnailAtlasLocation& location, const uint8_t* pixels);
+        [[nodiscard]] ThumbnailTexture get(const ThumbnailAtlasLocation& location) const;
+        [[nodiscard]] std::size_t getPageCount() const;
+        [[nodiscard]] std::size_t getPageSizeBytes() const;
     };
 
+    /**
+     * rendered thumbnails on disk so they don't have to be rendered again at the next start.
+     * the file is memory mapped, reading a thumbnail only touches its pixels.
+     * it's only valid for one library version and one thumbnail size.
+     * new thumbnails are collected in memory and written at the next save()
+     */
     class ThumbnailCache {
+    public:
+        ThumbnailCache(std::filesystem::path path, std::string libraryVersion, unsigned int thumbnailSize);
+        ThumbnailCache& operator=(ThumbnailCache&) = delete;
+        ThumbnailCache(const ThumbnailCache&) = delete;
+
+        /**
+         * @return the RGB pixels (rows from bottom to top) or an empty span if key isn't cached or the fingerprint doesn't match.
+         * valid until the next save()
+         */
+        [[nodiscard]] std::span<const uint8_t> read(const ThumbnailAtlasKey& key) const;
+        void put(const ThumbnailAtlasKey& key, std::vector<uint8_t> pixels);
+        /**
+         * writes all valid old entries and all new entries to disk if there are new ones.
+         * must not be called while other threads call read()
+         */
+        void save();
+
+        [[nodiscard]] std::size_t getEntryCount() const;
+        [[nodiscard]] std::size_t getImageSizeBytes() const;
+
+    private:
+        unsigned int thumbnailSize;
+        MappedBlobStore store;
     };
 }
@@ -1,6 +1,7 @@
 #include "thumbnail_generator.h"
 #include "../../config/read.h"
 #include "../../controller.h"
+#include "../../ldr/file_repo.h"
 #include "../../metrics.h"
 #include <glad/glad.h>
 #include <glm/ext/matrix_clip_space.hpp>
@@ -8,204 +9,235 @@
 #include <spdlog/spdlog.h>
 
 namespace bricksim::graphics {
-    std::shared_ptr<Texture> ThumbnailGenerator::getThumbnail(ThumbnailRequest request) {
+    namespace {
+        constexpr auto THUMBNAIL_CACHE_FILE_NAME = "thumbnail_cache.bin";
+    }
+
+    ThumbnailTexture ThumbnailGenerator::getThumbnail(const ThumbnailRequest& request) {
         plFunction();
-        if (renderedRotationDegrees != rotationDegrees) {
-            discardAllImages();
-            renderedRotationDegrees = rotationDegrees;
-        }
+        discardImagesIfRotationChanged();
         auto imgIt = images.find(request);
+        ThumbnailTexture result;
         if (imgIt == images.end()) {
-            spdlog::debug("rendering thumbnail {} {} in {}", request.ldrFile->metaInfo.name,
-                          request.ldrFile->getDescription(), request.color.get()->name);
-            auto before = std::chrono::high_resolution_clock::now();
-            scene->setImageSize({size, size});
-
-            std::shared_ptr<etree::RootNode> rootNode = std::make_shared<etree::RootNode>();
-            std::shared_ptr<etree::LdrNode> ldrNode;
-            if (request.ldrFile->metaInfo.type == ldr::FileType::MODEL || request.ldrFile->metaInfo.type == ldr::FileType::MPD_SUBFILE) {
-                ldrNode = std::make_shared<etree::ModelNode>(request.ldrFile, request.color, nullptr);
-                ldrNode->visible = true;
+            const auto key = getPersistentKey(request);
+            const auto cachedPixels = key.has_value() ? persistentCache->read(*key) : std::span<const uint8_t>();
+            if (!cachedPixels.empty()) {
+                result = addToAtlas(request, cachedPixels.data());
             } else {
-                ldrNode = std::make_shared<etree::PartNode>(request.ldrFile, request.color, nullptr, nullptr);
+                auto pixels = renderPixels(request);
+                result = addToAtlas(request, pixels.data());
+                if (key.has_value()) {
+                    persistentCache->put(*key, std::move(pixels));
+                }
             }
-            rootNode->addChild(ldrNode);
-            ldrNode->parent = rootNode;
-            ldrNode->createChildNodes();
-            scene->setRootNode(rootNode);
-            camera->setRootNode(ldrNode);
-
-            scene->setBackgroundColor(request.backgroundColor.value_or(config::get().graphics.background));
-            scene->updateImage();
-
-            const auto totalBufferSize = size * size * 3;//todo try to make transparent background
-            metrics::thumbnailBufferUsageBytes += totalBufferSize;
-            std::vector<GLbyte> buffer;
-            buffer.resize(totalBufferSize);
-            controller::executeOpenGL([this, &buffer, &request]() {
-                //todo copy image directly (VRAM -> VRAM instead of VRAM -> RAM -> VRAM)
-                glBindFramebuffer(GL_READ_FRAMEBUFFER, scene->getImage().getFBO());
-                glReadPixels(0, 0, size, size, GL_RGB, GL_UNSIGNED_BYTE, buffer.data());
-                glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-                texture_id_t textureId;
-                glGenTextures(1, &textureId);
-                glBindTexture(GL_TEXTURE_2D, textureId);
-                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, size, size, 0, GL_RGB, GL_UNSIGNED_BYTE, buffer.data());
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                //glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 0, 0, size, size, 0);
-                //todo this causes source=API, type=ERROR, id=1282: Error has been generated. GL error GL_INVALID_OPERATION in FramebufferTexture2D: (ID: 2333930068) Generic error
-                //glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureId, 0);
-                images.emplace(request, std::make_shared<Texture>(textureId, size, size, 3));
-            });
-            auto after = std::chrono::high_resolution_clock::now();
-            metrics::lastThumbnailRenderingTimeMs = static_cast<float>(std::chrono::duration_cast<std::chrono::microseconds>(after - before).count()) / 1000.f;
-        }
-        lastAccessed.remove(request);
-        lastAccessed.push_back(request);
-        return images[request];
-    }
-
-    void ThumbnailGenerator::discardAllImages() {
-        images.clear();
-        lastAccessed.clear();
+        } else {
+            markAsAccessed(imgIt->second);
+            result = atlas.get(imgIt->second.location);
+        }
+        return result;
     }
 
-    void ThumbnailGenerator::discardOldestImages(size_t reserve_space_for) {
-        controller::executeOpenGL([this, &reserve_space_for]() {
-            int deletedCount = 0;
-            while (lastAccessed.size() > maxCachedThumbnails - reserve_space_for) {
-                auto lastAccessedIt = lastAccessed.front();
-                lastAccessed.remove(lastAccessedIt);
-                images.erase(lastAccessedIt);
-                deletedCount++;
-            }
-            metrics::thumbnailBufferUsageBytes -= (size_t)size * size * 3 * deletedCount;
+    std::vector<uint8_t> ThumbnailGenerator::renderPixels(const ThumbnailRequest& request) {
+        plFunction();
+        spdlog::debug("rendering thumbnail {} {} in {}", request.ldrFile->metaInfo.name,
+                      request.ldrFile->getDescription(), request.color.get()->name);
+        if (!controller::isOpenGlInitialized()) {
+            return renderPixelsWithoutOpenGL(request);
+        }
+        auto before = std::chrono::high_resolution_clock::now();
+        scene->setImageSize({size, size});
+
+        const auto tree = createThumbnailTree(request);
+        scene->setRootNode(tree.root);
+        camera->setRootNode(tree.node);
+
+        scene->setBackgroundColor(request.backgroundColor.value_or(config::get().graphics.background));
+        scene->updateImage();
+
+        std::vector<uint8_t> buffer;
+        buffer.resize(static_cast<size_t>(size) * size * 3);//todo try to make transparent background
+        controller::executeOpenGL([this, &buffer]() {
+            //todo copy image directly (VRAM -> VRAM instead of VRAM -> RAM -> VRAM)
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, scene->getImage().getFBO());
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glReadPixels(0, 0, size, size, GL_RGB, GL_UNSIGNED_BYTE, buffer.data());
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
         });
+        auto after = std::chrono::high_resolution_clock::now();
+        metrics::lastThumbnailRenderingTimeMs = static_cast<float>(std::chrono::duration_cast<std::chrono::microseconds>(after - before).count()) / 1000.f;
+        return buffer;
     }
 
-    std::optional<std::shared_ptr<Texture>> ThumbnailGenerator::getThumbnailNonBlocking(ThumbnailRequest request) {
-        if (renderedRotationDegrees != rotationDegrees) {
-            discardAllImages();
-            renderedRotationDegrees = rotationDegrees;
+    std::vector<uint8_t> ThumbnailGenerator::renderPixelsWithoutOpenGL(const ThumbnailRequest& request) {
+        plFunction();
+        if (softwareMeshCache == nullptr) {
+            softwareMeshCache = std::make_unique<software_rasterizer::MeshCache>();
         }
-        auto imgIt = images.find(request);
-        if (imgIt == images.end()) {
-            if (std::find(renderRequests.begin(), renderRequests.end(), request) == renderRequests.end()) {
-                renderRequests.push_back(request);
+        auto before = std::chrono::high_resolution_clock::now();
+        //the rasterizer returns the rows from bottom to top like glReadPixels
+        auto image = software_rasterizer::renderThumbnail(request, size, *softwareMeshCache);
+        auto after = std::chrono::high_resolution_clock::now();
+        metrics::lastThumbnailRenderingTimeMs = static_cast<float>(std::chrono::duration_cast<std::chrono::microseconds>(after - before).count()) / 1000.f;
+        return std::move(image.data);
+    }
+
+    ThumbnailTexture ThumbnailGenerator::addToAtlas(const ThumbnailRequest& request, const uint8_t* pixels) {
+        const auto location = atlas.allocate();
+        atlas.upload(location, pixels);
+        images.emplace(request, CachedImage{location, lastAccessed.insert(lastAccessed.end(), request)});
+        return atlas.get(location);
+    }
+
+    void ThumbnailGenerator::markAsAccessed(CachedImage& image) {
+        lastAccessed.splice(lastAccessed.end(), lastAccessed, image.lastAccessedPosition);
+    }
+
+    void ThumbnailGenerator::enqueue(const ThumbnailRequest& request) {
+        const auto it = queuedRequests.find(request);
+        if (it != queuedRequests.end()) {
+            if (it->second->frame == currentFrame) {
+                return;
             }
-            return {};
+            renderQueue.erase(it->second);
+            it->second = renderQueue.insert({currentFrame, nextRequestOrder++, request}).first;
         } else {
-            return imgIt->second;
+            queuedRequests.emplace(request, renderQueue.insert({currentFrame, nextRequestOrder++, request}).first);
         }
     }
 
-    bool ThumbnailGenerator::workOnRenderQueue() {
-        if (!renderRequests.empty()) {
-            const auto& request = renderRequests.front();
-            getThumbnail(request);
-            renderRequests.pop_front();
+    std::optional<ThumbnailAtlasKey> ThumbnailGenerator::getPersistentKey(const ThumbnailRequest& request) const {
+        const auto& file = request.ldrFile;
+        //pure colors get a different code at every start
+        if (persistentCache == nullptr || file->nameSpace != nullptr || request.color.code < 0
+            || file->metaInfo.type == ldr::FileType::MODEL || file->metaInfo.type == ldr::FileType::MPD_SUBFILE) {
+            return std::nullopt;
         }
-        return !renderRequests.empty();
+        auto name = ldr::FileRepo::getPathRelativeToBase(file->metaInfo.type, file->metaInfo.name);
+        const auto fingerprint = ldr::file_repo::get().getLibraryFileFingerprint(name);
+        if (fingerprint == 0) {
+            return std::nullopt;
+        }
+        return ThumbnailAtlasKey{std::move(name), fingerprint, request.color.code, glm::ivec3(glm::round(rotationDegrees)), request.backgroundColor};
     }
 
-    unsigned int ThumbnailGenerator::copyImageToTexture() const {
-        //todo this is from https://stackoverflow.com/questions/15306899/is-it-possible-to-copy-data-from-one-framebuffer-to-another-in-opengl but it didn't work
-        unsigned int destinationTextureId;
-        controller::executeOpenGL([this, &destinationTextureId]() {
-            glGenTextures(1, &destinationTextureId);
-
-            // bind fbo as read / draw fbo
-            const auto& image = scene->getImage();
-            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, image.getFBO());
-            glBindFramebuffer(GL_READ_FRAMEBUFFER, image.getFBO());
-
-            // bind source texture to color attachment
-            glBindTexture(GL_TEXTURE_2D, image.getTexBO());
-            glFramebufferTexture2D(GL_TEXTURE_2D, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, image.getTexBO(), 0);
-            glDrawBuffer(GL_COLOR_ATTACHMENT0);
-
-            // bind destination texture to another color attachment
-            glBindTexture(GL_TEXTURE_2D, destinationTextureId);
-            glFramebufferTexture2D(GL_TEXTURE_2D, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, destinationTextureId, 0);
-            glReadBuffer(GL_COLOR_ATTACHMENT1);
-
-            // specify source, destination drawing (sub)rectangles.
-            glBlitFramebuffer(0, 0, size, size,
-                              0, 0, size, size, GL_COLOR_BUFFER_BIT, GL_NEAREST);
-
-            // release state
-            glBindTexture(GL_TEXTURE_2D, 0);
-            glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
-            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-        });
-        return destinationTextureId;
+    void ThumbnailGenerator::discardImagesIfRotationChanged() {
+        if (renderedRotationDegrees != rotationDegrees) {
+            discardAllImages();
+            renderedRotationDegrees = rotationDegrees;
+        }
     }
 
-    bool ThumbnailGenerator::renderQueueEmpty() const {
-        return renderRequests.empty();
+    void ThumbnailGenerator::discardAllImages() {
+        for (const auto& [request, image]: images) {
+            atlas.release(image.location);
+        }
+        images.clear();
+        lastAccessed.clear();
     }
 
-    bool ThumbnailGenerator::isThumbnailAvailable(const ThumbnailRequest &request) {
-        return images.find(request) != images.end();
+    void ThumbnailGenerator::discardOldestImages(size_t reserve_space_for) {
+        while (lastAccessed.size() > maxCachedThumbnails - reserve_space_for) {
+            const auto imgIt = images.find(lastAccessed.front());
+            atlas.release(imgIt->second.location);
+            images.erase(imgIt);
+            lastAccessed.pop_front();
+        }
     }
 
-    std::size_t ThumbnailGenerator::getNumCachedThumbnails() const {
-        return images.size();
+    std::optional<ThumbnailTexture> ThumbnailGenerator::getThumbnailNonBlocking(const ThumbnailRequest& request) {
+        discardImagesIfRotationChanged();
+        auto imgIt = images.find(request);
+        if (imgIt != images.end()) {
+            markAsAccessed(imgIt->second);
+            return atlas.get(imgIt->second.location);
+        }
+        const auto key = getPersistentKey(request);
+        if (key.has_value()) {
+            const auto cachedPixels = persistentCache->read(*key);
+            if (!cachedPixels.empty()) {
+                removeFromRenderQueue(request);
+                return addToAtlas(request, cachedPixels.data());
+            }
+        }
+        enqueue(request);
+        return {};
     }
 
-    void ThumbnailGenerator::removeFromRenderQueue(const ThumbnailRequest &request) {
-        auto it = std::find(renderRequests.begin(), renderRequests.end(), request);
-        if (it != renderRequests.end()) {
-            renderRequests.erase(it);
+    util::RawImage ThumbnailGenerator::getThumbnailImage(const ThumbnailRequest& request) {
+        util::RawImage image{size, size, 3, {}};
+        const auto key = getPersistentKey(request);
+        const auto cachedPixels = key.has_value() ? persistentCache->read(*key) : std::span<const uint8_t>();
+        if (!cachedPixels.empty()) {
+            image.data.assign(cachedPixels.begin(), cachedPixels.end());
+        } else {
+            image.data = renderPixels(request);
+            if (key.has_value()) {
+                persistentCache->put(*key, image.data);
+            }
         }
+        return image;
     }
 
-    ThumbnailGenerator::ThumbnailGenerator() {
-        maxCachedThumbnails = 8UL * (1 << 30) / 3 / size / size;
-        scene = scenes::create(scenes::THUMBNAIL_SCENE_ID);
-        scene->setCamera(camera);
+    bool ThumbnailGenerator::workOnRenderQueue(double timeBudgetSeconds) {
+        plFunction();
+        //requests which weren't repeated in this frame are for thumbnails which were scrolled out of view or whose window was closed
+        while (!renderQueue.empty() && std::prev(renderQueue.end())->frame < currentFrame) {
+            queuedRequests.erase(std::prev(renderQueue.end())->request);
+            renderQueue.erase(std::prev(renderQueue.end()));
+        }
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeBudgetSeconds);
+        do {
+            if (renderQueue.empty()) {
+                break;
+            }
+            const auto request = renderQueue.begin()->request;
+            queuedRequests.erase(request);
+            renderQueue.erase(renderQueue.begin());
+            getThumbnail(request);
+        } while (std::chrono::steady_clock::now() < deadline);
+        ++currentFrame;
+        return !renderQueue.empty();
     }
 
-    bool ThumbnailRequest::operator==(const ThumbnailRequest& rhs) const {
-        return ldrFile == rhs.ldrFile && color == rhs.color && backgroundColor == rhs.backgroundColor;
+    bool ThumbnailGenerator::renderQueueEmpty() const {
+        return renderQueue.empty();
     }
 
-    bool ThumbnailRequest::operator!=(const ThumbnailRequest& rhs) const {
-        return !(rhs == *this);
+    bool ThumbnailGenerator::isThumbnailAvailable(const ThumbnailRequest &request) {
+        return images.find(request) != images.end();
     }
 
-    bool ThumbnailRequest::operator<(const ThumbnailRequest& rhs) const {
-        if (ldrFile < rhs.ldrFile)
-            return true;
-        if (rhs.ldrFile < ldrFile)
-            return false;
-        if (color < rhs.color)
-            return true;
-        if (rhs.color < color)
-            return false;
-        return backgroundColor < rhs.backgroundColor;
+    std::size_t ThumbnailGenerator::getNumCachedThumbnails() const {
+        return images.size();
     }
 
-    bool ThumbnailRequest::operator>(const ThumbnailRequest& rhs) const {
-        return rhs < *this;
+    std::size_t ThumbnailGenerator::getNumAtlasPages() const {
+        return atlas.getPageCount();
     }
 
-    bool ThumbnailRequest::operator<=(const ThumbnailRequest& rhs) const {
-        return !(rhs < *this);
+    void ThumbnailGenerator::removeFromRenderQueue(const ThumbnailRequest &request) {
+        const auto it = queuedRequests.find(request);
+        if (it != queuedRequests.end()) {
+            renderQueue.erase(it->second);
+            queuedRequests.erase(it);
+        }
     }
 
-    bool ThumbnailRequest::operator>=(const ThumbnailRequest& rhs) const {
-        return !(*this < rhs);
+    void ThumbnailGenerator::cleanup() {
+        if (persistentCache != nullptr) {
+            persistentCache->save();
+        }
     }
 
-    std::string ThumbnailRequest::getFilename() {
-        return util::escapeFilename(fmt::format("{}_{}_{}.png",
-                                                ldrFile->metaInfo.name,
-                                                color.code,
-                                                backgroundColor.has_value()
-                                                    ? backgroundColor->asHtmlCode()
-                                                    : ""));
+    ThumbnailGenerator::ThumbnailGenerator() :
+        atlas(config::get().partPalette.thumbnailSize) {
+        maxCachedThumbnails = 8UL * (1 << 30) / 3 / size / size;
+        if (ldr::file_repo::isInitialized()) {
+            persistentCache = std::make_unique<ThumbnailCache>(THUMBNAIL_CACHE_FILE_NAME, ldr::file_repo::get().getVersion(), size);
+        }
+        scene = scenes::create(scenes::THUMBNAIL_SCENE_ID);
+        scene->setCamera(camera);
+        //a thumbnail is rendered only once, so all meshes have to be complete
+        scene->getMeshCollection().setBuildMeshesAsynchronously(false);
     }
 }
@@ -1,10 +1,13 @@
 #pragma once
 
 #include "thumbnail.h"
+#include "thumbnail_cache.h"
 #include "../../config/read.h"
 #include "../scene.h"
+#include "../software_rasterizer/headless_renderer.h"
 #include <list>
 #include <memory>
+#include <set>
 
 
 
@@ -13,32 +16,88 @@ namespace bricksim::graphics {
     private:
         std::shared_ptr<Scene> scene;
         const std::shared_ptr<FitContentCamera> camera = std::make_shared<FitContentCamera>();
-        uomap_t<thumbnail_file_key_t, std::shared_ptr<Texture>> images;
+        ThumbnailAtlas atlas;
+        std::unique_ptr<ThumbnailCache> persistentCache;
+        struct CachedImage {
+            ThumbnailAtlasLocation location;
+            std::list<thumbnail_file_key_t>::iterator lastAccessedPosition;
+        };
+        uomap_t<thumbnail_file_key_t, CachedImage> images;
+        ///least recently used first
         std::list<thumbnail_file_key_t> lastAccessed;
         glm::mat4 projection = glm::perspective(glm::radians(50.0f), 1.0f, 0.001f, 1000.0f);
         size_t maxCachedThumbnails;
         int framebufferSize = 0;
-        [[nodiscard]] unsigned int copyImageToTexture() const;
         glm::vec3 renderedRotationDegrees;
-        std::list<thumbnail_file_key_t> renderRequests;//TODO check if this can be made a set (maybe faster)
+
+        struct RenderRequest {
+            ///the requests of the current frame come first, in the order in which they were made (the drawing order of the palette)
+            uint64_t frame;
+            uint64_t order;
+            thumbnail_file_key_t request;
+
+            bool operator<(const RenderRequest& other) const {
+                return frame != other.frame ? frame > other.frame : order < other.order;
+            }
+        };
+        std::set<RenderRequest> renderQueue;
+        uomap_t<thumbnail_file_key_t, std::set<RenderRequest>::iterator> queuedRequests;
+        ///incremented by every workOnRenderQueue call
+        uint64_t currentFrame = 0;
+        uint64_t nextRequestOrder = 0;
+
+        /**
+         * @return nullopt if the thumbnail can't be stored in the persistent cache (files which are not from the library)
+         */
+        std::optional<ThumbnailAtlasKey> getPersistentKey(const ThumbnailRequest& request) const;
+        ///only created when a thumbnail is rendered without OpenGL
+        std::unique_ptr<software_rasterizer::MeshCache> softwareMeshCache;
+
+        /**
+         * renders with the thumbnail scene, or with the software rasterizer if OpenGL isn't initialized
+         * @return RGB pixels with the rows from bottom to top
+         */
+        std::vector<uint8_t> renderPixels(const ThumbnailRequest& request);
+        std::vector<uint8_t> renderPixelsWithoutOpenGL(const ThumbnailRequest& request);
+        ThumbnailTexture addToAtlas(const ThumbnailRequest& request, const uint8_t* pixels);
+        void markAsAccessed(CachedImage& image);
+        void enqueue(const ThumbnailRequest& request);
+        void discardImagesIfRotationChanged();
     public:
         int size = config::get().partPalette.thumbnailSize;
 
         glm::vec3 rotationDegrees = glm::vec3(45, -45, 0);
         ThumbnailGenerator();
-        std::shared_ptr<Texture> getThumbnail(ThumbnailRequest request);
-        std::optional<std::shared_ptr<Texture>> getThumbnailNonBlocking(ThumbnailRequest request);
+        ThumbnailTexture getThumbnail(const ThumbnailRequest& request);
+        /**
+         * thumbnails from the persistent cache are returned immediately, the others are added to the render queue.
+         * requests which are not repeated in the next frame are cancelled, so this has to be called every frame while the thumbnail is visible
+         */
+        std::optional<ThumbnailTexture> getThumbnailNonBlocking(const ThumbnailRequest& request);
+        /**
+         * @return the thumbnail as an image for util::writeImage, rendered if necessary.
+         * works without OpenGL (e.g. for exports without a window), the other functions need it for the atlas textures
+         */
+        util::RawImage getThumbnailImage(const ThumbnailRequest& request);
 
         bool isThumbnailAvailable(const ThumbnailRequest &request);
 
         std::size_t getNumCachedThumbnails() const;
+        std::size_t getNumAtlasPages() const;
 
         void discardOldestImages(size_t reserve_space_for = 1);
         void discardAllImages();
 
-        bool workOnRenderQueue();
+        /**
+         * renders the queued thumbnails with the highest priority until timeBudgetSeconds is used up, but at least one.
+         * has to be called once per frame
+         * @return true if there are more requests in the queue
+         */
+        bool workOnRenderQueue(double timeBudgetSeconds);
         [[nodiscard]] bool renderQueueEmpty() const;
 
         void removeFromRenderQueue(const ThumbnailRequest &request);
+        ///writes the newly rendered thumbnails to the persistent cache
+        void cleanup();
     };
 }
@@ -12,10 +12,11 @@ namespace bricksim::gui_internal {
         bool realThumbnailDrawn = false;
         const bool visible = ImGui::IsRectVisible(actualThumbSizeSquared);
         if (visible) {
-            auto optTexId = controller::getThumbnailGenerator()->getThumbnailNonBlocking({part, color});
-            if (optTexId.has_value()) {
-                auto texId = convertTextureId(optTexId.value()->getID());
-                ImGui::ImageButton(part->metaInfo.name.c_str(), texId, actualThumbSizeSquared, ImVec2(0, 1), ImVec2(1, 0));
+            auto optThumbnail = controller::getThumbnailGenerator()->getThumbnailNonBlocking({part, color});
+            if (optThumbnail.has_value()) {
+                const auto& thumbnail = optThumbnail.value();
+                auto texId = convertTextureId(thumbnail.texture->getID());
+                ImGui::ImageButton(part->metaInfo.name.c_str(), texId, actualThumbSizeSquared, ImVec2(thumbnail.uvMin.x, thumbnail.uvMax.y), ImVec2(thumbnail.uvMax.x, thumbnail.uvMin.y));
                 realThumbnailDrawn = true;
             }
         } else {
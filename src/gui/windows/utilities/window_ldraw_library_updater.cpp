@@ -1,5 +1,6 @@
 #include "window_ldraw_library_updater.h"
 #include "../../../controller.h"
+#include "../../../graphics/mesh/mesh_collection.h"
 #include "../../../utilities/ldraw_library_updater.h"
 #include "../../gui.h"
 
@@ -14,7 +15,7 @@ namespace bricksim::gui::windows::utilities::ldraw_library_updater {
 
             switch (state.step) {
                 case Step::INACTIVE:
-                    controller::addBackgroundTask("Initialize LDraw Library Updater", []() { getState().initialize(); });
+                    controller::addBackgroundTask("Initialize LDraw Library Updater", []() { getState().initialize(); }, true);
                 case Step::INITIALIZING:
                 {
                     const auto progressMessage = fmt::format("Initializing {}%", state.initializingProgress * 100.f);
@@ -66,7 +67,7 @@ namespace bricksim::gui::windows::utilities::ldraw_library_updater {
                         ImGui::Text("Total download size for incremental update: %s", stringutil::formatBytesValue(state.getIncrementalUpdateTotalSize()).c_str());
                         ImGui::BeginDisabled(state.step != Step::CHOOSE_ACTION);
                         if (ImGui::Button("Do Incremental Update")) {
-                            controller::addBackgroundTask("Update LDraw Library", []() { getState().doIncrementalUpdate(); });
+                            controller::addBackgroundTask("Update LDraw Library", []() { getState().doIncrementalUpdate(); }, true);
                         }
                         ImGui::EndDisabled();
                     }
@@ -76,7 +77,7 @@ namespace bricksim::gui::windows::utilities::ldraw_library_updater {
                         ImGui::Text("Complete update download size: %s", stringutil::formatBytesValue(state.completeDistribution->size).c_str());
                         ImGui::BeginDisabled(state.step != Step::CHOOSE_ACTION);
                         if (ImGui::Button("Do Complete Update")) {
-                            controller::addBackgroundTask("Update LDraw Library", []() { getState().doCompleteUpdate(); });
+                            controller::addBackgroundTask("Update LDraw Library", []() { getState().doCompleteUpdate(); }, true);
                         }
                         ImGui::EndDisabled();
                         if (state.step == Step::UPDATE_COMPLETE && state.completeUpdateProgress.has_value()) {
@@ -88,6 +89,19 @@ namespace bricksim::gui::windows::utilities::ldraw_library_updater {
 
                     break;
                 case Step::FINISHED:
+                    if (!state.invalidatedFiles.empty()) {
+                        const uoset_t<std::shared_ptr<ldr::File>> invalidatedFiles(state.invalidatedFiles.cbegin(), state.invalidatedFiles.cend());
+                        //otherwise the meshes would be built from the old files again
+                        for (const auto& editor: controller::getEditors()) {
+                            editor->getRootNode()->replaceInvalidatedFiles(invalidatedFiles);
+                        }
+                        uoset_t<mesh_identifier_t> meshIdentifiers;
+                        for (const auto& file: state.invalidatedFiles) {
+                            meshIdentifiers.insert(file->getHash());
+                        }
+                        mesh::SceneMeshCollection::deleteMeshes(meshIdentifiers);
+                        state.invalidatedFiles.clear();
+                    }
                     ImGui::Text("Update finished.");
                     ImGui::Text("Your parts library is up to date");
                     break;
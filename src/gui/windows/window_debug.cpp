@@ -10,15 +10,16 @@
 #include <memory>
 
 #include "../../connection/connection_check.h"
+#include "../../connection/connector_data_provider.h"
 #include "../../connection/visualization/connection_graphviz_generator.h"
 #include "../../helpers/graphviz_wrapper.h"
+#include "../../helpers/thread_pool.h"
 #include "../../ldr/shadow_file_repo.h"
 #include "imgui_internal.h"
 #include "spdlog/spdlog.h"
 #include "window_debug.h"
 #include "window_mesh_inspector.h"
 #include <fstream>
-#include <future>
 #include <sstream>
 #include <tinyfiledialogs.h>
 
@@ -188,10 +189,16 @@ namespace bricksim::gui::windows::debug {
                 if (!bgTasks.empty()) {
                     ImGui::Text("%zu background tasks:", bgTasks.size());
                     for (const auto& task: bgTasks) {
-                        ImGui::BulletText("%s", task.second.getName().c_str());
+                        ImGui::BulletText("%s (%.0f%%)", task.second.getName().c_str(), task.second.getProgress() * 100.f);
                     }
                 }
 
+                if (ImGui::Button(ICON_FA_PLUG " Precompute connectors of all parts")) {
+                    controller::addBackgroundTask("Precompute connectors of all parts", [](float* progress) {
+                        connection::precomputeLibraryConnectors(progress);
+                    });
+                }
+
                 for (auto& editor: controller::getEditors()) {
                     const auto& rootNode = editor->getRootNode();
                     ImGui::Text("Element tree root node version: %" PRIu64, rootNode->getVersion());
@@ -216,11 +223,17 @@ namespace bricksim::gui::windows::debug {
                 ImGui::PlotLines("ms/frame", arrPtr, count, startIdx);
                 ImGui::Text(ICON_FA_STOPWATCH " Last 3D View render time: %.3f ms (%.1f FPS)", metrics::lastSceneRenderTimeMs, 1000.0 / metrics::lastSceneRenderTimeMs);
                 ImGui::Text(ICON_FA_MEMORY " Total graphics buffer size: %s", stringutil::formatBytesValue(metrics::vramUsageBytes).c_str());
-                ImGui::Text(ICON_FA_IMAGES " Total thumbnail buffer size: %zu images, %s",
+                ImGui::Text("Graphics buffer size saved by mesh optimization: %s", stringutil::formatBytesValue(metrics::vramSavedByMeshOptimization).c_str());
+                ImGui::Text(ICON_FA_IMAGES " Total thumbnail buffer size: %zu images in %zu atlas pages, %s",
                             controller::getThumbnailGenerator()->getNumCachedThumbnails(),
+                            controller::getThumbnailGenerator()->getNumAtlasPages(),
                             stringutil::formatBytesValue(metrics::thumbnailBufferUsageBytes).c_str());
                 ImGui::Text("Memory saved by deleting vertex data from RAM: %s", stringutil::formatBytesValue(metrics::memorySavedByDeletingVertexData).c_str());
+                ImGui::Text("ldr::FileElement arena size: %s", stringutil::formatBytesValue(metrics::ldrElementArenaBytes).c_str());
+                ImGui::Text("Flattened geometry cache size: %s", stringutil::formatBytesValue(metrics::flattenedGeometryCacheBytes).c_str());
+                ImGui::Text("Picking BVH size: %s", stringutil::formatBytesValue(metrics::pickingBvhBytes).c_str());
                 ImGui::Text(ICON_FA_ARROWS_ROTATE " Last element tree reread: %.2f ms", metrics::lastElementTreeRereadMs);
+                ImGui::Text(ICON_FA_STOPWATCH " Last CPU pick: %.3f ms", metrics::lastPickTimeMs);
                 ImGui::Text(ICON_FA_IMAGES " Last thumbnail render time: %.2f ms", metrics::lastThumbnailRenderingTimeMs);
                 #ifndef NDEBUG
                 ImGui::Text("ldr::FileElement instance count: %zu", metrics::ldrFileElementInstanceCount);
@@ -346,25 +359,23 @@ namespace bricksim::gui::windows::debug {
                 } else {
                     auto& engine = activeEditor->getConnectionEngine();
 
-                    static std::optional<std::future<bool>> updateThread;
-                    static float progress;
-                    if (updateThread.has_value()) {
+                    static std::shared_ptr<thread_pool::Job> updateJob;
+                    if (updateJob != nullptr) {
                         ImGui::BeginDisabled();
                         ImGui::Button(ICON_FA_ROTATE " Update Connection Engine");
                         ImGui::EndDisabled();
                         ImGui::SameLine();
-                        ImGui::ProgressBar(progress);
-                        const auto status = updateThread->wait_for(std::chrono::milliseconds(0));
-                        if (status == std::future_status::ready) {
-                            updateThread = std::nullopt;
+                        ImGui::ProgressBar(updateJob->getProgress());
+                        if (updateJob->isDone()) {
+                            updateJob = nullptr;
                         }
                     } else {
                         if (ImGui::Button(ICON_FA_ROTATE " Update Connection Engine")) {
-                            updateThread = std::async(std::launch::async, [&engine, &activeEditor] {
-                                util::setThreadName("Debug Window / Connection Engine Update");
-                                engine.update(activeEditor->getEditingModel(), &progress);
-                                return true;
-                            });
+                            updateJob = thread_pool::submit(
+                                    [&engine, editor = activeEditor](float* progress) {
+                                        engine.update(editor->getEditingModel(), progress);
+                                    },
+                                    thread_pool::Priority::FOREGROUND);
                         }
                     }
 
@@ -150,7 +150,7 @@ namespace bricksim::gui::windows::element_properties {
                         const auto itemValue = item.get();
                         controller::addBackgroundTask("Reload price guide for " + partCode + " in " + itemValue->name, [partCode, itemValue, currencyCode]() {
                             info_providers::price_guide::getPriceGuide(partCode, currencyCode, util::translateLDrawColorNameToBricklink(itemValue->name), true);
-                        });
+                        }, true);
                     }
                 }
             }
@@ -174,7 +174,7 @@ namespace bricksim::gui::windows::element_properties {
                     if (ImGui::Button((ICON_FA_CLOUD_ARROW_DOWN " Reload for " + color->name).c_str())) {
                         controller::addBackgroundTask("Reload price guide for " + partCode, [partCode, colorBricklinkName, currencyCode]() {
                             info_providers::price_guide::getPriceGuide(partCode, currencyCode, colorBricklinkName, true);
-                        });
+                        }, true);
                     }
                 }
                 ImGui::Text("Currency: %s", currencyCode.c_str());
@@ -289,14 +289,14 @@ namespace bricksim::gui::windows::element_properties {
                 if (ImGui::Button((ICON_FA_DOWNLOAD " Get for " + color->name).c_str())) {
                     controller::addBackgroundTask("Get Price Guide for " + partCode, [partCode, colorBricklinkName, currencyCode]() {
                         info_providers::price_guide::getPriceGuide(partCode, currencyCode, colorBricklinkName, false);
-                    });
+                    }, true);
                 }
                 if (availableColors.has_value() && ImGui::Button((ICON_FA_DOWNLOAD " Get for all " + std::to_string(availableColors.value().size()) + " available colors").c_str())) {
                     for (const auto& avCol: availableColors.value()) {
                         const auto avColValue = avCol.get();
                         controller::addBackgroundTask("Get Price Guide for " + partCode + " in " + avColValue->name, [partCode, avColValue, currencyCode]() {
                             info_providers::price_guide::getPriceGuide(partCode, currencyCode, util::translateLDrawColorNameToBricklink(avColValue->name), false);
-                        });
+                        }, true);
                     }
                 }
             }
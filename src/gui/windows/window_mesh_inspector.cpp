@@ -224,6 +224,48 @@ namespace bricksim::gui::windows::mesh_inspector {
                     ImGui::EndTable();
                 }
 
+                if (ImGui::BeginTable("##meshInspectorTriangleDataTable", 5, ImGuiTableFlags_Borders)) {
+                    ImGui::TableSetupColumn("Color");
+                    ImGui::TableSetupColumn("Vertices");
+                    ImGui::TableSetupColumn("Indices");
+                    ImGui::TableSetupColumn("Index Size");
+                    ImGui::TableSetupColumn("ACMR");
+                    ImGui::TableHeadersRow();
+
+                    for (const auto& [color, triangleData]: mesh->getAllTriangleData()) {
+                        const auto& stats = triangleData.getOptimizationStats();
+                        ImGui::TableNextRow();
+
+                        ImGui::TableNextColumn();
+                        drawColorLabel(color);
+
+                        ImGui::TableNextColumn();
+                        if (stats.has_value()) {
+                            ImGui::Text("%zu " ICON_FA_ARROW_RIGHT " %zu", stats->vertexCountBefore, triangleData.getVertexCount());
+                        } else {
+                            ImGui::Text("%zu", triangleData.getVertexCount());
+                        }
+
+                        ImGui::TableNextColumn();
+                        if (stats.has_value()) {
+                            ImGui::Text("%zu " ICON_FA_ARROW_RIGHT " %zu", stats->indexCountBefore, triangleData.getIndexCount());
+                        } else {
+                            ImGui::Text("%zu", triangleData.getIndexCount());
+                        }
+
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%zu bit", triangleData.getIndexSize() * 8);
+
+                        ImGui::TableNextColumn();
+                        if (stats.has_value()) {
+                            ImGui::Text("%.2f " ICON_FA_ARROW_RIGHT " %.2f", stats->acmrBefore, stats->acmrAfter);
+                        } else {
+                            ImGui::Text("not optimized");
+                        }
+                    }
+                    ImGui::EndTable();
+                }
+
                 if (ImGui::BeginTable("##meshInspectorBufferIdsTable", 5)) {
                     ImGui::TableSetupColumn("Color");
                     ImGui::TableSetupColumn("VAO");
@@ -287,14 +287,26 @@ namespace bricksim::gui::windows::part_palette {
 
             const bool searchEmpty = searchTextBuffer[0] == '\0';
             const auto& searchPredicate = part_finder::getPredicate(searchTextBuffer);
+            //library parts are searched in the index, the predicate is only for files which aren't in the library
+            const auto searchIndex = part_finder::getSearchIndex();
 
-            const auto drawPart = [&actualThumbSizeSquared, &searchEmpty, &searchPredicate](const std::shared_ptr<ldr::File>& file) {
+            const auto drawThumbnail = [&actualThumbSizeSquared](const std::shared_ptr<ldr::File>& file) {
+                gui_internal::drawPartThumbnail(actualThumbSizeSquared, file, color->asReference());
+                ImGui::SameLine();
+                if (ImGui::GetContentRegionAvail().x < actualThumbSizeSquared.x) {
+                    ImGui::NewLine();
+                }
+            };
+
+            const auto drawPart = [&drawThumbnail, &searchEmpty, &searchPredicate](const std::shared_ptr<ldr::File>& file) {
                 if (searchEmpty || searchPredicate.matches(*file)) {
-                    gui_internal::drawPartThumbnail(actualThumbSizeSquared, file, color->asReference());
-                    ImGui::SameLine();
-                    if (ImGui::GetContentRegionAvail().x < actualThumbSizeSquared.x) {
-                        ImGui::NewLine();
-                    }
+                    drawThumbnail(file);
+                }
+            };
+
+            const auto drawSearchResults = [&drawThumbnail, &searchIndex](const std::string& query, const std::string& category) {
+                for (const auto& name: searchIndex->search(query, category)) {
+                    drawThumbnail(ldr::file_repo::get().getFile(std::shared_ptr<ldr::FileNamespace>(), name));
                 }
             };
 
@@ -310,15 +322,19 @@ namespace bricksim::gui::windows::part_palette {
                 }
             };
 
-            const auto drawCategory = [&drawPart](const std::string& category) {
-                for (const auto& part: ldr::file_repo::get().getAllFilesOfCategory(category)) {
-                    drawPart(part);
+            const auto drawCategory = [&drawPart, &drawSearchResults, &searchEmpty, &searchIndex](const std::string& category) {
+                if (!searchEmpty && searchIndex != nullptr) {
+                    drawSearchResults(searchTextBuffer, category);
+                } else {
+                    for (const auto& part: ldr::file_repo::get().getAllFilesOfCategory(category)) {
+                        drawPart(part);
+                    }
                 }
                 ImGui::NewLine();
             };
 
             static uomap_t<std::pair<std::string, std::string>, oset_t<std::shared_ptr<ldr::File>>> customCategoryCache;
-            const auto getCustomPartList = [](const std::string& ldrawCategory, const std::string& nameFilter) {
+            const auto getCustomPartList = [&searchIndex](const std::string& ldrawCategory, const std::string& nameFilter) {
                 if (nameFilter.empty()) {
                     return ldr::file_repo::get().getAllFilesOfCategory(ldrawCategory);
                 } else {
@@ -326,11 +342,17 @@ namespace bricksim::gui::windows::part_palette {
                     if (const auto it = customCategoryCache.find(key); it != customCategoryCache.end()) {
                         return it->second;
                     }
-                    const auto& matcher = part_finder::getPredicate(nameFilter);
                     oset_t<std::shared_ptr<ldr::File>> result;
-                    for (const auto& file: ldr::file_repo::get().getAllFilesOfCategory(ldrawCategory)) {
-                        if (matcher.matches(*file)) {
-                            result.insert(file);
+                    if (searchIndex != nullptr) {
+                        for (const auto& name: searchIndex->search(nameFilter, ldrawCategory)) {
+                            result.insert(ldr::file_repo::get().getFile(std::shared_ptr<ldr::FileNamespace>(), name));
+                        }
+                    } else {
+                        const auto& matcher = part_finder::getPredicate(nameFilter);
+                        for (const auto& file: ldr::file_repo::get().getAllFilesOfCategory(ldrawCategory)) {
+                            if (matcher.matches(*file)) {
+                                result.insert(file);
+                            }
                         }
                     }
                     return customCategoryCache.emplace(key, result).first->second;
@@ -131,6 +131,9 @@ namespace bricksim::gui::windows::settings {
         ImGui::Checkbox("VSync", &data.vsync);
         ImGui::Checkbox("Face Culling", &data.faceCulling);
         ImGui::Checkbox("Delete Vertex Data in RAM after Uploading to VRAM", &data.deleteVertexDataAfterUploading);
+        ImGui::Checkbox("Cache Flattened Geometry of Library Files", &data.cacheFlattenedGeometry);
+        ImGui::Checkbox("Weld and Reorder Mesh Vertices", &data.optimizeMeshes);
+        ImGui::Checkbox("Pick Elements on the CPU instead of reading the Selection Buffer", &data.cpuPicking);
     }
 
 
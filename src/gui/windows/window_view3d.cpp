@@ -16,7 +16,15 @@
 
 namespace bricksim::gui::windows::view3d {
     std::shared_ptr<etree::Node> getNodeUnderCursor(const std::shared_ptr<graphics::Scene>& mainScene, const glm::svec2& currentCursorPos) {
-        const auto elementIdUnderCursor = mainScene->getSelectionPixel(currentCursorPos);
+        element_id_t elementIdUnderCursor = 0;
+        if (config::get().graphics.cpuPicking) {
+            const auto hit = mainScene->pickElement(currentCursorPos);
+            if (hit.has_value()) {
+                elementIdUnderCursor = hit->elementId;
+            }
+        } else {
+            elementIdUnderCursor = mainScene->getSelectionPixel(currentCursorPos);
+        }
         auto nodeUnderCursor = elementIdUnderCursor != 0
                                    ? mainScene->getMeshCollection().getElementById(elementIdUnderCursor)
                                    : nullptr;
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace bricksim {
+    /**
+     * appends trivially copyable values and length-prefixed strings to a byte buffer (native byte order)
+     */
+    class BinaryWriter {
+    public:
+        std::vector<uint8_t> buffer;
+
+        template<typename T>
+        void put(const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            const auto pos = buffer.size();
+            buffer.resize(pos + sizeof(T));
+            std::memcpy(buffer.data() + pos, &value, sizeof(T));
+        }
+
+        void putString(std::string_view value) {
+            put(static_cast<uint32_t>(value.size()));
+            buffer.insert(buffer.end(), value.begin(), value.end());
+        }
+    };
+
+    /**
+     * reads what BinaryWriter wrote
+     * @throws std::out_of_range when reading past the end of the data
+     */
+    class BinaryReader {
+    public:
+        explicit BinaryReader(std::span<const uint8_t> data) :
+            data(data) {}
+
+        template<typename T>
+        T get() {
+            static_assert(std::is_trivially_copyable_v<T>);
+            require(sizeof(T));
+            T value;
+            std::memcpy(&value, data.data() + pos, sizeof(T));
+            pos += sizeof(T);
+            return value;
+        }
+
+        std::string getString() {
+            const auto size = get<uint32_t>();
+            require(size);
+            std::string value(reinterpret_cast<const char*>(data.data() + pos), size);
+            pos += size;
+            return value;
+        }
+
+        [[nodiscard]] std::size_t getPosition() const {
+            return pos;
+        }
+
+        [[nodiscard]] bool isAtEnd() const {
+            return pos == data.size();
+        }
+
+    private:
+        std::span<const uint8_t> data;
+        std::size_t pos = 0;
+
+        void require(std::size_t bytes) const {
+            if (pos + bytes > data.size()) {
+                throw std::out_of_range("unexpected end of binary data");
+            }
+        }
+    };
+}
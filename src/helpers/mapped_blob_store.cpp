@@ -0,0 +1,194 @@
+#include "mapped_blob_store.h"
+#include "binary_io.h"
+#include <fstream>
+#include <palanteer.h>
+#include <spdlog/spdlog.h>
+#include <utility>
+
+namespace bricksim {
+    MappedBlobStore::MappedBlobStore(std::filesystem::path path, std::string description, const magic_t& magic, uint32_t formatVersion, std::vector<std::string> headerValues) :
+        path(std::move(path)), description(std::move(description)), magic(magic), formatVersion(formatVersion), headerValues(std::move(headerValues)) {
+        openMapping();
+    }
+
+    void MappedBlobStore::openMapping() {
+        plFunction();
+        mapping = nullptr;
+        index.clear();
+        if (!std::filesystem::is_regular_file(path)) {
+            spdlog::info("{} {} does not exist yet", description, path.string());
+            return;
+        }
+        try {
+            mapping = std::make_unique<MemoryMappedFile>(path);
+            BinaryReader reader(mapping->asSpan());
+            magic_t cachedMagic;
+            for (auto& ch: cachedMagic) {
+                ch = reader.get<char>();
+            }
+            const auto cachedFormatVersion = reader.get<uint32_t>();
+            if (cachedMagic != magic || cachedFormatVersion != formatVersion) {
+                spdlog::info("{} {} has an old format, ignoring it", description, path.string());
+                mapping = nullptr;
+                return;
+            }
+            const auto indexOffset = reader.get<uint64_t>();
+            for (const auto& expected: headerValues) {
+                const auto cached = reader.getString();
+                if (cached != expected) {
+                    spdlog::info("{} {} was created for {}, current is {}. ignoring it", description, path.string(), cached, expected);
+                    mapping = nullptr;
+                    return;
+                }
+            }
+            if (indexOffset > mapping->size()) {
+                throw std::out_of_range("index offset out of range");
+            }
+            BinaryReader indexReader(mapping->asSpan().subspan(indexOffset));
+            const auto entryCount = indexReader.get<uint32_t>();
+            index.reserve(entryCount);
+            for (uint32_t i = 0; i < entryCount; ++i) {
+                auto name = indexReader.getString();
+                IndexEntry entry{};
+                entry.fingerprint = indexReader.get<uint64_t>();
+                entry.offset = indexReader.get<uint64_t>();
+                entry.size = indexReader.get<uint64_t>();
+                if (entry.offset + entry.size > indexOffset) {
+                    throw std::out_of_range(fmt::format("entry {} out of range", name));
+                }
+                index.emplace(std::move(name), entry);
+            }
+            spdlog::info("opened {} {} with {} entries", description, path.string(), index.size());
+        } catch (const std::exception& e) {
+            spdlog::warn("{} {} is invalid, ignoring it: {}", description, path.string(), e.what());
+            index.clear();
+            mapping = nullptr;
+        }
+    }
+
+    std::span<const uint8_t> MappedBlobStore::read(const std::string& name, uint64_t fingerprint) const {
+        if (fingerprint == 0) {
+            return {};
+        }
+        {
+            std::scoped_lock<std::mutex> lg(newEntriesMtx);
+            const auto it = newEntries.find(name);
+            if (it != newEntries.end()) {
+                return it->second.fingerprint == fingerprint ? std::span<const uint8_t>(*it->second.data) : std::span<const uint8_t>();
+            }
+        }
+        if (mapping == nullptr) {
+            return {};
+        }
+        const auto it = index.find(name);
+        if (it == index.end() || it->second.fingerprint != fingerprint) {
+            return {};
+        }
+        return mapping->asSpan().subspan(it->second.offset, it->second.size);
+    }
+
+    void MappedBlobStore::put(const std::string& name, uint64_t fingerprint, std::vector<uint8_t> data) {
+        if (fingerprint == 0) {
+            return;
+        }
+        auto entry = NewEntry{fingerprint, std::make_shared<const std::vector<uint8_t>>(std::move(data))};
+        std::scoped_lock<std::mutex> lg(newEntriesMtx);
+        const auto it = newEntries.find(name);
+        if (it != newEntries.end()) {
+            replacedEntries.push_back(std::move(it->second.data));
+            it->second = std::move(entry);
+        } else {
+            newEntries.emplace(name, std::move(entry));
+        }
+    }
+
+    void MappedBlobStore::save() {
+        plFunction();
+        std::scoped_lock<std::mutex> lg(newEntriesMtx);
+        if (newEntries.empty()) {
+            return;
+        }
+
+        BinaryWriter header;
+        for (const auto& ch: magic) {
+            header.put(ch);
+        }
+        header.put(formatVersion);
+        const auto indexOffsetPosition = header.buffer.size();
+        header.put<uint64_t>(0);
+        for (const auto& value: headerValues) {
+            header.putString(value);
+        }
+
+        const auto tmpPath = std::filesystem::path(path).concat(".tmp");
+        {
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                spdlog::warn("cannot write {} to {}", description, tmpPath.string());
+                return;
+            }
+            out.write(reinterpret_cast<const char*>(header.buffer.data()), static_cast<std::streamsize>(header.buffer.size()));
+            uint64_t offset = header.buffer.size();
+
+            BinaryWriter indexWriter;
+            uint32_t entryCount = 0;
+            const auto writeEntry = [&](const std::string& name, uint64_t fingerprint, std::span<const uint8_t> data) {
+                out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+                indexWriter.putString(name);
+                indexWriter.put(fingerprint);
+                indexWriter.put(offset);
+                indexWriter.put(static_cast<uint64_t>(data.size()));
+                offset += data.size();
+                ++entryCount;
+            };
+            if (mapping != nullptr) {
+                for (const auto& [name, entry]: index) {
+                    if (!newEntries.contains(name)) {
+                        writeEntry(name, entry.fingerprint, mapping->asSpan().subspan(entry.offset, entry.size));
+                    }
+                }
+            }
+            for (const auto& [name, entry]: newEntries) {
+                writeEntry(name, entry.fingerprint, *entry.data);
+            }
+
+            out.write(reinterpret_cast<const char*>(&entryCount), sizeof(entryCount));
+            out.write(reinterpret_cast<const char*>(indexWriter.buffer.data()), static_cast<std::streamsize>(indexWriter.buffer.size()));
+            out.seekp(static_cast<std::streamoff>(indexOffsetPosition));
+            out.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+            if (!out) {
+                spdlog::warn("writing {} to {} failed", description, tmpPath.string());
+                return;
+            }
+        }
+
+        //the old file must be unmapped before it can be replaced on windows
+        mapping = nullptr;
+        std::error_code ec;
+        std::filesystem::rename(tmpPath, path, ec);
+        if (ec) {
+            spdlog::warn("cannot replace {} {}: {}", description, path.string(), ec.message());
+        } else {
+            spdlog::info("saved {} new entries to {} {}", newEntries.size(), description, path.string());
+        }
+        newEntries.clear();
+        replacedEntries.clear();
+        openMapping();
+    }
+
+    std::size_t MappedBlobStore::getEntryCount() const {
+        std::scoped_lock<std::mutex> lg(newEntriesMtx);
+        auto count = index.size();
+        for (const auto& [name, entry]: newEntries) {
+            if (!index.contains(name)) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    std::size_t MappedBlobStore::getNewEntryCount() const {
+        std::scoped_lock<std::mutex> lg(newEntriesMtx);
+        return newEntries.size();
+    }
+}
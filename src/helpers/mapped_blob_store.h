@@ -0,0 +1,75 @@
+#pragma once
+
+#include "../types.h"
+#include "memory_mapped_file.h"
+#include <array>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace bricksim {
+    /**
+     * binary entries on disk, each identified by a name and a fingerprint of the data it was created from.
+     * the file is memory mapped, so reading an entry only touches its pages.
+     * the whole file is ignored if the format version or one of the header values (library version, ...) is different.
+     * new entries are collected in memory and written at the next save()
+     */
+    class MappedBlobStore {
+    public:
+        using magic_t = std::array<char, 8>;
+
+        /**
+         * @param description used in log messages
+         * @param formatVersion increment this when the layout of the entries changes
+         */
+        MappedBlobStore(std::filesystem::path path, std::string description, const magic_t& magic, uint32_t formatVersion, std::vector<std::string> headerValues);
+        MappedBlobStore(const MappedBlobStore&) = delete;
+        MappedBlobStore& operator=(const MappedBlobStore&) = delete;
+
+        /**
+         * thread safe, entries added with put() since the last save() are found too
+         * @param fingerprint 0 means unknown
+         * @return an empty span if there's no entry with this name and fingerprint. valid until the next save()
+         */
+        [[nodiscard]] std::span<const uint8_t> read(const std::string& name, uint64_t fingerprint) const;
+        ///thread safe. does nothing if fingerprint is 0
+        void put(const std::string& name, uint64_t fingerprint, std::vector<uint8_t> data);
+        /**
+         * writes all valid old entries and all new entries to disk if there are new ones.
+         * must not be called while other threads call read()
+         */
+        void save();
+
+        [[nodiscard]] std::size_t getEntryCount() const;
+        [[nodiscard]] std::size_t getNewEntryCount() const;
+
+    private:
+        struct IndexEntry {
+            uint64_t fingerprint;
+            uint64_t offset;
+            uint64_t size;
+        };
+
+        struct NewEntry {
+            uint64_t fingerprint;
+            std::shared_ptr<const std::vector<uint8_t>> data;
+        };
+
+        std::filesystem::path path;
+        std::string description;
+        magic_t magic;
+        uint32_t formatVersion;
+        std::vector<std::string> headerValues;
+        std::unique_ptr<MemoryMappedFile> mapping;
+        uomap_t<std::string, IndexEntry> index;
+
+        mutable std::mutex newEntriesMtx;
+        uomap_t<std::string, NewEntry> newEntries;
+        ///replaced new entries are kept until save() so the spans returned by read() stay valid
+        std::vector<std::shared_ptr<const std::vector<uint8_t>>> replacedEntries;
+
+        void openMapping();
+    };
+}
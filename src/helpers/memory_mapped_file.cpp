@@ -0,0 +1,100 @@
+#include "memory_mapped_file.h"
+#include "platform_detection.h"
+#include <spdlog/fmt/fmt.h>
+#include <stdexcept>
+
+#ifdef BRICKSIM_PLATFORM_WINDOWS
+    #include <windows.h>
+    #ifdef min
+        #undef min
+    #endif
+    #ifdef max
+        #undef max
+    #endif
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace bricksim {
+#ifdef BRICKSIM_PLATFORM_WINDOWS
+    MemoryMappedFile::MemoryMappedFile(const std::filesystem::path& path) {
+        fileHandle = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE) {
+            fileHandle = nullptr;
+            throw std::invalid_argument(fmt::format("cannot open {} for mapping", path.string()));
+        }
+        LARGE_INTEGER fileSize;
+        GetFileSizeEx(fileHandle, &fileSize);
+        mappingSize = static_cast<std::size_t>(fileSize.QuadPart);
+        if (mappingSize == 0) {
+            return;
+        }
+        mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle == nullptr) {
+            CloseHandle(fileHandle);
+            throw std::invalid_argument(fmt::format("cannot map {}", path.string()));
+        }
+        mapping = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        if (mapping == nullptr) {
+            CloseHandle(mappingHandle);
+            CloseHandle(fileHandle);
+            throw std::invalid_argument(fmt::format("cannot map {}", path.string()));
+        }
+    }
+
+    MemoryMappedFile::~MemoryMappedFile() {
+        if (mapping != nullptr) {
+            UnmapViewOfFile(mapping);
+        }
+        if (mappingHandle != nullptr) {
+            CloseHandle(mappingHandle);
+        }
+        if (fileHandle != nullptr) {
+            CloseHandle(fileHandle);
+        }
+    }
+#else
+    MemoryMappedFile::MemoryMappedFile(const std::filesystem::path& path) {
+        fileDescriptor = open(path.c_str(), O_RDONLY);
+        if (fileDescriptor == -1) {
+            throw std::invalid_argument(fmt::format("cannot open {} for mapping", path.string()));
+        }
+        struct stat fileStat{};
+        fstat(fileDescriptor, &fileStat);
+        mappingSize = static_cast<std::size_t>(fileStat.st_size);
+        if (mappingSize == 0) {
+            return;
+        }
+        void* result = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        if (result == MAP_FAILED) {
+            close(fileDescriptor);
+            throw std::invalid_argument(fmt::format("cannot map {}", path.string()));
+        }
+        mapping = static_cast<const uint8_t*>(result);
+    }
+
+    MemoryMappedFile::~MemoryMappedFile() {
+        if (mapping != nullptr) {
+            munmap(const_cast<uint8_t*>(mapping), mappingSize);
+        }
+        if (fileDescriptor != -1) {
+            close(fileDescriptor);
+        }
+    }
+#endif
+
+    const uint8_t* MemoryMappedFile::data() const {
+        return mapping;
+    }
+
+    std::size_t MemoryMappedFile::size() const {
+        return mapping != nullptr ? mappingSize : 0;
+    }
+
+    std::span<const uint8_t> MemoryMappedFile::asSpan() const {
+        return {data(), size()};
+    }
+}
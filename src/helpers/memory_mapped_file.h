@@ -0,0 +1,38 @@
+#pragma once
+
+#include "platform_detection.h"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+namespace bricksim {
+    /**
+     * read-only view of a whole file using the virtual memory system (mmap / MapViewOfFile).
+     * pages are only read from disk when they're accessed
+     */
+    class MemoryMappedFile {
+    public:
+        /**
+         * @throws std::invalid_argument if the file can't be opened or mapped
+         */
+        explicit MemoryMappedFile(const std::filesystem::path& path);
+        MemoryMappedFile(const MemoryMappedFile&) = delete;
+        MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+        ~MemoryMappedFile();
+
+        [[nodiscard]] const uint8_t* data() const;
+        [[nodiscard]] std::size_t size() const;
+        [[nodiscard]] std::span<const uint8_t> asSpan() const;
+
+    private:
+        const uint8_t* mapping = nullptr;
+        std::size_t mappingSize = 0;
+#ifdef BRICKSIM_PLATFORM_WINDOWS
+        void* fileHandle = nullptr;
+        void* mappingHandle = nullptr;
+#else
+        int fileDescriptor = -1;
+#endif
+    };
+}
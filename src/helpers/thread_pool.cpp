@@ -0,0 +1,357 @@
+#include "thread_pool.h"
+#include "util.h"
+#include <array>
+#include <deque>
+#include <palanteer.h>
+#include <spdlog/fmt/fmt.h>
+#include <thread>
+#include <vector>
+
+namespace bricksim::thread_pool {
+    namespace {
+        constexpr std::size_t PRIORITY_COUNT = 3;
+        using queues_t = std::array<std::deque<std::shared_ptr<Job>>, PRIORITY_COUNT>;
+
+        thread_local int currentWorkerIndex = -1;
+        thread_local const Job* currentJob = nullptr;
+
+        class Pool {
+        public:
+            Pool() {
+                const auto workerCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+                for (unsigned int i = 0; i < workerCount; ++i) {
+                    workers.push_back(std::make_unique<Worker>());
+                }
+                for (unsigned int i = 0; i < workerCount; ++i) {
+                    workers[i]->thread = std::thread(&Pool::workerLoop, this, i);
+                }
+            }
+
+            Pool(const Pool&) = delete;
+            Pool& operator=(const Pool&) = delete;
+
+            ~Pool() {
+                {
+                    std::scoped_lock<std::mutex> lg(sleepMtx);
+                    stopping = true;
+                }
+                wake.notify_all();
+                for (const auto& worker: workers) {
+                    worker->thread.join();
+                }
+                for (const auto& worker: workers) {
+                    cancelAll(worker->queues);
+                }
+                cancelAll(globalQueues);
+            }
+
+            void push(std::shared_ptr<Job> job) {
+                const auto prio = static_cast<std::size_t>(job->getPriority());
+                if (currentWorkerIndex >= 0) {
+                    //the own queue is used as a stack, this keeps nested jobs close to the data of the job which created them
+                    auto& worker = *workers[currentWorkerIndex];
+                    std::scoped_lock<std::mutex> lg(worker.mtx);
+                    worker.queues[prio].push_back(std::move(job));
+                } else {
+                    std::scoped_lock<std::mutex> lg(globalMtx);
+                    globalQueues[prio].push_back(std::move(job));
+                }
+                ++queuedCount;
+                {
+                    std::scoped_lock<std::mutex> lg(sleepMtx);
+                }
+                wake.notify_one();
+            }
+
+            ///runs one queued job on the calling worker thread
+            ///@return false if all queues were empty
+            bool tryRunOne() {
+                auto job = pop(currentWorkerIndex);
+                if (job == nullptr) {
+                    return false;
+                }
+                job->run();
+                return true;
+            }
+
+            [[nodiscard]] unsigned int getWorkerCount() const {
+                return static_cast<unsigned int>(workers.size());
+            }
+
+        private:
+            struct Worker {
+                std::mutex mtx;
+                queues_t queues;
+                std::thread thread;
+            };
+
+            std::vector<std::unique_ptr<Worker>> workers;
+            std::mutex globalMtx;
+            queues_t globalQueues;
+            std::atomic<std::size_t> queuedCount = 0;
+            std::mutex sleepMtx;
+            std::condition_variable wake;
+            bool stopping = false;
+
+            void workerLoop(unsigned int index) {
+                currentWorkerIndex = static_cast<int>(index);
+                const auto threadName = fmt::format("Thread pool #{}", index);
+                util::setThreadName(threadName.c_str());
+                while (true) {
+                    if (tryRunOne()) {
+                        continue;
+                    }
+                    std::unique_lock<std::mutex> lock(sleepMtx);
+                    wake.wait(lock, [this] { return stopping || queuedCount > 0; });
+                    if (stopping) {
+                        break;
+                    }
+                }
+            }
+
+            /**
+             * the highest priority wins over locality: all queues are searched for INTERACTIVE jobs before any FOREGROUND job is taken.
+             * jobs which were cancelled while they were queued are dropped here
+             */
+            std::shared_ptr<Job> pop(int workerIndex) {
+                if (queuedCount == 0) {
+                    return nullptr;
+                }
+                for (std::size_t prio = 0; prio < PRIORITY_COUNT; ++prio) {
+                    if (workerIndex >= 0) {
+                        auto& own = *workers[workerIndex];
+                        if (auto job = take(own.mtx, own.queues[prio], false)) {
+                            return job;
+                        }
+                    }
+                    if (auto job = take(globalMtx, globalQueues[prio], true)) {
+                        return job;
+                    }
+                    const auto firstVictim = static_cast<std::size_t>(workerIndex + 1);
+                    for (std::size_t i = 0; i < workers.size(); ++i) {
+                        const auto victimIndex = (firstVictim + i) % workers.size();
+                        if (static_cast<int>(victimIndex) == workerIndex) {
+                            continue;
+                        }
+                        auto& victim = *workers[victimIndex];
+                        if (auto job = take(victim.mtx, victim.queues[prio], true)) {
+                            return job;
+                        }
+                    }
+                }
+                return nullptr;
+            }
+
+            std::shared_ptr<Job> take(std::mutex& mtx, std::deque<std::shared_ptr<Job>>& queue, bool front) {
+                std::scoped_lock<std::mutex> lg(mtx);
+                while (!queue.empty()) {
+                    std::shared_ptr<Job> job;
+                    if (front) {
+                        job = std::move(queue.front());
+                        queue.pop_front();
+                    } else {
+                        job = std::move(queue.back());
+                        queue.pop_back();
+                    }
+                    --queuedCount;
+                    if (job->getState() == Job::State::PENDING) {
+                        return job;
+                    }
+                }
+                return nullptr;
+            }
+
+            static void cancelAll(queues_t& queues) {
+                for (auto& queue: queues) {
+                    for (const auto& job: queue) {
+                        job->cancel();
+                    }
+                    queue.clear();
+                }
+            }
+        };
+
+        Pool& getPool() {
+            static Pool pool;
+            return pool;
+        }
+    }
+
+    Job::Job(std::function<void(float*)> function, Priority priority, float initialProgress) :
+        function(std::move(function)), priority(priority), progress(initialProgress) {
+    }
+
+    Priority Job::getPriority() const {
+        return priority;
+    }
+
+    Job::State Job::getState() const {
+        return state;
+    }
+
+    bool Job::isDone() const {
+        const auto current = state.load();
+        return current == State::DONE || current == State::CANCELLED;
+    }
+
+    float Job::getProgress() const {
+        return progress;
+    }
+
+    const float* Job::getProgressPtr() const {
+        return &progress;
+    }
+
+    std::chrono::microseconds Job::getDuration() const {
+        return duration;
+    }
+
+    void Job::cancel() {
+        cancelRequested = true;
+        auto expected = State::PENDING;
+        if (state.compare_exchange_strong(expected, State::RUNNING)) {
+            setFinishedState(State::CANCELLED);
+        }
+    }
+
+    bool Job::isCancelRequested() const {
+        return cancelRequested;
+    }
+
+    void Job::wait() {
+        if (isWorkerThread()) {
+            while (!isDone()) {
+                if (!getPool().tryRunOne()) {
+                    std::unique_lock<std::mutex> lock(finishedMtx);
+                    finished.wait_for(lock, std::chrono::milliseconds(1), [this] { return isDone(); });
+                }
+            }
+        } else {
+            std::unique_lock<std::mutex> lock(finishedMtx);
+            finished.wait(lock, [this] { return isDone(); });
+        }
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    void Job::run() {
+        auto expected = State::PENDING;
+        if (!state.compare_exchange_strong(expected, State::RUNNING)) {
+            return;
+        }
+        plScope("thread_pool::Job::run");
+        const auto* previousJob = currentJob;
+        currentJob = this;
+        const auto before = std::chrono::high_resolution_clock::now();
+        try {
+            function(&progress);
+        } catch (...) {
+            exception = std::current_exception();
+        }
+        duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - before);
+        currentJob = previousJob;
+        progress = 1.f;
+        setFinishedState(State::DONE);
+    }
+
+    void Job::setFinishedState(State newState) {
+        {
+            std::scoped_lock<std::mutex> lg(finishedMtx);
+            state = newState;
+        }
+        finished.notify_all();
+    }
+
+    std::shared_ptr<Job> submit(std::function<void(float*)> function, Priority priority, float initialProgress) {
+        auto job = std::make_shared<Job>(std::move(function), priority, initialProgress);
+        getPool().push(job);
+        return job;
+    }
+
+    std::shared_ptr<Job> submit(const std::function<void()>& function, Priority priority) {
+        return submit([function](float*) { function(); }, priority, .5f);
+    }
+
+    std::shared_ptr<Job> startOnOwnThread(std::function<void(float*)> function, Priority priority, const std::string& threadName, float initialProgress) {
+        auto job = std::make_shared<Job>(std::move(function), priority, initialProgress);
+        std::thread([job, threadName]() {
+            util::setThreadName(threadName.c_str());
+            job->run();
+        }).detach();
+        return job;
+    }
+
+    void parallelFor(std::size_t count, std::size_t grainSize, const std::function<void(std::size_t, std::size_t)>& function, std::optional<Priority> priority) {
+        if (count == 0) {
+            return;
+        }
+        grainSize = std::max<std::size_t>(grainSize, 1);
+        const auto chunkCount = (count + grainSize - 1) / grainSize;
+        if (chunkCount == 1) {
+            function(0, count);
+            return;
+        }
+
+        //chunks are handed out through a counter, so a helper which starts late just finds nothing left to do
+        std::atomic<std::size_t> nextChunk = 0;
+        std::atomic<bool> failed = false;
+        std::mutex exceptionMtx;
+        std::exception_ptr firstException;
+        const auto* parentJob = currentJob;
+        const auto processChunks = [&]() {
+            while (!failed) {
+                const auto chunk = nextChunk++;
+                if (chunk >= chunkCount) {
+                    break;
+                }
+                try {
+                    function(chunk * grainSize, std::min(count, (chunk + 1) * grainSize));
+                } catch (...) {
+                    failed = true;
+                    std::scoped_lock<std::mutex> lg(exceptionMtx);
+                    if (!firstException) {
+                        firstException = std::current_exception();
+                    }
+                }
+            }
+        };
+
+        const auto jobPriority = priority.value_or(parentJob != nullptr ? parentJob->getPriority() : Priority::INTERACTIVE);
+        const auto helperCount = std::min<std::size_t>(chunkCount - 1, getPool().getWorkerCount());
+        std::vector<std::shared_ptr<Job>> helpers;
+        helpers.reserve(helperCount);
+        for (std::size_t i = 0; i < helperCount; ++i) {
+            helpers.push_back(submit(
+                    [&](float*) {
+                        //the chunks belong to the job which called parallelFor, so isCurrentJobCancelled() has to ask that one
+                        const auto* helperJob = currentJob;
+                        currentJob = parentJob;
+                        processChunks();
+                        currentJob = helperJob;
+                    },
+                    jobPriority));
+        }
+        processChunks();
+        for (const auto& helper: helpers) {
+            //helpers which were not started yet are not needed anymore
+            helper->cancel();
+            helper->wait();
+        }
+        if (firstException) {
+            std::rethrow_exception(firstException);
+        }
+    }
+
+    bool isWorkerThread() {
+        return currentWorkerIndex >= 0;
+    }
+
+    bool isCurrentJobCancelled() {
+        return currentJob != nullptr && currentJob->isCancelRequested();
+    }
+
+    unsigned int getWorkerCount() {
+        return getPool().getWorkerCount();
+    }
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace bricksim::thread_pool {
+    /**
+     * jobs with a higher priority are always started first, the order is the order of the enum values
+     */
+    enum class Priority {
+        ///the user is waiting for the result right now, for example parallelFor called from the main thread
+        INTERACTIVE,
+        ///visible work like building meshes or foreground tasks
+        FOREGROUND,
+        ///caches, precomputations and other background tasks
+        BACKGROUND,
+    };
+
+    class Job {
+    public:
+        enum class State {
+            PENDING,
+            RUNNING,
+            DONE,
+            CANCELLED,
+        };
+
+        Job(std::function<void(float*)> function, Priority priority, float initialProgress);
+        Job(const Job&) = delete;
+        Job& operator=(const Job&) = delete;
+
+        [[nodiscard]] Priority getPriority() const;
+        [[nodiscard]] State getState() const;
+        ///@return true if the job is DONE or CANCELLED
+        [[nodiscard]] bool isDone() const;
+        [[nodiscard]] float getProgress() const;
+        ///the pointer which is passed to the function, it stays valid as long as the job exists
+        [[nodiscard]] const float* getProgressPtr() const;
+        [[nodiscard]] std::chrono::microseconds getDuration() const;
+
+        /**
+         * a pending job is not started anymore. a running job continues, but isCurrentJobCancelled() returns true inside of it
+         */
+        void cancel();
+        [[nodiscard]] bool isCancelRequested() const;
+
+        /**
+         * blocks until the job is done and rethrows the exception of the function if there was one.
+         * on a worker thread, other jobs are run while waiting so nested jobs can't deadlock the pool
+         */
+        void wait();
+
+        ///called by the worker which took the job from the queue
+        void run();
+
+    private:
+        std::function<void(float*)> function;
+        const Priority priority;
+        std::atomic<State> state = State::PENDING;
+        std::atomic<bool> cancelRequested = false;
+        float progress;
+        std::exception_ptr exception;
+        std::chrono::microseconds duration{0};
+        mutable std::mutex finishedMtx;
+        std::condition_variable finished;
+
+        void setFinishedState(State newState);
+    };
+
+    /**
+     * starts function on the process-wide pool. there is one worker less than cores so that the main thread can keep rendering.
+     * workers take jobs from their own queue first and steal from the others when it's empty
+     */
+    std::shared_ptr<Job> submit(std::function<void(float*)> function, Priority priority, float initialProgress = 0.f);
+    std::shared_ptr<Job> submit(const std::function<void()>& function, Priority priority);
+    /**
+     * starts function on a new detached thread instead of the pool. for jobs which mostly wait for the network,
+     * they would block one of the few workers for a long time
+     */
+    std::shared_ptr<Job> startOnOwnThread(std::function<void(float*)> function, Priority priority, const std::string& threadName, float initialProgress = 0.f);
+
+    /**
+     * calls function(begin, end) for consecutive ranges of at most grainSize elements which cover [0, count) and blocks until all are done.
+     * the calling thread works on the ranges too. the first exception is rethrown after all started ranges are finished
+     * @param priority defaults to the priority of the current job on worker threads and to INTERACTIVE otherwise
+     */
+    void parallelFor(std::size_t count, std::size_t grainSize, const std::function<void(std::size_t, std::size_t)>& function, std::optional<Priority> priority = std::nullopt);
+
+    ///@return true if the calling thread is one of the workers of the pool
+    bool isWorkerThread();
+    ///@return true if cancel() was called on the job which is running on the calling thread
+    bool isCurrentJobCancelled();
+    unsigned int getWorkerCount();
+}
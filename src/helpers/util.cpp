@@ -16,6 +16,7 @@
 #include <sstream>
 #include <stb_image.h>
 #include <stb_image_write.h>
+#include <thread>
 
 #ifdef BRICKSIM_PLATFORM_WINDOWS
     #include <windows.h>
@@ -34,6 +35,8 @@
 namespace bricksim::util {
     namespace {
         bool isStbiVerticalFlipEnabled = false;
+        //static initialization runs on the main thread before any other thread is started
+        const std::thread::id mainThreadId = std::this_thread::get_id();
     }
 
     std::string extendHomeDir(const std::string& input) {
@@ -340,6 +343,10 @@ namespace bricksim::util {
 #endif
     }
 
+    bool isMainThread() {
+        return std::this_thread::get_id() == mainThreadId;
+    }
+
     UtfType determineUtfTypeFromBom(const std::string_view text) {
         if (text.starts_with(constants::UTF8_BOM)) {
             return {8,
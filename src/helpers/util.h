@@ -236,6 +236,8 @@ namespace bricksim::util {
     std::string escapeFilename(const std::string& original);
 
     void setThreadName(const char* threadName);
+    ///@return true if called on the thread which initialized the static variables of the program
+    bool isMainThread();
 
     template<typename T>
     struct ScopeVarBackup {
@@ -0,0 +1,240 @@
+#include "binary_library_cache.h"
+#include "../helpers/binary_io.h"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+#include <utility>
+
+namespace bricksim::ldr {
+    namespace {
+        constexpr MappedBlobStore::magic_t MAGIC = {'B', 'S', 'L', 'C', 'A', 'C', 'H', 'E'};
+        //increment this when the serialization format of FileMetaInfo or any FileElement changes
+        constexpr uint32_t FORMAT_VERSION = 2;
+
+        constexpr uint8_t FLAG_HIDDEN = 1 << 0;
+        constexpr uint8_t FLAG_BFC_INVERTED = 1 << 1;
+
+        void writeMetaInfo(BinaryWriter& writer, const FileMetaInfo& metaInfo) {
+            writer.putString(metaInfo.title);
+            writer.putString(metaInfo.name);
+            writer.putString(metaInfo.author);
+            writer.putString(metaInfo.license);
+            writer.putString(metaInfo.theme);
+            writer.putString(metaInfo.fileTypeLine);
+            writer.put<uint8_t>(metaInfo.headerCategory.has_value());
+            writer.putString(metaInfo.headerCategory.value_or(""));
+            writer.put(static_cast<uint32_t>(metaInfo.keywords.size()));
+            for (const auto& keyword: metaInfo.keywords) {
+                writer.putString(keyword);
+            }
+            writer.put(static_cast<uint32_t>(metaInfo.history.size()));
+            for (const auto& historyEntry: metaInfo.history) {
+                writer.putString(historyEntry);
+            }
+        }
+
+        void readMetaInfo(BinaryReader& reader, FileMetaInfo& metaInfo) {
+            metaInfo.title = reader.getString();
+            metaInfo.name = reader.getString();
+            metaInfo.author = reader.getString();
+            metaInfo.license = reader.getString();
+            metaInfo.theme = reader.getString();
+            metaInfo.fileTypeLine = reader.getString();
+            const bool hasHeaderCategory = reader.get<uint8_t>() != 0;
+            auto headerCategory = reader.getString();
+            if (hasHeaderCategory) {
+                metaInfo.headerCategory = std::move(headerCategory);
+            }
+            const auto keywordCount = reader.get<uint32_t>();
+            for (uint32_t i = 0; i < keywordCount; ++i) {
+                metaInfo.keywords.insert(reader.getString());
+            }
+            const auto historyCount = reader.get<uint32_t>();
+            for (uint32_t i = 0; i < historyCount; ++i) {
+                metaInfo.history.push_back(reader.getString());
+            }
+        }
+
+        template<std::size_t N>
+        void writeFloats(BinaryWriter& writer, const std::array<float, N>& values) {
+            for (const auto& value: values) {
+                writer.put(value);
+            }
+        }
+
+        template<std::size_t N>
+        std::array<float, N> readFloats(BinaryReader& reader) {
+            std::array<float, N> values;
+            for (auto& value: values) {
+                value = reader.get<float>();
+            }
+            return values;
+        }
+
+        std::vector<uint8_t> serialize(const std::shared_ptr<File>& file) {
+            BinaryWriter writer;
+            writeMetaInfo(writer, file->metaInfo);
+            writer.put(static_cast<uint32_t>(file->elements.size()));
+            for (const auto& element: file->elements) {
+                const auto type = element->getType();
+                writer.put(static_cast<uint8_t>(type));
+                writer.put(element->step);
+                uint8_t flags = element->hidden ? FLAG_HIDDEN : 0;
+                switch (type) {
+                    case 0:
+                        writer.put(flags);
+                        writer.putString(std::static_pointer_cast<CommentOrMetaElement>(element)->content);
+                        break;
+                    case 1: {
+                        const auto sfElement = std::static_pointer_cast<SubfileReference>(element);
+                        if (sfElement->bfcInverted) {
+                            flags |= FLAG_BFC_INVERTED;
+                        }
+                        writer.put(flags);
+                        writer.put(sfElement->color.code);
+                        writeFloats(writer, sfElement->numbers);
+                        writer.putString(sfElement->filename);
+                        break;
+                    }
+                    case 2: {
+                        const auto lineElement = std::static_pointer_cast<Line>(element);
+                        writer.put(flags);
+                        writer.put(lineElement->color.code);
+                        writeFloats(writer, lineElement->coords);
+                        break;
+                    }
+                    case 3: {
+                        const auto triangleElement = std::static_pointer_cast<Triangle>(element);
+                        writer.put(flags);
+                        writer.put(triangleElement->color.code);
+                        writeFloats(writer, triangleElement->coords);
+                        break;
+                    }
+                    case 4: {
+                        const auto quadElement = std::static_pointer_cast<Quadrilateral>(element);
+                        writer.put(flags);
+                        writer.put(quadElement->color.code);
+                        writeFloats(writer, quadElement->coords);
+                        break;
+                    }
+                    case 5: {
+                        const auto optionalLineElement = std::static_pointer_cast<OptionalLine>(element);
+                        writer.put(flags);
+                        writer.put(optionalLineElement->color.code);
+                        writeFloats(writer, optionalLineElement->coords);
+                        break;
+                    }
+                    default:
+                        throw std::invalid_argument(fmt::format("unknown element type {}", type));
+                }
+            }
+            return std::move(writer.buffer);
+        }
+
+        std::shared_ptr<File> deserialize(std::span<const uint8_t> data, const FileType type) {
+            BinaryReader reader(data);
+            auto file = std::make_shared<File>();
+            file->metaInfo.type = type;
+            readMetaInfo(reader, file->metaInfo);
+            const auto elementCount = reader.get<uint32_t>();
+            file->prepareElementArena(data.size());
+            const auto& arena = file->getElementArena();
+            file->elements.reserve(elementCount);
+            //ldcadMetas aren't serialized, they're parsed again from the comment elements
+            std::string ldcadMetaLines;
+            for (uint32_t i = 0; i < elementCount; ++i) {
+                const auto elementType = reader.get<uint8_t>();
+                const auto step = reader.get<unsigned int>();
+                const auto flags = reader.get<uint8_t>();
+                std::shared_ptr<FileElement> element;
+                switch (elementType) {
+                    case 0: {
+                        auto content = reader.getString();
+                        if (content.starts_with("!LDCAD")) {
+                            ldcadMetaLines.append(content).push_back('\n');
+                        }
+                        element = allocateElement<CommentOrMetaElement>(arena, content);
+                        break;
+                    }
+                    case 1: {
+                        const auto color = reader.get<Color::code_t>();
+                        const auto numbers = readFloats<12>(reader);
+                        element = allocateElement<SubfileReference>(arena, color, numbers, reader.getString(), (flags & FLAG_BFC_INVERTED) != 0);
+                        break;
+                    }
+                    case 2: {
+                        const auto color = reader.get<Color::code_t>();
+                        element = allocateElement<Line>(arena, color, readFloats<6>(reader));
+                        break;
+                    }
+                    case 3: {
+                        const auto color = reader.get<Color::code_t>();
+                        element = allocateElement<Triangle>(arena, color, readFloats<9>(reader));
+                        break;
+                    }
+                    case 4: {
+                        const auto color = reader.get<Color::code_t>();
+                        element = allocateElement<Quadrilateral>(arena, color, readFloats<12>(reader));
+                        break;
+                    }
+                    case 5: {
+                        const auto color = reader.get<Color::code_t>();
+                        element = allocateElement<OptionalLine>(arena, color, readFloats<12>(reader));
+                        break;
+                    }
+                    default:
+                        throw std::out_of_range(fmt::format("invalid element type {} in binary library cache", elementType));
+                }
+                element->step = step;
+                element->hidden = (flags & FLAG_HIDDEN) != 0;
+                file->elements.push_back(std::move(element));
+            }
+            if (!ldcadMetaLines.empty()) {
+                file->addShadowContent(ldcadMetaLines);
+            }
+            return file;
+        }
+    }
+
+    BinaryLibraryCache::BinaryLibraryCache(std::filesystem::path path, std::string libraryVersion, std::string ldConfigHash) :
+        store(std::move(path), "binary library cache", MAGIC, FORMAT_VERSION, {std::move(libraryVersion), std::move(ldConfigHash)}) {
+    }
+
+    std::shared_ptr<File> BinaryLibraryCache::read(const std::string& name, FileType type, uint64_t fingerprint) const {
+        std::shared_lock<std::shared_mutex> lg(saveMtx);
+        const auto data = store.read(name, fingerprint);
+        if (data.empty()) {
+            return nullptr;
+        }
+        try {
+            return deserialize(data, type);
+        } catch (const std::exception& e) {
+            spdlog::warn("cannot read {} from binary library cache: {}", name, e.what());
+            return nullptr;
+        }
+    }
+
+    void BinaryLibraryCache::put(const std::string& name, uint64_t fingerprint, const std::shared_ptr<File>& file) {
+        if (fingerprint == 0 || !canBeCached(file)) {
+            return;
+        }
+        store.put(name, fingerprint, serialize(file));
+    }
+
+    void BinaryLibraryCache::save() {
+        std::unique_lock<std::shared_mutex> lg(saveMtx);
+        store.save();
+    }
+
+    std::size_t BinaryLibraryCache::getEntryCount() const {
+        return store.getEntryCount();
+    }
+
+    bool BinaryLibraryCache::canBeCached(const std::shared_ptr<File>& file) {
+        if (file->metaInfo.type == FileType::MODEL || file->metaInfo.type == FileType::MPD_SUBFILE) {
+            return false;
+        }
+        return std::none_of(file->elements.cbegin(), file->elements.cend(), [](const auto& element) {
+            return element->directTexmap != nullptr || dynamic_cast<const TexmapStartCommand*>(element.get()) != nullptr;
+        });
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "../helpers/mapped_blob_store.h"
+#include "files.h"
+#include <filesystem>
+#include <shared_mutex>
+
+namespace bricksim::ldr {
+    /**
+     * Parsed library files in a compact binary format so that a part costs a page-in instead of text parsing.
+     * The cache file is only valid for one library version and one LDConfig.ldr hash, every entry
+     * additionally stores a fingerprint of the source file (crc or mtime), so a changed file is never served from the cache.
+     * Newly parsed files are collected in memory and written at the next save().
+     */
+    class BinaryLibraryCache {
+    public:
+        BinaryLibraryCache(std::filesystem::path path, std::string libraryVersion, std::string ldConfigHash);
+        BinaryLibraryCache(const BinaryLibraryCache&) = delete;
+        BinaryLibraryCache& operator=(const BinaryLibraryCache&) = delete;
+
+        /**
+         * thread safe
+         * @param fingerprint of the current source file. 0 means unknown
+         * @return nullptr if name isn't cached or the fingerprint doesn't match
+         */
+        [[nodiscard]] std::shared_ptr<File> read(const std::string& name, FileType type, uint64_t fingerprint) const;
+        ///thread safe
+        void put(const std::string& name, uint64_t fingerprint, const std::shared_ptr<File>& file);
+        /**
+         * writes all valid old entries and all new entries to disk if there are new ones.
+         * thread safe, blocks read() until the file is written
+         */
+        void save();
+
+        [[nodiscard]] std::size_t getEntryCount() const;
+        /**
+         * files with texmaps are not cached because the links between the !TEXMAP commands and the elements can't be restored
+         */
+        static bool canBeCached(const std::shared_ptr<File>& file);
+
+    private:
+        MappedBlobStore store;
+        ///save() replaces the mapping which read() is using
+        mutable std::shared_mutex saveMtx;
+    };
+}
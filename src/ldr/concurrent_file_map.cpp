@@ -0,0 +1,154 @@
+#include "concurrent_file_map.h"
+#include <ankerl/unordered_dense.h>
+#include <mutex>
+#include <palanteer.h>
+
+namespace bricksim::ldr {
+    std::shared_ptr<File> ConcurrentFileMap::find(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name) const {
+        const auto& stripe = getStripe(name);
+        std::shared_lock<std::shared_mutex> lg(stripe.mtx);
+        const auto nsIt = stripe.files.find(fileNamespace);
+        if (nsIt == stripe.files.end()) {
+            return nullptr;
+        }
+        const auto it = nsIt->second.find(name);
+        return it != nsIt->second.end() ? it->second.second : nullptr;
+    }
+
+    bool ConcurrentFileMap::contains(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name) const {
+        return find(fileNamespace, name) != nullptr;
+    }
+
+    std::shared_ptr<File> ConcurrentFileMap::insert(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name, FileType type, const std::shared_ptr<File>& file) {
+        auto& stripe = getStripe(name);
+        plLockWait("ConcurrentFileMap::Stripe::mtx");
+        std::unique_lock<std::shared_mutex> lg(stripe.mtx);
+        plLockScopeState("ConcurrentFileMap::Stripe::mtx", true);
+        return stripe.files[fileNamespace].emplace(name, std::make_pair(type, file)).first->second.second;
+    }
+
+    std::shared_ptr<File> ConcurrentFileMap::getOrLoad(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name, const loader_t& loader) {
+        if (auto file = find(fileNamespace, name); file != nullptr) {
+            return file;
+        }
+
+        auto& stripe = getStripe(name);
+        std::promise<std::shared_ptr<File>> promise;
+        std::shared_future<std::shared_ptr<File>> future;
+        {
+            plLockWait("ConcurrentFileMap::Stripe::mtx");
+            std::unique_lock<std::shared_mutex> lg(stripe.mtx);
+            plLockScopeState("ConcurrentFileMap::Stripe::mtx", true);
+            //another thread could have finished loading it between the shared and the unique lock
+            if (const auto nsIt = stripe.files.find(fileNamespace); nsIt != stripe.files.end()) {
+                if (const auto it = nsIt->second.find(name); it != nsIt->second.end()) {
+                    return it->second.second;
+                }
+            }
+            const auto [inFlightIt, inserted] = stripe.inFlight[fileNamespace].try_emplace(name);
+            if (inserted) {
+                inFlightIt->second = promise.get_future().share();
+            } else {
+                future = inFlightIt->second;
+            }
+        }
+        if (future.valid()) {
+            return future.get();
+        }
+
+        const auto removeInFlight = [&stripe, &fileNamespace, &name]() {
+            std::unique_lock<std::shared_mutex> lg(stripe.mtx);
+            auto nsIt = stripe.inFlight.find(fileNamespace);
+            nsIt->second.erase(name);
+            if (nsIt->second.empty()) {
+                stripe.inFlight.erase(nsIt);
+            }
+        };
+        try {
+            auto file = loader();
+            removeInFlight();
+            promise.set_value(file);
+            return file;
+        } catch (...) {
+            removeInFlight();
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+    }
+
+    void ConcurrentFileMap::erase(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name) {
+        auto& stripe = getStripe(name);
+        plLockWait("ConcurrentFileMap::Stripe::mtx");
+        std::unique_lock<std::shared_mutex> lg(stripe.mtx);
+        plLockScopeState("ConcurrentFileMap::Stripe::mtx", true);
+        if (const auto nsIt = stripe.files.find(fileNamespace); nsIt != stripe.files.end()) {
+            nsIt->second.erase(name);
+        }
+    }
+
+    void ConcurrentFileMap::eraseNamespace(const std::shared_ptr<FileNamespace>& fileNamespace) {
+        for (auto& stripe: stripes) {
+            std::unique_lock<std::shared_mutex> lg(stripe.mtx);
+            stripe.files.erase(fileNamespace);
+        }
+    }
+
+    void ConcurrentFileMap::clear() {
+        for (auto& stripe: stripes) {
+            std::unique_lock<std::shared_mutex> lg(stripe.mtx);
+            stripe.files.clear();
+        }
+    }
+
+    uomap_t<std::string, std::pair<FileType, std::shared_ptr<File>>> ConcurrentFileMap::getNamespaceFiles(const std::shared_ptr<FileNamespace>& fileNamespace) const {
+        uomap_t<std::string, std::pair<FileType, std::shared_ptr<File>>> result;
+        for (const auto& stripe: stripes) {
+            std::shared_lock<std::shared_mutex> lg(stripe.mtx);
+            if (const auto nsIt = stripe.files.find(fileNamespace); nsIt != stripe.files.end()) {
+                result.insert(nsIt->second.begin(), nsIt->second.end());
+            }
+        }
+        return result;
+    }
+
+    ConcurrentFileMap::file_map_t ConcurrentFileMap::getAll() const {
+        file_map_t result;
+        for (const auto& stripe: stripes) {
+            std::shared_lock<std::shared_mutex> lg(stripe.mtx);
+            for (const auto& [fileNamespace, files]: stripe.files) {
+                result[fileNamespace].insert(files.begin(), files.end());
+            }
+        }
+        return result;
+    }
+
+    std::vector<std::shared_ptr<FileNamespace>> ConcurrentFileMap::getNamespaces() const {
+        uoset_t<std::shared_ptr<FileNamespace>> result;
+        for (const auto& stripe: stripes) {
+            std::shared_lock<std::shared_mutex> lg(stripe.mtx);
+            for (const auto& [fileNamespace, files]: stripe.files) {
+                result.insert(fileNamespace);
+            }
+        }
+        return {result.begin(), result.end()};
+    }
+
+    std::size_t ConcurrentFileMap::size() const {
+        std::size_t result = 0;
+        for (const auto& stripe: stripes) {
+            std::shared_lock<std::shared_mutex> lg(stripe.mtx);
+            for (const auto& [fileNamespace, files]: stripe.files) {
+                result += files.size();
+            }
+        }
+        return result;
+    }
+
+    ConcurrentFileMap::Stripe& ConcurrentFileMap::getStripe(const std::string& name) {
+        return stripes[ankerl::unordered_dense::hash<std::string>{}(name) % STRIPE_COUNT];
+    }
+
+    const ConcurrentFileMap::Stripe& ConcurrentFileMap::getStripe(const std::string& name) const {
+        return stripes[ankerl::unordered_dense::hash<std::string>{}(name) % STRIPE_COUNT];
+    }
+}
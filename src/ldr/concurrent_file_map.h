@@ -0,0 +1,74 @@
+#pragma once
+
+#include "../types.h"
+#include "files.h"
+#include <array>
+#include <functional>
+#include <future>
+#include <shared_mutex>
+
+namespace bricksim::ldr {
+    /**
+     * The ldr::Files which are in memory, grouped by namespace.
+     * The keys are split into stripes by the hash of the name, every stripe has its own std::shared_mutex.
+     * Lookups only take a shared lock on one stripe, so readers never block each other and a writer only blocks
+     * the readers of its own stripe.
+     * Files which are currently loaded by some thread are tracked per key, so that other threads which want
+     * the same file wait for that load instead of loading it again.
+     * All names passed to this class must already be normalized (usually lowercase)
+     */
+    class ConcurrentFileMap {
+    public:
+        using file_map_t = uomap_t<std::shared_ptr<FileNamespace>, uomap_t<std::string, std::pair<FileType, std::shared_ptr<File>>>>;
+        using loader_t = std::function<std::shared_ptr<File>()>;
+
+        ConcurrentFileMap() = default;
+        ConcurrentFileMap(const ConcurrentFileMap&) = delete;
+        ConcurrentFileMap& operator=(const ConcurrentFileMap&) = delete;
+
+        /**
+         * @return the file or nullptr if it's not loaded. does not wait for files which are currently loaded by another thread
+         */
+        [[nodiscard]] std::shared_ptr<File> find(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name) const;
+        [[nodiscard]] bool contains(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name) const;
+        /**
+         * @return the file which is in the map after this call. if there already was one with the same name, that one is returned
+         */
+        std::shared_ptr<File> insert(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name, FileType type, const std::shared_ptr<File>& file);
+        /**
+         * returns the file if it's loaded. otherwise, loader is called if no other thread is currently loading the same name.
+         * if another thread is already loading it, this call waits for the result of that thread.
+         * @param loader is called without any lock held and has to insert the file itself (the loaded file can have a different name)
+         * @throws whatever loader throws, also in the waiting threads
+         */
+        std::shared_ptr<File> getOrLoad(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name, const loader_t& loader);
+        void erase(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name);
+        void eraseNamespace(const std::shared_ptr<FileNamespace>& fileNamespace);
+        void clear();
+
+        /**
+         * @return a copy of all files of one namespace
+         */
+        [[nodiscard]] uomap_t<std::string, std::pair<FileType, std::shared_ptr<File>>> getNamespaceFiles(const std::shared_ptr<FileNamespace>& fileNamespace) const;
+        /**
+         * @return a copy of all files, it's not a consistent snapshot if other threads modify the map at the same time
+         */
+        [[nodiscard]] file_map_t getAll() const;
+        [[nodiscard]] std::vector<std::shared_ptr<FileNamespace>> getNamespaces() const;
+        [[nodiscard]] std::size_t size() const;
+
+    private:
+        static constexpr std::size_t STRIPE_COUNT = 64;
+
+        struct alignas(64) Stripe {
+            mutable std::shared_mutex mtx;
+            file_map_t files;
+            uomap_t<std::shared_ptr<FileNamespace>, uomap_t<std::string, std::shared_future<std::shared_ptr<File>>>> inFlight;
+        };
+
+        std::array<Stripe, STRIPE_COUNT> stripes;
+
+        Stripe& getStripe(const std::string& name);
+        const Stripe& getStripe(const std::string& name) const;
+    };
+}
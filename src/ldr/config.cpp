@@ -37,7 +37,7 @@ namespace bricksim::ldr {
 
         for (const auto& element: file->elements) {
             if (element->getType() == 0) {
-                const auto& content = std::dynamic_pointer_cast<CommentOrMetaElement>(element)->content;
+                const auto& content = std::static_pointer_cast<CommentOrMetaElement>(element)->content;
                 const auto contentTrimmed = stringutil::trim(std::string_view(content));
                 if (contentTrimmed.starts_with("!COLOUR")) {
                     colors.push_back(std::make_shared<Color>(stringutil::trim(contentTrimmed.substr(strlen("!COLOUR")))));
@@ -0,0 +1,37 @@
+#include "element_arena.h"
+#include "../metrics.h"
+#include <algorithm>
+
+namespace bricksim::ldr {
+    namespace {
+        //a parsed line (element + shared_ptr control block) is roughly twice as big as its text
+        constexpr std::size_t PARSED_BYTES_PER_TEXT_BYTE = 2;
+        constexpr std::size_t MIN_BLOCK_SIZE = 512;
+    }
+
+    ElementArena::ElementArena(std::size_t expectedBytes) :
+        resource(std::max(expectedBytes, MIN_BLOCK_SIZE)) {}
+
+    ElementArena::~ElementArena() {
+        metrics::ldrElementArenaBytes -= usedBytes;
+    }
+
+    void* ElementArena::allocate(std::size_t bytes, std::size_t alignment) {
+        usedBytes += bytes;
+        ++allocationCount;
+        metrics::ldrElementArenaBytes += bytes;
+        return resource.allocate(bytes, alignment);
+    }
+
+    std::size_t ElementArena::getUsedBytes() const {
+        return usedBytes;
+    }
+
+    std::size_t ElementArena::getAllocationCount() const {
+        return allocationCount;
+    }
+
+    std::size_t ElementArena::estimateBytesForContent(std::size_t contentLength) {
+        return contentLength * PARSED_BYTES_PER_TEXT_BYTE;
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+namespace bricksim::ldr {
+    /**
+     * Backing storage for the FileElements of one ldr::File.
+     * All elements of a file are allocated in the order they are parsed into a few big blocks
+     * instead of one heap allocation per line. Deallocation is a no-op, the memory is released
+     * when the last element (or the file) referencing the arena is gone.
+     *
+     * Not thread safe: only the thread which currently owns the file (the file reader while parsing,
+     * the main thread while editing) may allocate from it.
+     * Every element holds a reference to the arena, so keeping a single element alive (e.g. in an undo
+     * history or a copied selection) keeps the memory of all elements which were ever allocated for the file.
+     */
+    class ElementArena {
+    public:
+        explicit ElementArena(std::size_t expectedBytes);
+        ElementArena(const ElementArena&) = delete;
+        ElementArena& operator=(const ElementArena&) = delete;
+        ~ElementArena();
+
+        void* allocate(std::size_t bytes, std::size_t alignment);
+        [[nodiscard]] std::size_t getUsedBytes() const;
+        [[nodiscard]] std::size_t getAllocationCount() const;
+
+        /**
+         * estimate for the size of the line-based content of a file when it's parsed.
+         * used to size the first block of the arena so that most files only need one block
+         */
+        static std::size_t estimateBytesForContent(std::size_t contentLength);
+
+    private:
+        std::pmr::monotonic_buffer_resource resource;
+        std::size_t usedBytes = 0;
+        std::size_t allocationCount = 0;
+    };
+
+    /**
+     * Allocator for std::allocate_shared which places the control block and the element inside an ElementArena.
+     * Every copy keeps the arena alive, so a shared_ptr to an element stays valid even after the ldr::File is gone
+     */
+    template<typename T>
+    class ElementArenaAllocator {
+    public:
+        using value_type = T;
+
+        explicit ElementArenaAllocator(std::shared_ptr<ElementArena> arena) :
+            arena(std::move(arena)) {}
+
+        template<typename U>
+        ElementArenaAllocator(const ElementArenaAllocator<U>& other) :
+            arena(other.arena) {}
+
+        T* allocate(std::size_t n) {
+            return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T* /*p*/, std::size_t /*n*/) {}
+
+        template<typename U>
+        bool operator==(const ElementArenaAllocator<U>& other) const {
+            return arena == other.arena;
+        }
+
+        template<typename U>
+        bool operator!=(const ElementArenaAllocator<U>& other) const {
+            return arena != other.arena;
+        }
+
+    private:
+        std::shared_ptr<ElementArena> arena;
+
+        template<typename U>
+        friend class ElementArenaAllocator;
+    };
+
+    /**
+     * @param arena if null, the element is allocated with std::make_shared
+     */
+    template<typename T, typename... Args>
+    std::shared_ptr<T> allocateElement(const std::shared_ptr<ElementArena>& arena, Args&&... args) {
+        if (arena != nullptr) {
+            return std::allocate_shared<T>(ElementArenaAllocator<T>(arena), std::forward<Args>(args)...);
+        }
+        return std::make_shared<T>(std::forward<Args>(args)...);
+    }
+}
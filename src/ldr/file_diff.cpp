@@ -0,0 +1,181 @@
+#include "file_diff.h"
+#include "../helpers/thread_pool.h"
+#include <algorithm>
+#include <optional>
+#include <palanteer.h>
+
+namespace bricksim::ldr {
+    namespace {
+        ///if the files differ in more lines than this, the remaining middle part is replaced completely
+        constexpr int MAX_DIFF_EDITS = 2000;
+        constexpr std::size_t KEY_GRAIN_SIZE = 512;
+
+        ///everything that makes an element different when its line is the same. the step is not included, it's just copied to the old element
+        std::string getElementKey(const FileElement& element) {
+            auto key = element.getLdrLine();
+            if (element.hidden) {
+                key += "\nhidden";
+            }
+            if (element.getType() == 1 && static_cast<const SubfileReference&>(element).bfcInverted) {
+                key += "\ninverted";
+            }
+            if (element.directTexmap != nullptr) {
+                key += '\n';
+                key += element.directTexmap->getLdrLine();
+            }
+            return key;
+        }
+
+        std::vector<std::string> getElementKeys(const std::vector<std::shared_ptr<FileElement>>& elements, std::size_t begin, std::size_t end) {
+            std::vector<std::string> keys(end - begin);
+            thread_pool::parallelFor(keys.size(), KEY_GRAIN_SIZE, [&](std::size_t chunkBegin, std::size_t chunkEnd) {
+                for (auto i = chunkBegin; i < chunkEnd; ++i) {
+                    keys[i] = getElementKey(*elements[begin + i]);
+                }
+            });
+            return keys;
+        }
+
+        /**
+         * Myers' O(ND) difference algorithm
+         * @return the indices of the lines which are in both sequences, ascending. std::nullopt if there are more than MAX_DIFF_EDITS differences
+         */
+        std::optional<std::vector<std::pair<int, int>>> findCommonLines(const std::vector<std::string>& a, const std::vector<std::string>& b) {
+            const auto n = static_cast<int>(a.size());
+            const auto m = static_cast<int>(b.size());
+            const auto maxD = std::min(n + m, MAX_DIFF_EDITS);
+            const auto offset = maxD + 1;
+            std::vector<int> v(2 * maxD + 3, 0);
+            //trace[d][k + d] is the furthest x on diagonal k after d edits
+            std::vector<std::vector<int>> trace;
+            for (int d = 0; d <= maxD; ++d) {
+                bool endReached = false;
+                for (int k = -d; k <= d; k += 2) {
+                    int x = k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1])
+                                    ? v[offset + k + 1]
+                                    : v[offset + k - 1] + 1;
+                    int y = x - k;
+                    while (x < n && y < m && a[x] == b[y]) {
+                        ++x;
+                        ++y;
+                    }
+                    v[offset + k] = x;
+                    endReached |= x >= n && y >= m;
+                }
+                trace.emplace_back(v.begin() + offset - d, v.begin() + offset + d + 1);
+                if (endReached) {
+                    break;
+                }
+                if (d == maxD) {
+                    return std::nullopt;
+                }
+            }
+
+            std::vector<std::pair<int, int>> common;
+            int x = n;
+            int y = m;
+            for (int d = static_cast<int>(trace.size()) - 1; d > 0; --d) {
+                const auto& previous = trace[d - 1];
+                const auto getPrevious = [&previous, d](int k) { return previous[k + d - 1]; };
+                const int k = x - y;
+                const bool down = k == -d || (k != d && getPrevious(k - 1) < getPrevious(k + 1));
+                const int previousK = down ? k + 1 : k - 1;
+                const int previousX = getPrevious(previousK);
+                const int snakeStartX = down ? previousX : previousX + 1;
+                while (x > snakeStartX) {
+                    --x;
+                    --y;
+                    common.emplace_back(x, y);
+                }
+                x = previousX;
+                y = previousX - previousK;
+            }
+            while (x > 0 && y > 0) {
+                --x;
+                --y;
+                common.emplace_back(x, y);
+            }
+            std::reverse(common.begin(), common.end());
+            return common;
+        }
+
+        bool isMetaInfoEqual(const FileMetaInfo& a, const FileMetaInfo& b) {
+            return a.title == b.title
+                   && a.name == b.name
+                   && a.author == b.author
+                   && a.keywords == b.keywords
+                   && a.history == b.history
+                   && a.license == b.license
+                   && a.theme == b.theme
+                   && a.fileTypeLine == b.fileTypeLine
+                   && a.headerCategory == b.headerCategory
+                   && a.type == b.type;
+        }
+    }
+
+    bool FileDiff::empty() const {
+        return removedElements.empty() && addedElements.empty() && !metaInfoChanged;
+    }
+
+    FileDiff patchFile(const std::shared_ptr<File>& oldFile, const File& newFile) {
+        plFunction();
+        FileDiff diff{oldFile};
+        const auto& oldElements = oldFile->elements;
+        const auto& newElements = newFile.elements;
+
+        //most changes only touch a few lines, so the common prefix and suffix are skipped before the expensive part
+        std::size_t prefix = 0;
+        const auto minSize = std::min(oldElements.size(), newElements.size());
+        while (prefix < minSize && getElementKey(*oldElements[prefix]) == getElementKey(*newElements[prefix])) {
+            ++prefix;
+        }
+        std::size_t suffix = 0;
+        while (suffix < minSize - prefix && getElementKey(*oldElements[oldElements.size() - 1 - suffix]) == getElementKey(*newElements[newElements.size() - 1 - suffix])) {
+            ++suffix;
+        }
+
+        const auto oldMiddle = getElementKeys(oldElements, prefix, oldElements.size() - suffix);
+        const auto newMiddle = getElementKeys(newElements, prefix, newElements.size() - suffix);
+        const auto common = findCommonLines(oldMiddle, newMiddle).value_or(std::vector<std::pair<int, int>>());
+
+        std::vector<std::shared_ptr<FileElement>> patchedElements;
+        patchedElements.reserve(newElements.size());
+        const auto keepOldElement = [&patchedElements, &oldElements, &newElements](std::size_t oldIndex, std::size_t newIndex) {
+            oldElements[oldIndex]->step = newElements[newIndex]->step;
+            patchedElements.push_back(oldElements[oldIndex]);
+        };
+        for (std::size_t i = 0; i < prefix; ++i) {
+            keepOldElement(i, i);
+        }
+        std::size_t oldIndex = 0;
+        std::size_t newIndex = 0;
+        for (const auto [commonOld, commonNew]: common) {
+            for (; oldIndex < static_cast<std::size_t>(commonOld); ++oldIndex) {
+                diff.removedElements.push_back(oldElements[prefix + oldIndex]);
+            }
+            for (; newIndex < static_cast<std::size_t>(commonNew); ++newIndex) {
+                diff.addedElements.push_back(newElements[prefix + newIndex]);
+                patchedElements.push_back(newElements[prefix + newIndex]);
+            }
+            keepOldElement(prefix + oldIndex, prefix + newIndex);
+            ++oldIndex;
+            ++newIndex;
+        }
+        for (; oldIndex < oldMiddle.size(); ++oldIndex) {
+            diff.removedElements.push_back(oldElements[prefix + oldIndex]);
+        }
+        for (; newIndex < newMiddle.size(); ++newIndex) {
+            diff.addedElements.push_back(newElements[prefix + newIndex]);
+            patchedElements.push_back(newElements[prefix + newIndex]);
+        }
+        for (std::size_t i = suffix; i > 0; --i) {
+            keepOldElement(oldElements.size() - i, newElements.size() - i);
+        }
+
+        diff.metaInfoChanged = !isMetaInfoEqual(oldFile->metaInfo, newFile.metaInfo);
+        oldFile->elements = std::move(patchedElements);
+        oldFile->metaInfo = newFile.metaInfo;
+        oldFile->ldcadMetas = newFile.ldcadMetas;
+        return diff;
+    }
+}
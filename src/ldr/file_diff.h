@@ -0,0 +1,24 @@
+#pragma once
+
+#include "files.h"
+
+namespace bricksim::ldr {
+    struct FileDiff {
+        ///the file which was patched, it's still the same object as before
+        std::shared_ptr<File> file;
+        ///elements which were in the file before, in their old order
+        std::vector<std::shared_ptr<FileElement>> removedElements;
+        ///elements which are new in the file, in their new order
+        std::vector<std::shared_ptr<FileElement>> addedElements;
+        bool metaInfoChanged = false;
+
+        [[nodiscard]] bool empty() const;
+    };
+
+    /**
+     * changes oldFile so that it has the content of newFile.
+     * the lines of both files are compared with a Myers diff, the elements of lines which are in both files are kept.
+     * so everything which points to an unchanged element (for example the child nodes in the element tree) stays valid
+     */
+    FileDiff patchFile(const std::shared_ptr<File>& oldFile, const File& newFile);
+}
@@ -0,0 +1,76 @@
+#include "file_header_scanner.h"
+
+namespace bricksim::ldr {
+    FileHeaderScanner::FileHeaderScanner(FileType type) {
+        metaInfo.type = type;
+    }
+
+    bool FileHeaderScanner::addData(std::string_view data) {
+        while (!complete && !data.empty()) {
+            const auto lineEnd = data.find_first_of("\r\n");
+            if (lineEnd == std::string_view::npos) {
+                incompleteLine.append(data);
+                break;
+            }
+            if (incompleteLine.empty()) {
+                addLine(data.substr(0, lineEnd));
+            } else {
+                incompleteLine.append(data.substr(0, lineEnd));
+                addLine(incompleteLine);
+                incompleteLine.clear();
+            }
+            data.remove_prefix(lineEnd + 1);
+        }
+        return !complete;
+    }
+
+    void FileHeaderScanner::finish() {
+        if (!complete && !incompleteLine.empty()) {
+            addLine(incompleteLine);
+            incompleteLine.clear();
+        }
+        complete = true;
+    }
+
+    bool FileHeaderScanner::isComplete() const {
+        return complete;
+    }
+
+    FileMetaInfo& FileHeaderScanner::getMetaInfo() {
+        return metaInfo;
+    }
+
+    void FileHeaderScanner::addLine(std::string_view line) {
+        //same as File::addTextLine and FileElement::parseLine, but only for the lines which can change metaInfo
+        const auto trimmed = stringutil::trim(line);
+        if (trimmed.empty()) {
+            return;
+        }
+        if (trimmed[0] >= '1' && trimmed[0] <= '5') {
+            complete = true;
+            return;
+        }
+        if (trimmed[0] != '0') {
+            return;
+        }
+        const auto content = trimmed.length() > 2 ? trimmed.substr(2) : std::string_view();
+        if (metaInfo.type == FileType::MODEL && (content.starts_with("FILE") || content.starts_with("NOFILE") || content.starts_with("!DATA"))) {
+            //like readComplexFile: the first FILE line is the name of the main file, everything after the next one belongs to other files
+            if (mpdFileLineSeen || !content.starts_with("FILE")) {
+                complete = true;
+            }
+            mpdFileLineSeen = true;
+            return;
+        }
+        if (!TexmapStartCommand::doesLineMatch(content)) {
+            metaInfo.addLine(std::string(content));
+        }
+    }
+
+    FileMetaInfo scanFileHeader(std::string_view content, FileType type) {
+        FileHeaderScanner scanner(type);
+        scanner.addData(content);
+        scanner.finish();
+        return std::move(scanner.getMetaInfo());
+    }
+}
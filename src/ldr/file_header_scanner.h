@@ -0,0 +1,37 @@
+#pragma once
+
+#include "files.h"
+#include <string>
+#include <string_view>
+
+namespace bricksim::ldr {
+    /**
+     * reads only the header of an LDraw file: the meta lines before the first geometry line (line type 1-5).
+     * fills the same FileMetaInfo as the full parser, but doesn't create any FileElement.
+     * the content can be passed in pieces of any size, so that a file can be streamed out of a zip archive and the rest of it is never read
+     */
+    class FileHeaderScanner {
+    public:
+        explicit FileHeaderScanner(FileType type);
+
+        /**
+         * @param data the next bytes of the file
+         * @return true if more data is needed, false if the header is complete
+         */
+        bool addData(std::string_view data);
+        ///has to be called at the end of the file, the last line may not have a line break
+        void finish();
+        [[nodiscard]] bool isComplete() const;
+        FileMetaInfo& getMetaInfo();
+
+    private:
+        FileMetaInfo metaInfo;
+        std::string incompleteLine;
+        bool complete = false;
+        bool mpdFileLineSeen = false;
+
+        void addLine(std::string_view line);
+    };
+
+    FileMetaInfo scanFileHeader(std::string_view content, FileType type);
+}
@@ -1,4 +1,5 @@
 #include "file_reader.h"
+#include "line_tokenizer.h"
 #include <magic_enum/magic_enum.hpp>
 #include <palanteer.h>
 #include <spdlog/spdlog.h>
@@ -26,21 +27,10 @@ namespace bricksim::ldr {
             mainFile->addShadowContent(*shadowContent);
         }
 
-        size_t lineStart = 0;
         bool firstFile = true;
-        bool hasMoreLines = true;
-        while (hasMoreLines) {
-            size_t lineEnd = content.find_first_of("\r\n", lineStart);
-            if (lineEnd == std::string::npos) {
-                hasMoreLines = false;
-                lineEnd = content.size();
-            } else {
-                ++lineEnd;
-            }
-            std::string line = content.substr(lineStart, lineEnd - lineStart);
-
+        tokenizer::forEachLine(content, [&](const std::string_view line) {
             if (line.starts_with("0 FILE")) {
-                const auto currentName = stringutil::trim(line.substr(7));
+                const std::string currentName(stringutil::trim(line.substr(std::min<std::size_t>(7, line.size()))));
                 if (firstFile) {
                     firstFile = false;
                     if (currentFile.has_value()) {
@@ -63,8 +53,7 @@ namespace bricksim::ldr {
             } else if (currentFile.has_value()) {
                 currentFile.value()->addTextLine(line);
             }
-            lineStart = lineEnd;
-        }
+        });
         return files;
     }
 
@@ -79,20 +68,10 @@ namespace bricksim::ldr {
         file->metaInfo.type = type;
         file->metaInfo.name = name;
         file->nameSpace = fileNamespace;
-        size_t lineStart = 0;
-        size_t lineEnd = 0;
-        const std::string_view contentSV = content;
-        while (lineEnd < contentSV.size()) {
-            lineEnd = contentSV.find_first_of("\r\n", lineStart);
-            if (lineEnd == std::string::npos) {
-                lineEnd = contentSV.size();
-            } else {
-                ++lineEnd;
-            }
-
-            file->addTextLine(contentSV.substr(lineStart, lineEnd - lineStart));
-            lineStart = lineEnd;
-        }
+        file->prepareElementArena(content.size());
+        tokenizer::forEachLine(content, [&file](std::string_view line) {
+            file->addTextLine(line);
+        });
 
         if (shadowContent.has_value()) {
             file->addShadowContent(*shadowContent);
@@ -1,18 +1,22 @@
 #include "file_repo.h"
 #include "../config/read.h"
+#include "../connection/connector_data_provider.h"
 #include "../config/write.h"
 #include "../constant_data/constants.h"
 #include "../db.h"
 #include "../errors/exceptions.h"
 #include "../helpers/stringutil.h"
+#include "../helpers/thread_pool.h"
 #include "../helpers/util.h"
+#include "../part_finder.h"
+#include "file_header_scanner.h"
 #include "file_reader.h"
 #include "regular_file_repo.h"
 #include "shadow_file_repo.h"
 #include "zip_file_repo.h"
 #include <palanteer.h>
 #include <spdlog/spdlog.h>
-#include <thread>
+#include <spdlog/stopwatch.h>
 #include <utility>
 #include <zip.h>
 #include <zlib.h>
@@ -28,6 +32,12 @@ namespace bricksim::ldr::file_repo {
 
     const char* const PART_SEARCH_PREFIXES[] = {"parts/", "p/", "models/", ""};
 
+    namespace {
+        constexpr auto BINARY_LIBRARY_CACHE_FILE_NAME = "library_cache.bin";
+        ///files per database transaction when the file list is filled
+        constexpr std::size_t FILE_LIST_CHUNK_SIZE = 256;
+    }
+
     namespace {
         std::unique_ptr<FileRepo> currentRepo = nullptr;
 
@@ -171,62 +181,137 @@ namespace bricksim::ldr::file_repo {
 
     std::shared_ptr<File> FileRepo::getFile(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name, std::optional<std::filesystem::path> contextRelativePath) {
         plFunction();
-        {
-            plLockWait("FileRepo::ldrFilesMtx");
-            std::scoped_lock<std::mutex> lg(ldrFilesMtx);
-            plLockScopeState("FileRepo::ldrFilesMtx", true);
-            auto nsFiles = ldrFiles[fileNamespace];
-            auto it = nsFiles.find(stringutil::asLower(name));
-            if (it != nsFiles.end()) {
-                return it->second.second;
-            }
+        const auto lowerName = stringutil::asLower(name);
+        if (auto file = ldrFiles.find(fileNamespace, lowerName); file != nullptr) {
+            return file;
         }
         if (fileNamespace == nullptr) {
-            if (db::fileList::getSize() == 0) {
-                spdlog::warn("FileRepo not initialized, but getFile() called. calling initialize now. this shouldn't happen.");
-                float progress;
-                initialize(&progress);
+            return getLibraryFile(name);
+        }
+        return ldrFiles.getOrLoad(fileNamespace, lowerName, [this, &fileNamespace, &name, &contextRelativePath]() {
+            const auto extendedPath = util::replaceSpecialPaths(name);
+            if (extendedPath.is_absolute() && std::filesystem::exists(extendedPath)) {
+                return addLdrFileWithContent(nullptr, name, extendedPath, FileType::MODEL, getContentOfLdrFile(extendedPath));
             }
-            auto filenameWithForwardSlash = stringutil::replaceChar(name, '\\', '/');
-            for (const auto& prefix: PART_SEARCH_PREFIXES) {
-                auto entryOpt = db::fileList::findFile(prefix + filenameWithForwardSlash);
-                if (entryOpt.has_value()) {
-                    FileType type;
-                    if (entryOpt->category == PSEUDO_CATEGORY_SUBPART) {
-                        type = FileType::SUBPART;
-                    } else if (entryOpt->category == PSEUDO_CATEGORY_PRIMITIVE) {
-                        type = FileType::PRIMITIVE;
-                    } else if (entryOpt->category == PSEUDO_CATEGORY_MODEL) {
-                        type = FileType::MODEL;
-                    } else if (entryOpt->category == PSEUDO_CATEGORY_OTHER) {
-                        type = FileType::OTHER;
-                    } else {
-                        type = FileType::PART;
+
+            const auto finalPath = contextRelativePath.has_value()
+                                           ? fileNamespace->searchPath / *contextRelativePath / name
+                                           : fileNamespace->searchPath / name;
+            if (std::filesystem::exists(finalPath)) {
+                return addLdrFileWithContent(fileNamespace, name, finalPath, FileType::MODEL, getContentOfLdrFile(finalPath));
+            }
+
+            try {
+                return getFile(std::shared_ptr<FileNamespace>(), name);
+            } catch (const std::invalid_argument& e) {
+                throw errors::TaskFailedException(fmt::format(R"(no file named "{}", neither in the namespace "{}" ({}) nor the library namespace)", name, fileNamespace->name, fileNamespace->searchPath.string()));
+            }
+        });
+    }
+
+    std::shared_ptr<File> FileRepo::getLibraryFile(const std::string& name) {
+        const auto key = stringutil::asLower(stringutil::replaceChar(name, '\\', '/'));
+        return ldrFiles.getOrLoad(nullptr, key, [this, &name]() {
+            return readLibraryFile(name);
+        });
+    }
+
+    std::shared_ptr<File> FileRepo::readLibraryFile(const std::string& name) {
+        if (db::fileList::getSize() == 0) {
+            spdlog::warn("FileRepo not initialized, but getFile() called. calling initialize now. this shouldn't happen.");
+            float progress;
+            initialize(&progress);
+        }
+        auto filenameWithForwardSlash = stringutil::replaceChar(name, '\\', '/');
+        for (const auto& prefix: PART_SEARCH_PREFIXES) {
+            auto entryOpt = db::fileList::findFile(prefix + filenameWithForwardSlash);
+            if (entryOpt.has_value()) {
+                FileType type;
+                if (entryOpt->category == PSEUDO_CATEGORY_SUBPART) {
+                    type = FileType::SUBPART;
+                } else if (entryOpt->category == PSEUDO_CATEGORY_PRIMITIVE) {
+                    type = FileType::PRIMITIVE;
+                } else if (entryOpt->category == PSEUDO_CATEGORY_MODEL) {
+                    type = FileType::MODEL;
+                } else if (entryOpt->category == PSEUDO_CATEGORY_OTHER) {
+                    type = FileType::OTHER;
+                } else {
+                    type = FileType::PART;
+                }
+                const auto pathRelativeToBase = getPathRelativeToBase(type, entryOpt->name);
+                const auto shadowContent = getShadowFileRepo().getContent(pathRelativeToBase);
+                if (type != FileType::MODEL) {
+                    std::shared_lock<std::shared_mutex> lg(binaryCacheMtx);
+                    if (binaryCache != nullptr) {
+                        const auto fingerprint = getLibraryFileFingerprint(pathRelativeToBase);
+                        if (auto cachedFile = binaryCache->read(pathRelativeToBase, type, fingerprint); cachedFile != nullptr) {
+                            if (shadowContent.has_value()) {
+                                cachedFile->addShadowContent(*shadowContent);
+                            }
+                            return ldrFiles.insert(nullptr, stringutil::asLower(entryOpt->name), type, cachedFile);
+                        }
+
+                        auto file = readSimpleFile(nullptr, entryOpt->name, "", type, getLibraryLdrFileContent(pathRelativeToBase), std::nullopt);
+                        binaryCache->put(pathRelativeToBase, fingerprint, file);
+                        if (shadowContent.has_value()) {
+                            file->addShadowContent(*shadowContent);
+                        }
+                        return ldrFiles.insert(nullptr, stringutil::asLower(entryOpt->name), type, file);
                     }
-                    const auto shadowContent = getShadowFileRepo().getContent(getPathRelativeToBase(type, entryOpt->name));
-                    const auto realFileContent = getLibraryLdrFileContent(type, entryOpt->name);
-                    return addLdrFileWithContent(nullptr, entryOpt->name, "", type, realFileContent, shadowContent);
                 }
+                return addLdrFileWithContent(nullptr, entryOpt->name, "", type, getLibraryLdrFileContent(pathRelativeToBase), shadowContent);
             }
-            throw errors::TaskFailedException(fmt::format("no file named \"{}\" in the library namespace", name));
-        }
-        const auto extendedPath = util::replaceSpecialPaths(name);
-        if (extendedPath.is_absolute() && std::filesystem::exists(extendedPath)) {
-            return addLdrFileWithContent(nullptr, name, extendedPath, FileType::MODEL, getContentOfLdrFile(extendedPath));
         }
+        throw errors::TaskFailedException(fmt::format("no file named \"{}\" in the library namespace", name));
+    }
 
-        const auto finalPath = contextRelativePath.has_value()
-                                       ? fileNamespace->searchPath / *contextRelativePath / name
-                                       : fileNamespace->searchPath / name;
-        if (std::filesystem::exists(finalPath)) {
-            return addLdrFileWithContent(fileNamespace, name, finalPath, FileType::MODEL, getContentOfLdrFile(finalPath));
-        }
+    void FileRepo::preloadReferencedFiles(const std::shared_ptr<File>& file) {
+        plFunction();
+        spdlog::stopwatch sw;
+        uoset_t<std::shared_ptr<File>> visitedFiles = {file};
+        uoset_t<std::string> visitedReferences;
+        std::vector<std::shared_ptr<File>> frontier = {file};
+        std::size_t level = 0;
+        while (!frontier.empty()) {
+            std::vector<std::pair<std::shared_ptr<File>, std::string>> references;
+            for (const auto& parent: frontier) {
+                for (const auto& element: parent->elements) {
+                    if (element->getType() != 1) {
+                        continue;
+                    }
+                    const auto& filename = std::static_pointer_cast<SubfileReference>(element)->filename;
+                    //the same name can mean different files in different namespaces and directories
+                    auto referenceKey = parent->nameSpace == nullptr
+                                                ? stringutil::asLower(stringutil::replaceChar(filename, '\\', '/'))
+                                                : fmt::format("{}|{}|{}", parent->nameSpace->name, parent->source.path.parent_path().string(), filename);
+                    if (visitedReferences.insert(std::move(referenceKey)).second) {
+                        references.emplace_back(parent, filename);
+                    }
+                }
+            }
 
-        try {
-            return getFile(std::shared_ptr<FileNamespace>(), name);
-        } catch (const std::invalid_argument& e) {
-            throw errors::TaskFailedException(fmt::format(R"(no file named "{}", neither in the namespace "{}" ({}) nor the library namespace)", name, fileNamespace->name, fileNamespace->searchPath.string()));
+            std::vector<std::shared_ptr<File>> resolved(references.size());
+            thread_pool::parallelFor(references.size(), 1, [this, &references, &resolved](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    try {
+                        resolved[i] = getFile(references[i].first, references[i].second);
+                    } catch (const std::exception& e) {
+                        //the element tree will report this again when it actually needs the file
+                        spdlog::debug("cannot preload {}: {}", references[i].second, e.what());
+                    }
+                }
+            });
+
+            frontier.clear();
+            for (const auto& subFile: resolved) {
+                if (subFile != nullptr && visitedFiles.insert(subFile).second) {
+                    frontier.push_back(subFile);
+                }
+            }
+            spdlog::debug("preloaded level {} of {}: {} references, {} new files", level, file->metaInfo.name, references.size(), frontier.size());
+            ++level;
         }
+        spdlog::info("preloaded {} files referenced by {} in {} levels ({:.1f} ms)", visitedFiles.size() - 1, file->metaInfo.name, level, sw.elapsed().count() * 1000);
     }
 
     std::shared_ptr<File> FileRepo::getFileOrNull(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name) {
@@ -309,13 +394,8 @@ namespace bricksim::ldr::file_repo {
                                                           const std::string& content,
                                                           const std::optional<std::string>& shadowContent) {
         auto readResults = readComplexFile(fileNamespace, name, source, type, content, shadowContent);
-        {
-            plLockWait("FileRepo::ldrFilesMtx");
-            std::scoped_lock<std::mutex> lg(ldrFilesMtx);
-            plLockScopeState("FileRepo::ldrFilesMtx", true);
-            for (const auto& newFile: readResults) {
-                ldrFiles[fileNamespace].emplace(stringutil::asLower(newFile.first), std::make_pair(newFile.second->metaInfo.type, newFile.second));
-            }
+        for (const auto& newFile: readResults) {
+            ldrFiles.insert(fileNamespace, stringutil::asLower(newFile.first), newFile.second->metaInfo.type, newFile.second);
         }
 
         return readResults[name];
@@ -387,14 +467,26 @@ namespace bricksim::ldr::file_repo {
         bool needFill = false;
         if (currentHash != lastIndexHash) {
             needFill = true;
-            spdlog::info("FileRepo: Hash of {} changed ({}!={}), going to refill file list", constants::LDRAW_CONFIG_FILE_NAME, lastIndexHash.value_or("?"), currentHash);
+            spdlog::info("FileRepo: Hash of {} changed ({}!={}), going to update file list", constants::LDRAW_CONFIG_FILE_NAME, lastIndexHash.value_or("?"), currentHash);
         } else if (db::fileList::getSize() == 0) {
             needFill = true;
             spdlog::info("FileRepo: file list in db is empty, going to fill it");
         }
         if (needFill) {
-            fillFileList([progress](float p) { *progress = p; }, currentHash);
+            updateFileList([progress](float p) { *progress = p; }, currentHash);
         }
+        part_finder::rebuildSearchIndex();
+        openBinaryCache(currentHash, true);
+    }
+
+    void FileRepo::openBinaryCache(const std::string& ldConfigHash, bool saveOldCache) {
+        std::unique_lock<std::shared_mutex> lg(binaryCacheMtx);
+        if (binaryCache != nullptr && saveOldCache) {
+            binaryCache->save();
+        }
+        //the old cache has to close the file before the new one opens it
+        binaryCache = nullptr;
+        binaryCache = std::make_unique<BinaryLibraryCache>(BINARY_LIBRARY_CACHE_FILE_NAME, getVersion(), ldConfigHash);
     }
     std::string FileRepo::getLDConfigContentHash() {
         auto currentLDConfigContent = getLibraryLdrFileContent(constants::LDRAW_CONFIG_FILE_NAME);
@@ -411,83 +503,230 @@ namespace bricksim::ldr::file_repo {
 
         auto fileNames = listAllFileNames(progress);
         const auto numFiles = fileNames.size();
-        const auto numCores = std::thread::hardware_concurrency();
-        const auto filesPerThread = numFiles / numCores;
-        std::vector<std::thread> threads;
-        std::vector<std::string> latestUpdates;
-        latestUpdates.resize(numCores);
-        for (size_t threadNum = 0; threadNum < numCores; ++threadNum) {
-            const size_t iStart = threadNum * filesPerThread;                                    //inclusive
-            const size_t iEnd = (threadNum == numCores - 1) ? numFiles : iStart + filesPerThread;//exclusive
-            threads.emplace_back([this,
-                                  iStart,
-                                  iEnd,
-                                  threadNum,
-                                  &fileNames,
-                                  progress,
-                                  &latestUpdates]() {
-                std::string threadName = fmt::format("FileList filler #{}", threadNum);
-                util::setThreadName(threadName.c_str());
-                std::vector<db::fileList::Entry> entries;
-                std::string latestUpdate;
-                for (auto fileName = fileNames.cbegin() + iStart; fileName < fileNames.cbegin() + iEnd; ++fileName) {
-                    auto [type, name] = getTypeAndNameFromPathRelativeToBase(*fileName);
-                    if (isBinaryFilename(name)) {
-                        entries.push_back({*fileName, name, PSEUDO_CATEGORY_BINARY_FILE});
-                    } else {
-                        auto ldrFile = addLdrFileWithContent(nullptr, name, "", type, getLibraryLdrFileContent(*fileName));
-
-                        std::string category;
-                        if (type == FileType::PART) {
-                            const char& firstChar = ldrFile->metaInfo.title[0];
-                            if ((firstChar == '~' && ldrFile->metaInfo.title[1] != '|') || firstChar == '=' || firstChar == '_') {
-                                category = PSEUDO_CATEGORY_HIDDEN_PART;
-                            } else {
-                                category = ldrFile->metaInfo.getCategory();
-                            }
-                        } else if (type == FileType::SUBPART) {
-                            category = PSEUDO_CATEGORY_SUBPART;
-                        } else if (type == FileType::PRIMITIVE) {
-                            category = PSEUDO_CATEGORY_PRIMITIVE;
-                        } else if (type == FileType::MODEL) {
-                            category = PSEUDO_CATEGORY_MODEL;
-                        } else if (type == FileType::OTHER) {
-                            category = PSEUDO_CATEGORY_OTHER;
+        const auto latestUpdate = indexLibraryFiles(fileNames, [&progress](float fraction) {
+            progress(.4f * fraction + .5f);
+        });
+        progress(1.f);
+
+        db::valueCache::set<std::string>(db::valueCache::LAST_INDEX_LDCONFIG_HASH, currentLDConfigHash);
+        db::valueCache::set<std::string>(db::valueCache::CURRENT_PARTS_LIBRARY_VERSION, latestUpdate);
+
+        auto after = std::chrono::high_resolution_clock::now();
+        auto durationMs = static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(after - before).count()) / 1000.0;
+
+        if (numFiles != static_cast<size_t>(db::fileList::getSize())) {
+            spdlog::error("had {} fileNames, but only {} are in db", numFiles, db::fileList::getSize());
+        }
+        spdlog::info("filled fileList in {} ms using {} threads. Size: {}", durationMs, thread_pool::getWorkerCount() + 1, numFiles);
+    }
+
+    std::optional<std::vector<std::string>> FileRepo::updateFileList(std::function<void(float)> progress, const std::string& currentLDConfigHash) {
+        auto oldFingerprints = db::fileList::getAllFingerprints();
+        if (oldFingerprints.empty() || db::fileList::getSize() == 0) {
+            fillFileList(progress, currentLDConfigHash);
+            return std::nullopt;
+        }
+        auto before = std::chrono::high_resolution_clock::now();
+
+        const auto fileNames = listAllFileNames(progress);
+        std::vector<uint64_t> fingerprints(fileNames.size());
+        thread_pool::parallelFor(fileNames.size(), FILE_LIST_CHUNK_SIZE, [this, &fileNames, &fingerprints](std::size_t iStart, std::size_t iEnd) {
+            for (auto i = iStart; i < iEnd; ++i) {
+                fingerprints[i] = getLibraryFileFingerprint(fileNames[i]);
+            }
+        });
+
+        std::vector<std::string> addedOrChanged;
+        std::vector<std::string> changedOrRemoved;
+        for (std::size_t i = 0; i < fileNames.size(); ++i) {
+            const auto it = oldFingerprints.find(fileNames[i]);
+            if (it == oldFingerprints.end()) {
+                addedOrChanged.push_back(fileNames[i]);
+            } else {
+                if (it->second != fingerprints[i]) {
+                    addedOrChanged.push_back(fileNames[i]);
+                    changedOrRemoved.push_back(fileNames[i]);
+                }
+                oldFingerprints.erase(it);
+            }
+        }
+        //the remaining ones don't exist anymore
+        std::vector<std::string> result = addedOrChanged;
+        for (const auto& [path, fingerprint]: oldFingerprints) {
+            changedOrRemoved.push_back(path);
+            result.push_back(path);
+        }
+
+        std::vector<std::string> namesToDelete;
+        namesToDelete.reserve(changedOrRemoved.size());
+        for (const auto& path: changedOrRemoved) {
+            auto name = getTypeAndNameFromPathRelativeToBase(path).second;
+            namesToDelete.push_back(isBinaryFilename(name) ? path : std::move(name));
+        }
+        db::fileList::deleteEntries(namesToDelete);
+        db::fileList::deleteFingerprints(changedOrRemoved);
+
+        const auto latestUpdate = indexLibraryFiles(addedOrChanged, [&progress](float fraction) {
+            progress(.4f * fraction + .5f);
+        });
+        progress(1.f);
+
+        db::valueCache::set<std::string>(db::valueCache::LAST_INDEX_LDCONFIG_HASH, currentLDConfigHash);
+        if (latestUpdate > getVersion()) {
+            db::valueCache::set<std::string>(db::valueCache::CURRENT_PARTS_LIBRARY_VERSION, latestUpdate);
+        }
+
+        auto after = std::chrono::high_resolution_clock::now();
+        auto durationMs = static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(after - before).count()) / 1000.0;
+        spdlog::info("updated fileList in {} ms. {} files added or changed, {} removed", durationMs, addedOrChanged.size(), result.size() - addedOrChanged.size());
+        return result;
+    }
+
+    std::string FileRepo::indexLibraryFiles(const std::vector<std::string>& fileNames, const std::function<void(float)>& progress) {
+        const auto numFiles = fileNames.size();
+        std::mutex progressMtx;
+        std::size_t doneCount = 0;
+        std::string latestUpdate;
+        std::vector<std::pair<std::string, uint64_t>> fingerprints;
+        fingerprints.reserve(numFiles);
+        thread_pool::parallelFor(numFiles, FILE_LIST_CHUNK_SIZE, [this, &fileNames, &progress, &progressMtx, &doneCount, &latestUpdate, &fingerprints, numFiles](std::size_t iStart, std::size_t iEnd) {
+            std::vector<db::fileList::Entry> entries;
+            std::vector<std::pair<std::string, uint64_t>> chunkFingerprints;
+            std::string chunkLatestUpdate;
+            for (auto fileName = fileNames.cbegin() + iStart; fileName < fileNames.cbegin() + iEnd; ++fileName) {
+                chunkFingerprints.emplace_back(*fileName, getLibraryFileFingerprint(*fileName));
+                auto [type, name] = getTypeAndNameFromPathRelativeToBase(*fileName);
+                if (isBinaryFilename(name)) {
+                    entries.push_back({*fileName, name, PSEUDO_CATEGORY_BINARY_FILE});
+                } else {
+                    auto metaInfo = scanLibraryLdrFileHeader(*fileName, type);
+
+                    std::string category;
+                    if (type == FileType::PART) {
+                        const char& firstChar = metaInfo.title[0];
+                        if ((firstChar == '~' && metaInfo.title[1] != '|') || firstChar == '=' || firstChar == '_') {
+                            category = PSEUDO_CATEGORY_HIDDEN_PART;
+                        } else {
+                            category = metaInfo.getCategory();
                         }
-                        entries.push_back({name, ldrFile->metaInfo.title, category});
-                        if (*fileName != constants::LDRAW_CONFIG_FILE_NAME) {
-                            const auto update = ldrFile->metaInfo.getUpdateId();
-                            if (update > latestUpdate) {
-                                latestUpdate = update;
-                            }
+                    } else if (type == FileType::SUBPART) {
+                        category = PSEUDO_CATEGORY_SUBPART;
+                    } else if (type == FileType::PRIMITIVE) {
+                        category = PSEUDO_CATEGORY_PRIMITIVE;
+                    } else if (type == FileType::MODEL) {
+                        category = PSEUDO_CATEGORY_MODEL;
+                    } else if (type == FileType::OTHER) {
+                        category = PSEUDO_CATEGORY_OTHER;
+                    }
+                    if (*fileName != constants::LDRAW_CONFIG_FILE_NAME) {
+                        const auto update = metaInfo.getUpdateId();
+                        if (update > chunkLatestUpdate) {
+                            chunkLatestUpdate = update;
                         }
                     }
-                    if (iStart == 0) {
-                        progress(.4f * static_cast<float>(entries.size()) / static_cast<float>(iEnd) + .5f);
+                    std::string keywords;
+                    for (const auto& keyword: metaInfo.keywords) {
+                        keywords += keyword;
+                        keywords += ", ";
                     }
+                    keywords += metaInfo.theme;
+                    entries.push_back({name, std::move(metaInfo.title), category, std::move(keywords)});
                 }
-                db::fileList::put(entries);
-                if (iStart == 0) {
-                    progress(1.f);
+            }
+            db::fileList::put(entries);
+            std::scoped_lock<std::mutex> lg(progressMtx);
+            if (chunkLatestUpdate > latestUpdate) {
+                latestUpdate = chunkLatestUpdate;
+            }
+            fingerprints.insert(fingerprints.end(), std::make_move_iterator(chunkFingerprints.begin()), std::make_move_iterator(chunkFingerprints.end()));
+            doneCount += iEnd - iStart;
+            progress(static_cast<float>(doneCount) / static_cast<float>(numFiles));
+        });
+        //one transaction for all of them, transactions can't be nested in the parallel chunks
+        db::fileList::putFingerprints(fingerprints);
+        return latestUpdate;
+    }
+
+    std::vector<std::shared_ptr<File>> FileRepo::invalidateLibraryFiles(const std::vector<std::string>& pathsRelativeToBase) {
+        std::vector<std::string> changedNames;
+        {
+            plLockWait("FileRepo::binaryFilesMtx");
+            std::scoped_lock<std::mutex> lg(binaryFilesMtx);
+            plLockScopeState("FileRepo::binaryFilesMtx", true);
+            auto& libraryBinaryFiles = binaryFiles[nullptr];
+            for (const auto& path: pathsRelativeToBase) {
+                const auto name = getTypeAndNameFromPathRelativeToBase(path).second;
+                if (isBinaryFilename(name)) {
+                    libraryBinaryFiles.erase(path);
+                } else {
+                    changedNames.push_back(stringutil::asLower(name));
                 }
-                latestUpdates[threadNum] = latestUpdate;
-            });
+            }
         }
 
-        for (auto& t: threads) {
-            t.join();
+        //SubfileReference keeps the file it resolved once, so the files which reference a changed file have to be read again too
+        struct Referrer {
+            std::shared_ptr<FileNamespace> fileNamespace;
+            std::string name;
+            std::shared_ptr<SubfileReference> reference;
+        };
+        uomap_t<std::string, std::vector<Referrer>> referrersByName;
+        const auto allFiles = ldrFiles.getAll();
+        for (const auto& [fileNamespace, files]: allFiles) {
+            for (const auto& [name, typeAndFile]: files) {
+                for (const auto& element: typeAndFile.second->elements) {
+                    if (element->getType() == 1) {
+                        auto reference = std::static_pointer_cast<SubfileReference>(element);
+                        const auto referencedName = stringutil::asLower(stringutil::replaceChar(reference->filename, '\\', '/'));
+                        referrersByName[referencedName].push_back({fileNamespace, name, std::move(reference)});
+                    }
+                }
+            }
         }
 
-        db::valueCache::set<std::string>(db::valueCache::LAST_INDEX_LDCONFIG_HASH, currentLDConfigHash);
-        db::valueCache::set<std::string>(db::valueCache::CURRENT_PARTS_LIBRARY_VERSION, *std::max_element(latestUpdates.cbegin(), latestUpdates.cend()));
-
-        auto after = std::chrono::high_resolution_clock::now();
-        auto durationMs = static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(after - before).count()) / 1000.0;
+        std::vector<std::shared_ptr<File>> invalidatedFiles;
+        uoset_t<std::string> visited(changedNames.cbegin(), changedNames.cend());
+        while (!changedNames.empty()) {
+            const auto name = std::move(changedNames.back());
+            changedNames.pop_back();
+            if (auto file = ldrFiles.find(nullptr, name); file != nullptr) {
+                ldrFiles.erase(nullptr, name);
+                invalidatedFiles.push_back(std::move(file));
+            }
+            const auto it = referrersByName.find(name);
+            if (it == referrersByName.end()) {
+                continue;
+            }
+            for (const auto& referrer: it->second) {
+                if (referrer.fileNamespace == nullptr) {
+                    if (visited.insert(referrer.name).second) {
+                        changedNames.push_back(referrer.name);
+                    }
+                } else {
+                    //models are not read again because they can have unsaved changes
+                    referrer.reference->resetFile();
+                }
+            }
+        }
 
-        if (numFiles != static_cast<size_t>(db::fileList::getSize())) {
-            spdlog::error("had {} fileNames, but only {} are in db", numFiles, db::fileList::getSize());
+        //library files which were resolved from another namespace are in that namespace too
+        const uoset_t<std::shared_ptr<File>> invalidatedSet(invalidatedFiles.cbegin(), invalidatedFiles.cend());
+        for (const auto& [fileNamespace, files]: allFiles) {
+            if (fileNamespace == nullptr) {
+                continue;
+            }
+            for (const auto& [name, typeAndFile]: files) {
+                if (invalidatedSet.contains(typeAndFile.second)) {
+                    ldrFiles.erase(fileNamespace, name);
+                }
+            }
         }
-        spdlog::info("filled fileList in {} ms using {} threads. Size: {}", durationMs, numCores, numFiles);
+        connection::removeLibraryFilesFromCache(invalidatedFiles);
+        return invalidatedFiles;
+    }
+
+    FileMetaInfo FileRepo::scanLibraryLdrFileHeader(const std::string& nameRelativeToRoot, FileType type) {
+        return scanFileHeader(getLibraryLdrFileContent(nameRelativeToRoot), type);
     }
 
     oset_t<std::string> FileRepo::getAllCategories() {
@@ -536,27 +775,24 @@ namespace bricksim::ldr::file_repo {
     }
 
     void FileRepo::cleanup() {
+        std::unique_lock<std::shared_mutex> lg(binaryCacheMtx);
+        if (binaryCache != nullptr) {
+            binaryCache->save();
+        }
         //ldrFiles.clear();
         //partsByCategory.clear();
     }
 
     bool FileRepo::hasFileCached(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name) {
-        plLockWait("FileRepo::ldrFilesMtx");
-        std::scoped_lock<std::mutex> lg(ldrFilesMtx);
-        plLockScopeState("FileRepo::ldrFilesMtx", true);
-        auto nsFiles = ldrFiles[fileNamespace];
-        return nsFiles.find(name) != nsFiles.end() || (fileNamespace != nullptr && ldrFiles[nullptr].find(name) != ldrFiles[nullptr].end());
+        return ldrFiles.contains(fileNamespace, name) || (fileNamespace != nullptr && ldrFiles.contains(nullptr, name));
     }
 
     void FileRepo::changeFileName(const std::shared_ptr<FileNamespace>& oldNamespace,
                                   const std::shared_ptr<File>& file,
                                   const std::shared_ptr<FileNamespace>& newNamespace,
                                   const std::string& newName) {
-        plLockWait("FileRepo::ldrFilesMtx");
-        std::scoped_lock<std::mutex> lg(ldrFilesMtx);
-        plLockScopeState("FileRepo::ldrFilesMtx", true);
-        auto oldNsFiles = ldrFiles[oldNamespace];
-        auto newNsFiles = ldrFiles[newNamespace];
+        auto oldNsFiles = ldrFiles.getNamespaceFiles(oldNamespace);
+        auto newNsFiles = ldrFiles.getNamespaceFiles(newNamespace);
         auto it = oldNsFiles.find(file->metaInfo.name);
         if (it == oldNsFiles.end()) {
             it = std::find_if(oldNsFiles.begin(), oldNsFiles.end(), [&file](const auto& entry) {
@@ -570,7 +806,7 @@ namespace bricksim::ldr::file_repo {
 
         for (const auto& el: file->elements) {
             if (el->getType() == 1) {
-                const auto subfileRef = std::dynamic_pointer_cast<SubfileReference>(el);
+                const auto subfileRef = std::static_pointer_cast<SubfileReference>(el);
                 const auto subIt = oldNsFiles.find(subfileRef->filename);
                 if (subIt != oldNsFiles.end()) {
                     const auto newRef = std::filesystem::relative(oldNamespace->searchPath / subfileRef->filename, newNamespace->searchPath).generic_string();
@@ -585,69 +821,105 @@ namespace bricksim::ldr::file_repo {
             const auto newRef = std::filesystem::relative(oldNamespace->searchPath / item.first, newNamespace->searchPath).generic_string();
             newNsFiles.emplace(newRef, item.second);
         }
-        ldrFiles.erase(oldNamespace);
+        ldrFiles.eraseNamespace(oldNamespace);
         for (const auto& item: newNsFiles) {
             item.second.second->nameSpace = newNamespace;
+            ldrFiles.insert(newNamespace, item.first, item.second.first, item.second.second);
         }
     }
 
     std::shared_ptr<File> FileRepo::reloadFile(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name) {
-        plLockWait("FileRepo::ldrFilesMtx");
-        std::scoped_lock<std::mutex> lg(ldrFilesMtx);
-        plLockScopeState("FileRepo::ldrFilesMtx", true);
-        auto nsFiles = ldrFiles[fileNamespace];
-        auto it = nsFiles.find(name);
-        if (it != nsFiles.end()) {
-            nsFiles.erase(it);
-        }
+        ldrFiles.erase(fileNamespace, stringutil::asLower(name));
         return getFile(fileNamespace, name);
     }
 
-    const uomap_t<std::shared_ptr<FileNamespace>, uomap_t<std::string, std::pair<FileType, std::shared_ptr<File>>>>& FileRepo::getAllFilesInMemory() const {
-        return ldrFiles;
+    std::optional<FileRepo::IncrementalReloadResult> FileRepo::reloadFileIncrementally(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name) {
+        plFunction();
+        const auto oldMainFile = ldrFiles.find(fileNamespace, stringutil::asLower(name));
+        if (oldMainFile == nullptr || oldMainFile->source.path.empty() || !std::filesystem::exists(oldMainFile->source.path)) {
+            return std::nullopt;
+        }
+        const auto source = oldMainFile->source.path;
+        const auto newFiles = readComplexFile(fileNamespace, name, source, oldMainFile->metaInfo.type, getContentOfLdrFile(source), std::nullopt);
+
+        IncrementalReloadResult result;
+        //the main file of an MPD is in the map twice, with the name of the file and the name in its 0 FILE line
+        uoset_t<std::shared_ptr<File>> patchedFiles;
+        uoset_t<std::string> newNames;
+        for (const auto& [newName, newFile]: newFiles) {
+            const auto key = stringutil::asLower(newName);
+            newNames.insert(key);
+            const auto oldFile = ldrFiles.find(fileNamespace, key);
+            if (oldFile == nullptr) {
+                ldrFiles.insert(fileNamespace, key, newFile->metaInfo.type, newFile);
+                result.addedFiles.push_back(newFile);
+            } else if (oldFile->source.path == source && patchedFiles.insert(oldFile).second) {
+                auto diff = patchFile(oldFile, *newFile);
+                if (!diff.empty()) {
+                    result.changedFiles.push_back(std::move(diff));
+                }
+            }
+        }
+        for (const auto& [key, typeAndFile]: ldrFiles.getNamespaceFiles(fileNamespace)) {
+            if (typeAndFile.second->source.path == source && !newNames.contains(key)) {
+                ldrFiles.erase(fileNamespace, key);
+                if (!patchedFiles.contains(typeAndFile.second)) {
+                    result.removedFiles.push_back(typeAndFile.second);
+                }
+            }
+        }
+        spdlog::info("reloaded {} incrementally: {} files changed, {} added, {} removed", name, result.changedFiles.size(), result.addedFiles.size(), result.removedFiles.size());
+        return result;
+    }
+
+    ConcurrentFileMap::file_map_t FileRepo::getAllFilesInMemory() const {
+        return ldrFiles.getAll();
     }
 
     std::shared_ptr<FileNamespace> FileRepo::getNamespace(const std::string& name) {
-        plLockWait("FileRepo::ldrFilesMtx");
-        std::scoped_lock<std::mutex> lg(ldrFilesMtx);
-        plLockScopeState("FileRepo::ldrFilesMtx", true);
-        for (const auto& [key, map]: ldrFiles) {
+        for (const auto& key: ldrFiles.getNamespaces()) {
             if (key != nullptr && key->name == name) {
                 return key;
             }
         }
         return nullptr;
     }
-    void FileRepo::updateLibraryFiles(const std::filesystem::path& updatedFileDirectory, std::function<void(float)> progress, uint64_t estimatedFileCount) {
+    std::vector<std::shared_ptr<File>> FileRepo::updateLibraryFiles(const std::filesystem::path& updatedFileDirectory, std::function<void(float)> progress, uint64_t estimatedFileCount) {
         updateLibraryFilesImpl(updatedFileDirectory, [&progress, estimatedFileCount](int fileNo) {
             progress(std::min(.5f, .5f * fileNo / estimatedFileCount));
         });
-        refreshAfterUpdateOrReplaceLibrary(progress);
+        return refreshAfterUpdateOrReplaceLibrary(progress);
     }
 
-    void FileRepo::replaceLibraryFiles(const std::filesystem::path& replacementFileOrDirectory, std::function<void(float)> progress, uint64_t estimatedFileCount) {
+    std::vector<std::shared_ptr<File>> FileRepo::replaceLibraryFiles(const std::filesystem::path& replacementFileOrDirectory, std::function<void(float)> progress, uint64_t estimatedFileCount) {
         replaceLibraryFilesImpl(replacementFileOrDirectory, [&progress, estimatedFileCount](int fileNo) {
             progress(std::min(.5f, .5f * fileNo / estimatedFileCount));
         });
-        refreshAfterUpdateOrReplaceLibrary(progress);
+        return refreshAfterUpdateOrReplaceLibrary(progress);
     }
-    void FileRepo::refreshAfterUpdateOrReplaceLibrary(const std::function<void(float)>& progress) {
-        {
-            plLockWait("FileRepo::ldrFilesMtx");
-            std::scoped_lock<std::mutex> lg(ldrFilesMtx);
-            plLockScopeState("FileRepo::ldrFilesMtx", true);
+    std::vector<std::shared_ptr<File>> FileRepo::refreshAfterUpdateOrReplaceLibrary(const std::function<void(float)>& progress) {
+        progress(.5f);
+        const auto changedFiles = updateFileList([&progress](float fillFraction) {
+            progress(.5f + fillFraction * .5f);
+        }, getLDConfigContentHash());
+        part_finder::rebuildSearchIndex();
+        std::vector<std::shared_ptr<File>> invalidatedFiles;
+        if (changedFiles.has_value()) {
+            invalidatedFiles = invalidateLibraryFiles(*changedFiles);
+        } else {
+            for (const auto& [name, typeAndFile]: ldrFiles.getNamespaceFiles(nullptr)) {
+                invalidatedFiles.push_back(typeAndFile.second);
+            }
             ldrFiles.clear();
-        }
-        {
+            connection::removeLibraryFilesFromCache(invalidatedFiles);
             plLockWait("FileRepo::binaryFilesMtx");
             std::scoped_lock<std::mutex> lg(binaryFilesMtx);
             plLockScopeState("FileRepo::binaryFilesMtx", true);
             binaryFiles.clear();
         }
-        progress(.5f);
-        fillFileList([&progress](float fillFraction) {
-            progress(.5f + fillFraction * .5f);
-        });
+        //the old entries are useless now, they would be discarded anyway because the version is different
+        openBinaryCache(getLDConfigContentHash(), false);
+        return invalidatedFiles;
     }
 
     std::string FileRepo::getVersion() const {
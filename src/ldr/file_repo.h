@@ -1,11 +1,15 @@
 #pragma once
 
 #include "../binary_file.h"
+#include "binary_library_cache.h"
+#include "concurrent_file_map.h"
+#include "file_diff.h"
 #include "files.h"
 #include <filesystem>
 #include <map>
 #include <mutex>
 #include <set>
+#include <shared_mutex>
 #include <vector>
 
 namespace bricksim::ldr::file_repo {
@@ -58,11 +62,43 @@ namespace bricksim::ldr::file_repo {
          * @return
          */
         std::shared_ptr<File> getFile(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name, std::optional<std::filesystem::path> contextRelativePath);
+        /**
+         * parses the transitive closure of all files referenced by file (line type 1) so that
+         * later calls to SubfileReference::getFile are cache hits.
+         * the reference graph is walked breadth-first and every level is resolved on all cores
+         */
+        void preloadReferencedFiles(const std::shared_ptr<File>& file);
         std::shared_ptr<File> getFileOrNull(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name);
         std::shared_ptr<BinaryFile> getBinaryFile(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name, BinaryFileSearchPath searchPath = BinaryFileSearchPath::DEFAULT);
         bool hasFileCached(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name);
-        [[nodiscard]] const uomap_t<std::shared_ptr<FileNamespace>, uomap_t<std::string, std::pair<FileType, std::shared_ptr<File>>>>& getAllFilesInMemory() const;
+        ///@return a copy of the map of all loaded files
+        [[nodiscard]] ConcurrentFileMap::file_map_t getAllFilesInMemory() const;
+        /**
+         * removes the file from memory and reads it again from its source
+         * @return the new File object, the old one isn't updated
+         */
         std::shared_ptr<File> reloadFile(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name);
+        struct IncrementalReloadResult {
+            ///the diffs of the files which changed, the File objects are the same as before
+            std::vector<FileDiff> changedFiles;
+            ///MPD subfiles which are new, they're already added to the repo
+            std::vector<std::shared_ptr<File>> addedFiles;
+            ///MPD subfiles which don't exist anymore, they're already removed from the repo
+            std::vector<std::shared_ptr<File>> removedFiles;
+        };
+        /**
+         * reads a file which is already loaded from its source again and patches the loaded File objects with patchFile.
+         * for MPD files this is done for every subfile
+         * @return std::nullopt if the file isn't loaded or doesn't have a source on disk
+         */
+        std::optional<IncrementalReloadResult> reloadFileIncrementally(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name);
+        /**
+         * removes the changed files and all library files which reference them from memory.
+         * files in other namespaces are kept, but their references to the changed files are resolved again.
+         * element trees which use the removed files have to be updated with etree::RootNode::replaceInvalidatedFiles
+         * @return the removed files
+         */
+        std::vector<std::shared_ptr<File>> invalidateLibraryFiles(const std::vector<std::string>& pathsRelativeToBase);
         std::shared_ptr<File> addLdrFileWithContent(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name, const std::filesystem::path& source, FileType type, const std::string& content);
         std::shared_ptr<File> addLdrFileWithContent(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name, const std::filesystem::path& source, FileType type, const std::string& content, const std::optional<std::string>& shadowContent);
         std::shared_ptr<BinaryFile> addBinaryFileWithContent(const std::shared_ptr<FileNamespace>& fileNamespace, const std::string& name, const std::shared_ptr<BinaryFile>& file);
@@ -90,18 +126,36 @@ namespace bricksim::ldr::file_repo {
         virtual std::string getLibraryLdrFileContent(FileType type, const std::string& name) = 0;
         virtual std::string getLibraryLdrFileContent(const std::string& nameRelativeToRoot) = 0;
         virtual std::shared_ptr<BinaryFile> getLibraryBinaryFileContent(const std::string& nameRelativeToRoot) = 0;
+        /**
+         * reads only as much of the file as needed for the meta lines before the first geometry line (see FileHeaderScanner).
+         * the default implementation reads the whole file, implementations which can stream the content override it
+         */
+        virtual FileMetaInfo scanLibraryLdrFileHeader(const std::string& nameRelativeToRoot, FileType type);
+        /**
+         * @return a value which changes when the content of the file changes (crc, modification time, ...) or 0 if the file doesn't exist
+         */
+        virtual uint64_t getLibraryFileFingerprint(const std::string& nameRelativeToRoot) = 0;
         virtual ~FileRepo();
         omap_t<std::string, oset_t<std::shared_ptr<File>>> getAllPartsGroupedByCategory();
         omap_t<std::string, oset_t<std::shared_ptr<File>>> getLoadedPartsGroupedByCategory() const;
 
+        /**
+         * moves file and all other files of oldNamespace to newNamespace, file gets newName.
+         * the other files are stored with their path relative to the search path of newNamespace and the references to them are updated
+         */
         void changeFileName(const std::shared_ptr<FileNamespace>& oldNamespace,
                             const std::shared_ptr<File>& file,
                             const std::shared_ptr<FileNamespace>& newNamespace,
                             const std::string& newName);
 
-        void updateLibraryFiles(const std::filesystem::path& updatedFileDirectory, std::function<void(float)> progress, uint64_t estimatedFileCount);
+        /**
+         * @return the library files which were in memory and had to be removed because they or one of their subfiles changed.
+         * the meshes of these files are outdated
+         */
+        std::vector<std::shared_ptr<File>> updateLibraryFiles(const std::filesystem::path& updatedFileDirectory, std::function<void(float)> progress, uint64_t estimatedFileCount);
         virtual bool replaceLibraryFilesDirectlyFromZip() = 0;
-        void replaceLibraryFiles(const std::filesystem::path& replacementFileOrDirectory, std::function<void(float)> progress, uint64_t estimatedFileCount);
+        ///@return see updateLibraryFiles
+        std::vector<std::shared_ptr<File>> replaceLibraryFiles(const std::filesystem::path& replacementFileOrDirectory, std::function<void(float)> progress, uint64_t estimatedFileCount);
 
     protected:
         static bool shouldFileBeSavedInList(const std::string& filename);
@@ -117,18 +171,37 @@ namespace bricksim::ldr::file_repo {
 
         void fillFileList(std::function<void(float)> progress);
         void fillFileList(std::function<void(float)> progress, const std::string& currentLDConfigHash);
+        /**
+         * compares the fingerprints of all library files with the ones stored in the db and only indexes the files which were added, changed or removed.
+         * calls fillFileList if there are no fingerprints in the db
+         * @return the paths relative to the root of the added, changed and removed files or std::nullopt if the whole list was filled again
+         */
+        std::optional<std::vector<std::string>> updateFileList(std::function<void(float)> progress, const std::string& currentLDConfigHash);
     private:
-        uomap_t<std::shared_ptr<FileNamespace>, uomap_t<std::string, std::pair<FileType, std::shared_ptr<File>>>> ldrFiles;
-        std::mutex ldrFilesMtx;
+        ConcurrentFileMap ldrFiles;
 
         uomap_t<std::shared_ptr<FileNamespace>, uomap_t<std::string, std::shared_ptr<BinaryFile>>> binaryFiles;
         std::mutex binaryFilesMtx;
 
         omap_t<std::string, oset_t<std::shared_ptr<File>>> partsByCategory;
+        std::unique_ptr<BinaryLibraryCache> binaryCache;
+        ///shared while binaryCache is used, exclusive while it's saved or replaced
+        std::shared_mutex binaryCacheMtx;
+        ///returns the library file from the cache or parses it
+        std::shared_ptr<File> getLibraryFile(const std::string& name);
+        std::shared_ptr<File> readLibraryFile(const std::string& name);
         static bool isLdrFilename(const std::string& filename);
         static bool isBinaryFilename(const std::string& filename);
         std::string getLDConfigContentHash();
-        void refreshAfterUpdateOrReplaceLibrary(const std::function<void(float)>& progress);
+        ///@param saveOldCache false if the entries of the current cache are outdated anyway
+        void openBinaryCache(const std::string& ldConfigHash, bool saveOldCache);
+        std::vector<std::shared_ptr<File>> refreshAfterUpdateOrReplaceLibrary(const std::function<void(float)>& progress);
+        /**
+         * puts the entries and the fingerprints of fileNames into the db
+         * @param progress range from 0.0f to 1.0f
+         * @return the newest update id of these files
+         */
+        std::string indexLibraryFiles(const std::vector<std::string>& fileNames, const std::function<void(float)>& progress);
     };
 
     FileRepo& get();
@@ -4,10 +4,13 @@
 #include "../helpers/util.h"
 #include "../metrics.h"
 #include "file_repo.h"
+#include "line_tokenizer.h"
+#include <algorithm>
 #include <charconv>
 #include <fast_float/fast_float.h>
 #include <iostream>
 #include <magic_enum/magic_enum.hpp>
+#include <mutex>
 #include <spdlog/spdlog.h>
 
 namespace bricksim::ldr {
@@ -16,22 +19,27 @@ namespace bricksim::ldr {
     }
 
     std::shared_ptr<FileElement> FileElement::parseLine(const std::string_view line, BfcState bfcState) {
+        return parseLine(line, bfcState, nullptr);
+    }
+
+    std::shared_ptr<FileElement> FileElement::parseLine(const std::string_view line, BfcState bfcState, const std::shared_ptr<ElementArena>& arena) {
         std::string_view lineContent = line.length() > 2 ? line.substr(2) : "";
         switch (line[0] - '0') {
             case 0:
-                return TexmapStartCommand::doesLineMatch(lineContent)
-                           ? std::make_shared<TexmapStartCommand>(lineContent)
-                           : std::make_shared<CommentOrMetaElement>(lineContent);
+                if (TexmapStartCommand::doesLineMatch(lineContent)) {
+                    return allocateElement<TexmapStartCommand>(arena, lineContent);
+                }
+                return allocateElement<CommentOrMetaElement>(arena, lineContent);
             case 1:
-                return std::make_shared<SubfileReference>(lineContent, bfcState.invertNext);
+                return allocateElement<SubfileReference>(arena, lineContent, bfcState.invertNext);
             case 2:
-                return std::make_shared<Line>(lineContent);
+                return allocateElement<Line>(arena, lineContent);
             case 3:
-                return std::make_shared<Triangle>(lineContent, bfcState.windingOrder);
+                return allocateElement<Triangle>(arena, lineContent, bfcState.windingOrder);
             case 4:
-                return std::make_shared<Quadrilateral>(lineContent, bfcState.windingOrder);
+                return allocateElement<Quadrilateral>(arena, lineContent, bfcState.windingOrder);
             case 5:
-                return std::make_shared<OptionalLine>(lineContent);
+                return allocateElement<OptionalLine>(arena, lineContent);
             default: /*throw std::invalid_argument("The line is not valid: \"" + line + "\"");*/
                 spdlog::warn("invalid line: {}", line);
                 return nullptr;
@@ -46,24 +54,29 @@ namespace bricksim::ldr {
         //std::cout << metrics::ldrFileElementInstanceCount << std::endl;
     }
 
-    FileElement::FileElement() {
+    FileElement::FileElement(int type) :
+        type(type) {
         std::scoped_lock lg(metrics::ldrFileElementInstanceCountMtx);
         ++metrics::ldrFileElementInstanceCount;
         //std::cout << metrics::ldrFileElementInstanceCount << std::endl;
     }
     #else
     FileElement::~FileElement() = default;
-    FileElement::FileElement() = default;
+    FileElement::FileElement(int type) :
+        type(type) {}
     #endif
 
     void File::addTextLine(const std::string_view line) {
         const auto trimmed = stringutil::trim(line);
         unsigned int currentStep = elements.empty() ? 0 : elements.back()->step;
         if (!trimmed.empty()) {
-            if (auto element = FileElement::parseLine(trimmed, bfcState); element != nullptr) {
+            if (elementArena == nullptr) {
+                prepareElementArena(0);
+            }
+            if (auto element = FileElement::parseLine(trimmed, bfcState, elementArena); element != nullptr) {
                 bfcState.invertNext = false;
                 if (element->getType() == 0) {
-                    const auto metaElement = std::dynamic_pointer_cast<CommentOrMetaElement>(element);
+                    const auto metaElement = std::static_pointer_cast<CommentOrMetaElement>(element);
                     if (metaInfo.addLine(metaElement->content)) {
                         element = nullptr;
                     } else if (metaElement->content == "STEP") {
@@ -109,7 +122,7 @@ namespace bricksim::ldr {
                         if (metaElement->content.starts_with("!:")) {
                             const std::size_t firstNonWhiteSpace = metaElement->content.find_first_not_of(LDR_WHITESPACE, 2);
                             const auto realCommand = std::string_view(metaElement->content).substr(firstNonWhiteSpace);
-                            element = FileElement::parseLine(realCommand, bfcState);
+                            element = FileElement::parseLine(realCommand, bfcState, elementArena);
                         }
                         element->directTexmap = texmapState.startCommand;
                     } else if (metaElement->content.starts_with(LDCAD_META_START)) {
@@ -140,6 +153,17 @@ namespace bricksim::ldr {
         return unknown;
     }
 
+    void File::prepareElementArena(std::size_t contentLength) {
+        elementArena = std::make_shared<ElementArena>(ElementArena::estimateBytesForContent(contentLength));
+    }
+
+    const std::shared_ptr<ElementArena>& File::getElementArena() {
+        if (elementArena == nullptr) {
+            prepareElementArena(0);
+        }
+        return elementArena;
+    }
+
     const std::size_t& File::getHash() const {
         if (hash == 0) {
             hash = bricksim::hash<std::string>{}(metaInfo.name);
@@ -182,13 +206,7 @@ namespace bricksim::ldr {
     File::~File() = default;
 
     CommentOrMetaElement::CommentOrMetaElement(const std::string_view line) :
-        content(line) {}
-
-    inline void parseNextInt(const std::string_view line, size_t& start, size_t& end, int& result) {
-        start = line.find_first_not_of(LDR_WHITESPACE, end);
-        end = std::min(line.size(), line.find_first_of(LDR_WHITESPACE, start));
-        fast_float::from_chars(line.data() + start, line.data() + end, result);
-    }
+        FileElement(0), content(line) {}
 
     inline void parseNextFloat(const std::string_view line, size_t& start, size_t& end, float& result) {
         start = line.find_first_not_of(LDR_WHITESPACE, end);
@@ -203,81 +221,58 @@ namespace bricksim::ldr {
     }
 
     SubfileReference::SubfileReference(const std::string_view line, const bool bfcInverted) :
-        bfcInverted(bfcInverted) {
-        std::size_t start;
-        std::size_t end = 0;
-        parseNextInt(line, start, end, color.code);
-        for (size_t n = 0; n < std::size(numbers); ++n) {
-            parseNextFloat(line, start, end, numbers[n]);
-        }
-        filename = stringutil::trim(line.substr(end + 1));
+        FileElement(1), bfcInverted(bfcInverted) {
+        const auto end = tokenizer::parseColorAndNumbers(line, color.code, numbers.data(), numbers.size());
+        filename = stringutil::trim(line.substr(end));
     }
 
-    Line::Line(const std::string_view line) {
-        std::size_t start;
-        std::size_t end = 0;
-        parseNextInt(line, start, end, color.code);
-        for (size_t n = 0; n < std::size(coords); ++n) {
-            parseNextFloat(line, start, end, coords[n]);
-        }
-    }
+    SubfileReference::SubfileReference(const ColorReference color, const std::array<float, 12>& numbers, std::string filename, const bool bfcInverted) :
+        FileElement(1), bfcInverted(bfcInverted), color(color), numbers(numbers), filename(std::move(filename)) {}
 
-    Triangle::Triangle(const std::string_view line, const WindingOrder order) {
-        std::size_t start;
-        std::size_t end = 0;
-        parseNextInt(line, start, end, color.code);
+    Line::Line(const ColorReference color, const std::array<float, 6>& coords) :
+        FileElement(2), color(color), coords(coords) {}
 
-        parseNextThreeFloats(line, start, end, &coords[0]);//p1
+    Triangle::Triangle(const ColorReference color, const std::array<float, 9>& coords) :
+        FileElement(3), color(color), coords(coords) {}
 
-        if (order == WindingOrder::CCW) {
-            parseNextThreeFloats(line, start, end, &coords[1 * 3]);//p2
-            parseNextThreeFloats(line, start, end, &coords[2 * 3]);//p3
-        } else {
-            parseNextThreeFloats(line, start, end, &coords[2 * 3]);//p3
-            parseNextThreeFloats(line, start, end, &coords[1 * 3]);//p2
-        }
-    }
+    Quadrilateral::Quadrilateral(const ColorReference color, const std::array<float, 12>& coords) :
+        FileElement(4), color(color), coords(coords) {}
 
-    Quadrilateral::Quadrilateral(const std::string_view line, const WindingOrder order) {
-        std::size_t start;
-        std::size_t end = 0;
-        parseNextInt(line, start, end, color.code);
+    OptionalLine::OptionalLine(const ColorReference color, const std::array<float, 12>& coords) :
+        FileElement(5), color(color), coords(coords) {}
 
-        parseNextThreeFloats(line, start, end, &coords[0]);//p1
+    Line::Line(const std::string_view line) :
+        FileElement(2) {
+        tokenizer::parseColorAndNumbers(line, color.code, coords.data(), coords.size());
+    }
 
-        if (order == WindingOrder::CCW) {
-            parseNextThreeFloats(line, start, end, &coords[1 * 3]);//p2
-            parseNextThreeFloats(line, start, end, &coords[2 * 3]);//p3
-            parseNextThreeFloats(line, start, end, &coords[3 * 3]);//p4
-        } else {
-            parseNextThreeFloats(line, start, end, &coords[3 * 3]);//p4
-            parseNextThreeFloats(line, start, end, &coords[2 * 3]);//p3
-            parseNextThreeFloats(line, start, end, &coords[1 * 3]);//p2
+    Triangle::Triangle(const std::string_view line, const WindingOrder order) :
+        FileElement(3) {
+        tokenizer::parseColorAndNumbers(line, color.code, coords.data(), coords.size());
+        if (order == WindingOrder::CW) {
+            //p1 p3 p2
+            std::swap_ranges(coords.begin() + 1 * 3, coords.begin() + 2 * 3, coords.begin() + 2 * 3);
         }
     }
 
-    OptionalLine::OptionalLine(const std::string_view line) {
-        std::size_t start;
-        std::size_t end = 0;
-        parseNextInt(line, start, end, color.code);
-
-        for (size_t i = 0; i < std::size(coords); ++i) {
-            parseNextFloat(line, start, end, coords[i]);
+    Quadrilateral::Quadrilateral(const std::string_view line, const WindingOrder order) :
+        FileElement(4) {
+        tokenizer::parseColorAndNumbers(line, color.code, coords.data(), coords.size());
+        if (order == WindingOrder::CW) {
+            //p1 p4 p3 p2
+            std::swap_ranges(coords.begin() + 1 * 3, coords.begin() + 2 * 3, coords.begin() + 3 * 3);
         }
     }
 
-    int CommentOrMetaElement::getType() const {
-        return 0;
+    OptionalLine::OptionalLine(const std::string_view line) :
+        FileElement(5) {
+        tokenizer::parseColorAndNumbers(line, color.code, coords.data(), coords.size());
     }
 
     std::string CommentOrMetaElement::getLdrLine() const {
         return "0 " + content;
     }
 
-    int SubfileReference::getType() const {
-        return 1;
-    }
-
     glm::mat4 SubfileReference::getTransformationMatrix() const {
         return {
                 a(), d(), g(), 0.f,
@@ -314,45 +309,53 @@ namespace bricksim::ldr {
     }
 
     SubfileReference::SubfileReference(const ColorReference color, const glm::mat4& transformation, const bool bfcInverted) :
-        bfcInverted(bfcInverted), color(color) {
+        FileElement(1), bfcInverted(bfcInverted), color(color) {
         setTransformationMatrix(transformation);
     }
 
+    namespace {
+        //meshes are built on multiple threads, so the same reference can be resolved by more than one thread at the same time
+        std::array<std::mutex, 64> subfileResolveMutexes;
+
+        std::mutex& getSubfileResolveMutex(const SubfileReference* reference) {
+            return subfileResolveMutexes[std::hash<const SubfileReference*>()(reference) % subfileResolveMutexes.size()];
+        }
+    }
+
     std::shared_ptr<File> SubfileReference::getFile(const std::shared_ptr<File>& containingFile) {
+        auto& mtx = getSubfileResolveMutex(this);
+        {
+            std::scoped_lock<std::mutex> lg(mtx);
+            if (file != nullptr) {
+                return file;
+            }
+        }
+        //not locked while the file is read, it can take a while
+        auto resolved = file_repo::get().getFile(containingFile, filename);
+        std::scoped_lock<std::mutex> lg(mtx);
         if (file == nullptr) {
-            file = file_repo::get().getFile(containingFile, filename);
+            file = std::move(resolved);
         }
         return file;
     }
 
-    int Line::getType() const {
-        return 2;
+    void SubfileReference::resetFile() {
+        std::scoped_lock<std::mutex> lg(getSubfileResolveMutex(this));
+        file = nullptr;
     }
 
     std::string Line::getLdrLine() const {
         return fmt::format("2 {:d} {:g} {:g} {:g} {:g} {:g} {:g}", color.code, x1(), y1(), z1(), x2(), y2(), z2());
     }
 
-    int Triangle::getType() const {
-        return 3;
-    }
-
     std::string Triangle::getLdrLine() const {
         return fmt::format("3 {:d} {:g} {:g} {:g} {:g} {:g} {:g} {:g} {:g} {:g}", color.code, x1(), y1(), z1(), x2(), y2(), z2(), x3(), y3(), z3());
     }
 
-    int Quadrilateral::getType() const {
-        return 4;
-    }
-
     std::string Quadrilateral::getLdrLine() const {
         return fmt::format("4 {:d} {:g} {:g} {:g} {:g} {:g} {:g} {:g} {:g} {:g} {:g} {:g} {:g}", color.code, x1(), y1(), z1(), x2(), y2(), z2(), x3(), y3(), z3(), x4(), y4(), z4());
     }
 
-    int OptionalLine::getType() const {
-        return 5;
-    }
-
     std::string OptionalLine::getLdrLine() const {
         return fmt::format("5 {:d} {:g} {:g} {:g} {:g} {:g} {:g} {:g} {:g} {:g} {:g} {:g} {:g}", color.code, x1(), y1(), z1(), x2(), y2(), z2(), controlX1(), controlY1(), controlZ1(), controlX2(), controlY2(), controlZ2());
     }
@@ -3,6 +3,7 @@
 #include "../connection/ldcad_meta/base.h"
 #include "../helpers/util.h"
 #include "colors.h"
+#include "element_arena.h"
 #include <array>
 #include <memory>
 #include <set>
@@ -79,9 +80,14 @@ namespace bricksim::ldr {
     class FileElement {
     public:
         static std::shared_ptr<FileElement> parseLine(std::string_view line, BfcState bfcState);
-        [[nodiscard]] virtual int getType() const = 0;
+        /**
+         * @param arena if not null, the element is allocated inside it instead of getting its own heap allocation
+         */
+        static std::shared_ptr<FileElement> parseLine(std::string_view line, BfcState bfcState, const std::shared_ptr<ElementArena>& arena);
+        ///the line type (0..5). not virtual because it's queried for every element in every hot loop over File::elements
+        [[nodiscard]] inline int getType() const { return type; }
         [[nodiscard]] virtual std::string getLdrLine() const = 0;
-        FileElement();
+        explicit FileElement(int type);
         virtual ~FileElement();
 
         unsigned int step = 0;//0 is before the first "0 STEP" line
@@ -93,6 +99,9 @@ namespace bricksim::ldr {
         ///this line therefore counts to the <geometry1> or <geometry2> section
         ///in all other cases this is nullptr
         std::shared_ptr<TexmapStartCommand> directTexmap;
+
+    private:
+        int type;
     };
 
     class CommentOrMetaElement : public FileElement {
@@ -100,7 +109,6 @@ namespace bricksim::ldr {
         explicit CommentOrMetaElement(std::string_view line);
         std::string content;
 
-        [[nodiscard]] int getType() const override;
         [[nodiscard]] std::string getLdrLine() const override;
     };
 
@@ -108,16 +116,18 @@ namespace bricksim::ldr {
     public:
         explicit SubfileReference(std::string_view line, bool bfcInverted);
         explicit SubfileReference(ColorReference color, const glm::mat4& transformation, bool bfcInverted);
+        SubfileReference(ColorReference color, const std::array<float, 12>& numbers, std::string filename, bool bfcInverted);
         bool bfcInverted;
         ColorReference color;
         std::array<float, 12> numbers;
         std::string filename;
-        [[nodiscard]] int getType() const override;
         [[nodiscard]] std::string getLdrLine() const override;
         [[nodiscard]] glm::mat4 getTransformationMatrix() const;
         [[nodiscard]] glm::mat4 getTransformationMatrixT() const;
         void setTransformationMatrix(const glm::mat4& matrix);
         std::shared_ptr<File> getFile(const std::shared_ptr<File>& containingFile);
+        ///forgets the resolved file, the next getFile call resolves filename again
+        void resetFile();
 
         inline float& x() { return numbers[0]; }
         inline float& y() { return numbers[1]; }
@@ -155,8 +165,8 @@ namespace bricksim::ldr {
         std::array<float, 6> coords;
 
         explicit Line(std::string_view line);
+        Line(ColorReference color, const std::array<float, 6>& coords);
 
-        [[nodiscard]] int getType() const override;
         [[nodiscard]] std::string getLdrLine() const override;
 
         inline float& x1() { return coords[0]; }
@@ -180,8 +190,9 @@ namespace bricksim::ldr {
         std::array<float, 9> coords;
 
         explicit Triangle(std::string_view line, WindingOrder order);
+        ///@param coords already in the final winding order
+        Triangle(ColorReference color, const std::array<float, 9>& coords);
 
-        [[nodiscard]] int getType() const override;
         [[nodiscard]] std::string getLdrLine() const override;
 
         inline float& x1() { return coords[0]; }
@@ -211,8 +222,9 @@ namespace bricksim::ldr {
         std::array<float, 12> coords;
 
         explicit Quadrilateral(std::string_view line, WindingOrder order);
+        ///@param coords already in the final winding order
+        Quadrilateral(ColorReference color, const std::array<float, 12>& coords);
 
-        [[nodiscard]] int getType() const override;
         [[nodiscard]] std::string getLdrLine() const override;
 
         inline float& x1() { return coords[0]; }
@@ -249,8 +261,8 @@ namespace bricksim::ldr {
         std::array<float, 12> coords;
 
         explicit OptionalLine(std::string_view line);
+        OptionalLine(ColorReference color, const std::array<float, 12>& coords);
 
-        [[nodiscard]] int getType() const override;
         [[nodiscard]] std::string getLdrLine() const override;
 
         inline float& x1() { return coords[0]; }
@@ -352,6 +364,13 @@ namespace bricksim::ldr {
         FileSource source;
 
         [[nodiscard]] const std::string& getDescription() const;
+        /**
+         * creates the arena which will hold the elements parsed by addTextLine
+         * @param contentLength length of the text which is going to be parsed, used to size the first block
+         */
+        void prepareElementArena(std::size_t contentLength);
+        ///the arena for elements which are added to this file. created if it doesn't exist yet
+        const std::shared_ptr<ElementArena>& getElementArena();
         [[nodiscard]] const std::size_t& getHash() const;
 
         void addTextLine(std::string_view line);
@@ -360,6 +379,7 @@ namespace bricksim::ldr {
     private:
         constexpr static const char LDCAD_META_START[] = "!LDCAD";
         mutable std::size_t hash = 0;
+        std::shared_ptr<ElementArena> elementArena;
         BfcState bfcState;
         TexmapState texmapState;
         /**
@@ -0,0 +1,145 @@
+#include "line_tokenizer.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <fast_float/fast_float.h>
+
+#ifdef __SSE2__
+    #include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+#endif
+
+namespace bricksim::ldr::tokenizer {
+    namespace {
+        //lines 1 to 5 are usually shorter than 200 characters, longer lines are parsed with the scalar fallback
+        constexpr std::size_t MAX_MASK_WORDS = 8;
+        constexpr std::size_t MAX_MASK_LENGTH = MAX_MASK_WORDS * 64;
+
+        constexpr bool isWhitespace(const char c) {
+            return c == ' ' || c == '\t';
+        }
+
+        constexpr bool isLineEnd(const char c) {
+            return c == '\r' || c == '\n';
+        }
+
+#if defined(BRICKSIM_USE_OPTIMIZED_VARIANTS) && (defined(__SSE2__) || defined(__aarch64__))
+    #define BRICKSIM_TOKENIZER_SIMD
+        constexpr std::size_t SIMD_WIDTH = 16;
+
+        /**
+         * @return bit i is set if data[i] is equal to a or b
+         */
+        inline uint16_t equalMask16(const char* data, const char a, const char b) {
+    #ifdef __SSE2__
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            const __m128i equal = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(a)), _mm_cmpeq_epi8(chunk, _mm_set1_epi8(b)));
+            return static_cast<uint16_t>(_mm_movemask_epi8(equal));
+    #else
+            static const uint8_t bitValues[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+            const uint8x16_t chunk = vld1q_u8(reinterpret_cast<const uint8_t*>(data));
+            const uint8x16_t equal = vorrq_u8(vceqq_u8(chunk, vdupq_n_u8(a)), vceqq_u8(chunk, vdupq_n_u8(b)));
+            const uint8x16_t bits = vandq_u8(equal, vld1q_u8(bitValues));
+            return static_cast<uint16_t>(vaddv_u8(vget_low_u8(bits)) | (vaddv_u8(vget_high_u8(bits)) << 8));
+    #endif
+        }
+#endif
+
+        /**
+         * bit i of the result is set if line[i] is whitespace. all bits after the end of the line are set too
+         */
+        void buildWhitespaceMask(const std::string_view line, std::array<uint64_t, MAX_MASK_WORDS>& mask) {
+            mask.fill(~0ull);
+            std::size_t i = 0;
+#ifdef BRICKSIM_TOKENIZER_SIMD
+            for (; i + SIMD_WIDTH <= line.size(); i += SIMD_WIDTH) {
+                const uint64_t bits = equalMask16(line.data() + i, ' ', '\t');
+                auto& word = mask[i / 64];
+                const auto shift = i % 64;
+                word = (word & ~(0xffffull << shift)) | (bits << shift);
+            }
+#endif
+            for (; i < line.size(); ++i) {
+                if (!isWhitespace(line[i])) {
+                    mask[i / 64] &= ~(1ull << (i % 64));
+                }
+            }
+        }
+
+        /**
+         * @param whitespace true to search the next whitespace position, false to search the next non-whitespace position
+         * @return position or MAX_MASK_LENGTH if there's none
+         */
+        std::size_t findNext(const std::array<uint64_t, MAX_MASK_WORDS>& mask, const std::size_t from, const bool whitespace) {
+            for (std::size_t wordIndex = from / 64; wordIndex < MAX_MASK_WORDS; ++wordIndex) {
+                uint64_t word = whitespace ? mask[wordIndex] : ~mask[wordIndex];
+                if (wordIndex == from / 64) {
+                    word &= ~0ull << (from % 64);
+                }
+                if (word != 0) {
+                    return wordIndex * 64 + std::countr_zero(word);
+                }
+            }
+            return MAX_MASK_LENGTH;
+        }
+
+        std::size_t parseColorAndNumbersScalar(const std::string_view line, int& color, float* numbers, const std::size_t count) {
+            std::size_t end = 0;
+            for (std::size_t i = 0; i <= count; ++i) {
+                std::size_t start = end;
+                while (start < line.size() && isWhitespace(line[start])) {
+                    ++start;
+                }
+                end = start;
+                while (end < line.size() && !isWhitespace(line[end])) {
+                    ++end;
+                }
+                if (i == 0) {
+                    fast_float::from_chars(line.data() + start, line.data() + end, color);
+                } else {
+                    fast_float::from_chars(line.data() + start, line.data() + end, numbers[i - 1]);
+                }
+            }
+            return end;
+        }
+    }
+
+    std::size_t findLineEnd(const std::string_view content, std::size_t start) {
+#ifdef BRICKSIM_TOKENIZER_SIMD
+        for (; start + SIMD_WIDTH <= content.size(); start += SIMD_WIDTH) {
+            const auto bits = equalMask16(content.data() + start, '\r', '\n');
+            if (bits != 0) {
+                return start + std::countr_zero(bits);
+            }
+        }
+#endif
+        while (start < content.size() && !isLineEnd(content[start])) {
+            ++start;
+        }
+        return start;
+    }
+
+    std::size_t parseColorAndNumbers(const std::string_view line, int& color, float* numbers, const std::size_t count) {
+        std::fill(numbers, numbers + count, 0.f);
+        if (line.size() >= MAX_MASK_LENGTH) {
+            return parseColorAndNumbersScalar(line, color, numbers, count);
+        }
+
+        std::array<uint64_t, MAX_MASK_WORDS> mask;// NOLINT(cppcoreguidelines-pro-type-member-init)
+        buildWhitespaceMask(line, mask);
+
+        std::size_t end = 0;
+        for (std::size_t i = 0; i <= count; ++i) {
+            const auto start = std::min(findNext(mask, end, false), line.size());
+            end = std::min(findNext(mask, start, true), line.size());
+            if (i == 0) {
+                fast_float::from_chars(line.data() + start, line.data() + end, color);
+            } else {
+                fast_float::from_chars(line.data() + start, line.data() + end, numbers[i - 1]);
+            }
+        }
+        return end;
+    }
+}
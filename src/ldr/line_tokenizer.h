@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace bricksim::ldr::tokenizer {
+    /**
+     * @return the index of the first '\r' or '\n' at or after start, or content.size() if there is none.
+     * checks 16 bytes at once if SIMD is available
+     */
+    std::size_t findLineEnd(std::string_view content, std::size_t start);
+
+    /**
+     * calls function(std::string_view line) for every line in content. the line terminators are not included
+     */
+    template<typename F>
+    void forEachLine(std::string_view content, F&& function) {
+        std::size_t lineStart = 0;
+        while (lineStart < content.size()) {
+            const auto lineEnd = findLineEnd(content, lineStart);
+            function(content.substr(lineStart, lineEnd - lineStart));
+            lineStart = lineEnd + 1;
+        }
+    }
+
+    /**
+     * parses "<color> <number> <number> ..." as it appears after the line type in LDraw lines 1 to 5.
+     * the whitespace positions of the whole line are computed with SIMD first, then every token is passed to fast_float
+     * @param numbers is filled with count floats in the order they appear in the line. missing numbers are set to 0
+     * @return the index in line directly after the last number
+     */
+    std::size_t parseColorAndNumbers(std::string_view line, int& color, float* numbers, std::size_t count);
+}
@@ -1,4 +1,7 @@
 #include "regular_file_repo.h"
+#include "file_header_scanner.h"
+#include <array>
+#include <fstream>
 #include <spdlog/spdlog.h>
 
 namespace bricksim::ldr::file_repo {
@@ -37,6 +40,21 @@ namespace bricksim::ldr::file_repo {
         return util::readFileToString(basePath / nameRelativeToRoot);
     }
 
+    FileMetaInfo RegularFileRepo::scanLibraryLdrFileHeader(const std::string& nameRelativeToRoot, FileType type) {
+        FileHeaderScanner scanner(type);
+        std::ifstream stream(basePath / nameRelativeToRoot, std::ios::binary);
+        std::array<char, 4096> buffer;// NOLINT(cppcoreguidelines-pro-type-member-init)
+        while (stream) {
+            stream.read(buffer.data(), buffer.size());
+            const auto readBytes = static_cast<std::size_t>(stream.gcount());
+            if (readBytes == 0 || !scanner.addData(std::string_view(buffer.data(), readBytes))) {
+                break;
+            }
+        }
+        scanner.finish();
+        return std::move(scanner.getMetaInfo());
+    }
+
     RegularFileRepo::~RegularFileRepo() = default;
 
     RegularFileRepo::RegularFileRepo(const std::filesystem::path& basePath) :
@@ -49,6 +67,20 @@ namespace bricksim::ldr::file_repo {
     std::shared_ptr<BinaryFile> RegularFileRepo::getLibraryBinaryFileContent(const std::string& nameRelativeToRoot) {
         return std::make_shared<BinaryFile>(basePath / nameRelativeToRoot);
     }
+
+    uint64_t RegularFileRepo::getLibraryFileFingerprint(const std::string& nameRelativeToRoot) {
+        std::error_code ec;
+        const auto path = basePath / nameRelativeToRoot;
+        const auto lastWriteTime = std::filesystem::last_write_time(path, ec);
+        if (ec) {
+            return 0;
+        }
+        const auto fileSize = std::filesystem::file_size(path, ec);
+        if (ec) {
+            return 0;
+        }
+        return static_cast<uint64_t>(lastWriteTime.time_since_epoch().count()) * 31 + fileSize;
+    }
     void RegularFileRepo::updateLibraryFilesImpl(const std::filesystem::path& updatedFileDirectory, std::function<void(int)> progress) {
         std::filesystem::copy(updatedFileDirectory, basePath, std::filesystem::copy_options::update_existing|std::filesystem::copy_options::recursive);
     }
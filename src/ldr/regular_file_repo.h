@@ -12,6 +12,8 @@ namespace bricksim::ldr::file_repo {
         std::string getLibraryLdrFileContent(ldr::FileType type, const std::string& name) override;
         std::string getLibraryLdrFileContent(const std::string& nameRelativeToRoot) override;
         std::shared_ptr<BinaryFile> getLibraryBinaryFileContent(const std::string& nameRelativeToRoot) override;
+        FileMetaInfo scanLibraryLdrFileHeader(const std::string& nameRelativeToRoot, FileType type) override;
+        uint64_t getLibraryFileFingerprint(const std::string& nameRelativeToRoot) override;
         bool replaceLibraryFilesDirectlyFromZip() override;
 
     protected:
@@ -46,10 +46,7 @@ namespace bricksim::ldr::file_repo {
     }
 
     ZipShadowFileRepo::ZipShadowFileRepo(const std::filesystem::path& basePath) :
-        ShadowFileRepo(basePath) {
-        int err;
-        archive = zip_open(basePath.string().c_str(), ZIP_RDONLY, &err);
-    }
+        ShadowFileRepo(basePath), archivePool(basePath) {}
 
     bool ZipShadowFileRepo::isValidZip(const std::filesystem::path& candidatePath) {
         int err;
@@ -57,26 +54,11 @@ namespace bricksim::ldr::file_repo {
     }
 
     std::optional<std::string> ZipShadowFileRepo::getContent(const std::string& pathRelativeToBase) {
-        std::scoped_lock<std::mutex> lg(libzipLock);
-        struct zip_stat stat{};
-        auto found = zip_stat(archive, pathRelativeToBase.c_str(), 0, &stat);
-        if (found == -1) {
-            found = zip_stat(archive, pathRelativeToBase.c_str(), ZIP_FL_NOCASE, &stat);
-        }
-        if (found == -1) {
+        //most library files don't have a shadow file
+        if (!archivePool.locate(pathRelativeToBase).has_value()) {
             return {};
         }
-        zip_file_t* file = zip_fopen_index(archive, stat.index, 0);
-        std::string result;
-        result.resize(stat.size);
-        const uint64_t readBytes = zip_fread(file, &result[0], stat.size);
-        if (readBytes != stat.size) {
-            spdlog::warn("file {} in zip shadow library has reported size of {} bytes, but only {} bytes read.", pathRelativeToBase, stat.size, readBytes);
-            result.resize(std::max(static_cast<decltype(readBytes)>(0), readBytes));
-        }
-
-        zip_fclose(file);
-        return result;
+        return archivePool.readString(pathRelativeToBase);
     }
 
     EmptyShadowFileRepo::EmptyShadowFileRepo() :
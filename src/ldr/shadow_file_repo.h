@@ -1,6 +1,7 @@
 #pragma once
 
 #include "zip.h"
+#include "zip_archive_pool.h"
 #include <filesystem>
 #include <mutex>
 #include <optional>
@@ -27,8 +28,7 @@ namespace bricksim::ldr::file_repo {
         std::optional<std::string> getContent(const std::string& pathRelativeToBase) override;
 
     private:
-        zip_t* archive;
-        std::mutex libzipLock;
+        ZipArchivePool archivePool;
     };
 
     class EmptyShadowFileRepo : public ShadowFileRepo {
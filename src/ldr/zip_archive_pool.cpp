@@ -0,0 +1,228 @@
+#include "zip_archive_pool.h"
+#include "../helpers/stringutil.h"
+#include <algorithm>
+#include <array>
+#include <spdlog/spdlog.h>
+#include <thread>
+
+namespace bricksim::ldr::file_repo {
+    namespace {
+        ///the header of a library file is almost always shorter than this
+        constexpr std::size_t READ_CHUNK_SIZE = 4096;
+    }
+
+    ZipArchivePool::ZipArchivePool(std::filesystem::path path) :
+        path(std::move(path)),
+        maxHandleCount(std::max(1u, std::thread::hardware_concurrency())) {
+        buildIndex();
+    }
+
+    ZipArchivePool::~ZipArchivePool() {
+        closeAllHandles();
+    }
+
+    zip_t* ZipArchivePool::openHandle() {
+        int errorCode;
+        zip_t* archive = zip_open(path.string().c_str(), ZIP_RDONLY, &errorCode);
+        if (archive == nullptr) {
+            zip_error_t zipError;
+            zip_error_init_with_code(&zipError, errorCode);
+            spdlog::error("can't open zip file {}: {} {}", path.string(), errorCode, zip_error_strerror(&zipError));
+            zip_error_fini(&zipError);
+        }
+        return archive;
+    }
+
+    void ZipArchivePool::buildIndex() {
+        indexByName.clear();
+        indexByLowerName.clear();
+        zip_t* archive = openHandle();
+        valid = archive != nullptr;
+        if (!valid) {
+            return;
+        }
+        const auto numEntries = zip_get_num_entries(archive, 0);
+        indexByName.reserve(numEntries);
+        indexByLowerName.reserve(numEntries);
+        for (zip_int64_t i = 0; i < numEntries; ++i) {
+            const char* name = zip_get_name(archive, i, ZIP_FL_ENC_GUESS);
+            if (name == nullptr) {
+                continue;
+            }
+            const std::string nameString(name);
+            indexByLowerName.emplace(stringutil::asLower(nameString), i);
+            indexByName.emplace(nameString, i);
+        }
+        std::scoped_lock<std::mutex> lg(handlesMtx);
+        idleHandles.push_back(archive);
+        ++openHandleCount;
+    }
+
+    void ZipArchivePool::closeAllHandles() {
+        std::scoped_lock<std::mutex> lg(handlesMtx);
+        //all reads hold reopenMtx, so every open handle is idle now
+        for (auto* archive: idleHandles) {
+            zip_discard(archive);
+        }
+        idleHandles.clear();
+        openHandleCount = 0;
+    }
+
+    void ZipArchivePool::modify(const std::function<void()>& modification) {
+        std::unique_lock<std::shared_mutex> lock(reopenMtx);
+        closeAllHandles();
+        modification();
+        buildIndex();
+    }
+
+    void ZipArchivePool::reopen() {
+        modify([]() {});
+    }
+
+    bool ZipArchivePool::isValid() const {
+        std::shared_lock<std::shared_mutex> lock(reopenMtx);
+        return valid;
+    }
+
+    std::optional<zip_uint64_t> ZipArchivePool::locate(const std::string& name) const {
+        std::shared_lock<std::shared_mutex> lock(reopenMtx);
+        return locateUnlocked(name);
+    }
+
+    std::optional<zip_uint64_t> ZipArchivePool::locateUnlocked(const std::string& name) const {
+        if (const auto it = indexByName.find(name); it != indexByName.end()) {
+            return it->second;
+        }
+        if (const auto it = indexByLowerName.find(stringutil::asLower(name)); it != indexByLowerName.end()) {
+            return it->second;
+        }
+        return std::nullopt;
+    }
+
+    std::optional<struct zip_stat> ZipArchivePool::stat(const std::string& name) {
+        std::shared_lock<std::shared_mutex> lock(reopenMtx);
+        const auto index = locateUnlocked(name);
+        if (!index.has_value()) {
+            return std::nullopt;
+        }
+        Lease lease(*this);
+        if (lease.get() == nullptr) {
+            return std::nullopt;
+        }
+        struct zip_stat result{};
+        if (zip_stat_index(lease.get(), *index, 0, &result) != 0) {
+            return std::nullopt;
+        }
+        return result;
+    }
+
+    template<typename T>
+    std::optional<T> ZipArchivePool::read(const std::string& name) {
+        std::shared_lock<std::shared_mutex> lock(reopenMtx);
+        const auto index = locateUnlocked(name);
+        if (!index.has_value()) {
+            spdlog::error("file {} not found in {}", name, path.string());
+            return std::nullopt;
+        }
+        Lease lease(*this);
+        if (lease.get() == nullptr) {
+            return std::nullopt;
+        }
+        struct zip_stat stat{};
+        if (zip_stat_index(lease.get(), *index, 0, &stat) != 0 || (stat.valid & ZIP_STAT_SIZE) == 0) {
+            throw std::invalid_argument(fmt::format("cannot stat file {} in {}: {}", name, path.string(), zip_error_strerror(zip_get_error(lease.get()))));
+        }
+        zip_file_t* file = zip_fopen_index(lease.get(), *index, 0);
+        if (file == nullptr) {
+            spdlog::error("failed to open file {} in {}: {}", name, path.string(), zip_error_strerror(zip_get_error(lease.get())));
+            return std::nullopt;
+        }
+
+        T result;
+        result.resize(stat.size);
+        const zip_int64_t readBytes = zip_fread(file, result.data(), stat.size);
+        if (readBytes < 0 || static_cast<zip_uint64_t>(readBytes) != stat.size) {
+            spdlog::warn("file {} in {} has reported size of {} bytes, but only {} bytes read. error={}", name, path.string(), stat.size, readBytes, zip_error_strerror(zip_file_get_error(file)));
+            result.resize(std::max<zip_int64_t>(0, readBytes));
+        }
+        zip_fclose(file);
+        return result;
+    }
+
+    std::optional<std::string> ZipArchivePool::readString(const std::string& name) {
+        return read<std::string>(name);
+    }
+
+    std::optional<std::vector<uint8_t>> ZipArchivePool::readBytes(const std::string& name) {
+        return read<std::vector<uint8_t>>(name);
+    }
+
+    bool ZipArchivePool::readChunks(const std::string& name, const std::function<bool(std::string_view)>& consumer) {
+        std::shared_lock<std::shared_mutex> lock(reopenMtx);
+        const auto index = locateUnlocked(name);
+        if (!index.has_value()) {
+            spdlog::error("file {} not found in {}", name, path.string());
+            return false;
+        }
+        Lease lease(*this);
+        if (lease.get() == nullptr) {
+            return false;
+        }
+        zip_file_t* file = zip_fopen_index(lease.get(), *index, 0);
+        if (file == nullptr) {
+            spdlog::error("failed to open file {} in {}: {}", name, path.string(), zip_error_strerror(zip_get_error(lease.get())));
+            return false;
+        }
+        std::array<char, READ_CHUNK_SIZE> buffer;// NOLINT(cppcoreguidelines-pro-type-member-init)
+        bool success = true;
+        while (true) {
+            const zip_int64_t readBytes = zip_fread(file, buffer.data(), buffer.size());
+            if (readBytes < 0) {
+                spdlog::warn("failed to read file {} in {}: {}", name, path.string(), zip_error_strerror(zip_file_get_error(file)));
+                success = false;
+                break;
+            }
+            if (readBytes == 0 || !consumer(std::string_view(buffer.data(), static_cast<std::size_t>(readBytes)))) {
+                break;
+            }
+        }
+        zip_fclose(file);
+        return success;
+    }
+
+    ZipArchivePool::Lease::Lease(ZipArchivePool& pool) :
+        pool(pool), archive(nullptr) {
+        std::unique_lock<std::mutex> lock(pool.handlesMtx);
+        pool.handleReturned.wait(lock, [&pool]() {
+            return !pool.idleHandles.empty() || pool.openHandleCount < pool.maxHandleCount;
+        });
+        if (!pool.idleHandles.empty()) {
+            archive = pool.idleHandles.back();
+            pool.idleHandles.pop_back();
+            return;
+        }
+        ++pool.openHandleCount;
+        lock.unlock();
+        //opening reads the central directory, don't block the other threads meanwhile
+        archive = pool.openHandle();
+        if (archive == nullptr) {
+            lock.lock();
+            --pool.openHandleCount;
+            pool.handleReturned.notify_one();
+        }
+    }
+
+    ZipArchivePool::Lease::~Lease() {
+        if (archive != nullptr) {
+            {
+                std::scoped_lock<std::mutex> lg(pool.handlesMtx);
+                pool.idleHandles.push_back(archive);
+            }
+            pool.handleReturned.notify_one();
+        }
+    }
+
+    zip_t* ZipArchivePool::Lease::get() const {
+        return archive;
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "../types.h"
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <vector>
+#include <zip.h>
+
+namespace bricksim::ldr::file_repo {
+    /**
+     * Read-only access to a zip file from multiple threads at the same time.
+     * A libzip handle can only be used by one thread, so this class opens up to one handle per core and hands them out.
+     * The names of the entries are indexed once (case-sensitive and case-insensitive), so that looking up a name
+     * doesn't need a libzip handle and is not a linear search for case-insensitive matches.
+     * The content is inflated directly into the buffer which is returned to the caller.
+     */
+    class ZipArchivePool {
+    public:
+        explicit ZipArchivePool(std::filesystem::path path);
+        ZipArchivePool(const ZipArchivePool&) = delete;
+        ZipArchivePool& operator=(const ZipArchivePool&) = delete;
+        ~ZipArchivePool();
+
+        /**
+         * @param name full name of the entry inside the archive. first searched case-sensitive, then case-insensitive
+         * @return index of the entry or std::nullopt if there's no such entry
+         */
+        [[nodiscard]] std::optional<zip_uint64_t> locate(const std::string& name) const;
+        std::optional<struct zip_stat> stat(const std::string& name);
+        std::optional<std::string> readString(const std::string& name);
+        std::optional<std::vector<uint8_t>> readBytes(const std::string& name);
+        /**
+         * inflates the entry piece by piece and passes each piece to consumer until it returns false or the end is reached.
+         * the rest of the entry is not inflated, so this is cheaper than readString if only the beginning is needed
+         * @return false if the entry can't be read
+         */
+        bool readChunks(const std::string& name, const std::function<bool(std::string_view)>& consumer);
+
+        /**
+         * waits until the running reads are finished, closes all handles, calls modification and indexes the file again.
+         * reads which start meanwhile wait until this is done, so modification can safely replace the file
+         */
+        void modify(const std::function<void()>& modification);
+        /**
+         * like modify, for files which were changed by someone else
+         */
+        void reopen();
+
+        [[nodiscard]] bool isValid() const;
+
+    private:
+        class Lease {
+        public:
+            explicit Lease(ZipArchivePool& pool);
+            Lease(const Lease&) = delete;
+            Lease& operator=(const Lease&) = delete;
+            ~Lease();
+            [[nodiscard]] zip_t* get() const;
+
+        private:
+            ZipArchivePool& pool;
+            zip_t* archive;
+        };
+
+        std::filesystem::path path;
+        std::size_t maxHandleCount;
+
+        /**
+         * shared for the whole duration of a read (locate + lease), exclusive while the file is reopened.
+         * so there are no leased handles while the index and the handles are replaced
+         */
+        mutable std::shared_mutex reopenMtx;
+        bool valid = false;
+
+        std::mutex handlesMtx;
+        std::condition_variable handleReturned;
+        std::vector<zip_t*> idleHandles;
+        std::size_t openHandleCount = 0;
+
+        uomap_t<std::string, zip_uint64_t> indexByName;
+        uomap_t<std::string, zip_uint64_t> indexByLowerName;
+
+        zip_t* openHandle();
+        ///reopenMtx has to be locked exclusively (or no other thread may use the pool)
+        void closeAllHandles();
+        ///reopenMtx has to be locked exclusively (or no other thread may use the pool)
+        void buildIndex();
+        ///reopenMtx has to be locked
+        [[nodiscard]] std::optional<zip_uint64_t> locateUnlocked(const std::string& name) const;
+        template<typename T>
+        std::optional<T> read(const std::string& name);
+    };
+}
@@ -1,7 +1,8 @@
 #include "zip_file_repo.h"
+#include "file_header_scanner.h"
+#include <cstring>
 #include <fstream>
 #include <spdlog/spdlog.h>
-#include <zipint.h>
 
 namespace bricksim::ldr::file_repo {
     bool ZipFileRepo::isValidBasePath(const std::filesystem::path& basePath) {
@@ -61,6 +62,7 @@ namespace bricksim::ldr::file_repo {
             throw std::invalid_argument("invalid basePath: " + basePath.string());
         }
         openZipArchive();
+        readerPool = std::make_unique<ZipArchivePool>(basePath);
 
         if (zipArchive== nullptr) {
             return;
@@ -92,43 +94,16 @@ namespace bricksim::ldr::file_repo {
     }
 
     std::string ZipFileRepo::getLibraryLdrFileContent(const std::string& nameRelativeToRoot) {
-        std::scoped_lock<std::mutex> lg(libzipLock);
-        auto [stat, file] = openFileByName(nameRelativeToRoot);
-
-        if (file == nullptr) {
-            return "";
-        }
-
-        std::string result;
-        result.resize(stat.size);
-        const uint64_t readBytes = zip_fread(file, &result[0], stat.size);
-        if (readBytes != stat.size) {
-            spdlog::warn("file {} in zip library has reported size of {} bytes, but only {} bytes read. error={}", nameRelativeToRoot, stat.size, readBytes, zip_error_strerror(&file->error));
-            result.resize(std::max(static_cast<decltype(readBytes)>(0), readBytes));
-        }
-
-        zip_fclose(file);
-
-        return result;
+        return readerPool->readString(rootFolderName + nameRelativeToRoot).value_or("");
     }
 
-    std::pair<struct zip_stat, zip_file_t*> ZipFileRepo::openFileByName(const std::string& nameRelativeToRoot) {
-        struct zip_stat stat{};
-        std::string entryName = rootFolderName + nameRelativeToRoot;
-        //try to find it with case-sensitive first because it's faster
-        auto found = zip_stat(zipArchive, entryName.c_str(), 0, &stat);
-        if (found == -1) {
-            //if not found with exact case, try again with case-insensitive
-            found = zip_stat(zipArchive, entryName.c_str(), ZIP_FL_NOCASE, &stat);
-        }
-        if (found == -1) {
-            spdlog::error("file {} not found in zip library", entryName);
-        }
-        zip_file_t* file = zip_fopen_index(zipArchive, stat.index, 0);
-        if (file == nullptr) {
-            spdlog::error("failed to open file {} in zip library: {}", entryName, zip_error_strerror(zip_get_error(zipArchive)));
-        }
-        return std::make_pair(stat, file);
+    FileMetaInfo ZipFileRepo::scanLibraryLdrFileHeader(const std::string& nameRelativeToRoot, FileType type) {
+        FileHeaderScanner scanner(type);
+        readerPool->readChunks(rootFolderName + nameRelativeToRoot, [&scanner](std::string_view chunk) {
+            return scanner.addData(chunk);
+        });
+        scanner.finish();
+        return std::move(scanner.getMetaInfo());
     }
 
     std::string ZipFileRepo::getZipRootFolder(zip_t* archive) {
@@ -139,25 +114,23 @@ namespace bricksim::ldr::file_repo {
     }
 
     std::shared_ptr<BinaryFile> ZipFileRepo::getLibraryBinaryFileContent(const std::string& nameRelativeToRoot) {
-        std::scoped_lock<std::mutex> lg(libzipLock);
-        auto [stat, file] = openFileByName(nameRelativeToRoot);
-        if (file == nullptr) {
+        auto data = readerPool->readBytes(rootFolderName + nameRelativeToRoot);
+        if (!data.has_value()) {
             return nullptr;
         }
-
         auto result = std::make_shared<BinaryFile>(nameRelativeToRoot);
-        result->data.resize(stat.size);
-        const uint64_t readBytes = zip_fread(file, &result->data[0], stat.size);
-        if (readBytes != stat.size) {
-            spdlog::warn("file {} in zip library has reported size of {} bytes, but only {} bytes read", nameRelativeToRoot, stat.size, readBytes);
-            result->data.resize(std::max(static_cast<decltype(readBytes)>(0), readBytes));
-        }
-
-        zip_fclose(file);
-
+        result->data = std::move(*data);
         return result;
     }
 
+    uint64_t ZipFileRepo::getLibraryFileFingerprint(const std::string& nameRelativeToRoot) {
+        const auto stat = readerPool->stat(rootFolderName + nameRelativeToRoot);
+        if (!stat.has_value() || (stat->valid & ZIP_STAT_CRC) == 0 || (stat->valid & ZIP_STAT_SIZE) == 0) {
+            return 0;
+        }
+        return static_cast<uint64_t>(stat->crc) << 32 | (stat->size & 0xffffffff);
+    }
+
     void ZipFileRepo::updateLibraryFilesImpl(const std::filesystem::path& updatedFileDirectory, std::function<void(int)> progress) {
         std::scoped_lock<std::mutex> lg(libzipLock);
         int currentFileNr = 0;
@@ -187,8 +160,10 @@ namespace bricksim::ldr::file_repo {
 
             progress(currentFileNr++);
         }
-        closeZipArchive();
-        openZipArchive();
+        readerPool->modify([this]() {
+            closeZipArchive();
+            openZipArchive();
+        });
     }
     bool ZipFileRepo::replaceLibraryFilesDirectlyFromZip() {
         return true;
@@ -197,8 +172,10 @@ namespace bricksim::ldr::file_repo {
         if (!std::filesystem::is_regular_file(replacementFileOrDirectory)) {
             throw std::invalid_argument("replacement file is not a regular file");
         }
-        closeZipArchive();
-        std::filesystem::copy(replacementFileOrDirectory, basePath, std::filesystem::copy_options::overwrite_existing);
-        openZipArchive();
+        readerPool->modify([this, &replacementFileOrDirectory]() {
+            closeZipArchive();
+            std::filesystem::copy(replacementFileOrDirectory, basePath, std::filesystem::copy_options::overwrite_existing);
+            openZipArchive();
+        });
     }
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "file_repo.h"
+#include "zip_archive_pool.h"
 #include <mutex>
 #include <zip.h>
 
@@ -14,6 +15,8 @@ namespace bricksim::ldr::file_repo {
         std::string getLibraryLdrFileContent(ldr::FileType type, const std::string& name) override;
         std::string getLibraryLdrFileContent(const std::string& nameRelativeToRoot) override;
         std::shared_ptr<BinaryFile> getLibraryBinaryFileContent(const std::string& nameRelativeToRoot) override;
+        FileMetaInfo scanLibraryLdrFileHeader(const std::string& nameRelativeToRoot, FileType type) override;
+        uint64_t getLibraryFileFingerprint(const std::string& nameRelativeToRoot) override;
         bool replaceLibraryFilesDirectlyFromZip() override;
 
     protected:
@@ -21,11 +24,13 @@ namespace bricksim::ldr::file_repo {
         void replaceLibraryFilesImpl(const std::filesystem::path& replacementFileOrDirectory, std::function<void(int)> progress) override;
 
     private:
+        ///used for listing and modifying the archive
         struct zip* zipArchive;
         std::string rootFolderName;
         std::mutex libzipLock;
+        ///used for reading the content of files, allows parallel reading
+        std::unique_ptr<ZipArchivePool> readerPool;
         static std::string getZipRootFolder(zip_t* archive);//including / at the end
-        std::pair<struct zip_stat, zip_file_t*> openFileByName(const std::string& nameRelativeToRoot);
         void openZipArchive();
         void closeZipArchive() const;
     };
@@ -9,6 +9,11 @@ namespace bricksim::metrics {
     std::vector<std::pair<std::string, float>> lastWindowDrawingTimesUs = {};
     float lastSceneRenderTimeMs;
     size_t memorySavedByDeletingVertexData = 0;
+    size_t vramSavedByMeshOptimization = 0;
+    std::atomic<size_t> ldrElementArenaBytes = 0;
+    std::atomic<size_t> flattenedGeometryCacheBytes = 0;
+    std::atomic<size_t> pickingBvhBytes = 0;
+    float lastPickTimeMs = 0;
     #ifndef NDEBUG
     //std::mutex ldrFileElementInstanceCountMtx;
     size_t ldrFileElementInstanceCount = 0;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <vector>
 
@@ -16,6 +17,11 @@ namespace bricksim::metrics {
     extern std::vector<std::pair<std::string, float>> lastWindowDrawingTimesUs;
     extern float lastSceneRenderTimeMs;
     extern size_t memorySavedByDeletingVertexData;
+    extern size_t vramSavedByMeshOptimization;
+    extern std::atomic<size_t> ldrElementArenaBytes;
+    extern std::atomic<size_t> flattenedGeometryCacheBytes;
+    extern std::atomic<size_t> pickingBvhBytes;
+    extern float lastPickTimeMs;
     #ifndef NDEBUG
     inline std::mutex ldrFileElementInstanceCountMtx;
     extern size_t ldrFileElementInstanceCount;
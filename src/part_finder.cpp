@@ -1,10 +1,56 @@
 #include "part_finder.h"
 #include "helpers/stringutil.h"
 #include "helpers/util.h"
+#include "ldr/file_repo.h"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <palanteer.h>
+#include <spdlog/spdlog.h>
 
 namespace bricksim::part_finder {
     namespace {
         uomap_t<std::string, Predicate> predicates;
+
+        std::shared_ptr<const SearchIndex> searchIndex;
+        std::mutex searchIndexMtx;
+
+        constexpr char FIELD_SEPARATOR = '\n';
+
+        bool isWordSeparator(char c) {
+            switch (c) {
+                case FIELD_SEPARATOR:
+                case ' ':
+                case '\t':
+                case ',':
+                case ';':
+                case '(':
+                case ')':
+                case '[':
+                case ']':
+                case '/':
+                case '\\':
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        uint32_t getTrigram(const char* chars) {
+            return static_cast<uint32_t>(static_cast<unsigned char>(chars[0])) << 16
+                   | static_cast<uint32_t>(static_cast<unsigned char>(chars[1])) << 8
+                   | static_cast<uint32_t>(static_cast<unsigned char>(chars[2]));
+        }
+
+        ///both vectors have to be sorted
+        template<typename T>
+        void intersect(std::vector<T>& inOut, const std::vector<T>& other) {
+            std::vector<T> result;
+            std::set_intersection(inOut.cbegin(), inOut.cend(), other.cbegin(), other.cend(), std::back_inserter(result));
+            inOut = std::move(result);
+        }
     }
 
     const Predicate& getPredicate(const std::string& expression) {
@@ -29,4 +75,221 @@ namespace bricksim::part_finder {
                 || stringutil::containsIgnoreCase(part.metaInfo.theme, expression)
                 || std::any_of(part.metaInfo.keywords.begin(), part.metaInfo.keywords.end(), [this](const auto& keyword) { return stringutil::containsIgnoreCase(keyword, expression); }));
     }
+
+    SearchIndex::SearchIndex(const std::vector<db::fileList::Entry>& entries) {
+        documents.reserve(entries.size());
+        for (const auto& entry: entries) {
+            if (entry.category == ldr::file_repo::PSEUDO_CATEGORY_BINARY_FILE) {
+                continue;
+            }
+            const auto categoryId = categoryIds.emplace(entry.category, static_cast<uint32_t>(categoryIds.size())).first->second;
+            auto text = stringutil::asLower(entry.name);
+            text += FIELD_SEPARATOR;
+            text += stringutil::asLower(entry.title);
+            text += FIELD_SEPARATOR;
+            text += stringutil::asLower(entry.keywords);
+            documents.push_back({entry.name,
+                                 std::move(text),
+                                 static_cast<uint32_t>(entry.name.size()),
+                                 static_cast<uint32_t>(entry.title.size()),
+                                 categoryId});
+        }
+        //results with the same score are sorted by doc id, that should be the same as sorting by name
+        std::sort(documents.begin(), documents.end(), [](const auto& a, const auto& b) { return a.name < b.name; });
+        documentsByCategory.resize(categoryIds.size());
+        for (doc_id_t docId = 0; docId < documents.size(); ++docId) {
+            documentsByCategory[documents[docId].categoryId].push_back(docId);
+        }
+
+        uomap_t<std::string, std::vector<doc_id_t>> documentsByWord;
+        for (doc_id_t docId = 0; docId < documents.size(); ++docId) {
+            const auto& text = documents[docId].text;
+            for (std::size_t i = 0; i + 3 <= text.size(); ++i) {
+                if (text[i] == FIELD_SEPARATOR || text[i + 1] == FIELD_SEPARATOR || text[i + 2] == FIELD_SEPARATOR) {
+                    continue;
+                }
+                auto& postings = trigrams[getTrigram(&text[i])];
+                //doc ids are added in ascending order, so the list stays sorted
+                if (postings.empty() || postings.back() != docId) {
+                    postings.push_back(docId);
+                }
+            }
+            std::size_t wordStart = 0;
+            for (std::size_t i = 0; i <= text.size(); ++i) {
+                if (i == text.size() || isWordSeparator(text[i])) {
+                    if (i > wordStart) {
+                        auto& postings = documentsByWord[text.substr(wordStart, i - wordStart)];
+                        if (postings.empty() || postings.back() != docId) {
+                            postings.push_back(docId);
+                        }
+                    }
+                    wordStart = i + 1;
+                }
+            }
+        }
+        words.reserve(documentsByWord.size());
+        for (auto& [text, wordDocuments]: documentsByWord) {
+            words.push_back({text, std::move(wordDocuments)});
+        }
+        std::sort(words.begin(), words.end(), [](const auto& a, const auto& b) { return a.text < b.text; });
+    }
+
+    std::vector<SearchIndex::doc_id_t> SearchIndex::findCandidates(std::string_view token) const {
+        std::vector<doc_id_t> result;
+        if (token.size() < MIN_TRIGRAM_TOKEN_LENGTH) {
+            auto it = std::lower_bound(words.cbegin(), words.cend(), token, [](const auto& word, std::string_view value) { return std::string_view(word.text) < value; });
+            if (it == words.cend() || !it->text.starts_with(token)) {
+                return result;
+            }
+            if (std::next(it) == words.cend() || !std::next(it)->text.starts_with(token)) {
+                return it->documents;
+            }
+            //union of the lists of all words with this prefix
+            std::vector<bool> found(documents.size());
+            for (; it != words.cend() && it->text.starts_with(token); ++it) {
+                for (const auto docId: it->documents) {
+                    found[docId] = true;
+                }
+            }
+            for (doc_id_t docId = 0; docId < documents.size(); ++docId) {
+                if (found[docId]) {
+                    result.push_back(docId);
+                }
+            }
+            return result;
+        }
+
+        //start with the rarest trigram so that the intersections stay small
+        std::vector<const std::vector<doc_id_t>*> postingLists;
+        for (std::size_t i = 0; i + 3 <= token.size(); ++i) {
+            const auto it = trigrams.find(getTrigram(&token[i]));
+            if (it == trigrams.end()) {
+                return {};
+            }
+            postingLists.push_back(&it->second);
+        }
+        std::sort(postingLists.begin(), postingLists.end(), [](const auto* a, const auto* b) { return a->size() < b->size(); });
+        result = *postingLists[0];
+        for (std::size_t i = 1; i < postingLists.size() && !result.empty(); ++i) {
+            intersect(result, *postingLists[i]);
+        }
+        return result;
+    }
+
+    std::optional<float> SearchIndex::getScore(const Document& document, const std::vector<std::string_view>& tokens) {
+        float score = 0.f;
+        for (const auto& token: tokens) {
+            float bestTokenScore = 0.f;
+            for (auto pos = document.text.find(token); pos != std::string::npos; pos = document.text.find(token, pos + 1)) {
+                float tokenScore = 1.f;
+                const bool wordStart = pos == 0 || isWordSeparator(document.text[pos - 1]);
+                if (!wordStart && token.size() < MIN_TRIGRAM_TOKEN_LENGTH) {
+                    continue;
+                }
+                const bool wordEnd = pos + token.size() == document.text.size() || isWordSeparator(document.text[pos + token.size()]);
+                if (wordStart) {
+                    tokenScore += 1.f;
+                    if (wordEnd) {
+                        tokenScore += 1.f;
+                    }
+                }
+                if (pos < document.nameLength) {
+                    tokenScore += 2.f;
+                }
+                bestTokenScore = std::max(bestTokenScore, tokenScore);
+            }
+            if (bestTokenScore == 0.f) {
+                //the document contains all trigrams of the token, but not the token itself
+                return std::nullopt;
+            }
+            score += bestTokenScore;
+        }
+        //"Brick 2 x 4" is a better match for "brick 2 x 4" than "Brick 2 x 4 with Pins"
+        return score - .001f * static_cast<float>(document.titleLength);
+    }
+
+    std::vector<std::string> SearchIndex::search(std::string_view query, const std::string& category, std::size_t maxResults) const {
+        plFunction();
+        std::optional<uint32_t> categoryId;
+        if (!category.empty()) {
+            const auto it = categoryIds.find(category);
+            if (it == categoryIds.end()) {
+                return {};
+            }
+            categoryId = it->second;
+        }
+
+        const auto lowerQuery = stringutil::asLower(query);
+        std::vector<std::string_view> tokens;
+        std::size_t tokenStart = 0;
+        for (std::size_t i = 0; i <= lowerQuery.size(); ++i) {
+            if (i == lowerQuery.size() || lowerQuery[i] == ' ' || lowerQuery[i] == '\t') {
+                if (i > tokenStart) {
+                    tokens.emplace_back(lowerQuery.data() + tokenStart, i - tokenStart);
+                }
+                tokenStart = i + 1;
+            }
+        }
+        //the longest tokens usually have the fewest matches
+        std::sort(tokens.begin(), tokens.end(), [](const auto& a, const auto& b) { return a.size() > b.size(); });
+
+        //short tokens are only looked up in the word list if there's nothing else to start with, otherwise they're just checked in getScore
+        std::optional<std::vector<doc_id_t>> candidates;
+        if (categoryId.has_value()) {
+            candidates = documentsByCategory[*categoryId];
+        }
+        for (const auto& token: tokens) {
+            if (candidates.has_value() && (candidates->empty() || token.size() < MIN_TRIGRAM_TOKEN_LENGTH)) {
+                break;
+            }
+            if (candidates.has_value()) {
+                intersect(*candidates, findCandidates(token));
+            } else {
+                candidates = findCandidates(token);
+            }
+        }
+        if (!candidates.has_value()) {
+            candidates.emplace(documents.size());
+            std::iota(candidates->begin(), candidates->end(), 0);
+        }
+
+        std::vector<std::pair<float, doc_id_t>> ranked;
+        ranked.reserve(candidates->size());
+        for (const auto docId: *candidates) {
+            if (const auto score = getScore(documents[docId], tokens); score.has_value()) {
+                ranked.emplace_back(*score, docId);
+            }
+        }
+        const auto resultCount = std::min(maxResults, ranked.size());
+        const auto compare = [](const auto& a, const auto& b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        };
+        std::partial_sort(ranked.begin(), ranked.begin() + static_cast<std::ptrdiff_t>(resultCount), ranked.end(), compare);
+
+        std::vector<std::string> result;
+        result.reserve(resultCount);
+        for (std::size_t i = 0; i < resultCount; ++i) {
+            result.push_back(documents[ranked[i].second].name);
+        }
+        return result;
+    }
+
+    std::size_t SearchIndex::getDocumentCount() const {
+        return documents.size();
+    }
+
+    void rebuildSearchIndex() {
+        plFunction();
+        auto before = std::chrono::high_resolution_clock::now();
+        auto newIndex = std::make_shared<const SearchIndex>(db::fileList::getAllEntries());
+        auto after = std::chrono::high_resolution_clock::now();
+        spdlog::info("built part search index with {} files in {} ms", newIndex->getDocumentCount(), std::chrono::duration_cast<std::chrono::milliseconds>(after - before).count());
+        std::scoped_lock<std::mutex> lg(searchIndexMtx);
+        searchIndex = std::move(newIndex);
+    }
+
+    std::shared_ptr<const SearchIndex> getSearchIndex() {
+        std::scoped_lock<std::mutex> lg(searchIndexMtx);
+        return searchIndex;
+    }
 }
@@ -1,6 +1,10 @@
 #pragma once
 
+#include "db.h"
 #include "ldr/files.h"
+#include <limits>
+#include <memory>
+#include <optional>
 
 namespace bricksim::part_finder {
     class Predicate {
@@ -14,4 +18,66 @@ namespace bricksim::part_finder {
     };
 
     const Predicate& getPredicate(const std::string& expression);
+
+    /**
+     * In-memory full-text index over the name, title and keywords of all library files.
+     * It is built from the file list in the db, so no file has to be loaded for a search.
+     * Every whitespace separated token of a query has to match (case-insensitive).
+     * Tokens with at least 3 characters match anywhere in the text, the candidates are found with a trigram index.
+     * Shorter tokens match the beginning of a word.
+     */
+    class SearchIndex {
+    public:
+        explicit SearchIndex(const std::vector<db::fileList::Entry>& entries);
+        SearchIndex(const SearchIndex&) = delete;
+        SearchIndex& operator=(const SearchIndex&) = delete;
+
+        /**
+         * @param category only files of this category are returned if it is not empty
+         * @return the names of the matching files, best match first.
+         * matches in the name, at the beginning of words and whole words rank higher, shorter titles rank higher
+         */
+        [[nodiscard]] std::vector<std::string> search(std::string_view query, const std::string& category, std::size_t maxResults = std::numeric_limits<std::size_t>::max()) const;
+        [[nodiscard]] std::size_t getDocumentCount() const;
+
+    private:
+        using doc_id_t = uint32_t;
+        static constexpr std::size_t MIN_TRIGRAM_TOKEN_LENGTH = 3;
+
+        struct Document {
+            std::string name;
+            ///lowercase name, title and keywords, separated by '\n'
+            std::string text;
+            uint32_t nameLength;
+            uint32_t titleLength;
+            uint32_t categoryId;
+        };
+
+        std::vector<Document> documents;
+        uomap_t<std::string, uint32_t> categoryIds;
+        ///sorted doc ids of every category, the index is the category id
+        std::vector<std::vector<doc_id_t>> documentsByCategory;
+        ///sorted doc ids for every trigram which appears in a text
+        uomap_t<uint32_t, std::vector<doc_id_t>> trigrams;
+        struct Word {
+            std::string text;
+            std::vector<doc_id_t> documents;
+        };
+        ///all distinct words of all texts sorted by text, for the prefix search of short tokens
+        std::vector<Word> words;
+
+        /**
+         * @return sorted ids of the documents which can contain token. for long tokens these are only candidates which contain all trigrams of the token
+         */
+        [[nodiscard]] std::vector<doc_id_t> findCandidates(std::string_view token) const;
+        ///@return std::nullopt if one of the tokens doesn't appear in the document
+        [[nodiscard]] static std::optional<float> getScore(const Document& document, const std::vector<std::string_view>& tokens);
+    };
+
+    /**
+     * builds the index from the file list in the db. called by the FileRepo when the file list is ready
+     */
+    void rebuildSearchIndex();
+    ///@return the index or nullptr if it isn't built yet
+    std::shared_ptr<const SearchIndex> getSearchIndex();
 }
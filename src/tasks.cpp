@@ -3,27 +3,32 @@
 #include <spdlog/spdlog.h>
 
 namespace bricksim {
-    RunningTask::RunningTask(const std::function<void(float*)>& func, float* progress, const std::string& name) :
-        future(std::async(std::launch::async, [&name, progress, &func]() {
-            const auto plName = fmt::format("Tasks/", name);
-            util::setThreadName(plName.c_str());
-
+    RunningTask::RunningTask(std::function<void(float*)> func, float initialProgress, std::string name, thread_pool::Priority priority, bool ownThread) {
+        auto function = [name, func = std::move(func)](float* progress) {
             spdlog::debug("Task \"{}\" started", name);
-            const auto before = std::chrono::high_resolution_clock::now();
             func(progress);
-            const auto after = std::chrono::high_resolution_clock::now();
             spdlog::debug("Task \"{}\" finished", name);
-
-            *progress = 1.f;
-            return std::chrono::duration_cast<std::chrono::microseconds>(after - before);
-        })) {}
+        };
+        job = ownThread
+                  ? thread_pool::startOnOwnThread(std::move(function), priority, fmt::format("Tasks/{}", name), initialProgress)
+                  : thread_pool::submit(std::move(function), priority, initialProgress);
+    }
 
     bool RunningTask::isDone() const {
-        return future.wait_for(std::chrono::microseconds(0)) == std::future_status::ready;
+        return job->isDone();
     }
 
     std::chrono::microseconds RunningTask::finish() {
-        return future.get();
+        job->wait();
+        return job->getDuration();
+    }
+
+    void RunningTask::cancel() {
+        job->cancel();
+    }
+
+    const float* RunningTask::getProgressPtr() const {
+        return job->getProgressPtr();
     }
 
     Task::Task(std::string name, const std::function<void()>& taskFunctionNoProgress, bool autostart) :
@@ -48,8 +53,8 @@ namespace bricksim {
         return name;
     }
 
-    void Task::startThread() {
-        runningTask = std::make_optional<RunningTask>(function, &progress, name);
+    void Task::startThread(thread_pool::Priority priority, bool ownThread) {
+        runningTask = std::make_optional<RunningTask>(function, progress, name, priority, ownThread);
 
         if (!config::get().system.enableThreading) {
             joinThread();
@@ -66,6 +71,12 @@ namespace bricksim {
         }
     }
 
+    void Task::cancel() {
+        if (runningTask.has_value()) {
+            runningTask->cancel();
+        }
+    }
+
     bool Task::isStarted() const {
         return runningTask.has_value();
     }
@@ -75,11 +86,12 @@ namespace bricksim {
     }
 
     float Task::getProgress() const {
-        return progress;
+        return *getProgressPtr();
     }
 
     const float* Task::getProgressPtr() const {
-        return &progress;
+        //the job owns the progress while it runs, so the pointer stays valid when this Task is moved
+        return runningTask.has_value() ? runningTask->getProgressPtr() : &progress;
     }
 
     Task::Task(Task&& other) noexcept :
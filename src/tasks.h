@@ -1,18 +1,20 @@
 #pragma once
 
+#include "helpers/thread_pool.h"
 #include <functional>
 #include <optional>
 #include <string>
-#include <future>
 
 namespace bricksim {
     class RunningTask {
-        std::future<std::chrono::microseconds> future;
+        std::shared_ptr<thread_pool::Job> job;
 
     public:
         bool isDone() const;
         std::chrono::microseconds finish();
-        RunningTask(const std::function<void(float*)>& func, float* progress, const std::string& name);
+        void cancel();
+        [[nodiscard]] const float* getProgressPtr() const;
+        RunningTask(std::function<void(float*)> func, float initialProgress, std::string name, thread_pool::Priority priority, bool ownThread);
     };
 
     class Task {
@@ -27,8 +29,11 @@ namespace bricksim {
         [[nodiscard]] const std::string& getName() const;
         [[nodiscard]] float getProgress() const;
         [[nodiscard]] const float* getProgressPtr() const;
-        void startThread();
+        ///@param ownThread true for tasks which mostly wait for the network, they run on a new thread instead of the thread pool
+        void startThread(thread_pool::Priority priority = thread_pool::Priority::FOREGROUND, bool ownThread = false);
         void joinThread();
+        ///the task function can check this with thread_pool::isCurrentJobCancelled()
+        void cancel();
         [[nodiscard]] bool isStarted() const;
         [[nodiscard]] bool isDone() const;
 
@@ -0,0 +1,83 @@
+#include "../../connection/connector/clip.h"
+#include "../../connection/connector/cylindrical.h"
+#include "../../connection/connector/finger.h"
+#include "../../connection/connector/generic.h"
+#include "../../connection/connector_cache.h"
+#include "../testing_tools.h"
+
+using namespace bricksim::connection;
+
+namespace {
+    std::filesystem::path getCachePath() {
+        return std::filesystem::temp_directory_path() / "bricksim_test_connector_cache.bin";
+    }
+
+    connector_container_t createConnectors() {
+        return {
+                std::make_shared<CylindricalConnector>("stud", glm::vec3(0, -4, 0), glm::vec3(0, -1, 0), "3001.dat->stud.dat", Gender::M,
+                                                       std::vector<CylindricalShapePart>{{CylindricalShapeType::ROUND, false, 6.f, 4.f},
+                                                                                         {CylindricalShapeType::AXLE, true, 4.f, 2.f}},
+                                                       false, true, false),
+                std::make_shared<ClipConnector>("", glm::vec3(1, 2, 3), glm::vec3(1, 0, 0), "clip.dat", 4.f, 8.f, true, glm::vec3(0, 0, 1)),
+                std::make_shared<FingerConnector>("hinge", glm::vec3(0, 0, 0), glm::vec3(0, 0, 1), "finger.dat", Gender::F, 6.f, std::vector<float>{4.f, 8.f, 4.f}),
+                std::make_shared<GenericConnector>("", glm::vec3(5, 5, 5), glm::vec3(0, 1, 0), "gen.dat", Gender::M, BoundingCyl{3.f, 7.f}),
+                std::make_shared<GenericConnector>("", glm::vec3(5, 5, 5), glm::vec3(0, 1, 0), "gen.dat", Gender::F, BoundingBox{glm::vec3(1, 2, 3)}),
+        };
+    }
+
+    void checkEqual(const connector_container_t& actual, const connector_container_t& expected) {
+        REQUIRE(actual.size() == expected.size());
+        for (std::size_t i = 0; i < expected.size(); ++i) {
+            REQUIRE(actual[i]->type == expected[i]->type);
+            CHECK(actual[i]->sourceTrace == expected[i]->sourceTrace);
+            switch (expected[i]->type) {
+                case Connector::Type::CYLINDRICAL:
+                {
+                    const auto& a = *std::dynamic_pointer_cast<CylindricalConnector>(actual[i]);
+                    const auto& e = *std::dynamic_pointer_cast<CylindricalConnector>(expected[i]);
+                    CHECK(a == e);
+                    CHECK(a.totalLength == e.totalLength);
+                    break;
+                }
+                case Connector::Type::CLIP:
+                    CHECK(*std::dynamic_pointer_cast<ClipConnector>(actual[i]) == *std::dynamic_pointer_cast<ClipConnector>(expected[i]));
+                    break;
+                case Connector::Type::FINGER:
+                    CHECK(*std::dynamic_pointer_cast<FingerConnector>(actual[i]) == *std::dynamic_pointer_cast<FingerConnector>(expected[i]));
+                    break;
+                case Connector::Type::GENERIC:
+                    CHECK(*std::dynamic_pointer_cast<GenericConnector>(actual[i]) == *std::dynamic_pointer_cast<GenericConnector>(expected[i]));
+                    break;
+            }
+        }
+    }
+}
+
+TEST_CASE("connection::ConnectorCache roundtrip") {
+    const auto path = getCachePath();
+    std::filesystem::remove(path);
+    const auto original = createConnectors();
+    {
+        ConnectorCache cache(path, "2023-01");
+        cache.put("parts/3001.dat", 42, original);
+        cache.put("parts/3002.dat", 42, {});
+        const auto beforeSave = cache.read("parts/3001.dat", 42);
+        REQUIRE(beforeSave != nullptr);
+        checkEqual(*beforeSave, original);
+        cache.save();
+        CHECK(cache.getEntryCount() == 2);
+    }
+
+    ConnectorCache cache(path, "2023-01");
+    const auto cached = cache.read("parts/3001.dat", 42);
+    REQUIRE(cached != nullptr);
+    checkEqual(*cached, original);
+    //a part without connectors is cached too
+    const auto empty = cache.read("parts/3002.dat", 42);
+    REQUIRE(empty != nullptr);
+    CHECK(empty->empty());
+    CHECK(cache.contains("parts/3002.dat", 42));
+    CHECK_FALSE(cache.contains("parts/3003.dat", 42));
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,136 @@
+#include "../../connection/connector_spatial_hash.h"
+#include "../testing_tools.h"
+#include <set>
+
+using namespace bricksim::connection;
+
+namespace {
+    std::shared_ptr<Connector> createStud(float x, float z) {
+        return std::make_shared<CylindricalConnector>("", glm::vec3(x, 0, z), glm::vec3(0, -1, 0), "stud", Gender::M,
+                                                      std::vector<CylindricalShapePart>{{CylindricalShapeType::ROUND, false, 6.f, 4.f}},
+                                                      false, true, false);
+    }
+
+    std::shared_ptr<Connector> createAntiStud(float x, float z) {
+        return std::make_shared<CylindricalConnector>("", glm::vec3(x, 8, z), glm::vec3(0, -1, 0), "antistud", Gender::F,
+                                                      std::vector<CylindricalShapePart>{{CylindricalShapeType::ROUND, false, 6.f, 4.f}},
+                                                      true, false, false);
+    }
+
+    std::shared_ptr<connector_container_t> createPlate(int width, int depth) {
+        auto connectors = std::make_shared<connector_container_t>();
+        for (int x = 0; x < width; ++x) {
+            for (int z = 0; z < depth; ++z) {
+                connectors->push_back(createStud(x * 20.f, z * 20.f));
+                connectors->push_back(createAntiStud(x * 20.f, z * 20.f));
+            }
+        }
+        connectors->push_back(std::make_shared<FingerConnector>("hinge", glm::vec3(0, 0, 0), glm::vec3(1, 0, 0), "finger", Gender::M, 4.f, std::vector<float>{4.f, 4.f}));
+        connectors->push_back(std::make_shared<GenericConnector>("gen", glm::vec3(10, 0, 10), glm::vec3(0, -1, 0), "generic", Gender::M, BoundingPnt()));
+        connectors->push_back(std::make_shared<GenericConnector>("gen", glm::vec3(10, 8, 10), glm::vec3(0, -1, 0), "generic", Gender::F, BoundingPnt()));
+        return connectors;
+    }
+
+    using connection_set_t = std::set<std::pair<Connector*, Connector*>>;
+
+    connection_set_t toSet(const std::vector<Connection>& connections) {
+        connection_set_t result;
+        for (const auto& conn: connections) {
+            result.insert(std::minmax(conn.connectorA.get(), conn.connectorB.get()));
+        }
+        return result;
+    }
+
+    connection_set_t findConnections(const ConnectorSpatialHash& hash, ConnectorSpatialHash::owner_t owner) {
+        std::vector<ConnectorSpatialHash::Candidate> candidates;
+        hash.findCandidates(owner, candidates);
+        VectorPairCheckResultConsumer consumer;
+        for (const auto& candidate: candidates) {
+            hash.checkCandidate(owner, candidate, consumer);
+        }
+        return toSet(consumer.getResult());
+    }
+
+    ///every pair through PairChecker
+    connection_set_t checkAllPairs(const connector_container_t& a, const connector_container_t& b, const glm::mat4& aTransf, const glm::mat4& bTransf) {
+        VectorPairCheckResultConsumer consumer;
+        for (const auto& ca: a) {
+            const PairCheckData aData(aTransf, ca);
+            for (const auto& cb: b) {
+                const PairCheckData bData(bTransf, cb);
+                PairChecker(aData, bData, consumer).findConnections();
+            }
+        }
+        return toSet(consumer.getResult());
+    }
+
+    const int OWNER_A = 1;
+    const int OWNER_B = 2;
+}
+
+TEST_CASE("connection::ConnectorSpatialHash finds the same connections as checking all pairs") {
+    const auto plateA = createPlate(6, 4);
+    const auto plateB = createPlate(4, 6);
+    const auto transfA = glm::mat4(1.f);
+    const auto rotation = glm::mat4(glm::vec4(0, 0, -1, 0), glm::vec4(0, 1, 0, 0), glm::vec4(1, 0, 0, 0), glm::vec4(0, 0, 0, 1));
+    const auto transfB = GENERATE_COPY(glm::mat4(glm::vec4(1, 0, 0, 0), glm::vec4(0, 1, 0, 0), glm::vec4(0, 0, 1, 0), glm::vec4(0, -8, 0, 1)),
+                                       glm::mat4(glm::vec4(1, 0, 0, 0), glm::vec4(0, 1, 0, 0), glm::vec4(0, 0, 1, 0), glm::vec4(40, -8, 20, 1)) * rotation,
+                                       glm::mat4(glm::vec4(1, 0, 0, 0), glm::vec4(0, 1, 0, 0), glm::vec4(0, 0, 1, 0), glm::vec4(10, -8, 0, 1)),
+                                       glm::mat4(glm::vec4(1, 0, 0, 0), glm::vec4(0, 1, 0, 0), glm::vec4(0, 0, 1, 0), glm::vec4(20.05f, -8, 19.95f, 1)));
+
+    ConnectorSpatialHash hash;
+    hash.insert(&OWNER_A, plateA, transfA);
+    hash.insert(&OWNER_B, plateB, transfB);
+
+    const auto expected = checkAllPairs(*plateA, *plateB, transfA, transfB);
+    CHECK_FALSE(expected.empty());
+    CHECK(findConnections(hash, &OWNER_A) == expected);
+    CHECK(findConnections(hash, &OWNER_B) == expected);
+}
+
+TEST_CASE("connection::ConnectorSpatialHash connectors near a cell border") {
+    //the studs are on both sides of a cell border, but less than COLINEARITY_TOLERANCE_LDU apart
+    const auto x = GENERATE(ConnectorSpatialHash::CELL_SIZE_LDU, 0.f, -ConnectorSpatialHash::CELL_SIZE_LDU * 7);
+    const auto offset = GENERATE(-.03f, .03f);
+    const auto stud = std::make_shared<connector_container_t>(connector_container_t{createStud(x + offset, x - offset)});
+    const auto antiStud = std::make_shared<connector_container_t>(connector_container_t{createAntiStud(x - offset, x + offset)});
+    const auto transfB = glm::mat4(glm::vec4(1, 0, 0, 0), glm::vec4(0, 1, 0, 0), glm::vec4(0, 0, 1, 0), glm::vec4(0, -8, 0, 1));
+
+    ConnectorSpatialHash hash;
+    hash.insert(&OWNER_A, stud, glm::mat4(1.f));
+    hash.insert(&OWNER_B, antiStud, transfB);
+
+    std::vector<ConnectorSpatialHash::Candidate> candidates;
+    hash.findCandidates(&OWNER_A, candidates);
+    REQUIRE(candidates.size() == 1);
+    CHECK(candidates[0].otherOwner == &OWNER_B);
+    CHECK(findConnections(hash, &OWNER_B).size() == 1);
+}
+
+TEST_CASE("connection::ConnectorSpatialHash insert and remove") {
+    const auto plate = createPlate(2, 2);
+    const auto above = glm::mat4(glm::vec4(1, 0, 0, 0), glm::vec4(0, 1, 0, 0), glm::vec4(0, 0, 1, 0), glm::vec4(0, -8, 0, 1));
+    const auto farAway = glm::mat4(glm::vec4(1, 0, 0, 0), glm::vec4(0, 1, 0, 0), glm::vec4(0, 0, 1, 0), glm::vec4(1000, 0, 1000, 1));
+
+    ConnectorSpatialHash hash;
+    hash.insert(&OWNER_A, plate, glm::mat4(1.f));
+    hash.insert(&OWNER_B, plate, above);
+    CHECK(hash.getOwnerCount() == 2);
+    CHECK(hash.contains(&OWNER_B));
+    CHECK(findConnections(hash, &OWNER_A).size() == 2 * 2 + 1);
+
+    //inserting again replaces the old position
+    hash.insert(&OWNER_B, plate, farAway);
+    CHECK(hash.getOwnerCount() == 2);
+    CHECK(findConnections(hash, &OWNER_A).empty());
+
+    hash.insert(&OWNER_B, plate, above);
+    CHECK(findConnections(hash, &OWNER_A).size() == 2 * 2 + 1);
+
+    hash.remove(&OWNER_B);
+    CHECK_FALSE(hash.contains(&OWNER_B));
+    CHECK(findConnections(hash, &OWNER_A).empty());
+    hash.remove(&OWNER_A);
+    CHECK(hash.getOwnerCount() == 0);
+    CHECK(hash.getCellCount() == 0);
+}
@@ -0,0 +1,132 @@
+#include "../../connection/connection_check.h"
+#include "../../connection/connector_table.h"
+#include "../testing_tools.h"
+#include <set>
+
+using namespace bricksim::connection;
+
+namespace {
+    std::shared_ptr<Connector> createStud(float x, float z) {
+        return std::make_shared<CylindricalConnector>("", glm::vec3(x, 0, z), glm::vec3(0, -1, 0), "stud", Gender::M,
+                                                      std::vector<CylindricalShapePart>{{CylindricalShapeType::ROUND, false, 6.f, 4.f}},
+                                                      false, true, false);
+    }
+
+    std::shared_ptr<Connector> createAntiStud(float x, float z) {
+        return std::make_shared<CylindricalConnector>("", glm::vec3(x, -4, z), glm::vec3(0, 1, 0), "antistud", Gender::F,
+                                                      std::vector<CylindricalShapePart>{{CylindricalShapeType::ROUND, false, 6.f, 4.f}},
+                                                      true, false, false);
+    }
+
+    connector_container_t createPlate(int width, int depth) {
+        connector_container_t connectors;
+        for (int x = 0; x < width; ++x) {
+            for (int z = 0; z < depth; ++z) {
+                connectors.push_back(createStud(x * 20.f, z * 20.f));
+                connectors.push_back(createAntiStud(x * 20.f, z * 20.f));
+            }
+        }
+        connectors.push_back(std::make_shared<FingerConnector>("hinge", glm::vec3(0, 0, 0), glm::vec3(1, 0, 0), "finger", Gender::M, 4.f, std::vector<float>{4.f, 4.f}));
+        connectors.push_back(std::make_shared<GenericConnector>("gen", glm::vec3(10, 0, 10), glm::vec3(0, -1, 0), "generic", Gender::M, BoundingPnt()));
+        connectors.push_back(std::make_shared<GenericConnector>("gen", glm::vec3(10, 0, 10), glm::vec3(1, 0, 0), "generic", Gender::F, BoundingPnt()));
+        return connectors;
+    }
+
+    ///rotated by 90° around the y axis, without the rounding errors of glm::rotate
+    glm::mat4 createTransformation(const glm::vec3& translation) {
+        return {
+                glm::vec4(0, 0, -1, 0),
+                glm::vec4(0, 1, 0, 0),
+                glm::vec4(1, 0, 0, 0),
+                glm::vec4(translation, 1),
+        };
+    }
+
+    using connection_set_t = std::set<std::pair<Connector*, Connector*>>;
+
+    connection_set_t toSet(const std::vector<Connection>& connections) {
+        connection_set_t result;
+        for (const auto& conn: connections) {
+            result.insert(std::minmax(conn.connectorA.get(), conn.connectorB.get()));
+        }
+        return result;
+    }
+
+    ///every pair through PairChecker, without grouping and without the pre-filter
+    connection_set_t checkAllPairs(const connector_container_t& a, const connector_container_t& b, const glm::mat4& aTransf, const glm::mat4& bTransf) {
+        VectorPairCheckResultConsumer consumer;
+        for (const auto& ca: a) {
+            const PairCheckData aData(aTransf, ca);
+            for (const auto& cb: b) {
+                const PairCheckData bData(bTransf, cb);
+                PairChecker(aData, bData, consumer).findConnections();
+            }
+        }
+        return toSet(consumer.getResult());
+    }
+}
+
+TEST_CASE("connection::ConnectorTable columns") {
+    const auto connectors = createPlate(2, 1);
+    const ConnectorTable table(connectors);
+    REQUIRE(table.size() == connectors.size());
+    CHECK(table.types[0] == Connector::Type::CYLINDRICAL);
+    CHECK(table.genders[0] == static_cast<int32_t>(Gender::M));
+    CHECK(table.lengths[0] == 4.f);
+    CHECK(table.start[1][1] == -4.f);
+    CHECK(table.genders[4] == ConnectorTable::NO_GENDER);
+    CHECK(table.lengths[4] == 8.f);
+    CHECK(table.groups[5] == getGroupId("gen"));
+    CHECK(table.groups[5] != table.groups[4]);
+    CHECK(table.groups[0] == 0);
+    CHECK(table.getConnector(3) == connectors[3]);
+
+    const auto transformation = createTransformation({100, 0, 0});
+    const TransformedConnectorTable transformed(table, transformation);
+    for (std::size_t i = 0; i < table.size(); ++i) {
+        CHECK(transformed.getAbsStart(i) == ApproxVec(glm::vec3(transformation * glm::vec4(connectors[i]->start, 1.f))));
+        CHECK(transformed.getAbsDirection(i) == ApproxVec(glm::vec3(transformation * glm::vec4(connectors[i]->direction, 0.f))));
+    }
+}
+
+TEST_CASE("connection::findPairCandidates") {
+    connector_container_t connectors = {
+            createStud(0, 0),
+            createAntiStud(0, 0),
+            createAntiStud(20, 0),
+            createAntiStud(0.05f, 0),
+            std::make_shared<ClipConnector>("", glm::vec3(30, 0, 30), glm::vec3(0, 1, 0), "clip", 4.f, 8.f, false, glm::vec3(1, 0, 0)),
+            std::make_shared<CylindricalConnector>("", glm::vec3(0, 0, 0), glm::vec3(1, 0, 0), "bar", Gender::M,
+                                                   std::vector<CylindricalShapePart>{{CylindricalShapeType::ROUND, false, 4.f, 20.f}},
+                                                   true, true, false),
+    };
+    const ConnectorTable table(connectors);
+    const TransformedConnectorTable transformed(table, glm::mat4(1.f));
+    std::vector<uint32_t> candidates;
+    findPairCandidates(transformed, 0, transformed, table.size(), candidates);
+    //colinear ones, the clip because its line is checked by PairChecker, but not the bar which isn't parallel
+    CHECK(candidates == std::vector<uint32_t>{0, 1, 3, 4});
+}
+
+TEST_CASE("connection::ConnectionCheck finds the same connections as checking all pairs") {
+    const auto plateA = createPlate(6, 4);
+    const auto plateB = createPlate(4, 6);
+    const auto transfA = glm::mat4(1.f);
+    const auto transfB = GENERATE(createTransformation({0, -8, 0}),
+                                  createTransformation({40, -8, 20}),
+                                  createTransformation({10, -8, 0}));
+
+    VectorPairCheckResultConsumer consumer;
+    ConnectionCheck(consumer).checkForConnected(plateA, plateB, transfA, transfB);
+    const auto expected = checkAllPairs(plateA, plateB, transfA, transfB);
+    CHECK(toSet(consumer.getResult()) == expected);
+}
+
+TEST_CASE("connection::ConnectionCheck inside one container") {
+    const auto plate = createPlate(5, 5);
+    VectorPairCheckResultConsumer consumer;
+    ConnectionCheck(consumer).checkForConnected(plate);
+    const auto result = toSet(consumer.getResult());
+    //every stud is connected to its own anti stud, and the two generic connectors to each other
+    CHECK(result.size() == 5 * 5 + 1);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../constant_data/constants.h"
+#include "../ldr/file_repo.h"
+#include "catch2/catch_test_macros.hpp"
+#include <filesystem>
+#include <fstream>
+
+/**
+ * a library directory which only contains LDConfig.ldr.
+ * the tests add library files with addLdrFileWithContent, so they are found in memory and the db isn't needed.
+ * the file repo is a singleton, so all tests which need one have to use this library
+ */
+inline const std::filesystem::path& getTestLibraryPath() {
+    static const auto path = []() {
+        auto libraryPath = std::filesystem::temp_directory_path() / "bricksim_test_library";
+        std::filesystem::create_directories(libraryPath);
+        std::ofstream(libraryPath / bricksim::constants::LDRAW_CONFIG_FILE_NAME) << "0 LDraw.org Configuration File\n";
+        return libraryPath;
+    }();
+    return path;
+}
+
+inline bricksim::ldr::FileRepo& initializeTestFileRepo() {
+    if (!bricksim::ldr::file_repo::isInitialized()) {
+        REQUIRE(bricksim::ldr::file_repo::tryToInitializeWithLibraryPath(getTestLibraryPath()));
+    }
+    return bricksim::ldr::file_repo::get();
+}
@@ -0,0 +1,145 @@
+#include "../../graphics/mesh/mesh_optimizer.h"
+#include "../testing_tools.h"
+#include <algorithm>
+#include <set>
+
+using namespace bricksim;
+using namespace bricksim::mesh;
+
+namespace {
+    /**
+     * flat grid of size*size quads, every triangle has its own three vertices like the ones from Mesh::addLdrTriangle
+     */
+    void generateUnweldedGrid(std::vector<TriangleVertex>& vertices, std::vector<unsigned int>& indices, int size) {
+        const glm::vec3 normal(0, -1, 0);
+        auto addTriangle = [&](glm::vec3 a, glm::vec3 b, glm::vec3 c) {
+            const auto idx = static_cast<unsigned int>(vertices.size());
+            vertices.emplace_back(a, normal);
+            vertices.emplace_back(b, normal);
+            vertices.emplace_back(c, normal);
+            indices.insert(indices.end(), {idx, idx + 1, idx + 2});
+        };
+        for (int x = 0; x < size; ++x) {
+            for (int z = 0; z < size; ++z) {
+                const glm::vec3 p00(x, 0, z);
+                const glm::vec3 p10(x + 1, 0, z);
+                const glm::vec3 p01(x, 0, z + 1);
+                const glm::vec3 p11(x + 1, 0, z + 1);
+                addTriangle(p00, p10, p11);
+                addTriangle(p11, p01, p00);
+            }
+        }
+    }
+
+    std::multiset<std::array<float, 9>> getTriangleSet(const std::vector<TriangleVertex>& vertices, const std::vector<unsigned int>& indices) {
+        std::multiset<std::array<float, 9>> result;
+        for (std::size_t i = 0; i < indices.size(); i += 3) {
+            std::array<glm::vec3, 3> corners = {vertices[indices[i]].position, vertices[indices[i + 1]].position, vertices[indices[i + 2]].position};
+            //normalize the rotation of the corners without changing the winding order
+            const auto minIt = std::min_element(corners.begin(), corners.end(), [](const glm::vec3& a, const glm::vec3& b) {
+                return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+            });
+            std::rotate(corners.begin(), minIt, corners.end());
+            result.insert({corners[0].x, corners[0].y, corners[0].z, corners[1].x, corners[1].y, corners[1].z, corners[2].x, corners[2].y, corners[2].z});
+        }
+        return result;
+    }
+}
+
+TEST_CASE("mesh_optimizer::weldVertices merges equal vertices") {
+    std::vector<TriangleVertex> vertices;
+    std::vector<unsigned int> indices;
+    generateUnweldedGrid(vertices, indices, 4);
+    const auto trianglesBefore = getTriangleSet(vertices, indices);
+
+    mesh_optimizer::weldVertices(vertices, indices, mesh_optimizer::WELD_POSITION_TOLERANCE, mesh_optimizer::WELD_NORMAL_TOLERANCE);
+
+    CHECK(vertices.size() == 5 * 5);
+    CHECK(indices.size() == 4 * 4 * 6);
+    CHECK(getTriangleSet(vertices, indices) == trianglesBefore);
+}
+
+TEST_CASE("mesh_optimizer::weldVertices keeps vertices with different normals") {
+    std::vector<TriangleVertex> vertices = {
+            {{0, 0, 0}, {0, -1, 0}},
+            {{1, 0, 0}, {0, -1, 0}},
+            {{0, 0, 1}, {0, -1, 0}},
+            {{0, 0, 0}, {-1, 0, 0}},
+            {{0, 1, 0}, {-1, 0, 0}},
+            {{0, 0, 1}, {-1, 0, 0}},
+    };
+    std::vector<unsigned int> indices = {0, 1, 2, 3, 4, 5};
+
+    mesh_optimizer::weldVertices(vertices, indices, mesh_optimizer::WELD_POSITION_TOLERANCE, mesh_optimizer::WELD_NORMAL_TOLERANCE);
+
+    CHECK(vertices.size() == 6);
+    CHECK(indices == std::vector<unsigned int>{0, 1, 2, 3, 4, 5});
+}
+
+TEST_CASE("mesh_optimizer::weldVertices removes triangles which become degenerate") {
+    std::vector<TriangleVertex> vertices = {
+            {{0, 0, 0}, {0, -1, 0}},
+            {{1, 0, 0}, {0, -1, 0}},
+            {{1.0001f, 0, 0}, {0, -1, 0}},
+            {{0, 0, 1}, {0, -1, 0}},
+    };
+    std::vector<unsigned int> indices = {0, 1, 3, 0, 1, 2};
+
+    mesh_optimizer::weldVertices(vertices, indices, mesh_optimizer::WELD_POSITION_TOLERANCE, mesh_optimizer::WELD_NORMAL_TOLERANCE);
+
+    CHECK(vertices.size() == 3);
+    CHECK(indices == std::vector<unsigned int>{0, 1, 2});
+}
+
+TEST_CASE("mesh_optimizer::optimizeVertexCache keeps all triangles and lowers the ACMR") {
+    std::vector<TriangleVertex> vertices;
+    std::vector<unsigned int> indices;
+    generateUnweldedGrid(vertices, indices, 64);
+    mesh_optimizer::weldVertices(vertices, indices, mesh_optimizer::WELD_POSITION_TOLERANCE, mesh_optimizer::WELD_NORMAL_TOLERANCE);
+
+    //shuffle the triangles so that the initial order is bad for the cache
+    std::vector<std::array<unsigned int, 3>> triangles;
+    for (std::size_t i = 0; i < indices.size(); i += 3) {
+        triangles.push_back({indices[i], indices[i + 1], indices[i + 2]});
+    }
+    for (std::size_t i = 0; i < triangles.size(); ++i) {
+        std::swap(triangles[i], triangles[(i * 7919) % triangles.size()]);
+    }
+    indices.clear();
+    for (const auto& triangle: triangles) {
+        indices.insert(indices.end(), triangle.begin(), triangle.end());
+    }
+    const auto trianglesBefore = getTriangleSet(vertices, indices);
+    const auto acmrBefore = mesh_optimizer::calculateACMR(indices, mesh_optimizer::VERTEX_CACHE_SIZE);
+
+    mesh_optimizer::optimizeVertexCache(indices, vertices.size());
+    const auto acmrAfter = mesh_optimizer::calculateACMR(indices, mesh_optimizer::VERTEX_CACHE_SIZE);
+
+    CHECK(getTriangleSet(vertices, indices) == trianglesBefore);
+    CHECK(acmrAfter < acmrBefore);
+    CHECK(acmrAfter < 0.8f);
+}
+
+TEST_CASE("mesh_optimizer::optimizeVertexFetch orders vertices by first use") {
+    std::vector<TriangleVertex> vertices = {
+            {{0, 0, 0}, {0, -1, 0}},
+            {{1, 0, 0}, {0, -1, 0}},
+            {{2, 0, 0}, {0, -1, 0}},
+            {{3, 0, 0}, {0, -1, 0}},
+    };
+    std::vector<unsigned int> indices = {3, 1, 0};
+    const auto trianglesBefore = getTriangleSet(vertices, indices);
+
+    mesh_optimizer::optimizeVertexFetch(vertices, indices);
+
+    CHECK(indices == std::vector<unsigned int>{0, 1, 2});
+    REQUIRE(vertices.size() == 3);
+    CHECK(vertices[0].position.x == 3.0f);
+    CHECK(getTriangleSet(vertices, indices) == trianglesBefore);
+}
+
+TEST_CASE("mesh_optimizer::calculateACMR") {
+    CHECK(mesh_optimizer::calculateACMR({0, 1, 2}, 32) == 3.0f);
+    CHECK(mesh_optimizer::calculateACMR({0, 1, 2, 2, 1, 3}, 32) == 2.0f);
+    CHECK(mesh_optimizer::calculateACMR({}, 32) == 0.0f);
+}
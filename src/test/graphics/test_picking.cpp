@@ -0,0 +1,192 @@
+#include "../../graphics/picking/scene_picker.h"
+#include "../testing_tools.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+
+using namespace bricksim;
+using namespace bricksim::picking;
+
+namespace {
+    void addBox(TriangleBvh& bvh, const glm::vec3& pMin, const glm::vec3& pMax) {
+        std::array<glm::vec3, 8> c;
+        for (int i = 0; i < 8; ++i) {
+            c[i] = {i & 1 ? pMax.x : pMin.x, i & 2 ? pMax.y : pMin.y, i & 4 ? pMax.z : pMin.z};
+        }
+        const std::array<std::array<int, 4>, 6> faces = {{{0, 1, 3, 2}, {4, 6, 7, 5}, {0, 4, 5, 1}, {2, 3, 7, 6}, {0, 2, 6, 4}, {1, 5, 7, 3}}};
+        for (const auto& f: faces) {
+            bvh.addTriangle(c[f[0]], c[f[1]], c[f[2]]);
+            bvh.addTriangle(c[f[2]], c[f[3]], c[f[0]]);
+        }
+    }
+
+    std::shared_ptr<const TriangleBvh> createUnitCube() {
+        auto bvh = std::make_shared<TriangleBvh>();
+        addBox(*bvh, glm::vec3(-.5f), glm::vec3(.5f));
+        bvh->build();
+        return bvh;
+    }
+
+    ///like MeshInstance::transformation
+    glm::mat4 translation(const glm::vec3& offset) {
+        return glm::transpose(glm::translate(glm::mat4(1.f), offset));
+    }
+
+    const glm::vec2 SCREEN_SIZE(200, 200);
+    ///x and y from -10 to 10 are visible, looking in -z direction
+    const glm::mat4 WORLD_TO_CLIP = glm::ortho(-10.f, 10.f, -10.f, 10.f, -100.f, 100.f);
+
+    glm::vec2 worldToScreen(float x, float y) {
+        return {(x + 10.f) * 10.f, (10.f - y) * 10.f};
+    }
+}
+
+TEST_CASE("TriangleBvh::intersectRay matches brute force") {
+    TriangleBvh bvh;
+    std::vector<std::array<glm::vec3, 3>> triangles;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> coord(-50.f, 50.f);
+    std::uniform_real_distribution<float> offset(-2.f, 2.f);
+    for (int i = 0; i < 2000; ++i) {
+        const glm::vec3 center(coord(rng), coord(rng), coord(rng));
+        const std::array<glm::vec3, 3> triangle = {
+                center + glm::vec3(offset(rng), offset(rng), offset(rng)),
+                center + glm::vec3(offset(rng), offset(rng), offset(rng)),
+                center + glm::vec3(offset(rng), offset(rng), offset(rng)),
+        };
+        triangles.push_back(triangle);
+        bvh.addTriangle(triangle[0], triangle[1], triangle[2]);
+    }
+    bvh.build();
+    CHECK(bvh.getTriangleCount() == triangles.size());
+    CHECK(bvh.getNodeCount() > 1);
+
+    int hitCount = 0;
+    for (int i = 0; i < 500; ++i) {
+        const Ray3 ray({coord(rng), coord(rng), -100.f}, glm::normalize(glm::vec3(offset(rng) * .05f, offset(rng) * .05f, 1.f)));
+        std::optional<float> expected;
+        for (const auto& [a, b, c]: triangles) {
+            const auto t = bvh::intersectRayTriangle(ray, a, b, c);
+            if (t.has_value() && (!expected.has_value() || *t < *expected)) {
+                expected = t;
+            }
+        }
+        const auto hit = bvh.intersectRay(ray, INFINITY);
+        REQUIRE(hit.has_value() == expected.has_value());
+        if (hit.has_value()) {
+            ++hitCount;
+            CHECK(hit->distance == Catch::Approx(*expected));
+            CHECK(glm::dot(hit->normal, ray.direction) <= 0.f);
+        }
+    }
+    CHECK(hitCount > 0);
+}
+
+TEST_CASE("ScenePicker::pickRay returns the nearest element") {
+    const auto cube = createUnitCube();
+    ScenePicker picker;
+    picker.setInstances({
+            {cube, translation({0, 0, 0}), 1, 0},
+            {cube, translation({0, 0, -5}), 2, 0},
+            {cube, translation({5, 0, 0}), 3, 0},
+    });
+    CHECK(picker.getInstanceCount() == 3);
+
+    const auto hit = picker.pickRay(Ray3({0, 0, 10}, {0, 0, -1}));
+    REQUIRE(hit.has_value());
+    CHECK(hit->elementId == 1);
+    CHECK(hit->point == ApproxVec(glm::vec3(0, 0, .5f)));
+    CHECK(hit->normal == ApproxVec(glm::vec3(0, 0, 1)));
+    CHECK(hit->distance == Catch::Approx(9.5f));
+
+    const auto hitFromBehind = picker.pickRay(Ray3({0, 0, -10}, {0, 0, 1}));
+    REQUIRE(hitFromBehind.has_value());
+    CHECK(hitFromBehind->elementId == 2);
+    CHECK(hitFromBehind->normal == ApproxVec(glm::vec3(0, 0, -1)));
+
+    const auto hitSide = picker.pickRay(Ray3({5, 10, 0}, {0, -1, 0}));
+    REQUIRE(hitSide.has_value());
+    CHECK(hitSide->elementId == 3);
+    CHECK(hitSide->point == ApproxVec(glm::vec3(5, .5f, 0)));
+
+    CHECK_FALSE(picker.pickRay(Ray3({2.5f, 0, 10}, {0, 0, -1})).has_value());
+}
+
+TEST_CASE("ScenePicker::pickRay transforms normals and prefers higher layers") {
+    const auto cube = createUnitCube();
+    ScenePicker picker;
+    const auto scaled = glm::transpose(glm::scale(glm::translate(glm::mat4(1.f), {0, 0, -3}), {4, 1, 1}));
+    picker.setInstances({
+            {cube, translation({0, 0, 0}), 1, 0},
+            {cube, scaled, 2, 1},
+    });
+
+    const auto hit = picker.pickRay(Ray3({.25f, 0, 10}, {0, 0, -1}));
+    REQUIRE(hit.has_value());
+    //element 2 is farther away, but it's on a higher layer
+    CHECK(hit->elementId == 2);
+    CHECK(hit->point == ApproxVec(glm::vec3(.25f, 0, -2.5f)));
+    CHECK(hit->normal == ApproxVec(glm::vec3(0, 0, 1)));
+
+    picker.clear();
+    CHECK_FALSE(picker.pickRay(Ray3({0, 0, 10}, {0, 0, -1})).has_value());
+}
+
+TEST_CASE("ScenePicker::findElementsInPolygon rectangle") {
+    const auto cube = createUnitCube();
+    ScenePicker picker;
+    std::vector<ScenePicker::Instance> instances;
+    for (int x = -4; x <= 4; ++x) {
+        instances.push_back({cube, translation({static_cast<float>(2 * x), 0, 0}), static_cast<element_id_t>(x + 5), 0});
+    }
+    //hidden behind element 5, but box selection doesn't care about occlusion
+    instances.push_back({cube, translation({0, 0, -5}), 100, 0});
+    picker.setInstances(instances);
+
+    const auto polygon = SelectionPolygon::rectangle(worldToScreen(-.2f, 3), worldToScreen(4.2f, -3));
+    CHECK(picker.findElementsInPolygon(polygon, WORLD_TO_CLIP, SCREEN_SIZE) == std::vector<element_id_t>{5, 6, 7, 100});
+
+    const auto nothing = SelectionPolygon::rectangle(worldToScreen(-1.5f, 8), worldToScreen(1.5f, 6));
+    CHECK(picker.findElementsInPolygon(nothing, WORLD_TO_CLIP, SCREEN_SIZE).empty());
+}
+
+TEST_CASE("ScenePicker::findElementsInPolygon lasso") {
+    const auto cube = createUnitCube();
+    ScenePicker picker;
+    picker.setInstances({
+            {cube, translation({0, 0, 0}), 1, 0},
+            {cube, translation({4, 0, 0}), 2, 0},
+            {cube, translation({0, 4, 0}), 3, 0},
+            {cube, translation({4, 4, 0}), 4, 0},
+    });
+    //L-shaped lasso around elements 1, 2 and 3, the inner corner is next to element 4
+    const SelectionPolygon lasso({
+            worldToScreen(-1, -1),
+            worldToScreen(5, -1),
+            worldToScreen(5, 2),
+            worldToScreen(2, 2),
+            worldToScreen(2, 5),
+            worldToScreen(-1, 5),
+    });
+    CHECK(picker.findElementsInPolygon(lasso, WORLD_TO_CLIP, SCREEN_SIZE) == std::vector<element_id_t>{1, 2, 3});
+
+    //a lasso completely inside of the projection of a single element
+    const SelectionPolygon small({worldToScreen(3.9f, 3.9f), worldToScreen(4.1f, 3.9f), worldToScreen(4, 4.1f)});
+    CHECK(picker.findElementsInPolygon(small, WORLD_TO_CLIP, SCREEN_SIZE) == std::vector<element_id_t>{4});
+}
+
+TEST_CASE("SelectionPolygon") {
+    const SelectionPolygon triangle({{0, 0}, {10, 0}, {0, 10}});
+    CHECK(triangle.containsPoint({1, 1}));
+    CHECK_FALSE(triangle.containsPoint({6, 6}));
+    CHECK(triangle.intersectsTriangle({4, 4}, {8, 8}, {8, 4}));
+    CHECK_FALSE(triangle.intersectsTriangle({6, 6}, {8, 8}, {8, 6}));
+    CHECK(triangle.containsRectangle({1, 1}, {3, 3}));
+    CHECK_FALSE(triangle.containsRectangle({1, 1}, {6, 6}));
+
+    const auto rectangle = SelectionPolygon::rectangle({10, 10}, {0, 0});
+    CHECK(rectangle.containsPoint({5, 5}));
+    CHECK(rectangle.containsRectangle({1, 1}, {9, 9}));
+    CHECK_FALSE(rectangle.containsRectangle({1, 1}, {11, 9}));
+    //crosses the rectangle without a corner inside
+    CHECK(rectangle.intersectsTriangle({-5, 4}, {15, 4}, {15, 6}));
+}
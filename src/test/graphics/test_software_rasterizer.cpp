@@ -0,0 +1,257 @@
+#include "../../graphics/software_rasterizer/rasterizer.h"
+#include "../testing_tools.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+
+using namespace bricksim;
+using namespace bricksim::software_rasterizer;
+
+namespace {
+    constexpr int IMAGE_SIZE = 100;
+    const glm::vec3 BACKGROUND(.2f, .4f, .6f);
+
+    ///x and y from -10 to 10 are visible, looking in -z direction. one unit is 5 pixels
+    Settings createSettings() {
+        Settings settings;
+        settings.imageSize = {IMAGE_SIZE, IMAGE_SIZE};
+        settings.projectionView = glm::ortho(-10.f, 10.f, -10.f, 10.f, -100.f, 100.f);
+        //far away, so the light direction is almost the same for all pixels
+        settings.cameraPos = {0, 0, 1000};
+        settings.backgroundColor = BACKGROUND;
+        settings.threadCount = 2;
+        return settings;
+    }
+
+    ///without specular light, so a surface facing the camera has LIGHT_AMBIENT*ambientFactor*color+LIGHT_DIFFUSE*color
+    mesh::TriangleInstance createInstance(const glm::vec3& color, const glm::vec3& offset = glm::vec3(0.f)) {
+        mesh::TriangleInstance instance{};
+        instance.diffuseColor = color;
+        instance.ambientFactor = .5f;
+        instance.specularBrightness = 0.f;
+        instance.shininess = 32.f;
+        instance.transformation = glm::translate(glm::mat4(1.f), offset);
+        return instance;
+    }
+
+    glm::vec3 expectedColor(const glm::vec3& diffuseColor) {
+        return diffuseColor * (.65f * .5f + .5f);
+    }
+
+    struct Quad {
+        std::vector<mesh::TriangleVertex> vertices;
+        std::vector<unsigned int> indices;
+
+        ///counter-clockwise when seen from +z
+        Quad(float x0, float y0, float x1, float y1, float z) {
+            vertices = {
+                    {{x0, y0, z}, {0, 0, 1}},
+                    {{x1, y0, z}, {0, 0, 1}},
+                    {{x1, y1, z}, {0, 0, 1}},
+                    {{x0, y1, z}, {0, 0, 1}},
+            };
+            indices = {0, 1, 2, 2, 3, 0};
+        }
+    };
+
+    glm::ivec3 getPixel(const util::RawImage& image, int x, int y) {
+        const auto* pixel = image.data.data() + (static_cast<size_t>(y) * image.width + x) * 3;
+        return {pixel[0], pixel[1], pixel[2]};
+    }
+
+    glm::ivec3 toBytes(const glm::vec3& color) {
+        return glm::ivec3(glm::round(glm::clamp(color, 0.f, 1.f) * 255.f));
+    }
+
+    void checkColor(const util::RawImage& image, int x, int y, const glm::vec3& color) {
+        const auto actual = getPixel(image, x, y);
+        const auto expected = toBytes(color);
+        INFO("pixel " << x << ", " << y << ": " << actual.x << " " << actual.y << " " << actual.z << ", expected " << expected.x << " " << expected.y << " " << expected.z);
+        CHECK(glm::all(glm::lessThanEqual(glm::abs(actual - expected), glm::ivec3(1))));
+    }
+
+    int countPixels(const util::RawImage& image, const glm::vec3& color) {
+        const auto bytes = toBytes(color);
+        int count = 0;
+        for (int y = 0; y < image.height; ++y) {
+            for (int x = 0; x < image.width; ++x) {
+                count += getPixel(image, x, y) == bytes;
+            }
+        }
+        return count;
+    }
+}
+
+TEST_CASE("software_rasterizer::Rasterizer background") {
+    Rasterizer rasterizer(createSettings());
+    const auto image = rasterizer.render();
+    CHECK(image.width == IMAGE_SIZE);
+    CHECK(image.height == IMAGE_SIZE);
+    CHECK(image.channels == 3);
+    CHECK(countPixels(image, BACKGROUND) == IMAGE_SIZE * IMAGE_SIZE);
+    CHECK(rasterizer.getDepthBuffer()[0] == 1.f);
+}
+
+TEST_CASE("software_rasterizer::Rasterizer fills quads without gaps") {
+    const glm::vec3 color(.4f, .2f, .8f);
+    const Quad quad(-5, -5, 5, 5, 0);
+    const std::vector<mesh::TriangleInstance> instances = {createInstance(color)};
+    Rasterizer rasterizer(createSettings());
+    rasterizer.addTriangles(quad.vertices, quad.indices, instances, 0);
+    const auto image = rasterizer.render();
+
+    //the quad covers the pixels 25 to 74 in both directions
+    CHECK(countPixels(image, expectedColor(color)) == 50 * 50);
+    checkColor(image, 25, 25, expectedColor(color));
+    checkColor(image, 74, 74, expectedColor(color));
+    checkColor(image, 24, 50, BACKGROUND);
+    checkColor(image, 75, 50, BACKGROUND);
+    CHECK(rasterizer.getDepthBuffer()[50 * IMAGE_SIZE + 50] == Catch::Approx(0.f).margin(1e-6));
+}
+
+TEST_CASE("software_rasterizer::Rasterizer depth test and layers") {
+    const glm::vec3 red(.8f, 0, 0);
+    const glm::vec3 green(0, .8f, 0);
+    const Quad front(-5, -5, 5, 5, 1);
+    const Quad back(0, 0, 8, 8, -1);
+    const std::vector<mesh::TriangleInstance> redInstances = {createInstance(red)};
+    const std::vector<mesh::TriangleInstance> greenInstances = {createInstance(green)};
+
+    SECTION("same layer") {
+        Rasterizer rasterizer(createSettings());
+        //the back quad is added last, but it's behind the front quad
+        rasterizer.addTriangles(front.vertices, front.indices, redInstances, 0);
+        rasterizer.addTriangles(back.vertices, back.indices, greenInstances, 0);
+        const auto image = rasterizer.render();
+        checkColor(image, 60, 60, expectedColor(red));
+        checkColor(image, 80, 80, expectedColor(green));
+        checkColor(image, 30, 30, expectedColor(red));
+    }
+
+    SECTION("higher layer") {
+        Rasterizer rasterizer(createSettings());
+        rasterizer.addTriangles(front.vertices, front.indices, redInstances, 0);
+        rasterizer.addTriangles(back.vertices, back.indices, greenInstances, 1);
+        const auto image = rasterizer.render();
+        checkColor(image, 60, 60, expectedColor(green));
+        checkColor(image, 30, 30, expectedColor(red));
+    }
+}
+
+TEST_CASE("software_rasterizer::Rasterizer face culling and instances") {
+    const glm::vec3 color(.5f, .5f, .1f);
+    Quad quad(-2, -2, 2, 2, 0);
+    std::reverse(quad.indices.begin(), quad.indices.end());
+    const std::vector<mesh::TriangleInstance> instances = {createInstance(color, {-5, 0, 0}), createInstance(color, {5, 0, 0})};
+
+    auto settings = createSettings();
+    settings.faceCulling = true;
+    Rasterizer culling(settings);
+    culling.addTriangles(quad.vertices, quad.indices, instances, 0);
+    CHECK(countPixels(culling.render(), BACKGROUND) == IMAGE_SIZE * IMAGE_SIZE);
+
+    settings.faceCulling = false;
+    Rasterizer notCulling(settings);
+    notCulling.addTriangles(quad.vertices, quad.indices, instances, 0);
+    const auto image = notCulling.render();
+    //only the winding is reversed, the normals still point to the camera
+    checkColor(image, 25, 50, expectedColor(color));
+    checkColor(image, 75, 50, expectedColor(color));
+    checkColor(image, 50, 50, BACKGROUND);
+}
+
+TEST_CASE("software_rasterizer::Rasterizer lines") {
+    const glm::vec3 lineColor(1, 1, 0);
+    const std::vector<mesh::LineVertex> vertices = {
+            {{-8, 0, 0}, lineColor},
+            {{8, 0, 0}, lineColor},
+            {{0, -8, 0}, lineColor},
+            {{0, 8, 0}, lineColor},
+    };
+    const std::vector<unsigned int> indices = {0, 1};
+    std::vector<glm::mat4> instances = {glm::mat4(1.f)};
+
+    SECTION("line on top of a triangle") {
+        const Quad quad(-5, -5, 5, 5, 0);
+        const std::vector<mesh::TriangleInstance> triangleInstances = {createInstance(glm::vec3(.1f))};
+        Rasterizer rasterizer(createSettings());
+        rasterizer.addTriangles(quad.vertices, quad.indices, triangleInstances, 0);
+        rasterizer.addLines(vertices, indices, instances, 0);
+        const auto image = rasterizer.render();
+        //the line covers the pixels 10 to 89 in the row above y=0
+        CHECK(countPixels(image, lineColor) == 80);
+        checkColor(image, 10, 50, lineColor);
+        checkColor(image, 50, 50, lineColor);
+        checkColor(image, 89, 50, lineColor);
+        checkColor(image, 50, 49, expectedColor(glm::vec3(.1f)));
+    }
+
+    SECTION("selected instance") {
+        instances[0][2][3] = 1.f;
+        Rasterizer rasterizer(createSettings());
+        rasterizer.addLines(vertices, indices, instances, 0);
+        const auto image = rasterizer.render();
+        checkColor(image, 50, 50, {0, 0, 1});
+        CHECK(countPixels(image, {0, 0, 1}) == 80);
+    }
+
+    SECTION("optional lines") {
+        //control points on the same side of the first line, on different sides of the second one
+        const std::vector<mesh::LineVertex> optionalVertices = {
+                {{-2, 5, 0}, lineColor},
+                {{-8, 0, 0}, lineColor},
+                {{8, 0, 0}, lineColor},
+                {{2, 5, 0}, lineColor},
+                {{-5, -2, 0}, lineColor},
+                {{0, -8, 0}, lineColor},
+                {{0, 8, 0}, lineColor},
+                {{5, 2, 0}, lineColor},
+        };
+        const std::vector<unsigned int> optionalIndices = {0, 1, 2, 3, 4, 5, 6, 7};
+        Rasterizer rasterizer(createSettings());
+        rasterizer.addOptionalLines(optionalVertices, optionalIndices, instances, 0);
+        const auto image = rasterizer.render();
+        CHECK(countPixels(image, lineColor) == 80);
+        checkColor(image, 30, 50, lineColor);
+        checkColor(image, 50, 30, BACKGROUND);
+    }
+}
+
+TEST_CASE("software_rasterizer::Rasterizer result doesn't depend on the thread count") {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> coord(-12.f, 12.f);
+    std::uniform_real_distribution<float> channel(0.f, 1.f);
+    std::vector<mesh::TriangleVertex> vertices;
+    std::vector<unsigned int> indices;
+    for (unsigned int i = 0; i < 300; ++i) {
+        const glm::vec3 normal = glm::normalize(glm::vec3(channel(rng) - .5f, channel(rng) - .5f, 1.f));
+        for (int j = 0; j < 3; ++j) {
+            vertices.push_back({{coord(rng), coord(rng), coord(rng)}, normal});
+            indices.push_back(static_cast<unsigned int>(vertices.size() - 1));
+        }
+    }
+    std::vector<mesh::TriangleInstance> instances;
+    for (int i = 0; i < 4; ++i) {
+        auto instance = createInstance({channel(rng), channel(rng), channel(rng)}, {coord(rng) * .2f, coord(rng) * .2f, 0});
+        instance.specularBrightness = .5f;
+        instances.push_back(instance);
+    }
+
+    auto settings = createSettings();
+    settings.faceCulling = false;
+    settings.projectionView = glm::perspective(glm::radians(50.f), 1.f, .01f, 1000.f) * glm::lookAt(glm::vec3(3, 4, 30), glm::vec3(0), glm::vec3(0, 1, 0));
+    settings.cameraPos = {3, 4, 30};
+    settings.imageSize = {160, 120};
+
+    settings.threadCount = 1;
+    Rasterizer single(settings);
+    single.addTriangles(vertices, indices, instances, 0);
+    const auto singleImage = single.render();
+
+    settings.threadCount = 5;
+    Rasterizer multi(settings);
+    multi.addTriangles(vertices, indices, instances, 0);
+    const auto multiImage = multi.render();
+
+    CHECK(singleImage.data == multiImage.data);
+    CHECK(countPixels(singleImage, BACKGROUND) < 160 * 120);
+}
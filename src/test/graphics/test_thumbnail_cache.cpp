@@ -0,0 +1,77 @@
+#include "../../graphics/thumbnail/thumbnail_cache.h"
+#include "../testing_tools.h"
+#include <algorithm>
+
+using namespace bricksim::graphics;
+
+namespace {
+    constexpr unsigned int THUMBNAIL_SIZE = 4;
+
+    std::filesystem::path getCachePath() {
+        return std::filesystem::temp_directory_path() / "bricksim_test_thumbnail_cache.bin";
+    }
+
+    ThumbnailAtlasKey createKey(uint64_t fingerprint) {
+        return {"parts/3001.dat", fingerprint, 4, {45, -45, 0}, std::nullopt};
+    }
+
+    std::vector<uint8_t> createPixels(uint8_t seed) {
+        std::vector<uint8_t> pixels(THUMBNAIL_SIZE * THUMBNAIL_SIZE * 3);
+        for (std::size_t i = 0; i < pixels.size(); ++i) {
+            pixels[i] = static_cast<uint8_t>(seed + i);
+        }
+        return pixels;
+    }
+
+    bool equals(std::span<const uint8_t> actual, const std::vector<uint8_t>& expected) {
+        return std::equal(actual.begin(), actual.end(), expected.begin(), expected.end());
+    }
+}
+
+TEST_CASE("graphics::ThumbnailCache roundtrip") {
+    const auto path = getCachePath();
+    std::filesystem::remove(path);
+    auto otherColor = createKey(42);
+    otherColor.color = 1;
+    auto otherBackground = createKey(42);
+    otherBackground.background = bricksim::color::RGB("#FFFFFF");
+    {
+        ThumbnailCache cache(path, "2023-01", THUMBNAIL_SIZE);
+        cache.put(createKey(42), createPixels(1));
+        cache.put(otherColor, createPixels(2));
+        //not the size of a thumbnail
+        cache.put(otherBackground, {1, 2, 3});
+        CHECK(equals(cache.read(createKey(42)), createPixels(1)));
+        cache.save();
+        CHECK(cache.getEntryCount() == 2);
+    }
+
+    ThumbnailCache cache(path, "2023-01", THUMBNAIL_SIZE);
+    CHECK(cache.getEntryCount() == 2);
+    CHECK(equals(cache.read(createKey(42)), createPixels(1)));
+    CHECK(equals(cache.read(otherColor), createPixels(2)));
+    CHECK(cache.read(otherBackground).empty());
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("graphics::ThumbnailCache ignores other thumbnail size") {
+    const auto path = getCachePath();
+    std::filesystem::remove(path);
+    {
+        ThumbnailCache cache(path, "2023-01", THUMBNAIL_SIZE);
+        cache.put(createKey(42), createPixels(1));
+        cache.save();
+    }
+    CHECK(ThumbnailCache(path, "2023-01", THUMBNAIL_SIZE * 2).read(createKey(42)).empty());
+    CHECK_FALSE(ThumbnailCache(path, "2023-01", THUMBNAIL_SIZE).read(createKey(42)).empty());
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("graphics::ThumbnailAtlasKey::getId") {
+    const auto key = createKey(42);
+    auto otherRotation = createKey(42);
+    otherRotation.rotation.z = 90;
+    CHECK(key.getId() == createKey(43).getId());
+    CHECK(key.getId() != otherRotation.getId());
+}
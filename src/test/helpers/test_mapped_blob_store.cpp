@@ -0,0 +1,154 @@
+#include "../../helpers/mapped_blob_store.h"
+#include "../testing_tools.h"
+#include <algorithm>
+#include <fstream>
+
+using namespace bricksim;
+
+namespace {
+    constexpr MappedBlobStore::magic_t MAGIC = {'B', 'S', 'T', 'E', 'S', 'T', '0', '1'};
+    constexpr uint32_t FORMAT_VERSION = 3;
+
+    std::filesystem::path getStorePath() {
+        return std::filesystem::temp_directory_path() / "bricksim_test_mapped_blob_store.bin";
+    }
+
+    MappedBlobStore openStore(const std::vector<std::string>& headerValues = {"2023-01", "abc"}, const MappedBlobStore::magic_t& magic = MAGIC, uint32_t formatVersion = FORMAT_VERSION) {
+        return {getStorePath(), "test store", magic, formatVersion, headerValues};
+    }
+
+    std::vector<uint8_t> createData(uint8_t seed, std::size_t size = 16) {
+        std::vector<uint8_t> data(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<uint8_t>(seed + i);
+        }
+        return data;
+    }
+
+    bool equals(std::span<const uint8_t> actual, const std::vector<uint8_t>& expected) {
+        return std::equal(actual.begin(), actual.end(), expected.begin(), expected.end());
+    }
+}
+
+TEST_CASE("MappedBlobStore roundtrip") {
+    std::filesystem::remove(getStorePath());
+    {
+        auto store = openStore();
+        CHECK(store.getEntryCount() == 0);
+        CHECK(store.read("a", 42).empty());
+        store.put("a", 42, createData(1));
+        store.put("b", 7, createData(2));
+        //0 means unknown, these can't be cached
+        store.put("c", 0, createData(3));
+        CHECK(equals(store.read("a", 42), createData(1)));
+        CHECK(store.read("a", 43).empty());
+        CHECK(store.getNewEntryCount() == 2);
+        store.save();
+        CHECK(store.getNewEntryCount() == 0);
+        CHECK(store.getEntryCount() == 2);
+        CHECK(equals(store.read("a", 42), createData(1)));
+    }
+
+    auto store = openStore();
+    CHECK(store.getEntryCount() == 2);
+    CHECK(equals(store.read("a", 42), createData(1)));
+    CHECK(store.read("a", 43).empty());
+    CHECK(store.read("a", 0).empty());
+    CHECK(equals(store.read("b", 7), createData(2)));
+    CHECK(store.read("c", 0).empty());
+    CHECK(store.read("d", 42).empty());
+    std::filesystem::remove(getStorePath());
+}
+
+TEST_CASE("MappedBlobStore growth") {
+    std::filesystem::remove(getStorePath());
+    {
+        auto store = openStore();
+        store.put("a", 1, createData(1));
+        store.put("b", 1, createData(2));
+        store.save();
+    }
+    {
+        auto store = openStore();
+        //saving without new entries doesn't touch the file
+        store.save();
+        CHECK(store.getEntryCount() == 2);
+
+        store.put("c", 1, createData(3, 100000));
+        //a changed source replaces the old entry
+        store.put("a", 2, createData(4));
+        store.put("a", 3, createData(5));
+        CHECK(store.getEntryCount() == 3);
+        CHECK(store.read("a", 1).empty());
+        CHECK(equals(store.read("a", 3), createData(5)));
+        store.save();
+        CHECK(store.getEntryCount() == 3);
+    }
+
+    auto store = openStore();
+    CHECK(store.getEntryCount() == 3);
+    CHECK(store.read("a", 1).empty());
+    CHECK(store.read("a", 2).empty());
+    CHECK(equals(store.read("a", 3), createData(5)));
+    CHECK(equals(store.read("b", 1), createData(2)));
+    CHECK(equals(store.read("c", 1), createData(3, 100000)));
+    std::filesystem::remove(getStorePath());
+}
+
+TEST_CASE("MappedBlobStore reopen with a different header") {
+    std::filesystem::remove(getStorePath());
+    {
+        auto store = openStore();
+        store.put("a", 42, createData(1));
+        store.save();
+    }
+
+    CHECK(openStore({"2023-02", "abc"}).getEntryCount() == 0);
+    CHECK(openStore({"2023-01", "def"}).getEntryCount() == 0);
+    CHECK(openStore({"2023-01", "abc"}, {'O', 'T', 'H', 'E', 'R', '0', '0', '1'}).getEntryCount() == 0);
+    CHECK(openStore({"2023-01", "abc"}, MAGIC, FORMAT_VERSION + 1).getEntryCount() == 0);
+    CHECK(openStore().getEntryCount() == 1);
+
+    //the file of the other version is replaced at the next save
+    {
+        auto store = openStore({"2023-02", "abc"});
+        store.put("b", 42, createData(2));
+        store.save();
+        CHECK(store.getEntryCount() == 1);
+    }
+    CHECK(openStore().getEntryCount() == 0);
+    std::filesystem::remove(getStorePath());
+}
+
+TEST_CASE("MappedBlobStore corrupt file") {
+    std::filesystem::remove(getStorePath());
+    {
+        auto store = openStore();
+        store.put("a", 42, createData(1));
+        store.save();
+    }
+    const auto fileSize = std::filesystem::file_size(getStorePath());
+
+    SECTION("truncated") {
+        std::filesystem::resize_file(getStorePath(), fileSize - 10);
+    }
+    SECTION("only a part of the header") {
+        std::filesystem::resize_file(getStorePath(), 10);
+    }
+    SECTION("index offset out of range") {
+        std::fstream file(getStorePath(), std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(static_cast<std::streamoff>(MAGIC.size() + sizeof(FORMAT_VERSION)));
+        const uint64_t indexOffset = fileSize * 2;
+        file.write(reinterpret_cast<const char*>(&indexOffset), sizeof(indexOffset));
+    }
+
+    auto store = openStore();
+    CHECK(store.getEntryCount() == 0);
+    CHECK(store.read("a", 42).empty());
+
+    //a corrupt file is replaced by the next save
+    store.put("b", 42, createData(2));
+    store.save();
+    CHECK(equals(openStore().read("b", 42), createData(2)));
+    std::filesystem::remove(getStorePath());
+}
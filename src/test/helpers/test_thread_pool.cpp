@@ -0,0 +1,107 @@
+#include "../../helpers/thread_pool.h"
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/generators/catch_generators.hpp"
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace bricksim {
+    TEST_CASE("thread_pool::parallelFor covers every index exactly once") {
+        const std::size_t count = GENERATE(0, 1, 7, 100, 10007);
+        const std::size_t grainSize = GENERATE(1, 3, 64, 100000);
+        std::vector<std::atomic<int>> visits(count);
+        thread_pool::parallelFor(count, grainSize, [&visits, grainSize](std::size_t begin, std::size_t end) {
+            CHECK(begin < end);
+            CHECK(end - begin <= grainSize);
+            for (auto i = begin; i < end; ++i) {
+                ++visits[i];
+            }
+        });
+        for (const auto& v: visits) {
+            CHECK(v == 1);
+        }
+    }
+
+    TEST_CASE("thread_pool::parallelFor nested inside jobs and other parallelFor calls") {
+        constexpr std::size_t OUTER = 16;
+        constexpr std::size_t INNER = 1000;
+        std::vector<std::size_t> sums(OUTER);
+        auto job = thread_pool::submit(
+                [&sums]() {
+                    thread_pool::parallelFor(OUTER, 1, [&sums](std::size_t begin, std::size_t end) {
+                        CHECK(thread_pool::isWorkerThread());
+                        for (auto i = begin; i < end; ++i) {
+                            std::atomic<std::size_t> sum = 0;
+                            thread_pool::parallelFor(INNER, 10, [&sum](std::size_t innerBegin, std::size_t innerEnd) {
+                                for (auto j = innerBegin; j < innerEnd; ++j) {
+                                    sum += j;
+                                }
+                            });
+                            sums[i] = sum;
+                        }
+                    });
+                },
+                thread_pool::Priority::BACKGROUND);
+        job->wait();
+        CHECK(job->getState() == thread_pool::Job::State::DONE);
+        for (const auto& sum: sums) {
+            CHECK(sum == INNER * (INNER - 1) / 2);
+        }
+    }
+
+    TEST_CASE("thread_pool::parallelFor rethrows the exception of a range") {
+        std::atomic<std::size_t> processed = 0;
+        CHECK_THROWS_AS(thread_pool::parallelFor(1000, 1, [&processed](std::size_t begin, std::size_t) {
+                            if (begin == 10) {
+                                throw std::runtime_error("range 10 failed");
+                            }
+                            ++processed;
+                        }),
+                        std::runtime_error);
+        CHECK(processed < 1000);
+    }
+
+    TEST_CASE("thread_pool::Job progress, exceptions and cancellation") {
+        SECTION("progress is 1 when done") {
+            auto job = thread_pool::submit(
+                    [](float* progress) {
+                        *progress = .5f;
+                    },
+                    thread_pool::Priority::FOREGROUND,
+                    .25f);
+            job->wait();
+            CHECK(job->isDone());
+            CHECK(job->getProgress() == 1.f);
+        }
+        SECTION("wait rethrows the exception") {
+            auto job = thread_pool::submit([]() { throw std::invalid_argument("test"); }, thread_pool::Priority::FOREGROUND);
+            CHECK_THROWS_AS(job->wait(), std::invalid_argument);
+        }
+        SECTION("running jobs see the cancel request, pending jobs are not started") {
+            std::atomic<bool> started = false;
+            auto running = thread_pool::submit(
+                    [&started]() {
+                        started = true;
+                        while (!thread_pool::isCurrentJobCancelled()) {
+                            std::this_thread::yield();
+                        }
+                    },
+                    thread_pool::Priority::BACKGROUND);
+            while (!started) {
+                std::this_thread::yield();
+            }
+            running->cancel();
+            running->wait();
+            CHECK(running->getState() == thread_pool::Job::State::DONE);
+
+            std::atomic<bool> executed = false;
+            auto pending = std::make_shared<thread_pool::Job>([&executed](float*) { executed = true; }, thread_pool::Priority::BACKGROUND, 0.f);
+            pending->cancel();
+            pending->run();
+            pending->wait();
+            CHECK(pending->getState() == thread_pool::Job::State::CANCELLED);
+            CHECK_FALSE(executed);
+        }
+    }
+}
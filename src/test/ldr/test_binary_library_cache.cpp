@@ -0,0 +1,111 @@
+#include "../../ldr/binary_library_cache.h"
+#include "../../ldr/file_reader.h"
+#include "../testing_tools.h"
+#include <atomic>
+#include <thread>
+
+using namespace bricksim::ldr;
+
+namespace {
+    constexpr auto CONTENT = "0 Brick  2 x  4\n"
+                             "0 Name: 3001.dat\n"
+                             "0 Author: James Jessiman\n"
+                             "0 !LDRAW_ORG Part UPDATE 2004-03\n"
+                             "0 !KEYWORDS first, second\n"
+                             "0 BFC CERTIFY CCW\n"
+                             "0 !LDCAD SNAP_CYL [gender=M] [caps=one] [secs=R 6 4] [pos=0 -4 0]\n"
+                             "1 16 0 4 0 1 0 0 0 1 0 0 0 1 s\\3001s01.dat\n"
+                             "0 BFC INVERTNEXT\n"
+                             "1 16 0 4 0 1 0 0 0 -1 0 0 0 1 stud.dat\n"
+                             "2 24 1 2 3 4 5 6\n"
+                             "3 16 1 2 3 4 5 6 7 8 9\n"
+                             "4 16 1 2 3 4 5 6 7 8 9 10 11 12\n"
+                             "5 24 1 2 3 4 5 6 7 8 9 10 11 12\n";
+
+    std::filesystem::path getCachePath() {
+        return std::filesystem::temp_directory_path() / "bricksim_test_library_cache.bin";
+    }
+}
+
+TEST_CASE("ldr::BinaryLibraryCache roundtrip") {
+    const auto path = getCachePath();
+    std::filesystem::remove(path);
+    const auto original = readSimpleFile(nullptr, "3001.dat", "", FileType::PART, CONTENT, {});
+    REQUIRE(BinaryLibraryCache::canBeCached(original));
+    {
+        BinaryLibraryCache cache(path, "2023-01", "abc");
+        cache.put("parts/3001.dat", 42, original);
+        cache.save();
+        CHECK(cache.getEntryCount() == 1);
+    }
+
+    BinaryLibraryCache cache(path, "2023-01", "abc");
+    const auto cached = cache.read("parts/3001.dat", FileType::PART, 42);
+    REQUIRE(cached != nullptr);
+    CHECK(cached->metaInfo.title == original->metaInfo.title);
+    CHECK(cached->metaInfo.name == original->metaInfo.name);
+    CHECK(cached->metaInfo.author == original->metaInfo.author);
+    CHECK(cached->metaInfo.keywords == original->metaInfo.keywords);
+    CHECK(cached->metaInfo.type == FileType::PART);
+    CHECK(cached->ldcadMetas.size() == original->ldcadMetas.size());
+    REQUIRE(cached->elements.size() == original->elements.size());
+    for (std::size_t i = 0; i < original->elements.size(); ++i) {
+        CHECK(cached->elements[i]->getType() == original->elements[i]->getType());
+        CHECK(cached->elements[i]->getLdrLine() == original->elements[i]->getLdrLine());
+        CHECK(cached->elements[i]->step == original->elements[i]->step);
+    }
+    const auto stud = std::find_if(cached->elements.cbegin(), cached->elements.cend(), [](const auto& element) {
+        return element->getType() == 1 && std::static_pointer_cast<SubfileReference>(element)->filename == "stud.dat";
+    });
+    REQUIRE(stud != cached->elements.cend());
+    CHECK(std::static_pointer_cast<SubfileReference>(*stud)->bfcInverted);
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("ldr::BinaryLibraryCache ignores other LDConfig") {
+    const auto path = getCachePath();
+    std::filesystem::remove(path);
+    {
+        BinaryLibraryCache cache(path, "2023-01", "abc");
+        cache.put("parts/3001.dat", 42, readSimpleFile(nullptr, "3001.dat", "", FileType::PART, CONTENT, {}));
+        cache.save();
+    }
+    CHECK(BinaryLibraryCache(path, "2023-01", "def").read("parts/3001.dat", FileType::PART, 42) == nullptr);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("ldr::BinaryLibraryCache read while saving") {
+    const auto path = getCachePath();
+    std::filesystem::remove(path);
+    const auto original = readSimpleFile(nullptr, "3001.dat", "", FileType::PART, CONTENT, {});
+    BinaryLibraryCache cache(path, "2023-01", "abc");
+    cache.put("parts/3001.dat", 42, original);
+    cache.save();
+
+    std::atomic<bool> stop = false;
+    std::atomic<int> failedReads = 0;
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&]() {
+            while (!stop) {
+                const auto cached = cache.read("parts/3001.dat", FileType::PART, 42);
+                if (cached == nullptr || cached->elements.size() != original->elements.size()) {
+                    ++failedReads;
+                }
+            }
+        });
+    }
+    //every save replaces the mapping which the readers are using
+    for (int i = 0; i < 20; ++i) {
+        cache.put("parts/" + std::to_string(4000 + i) + ".dat", 42, original);
+        cache.save();
+    }
+    stop = true;
+    for (auto& reader: readers) {
+        reader.join();
+    }
+    CHECK(failedReads == 0);
+    CHECK(cache.getEntryCount() == 21);
+    std::filesystem::remove(path);
+}
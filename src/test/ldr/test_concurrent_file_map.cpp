@@ -0,0 +1,52 @@
+#include "../../ldr/concurrent_file_map.h"
+#include "../testing_tools.h"
+#include <atomic>
+#include <thread>
+
+using namespace bricksim::ldr;
+
+TEST_CASE("ldr::ConcurrentFileMap insert and find") {
+    ConcurrentFileMap map;
+    const auto file = std::make_shared<File>();
+    CHECK(map.find(nullptr, "3001.dat") == nullptr);
+    CHECK(map.insert(nullptr, "3001.dat", FileType::PART, file) == file);
+    CHECK(map.insert(nullptr, "3001.dat", FileType::PART, std::make_shared<File>()) == file);
+    CHECK(map.find(nullptr, "3001.dat") == file);
+    CHECK(map.size() == 1);
+    map.erase(nullptr, "3001.dat");
+    CHECK_FALSE(map.contains(nullptr, "3001.dat"));
+}
+
+TEST_CASE("ldr::ConcurrentFileMap loads every name only once") {
+    ConcurrentFileMap map;
+    std::atomic<int> loadCount = 0;
+    std::vector<std::shared_ptr<File>> results(8);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back([&map, &loadCount, &results, i]() {
+            results[i] = map.getOrLoad(nullptr, "3001.dat", [&map, &loadCount]() {
+                ++loadCount;
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                return map.insert(nullptr, "3001.dat", FileType::PART, std::make_shared<File>());
+            });
+        });
+    }
+    for (auto& t: threads) {
+        t.join();
+    }
+    CHECK(loadCount == 1);
+    for (const auto& result: results) {
+        CHECK(result == results[0]);
+    }
+}
+
+TEST_CASE("ldr::ConcurrentFileMap passes loader exception to waiting threads") {
+    ConcurrentFileMap map;
+    const auto loader = []() -> std::shared_ptr<File> {
+        throw std::invalid_argument("not found");
+    };
+    CHECK_THROWS_AS(map.getOrLoad(nullptr, "missing.dat", loader), std::invalid_argument);
+    //the failed load must not stay in flight
+    const auto file = std::make_shared<File>();
+    CHECK(map.getOrLoad(nullptr, "missing.dat", [&map, &file]() { return map.insert(nullptr, "missing.dat", FileType::PART, file); }) == file);
+}
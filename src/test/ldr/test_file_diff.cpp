@@ -0,0 +1,98 @@
+#include "../../ldr/file_diff.h"
+#include "../../ldr/file_reader.h"
+#include "../testing_tools.h"
+
+using namespace bricksim::ldr;
+
+namespace {
+    std::shared_ptr<File> readModel(const std::string& content) {
+        return readSimpleFile(nullptr, "model.ldr", "", FileType::MODEL, content, {});
+    }
+
+    std::vector<std::string> getLines(const std::vector<std::shared_ptr<FileElement>>& elements) {
+        std::vector<std::string> lines;
+        for (const auto& element: elements) {
+            lines.push_back(element->getLdrLine());
+        }
+        return lines;
+    }
+}
+
+TEST_CASE("ldr::patchFile") {
+    const auto file = readModel("0 Title\n"
+                                "2 24 0 0 0 1 1 1\n"
+                                "2 24 0 0 0 2 2 2\n"
+                                "0 STEP\n"
+                                "2 24 0 0 0 3 3 3\n"
+                                "2 24 0 0 0 4 4 4");
+    const auto oldElements = file->elements;
+    REQUIRE(oldElements.size() == 5);
+
+    SECTION("unchanged file") {
+        const auto diff = patchFile(file, *readModel("0 Title\n"
+                                                      "2 24 0 0 0 1 1 1\n"
+                                                      "2 24 0 0 0 2 2 2\n"
+                                                      "0 STEP\n"
+                                                      "2 24 0 0 0 3 3 3\n"
+                                                      "2 24 0 0 0 4 4 4"));
+        CHECK(diff.empty());
+        CHECK(file->elements == oldElements);
+    }
+    SECTION("changed line in the middle") {
+        const auto diff = patchFile(file, *readModel("0 Title\n"
+                                                      "2 24 0 0 0 1 1 1\n"
+                                                      "2 24 0 0 0 9 9 9\n"
+                                                      "0 STEP\n"
+                                                      "2 24 0 0 0 3 3 3\n"
+                                                      "2 24 0 0 0 4 4 4"));
+        CHECK(diff.file == file);
+        CHECK(getLines(diff.removedElements) == std::vector<std::string>{"2 24 0 0 0 2 2 2"});
+        CHECK(getLines(diff.addedElements) == std::vector<std::string>{"2 24 0 0 0 9 9 9"});
+        CHECK_FALSE(diff.metaInfoChanged);
+        REQUIRE(file->elements.size() == 5);
+        CHECK(file->elements[0] == oldElements[0]);
+        CHECK(file->elements[1] == diff.addedElements[0]);
+        CHECK(file->elements[2] == oldElements[2]);
+        CHECK(file->elements[3] == oldElements[3]);
+        CHECK(file->elements[4] == oldElements[4]);
+    }
+    SECTION("removed step updates the steps of the kept elements") {
+        const auto diff = patchFile(file, *readModel("0 Title\n"
+                                                      "2 24 0 0 0 1 1 1\n"
+                                                      "2 24 0 0 0 2 2 2\n"
+                                                      "2 24 0 0 0 3 3 3\n"
+                                                      "2 24 0 0 0 4 4 4"));
+        CHECK(getLines(diff.removedElements) == std::vector<std::string>{"0 STEP"});
+        CHECK(diff.addedElements.empty());
+        REQUIRE(file->elements.size() == 4);
+        CHECK(file->elements[2] == oldElements[3]);
+        CHECK(file->elements[2]->step == file->elements[0]->step);
+    }
+    SECTION("inserted and moved lines") {
+        const auto diff = patchFile(file, *readModel("0 Title\n"
+                                                      "2 24 0 0 0 4 4 4\n"
+                                                      "2 24 0 0 0 1 1 1\n"
+                                                      "2 24 0 0 0 5 5 5\n"
+                                                      "2 24 0 0 0 2 2 2\n"
+                                                      "0 STEP\n"
+                                                      "2 24 0 0 0 3 3 3"));
+        CHECK(getLines(diff.removedElements) == std::vector<std::string>{"2 24 0 0 0 4 4 4"});
+        CHECK(getLines(diff.addedElements) == std::vector<std::string>{"2 24 0 0 0 4 4 4", "2 24 0 0 0 5 5 5"});
+        CHECK(getLines(file->elements) == std::vector<std::string>{"2 24 0 0 0 4 4 4", "2 24 0 0 0 1 1 1", "2 24 0 0 0 5 5 5", "2 24 0 0 0 2 2 2", "0 STEP", "2 24 0 0 0 3 3 3"});
+        CHECK(file->elements[1] == oldElements[0]);
+        CHECK(file->elements[5] == oldElements[3]);
+    }
+    SECTION("changed header") {
+        const auto diff = patchFile(file, *readModel("0 Other Title\n"
+                                                      "2 24 0 0 0 1 1 1\n"
+                                                      "2 24 0 0 0 2 2 2\n"
+                                                      "0 STEP\n"
+                                                      "2 24 0 0 0 3 3 3\n"
+                                                      "2 24 0 0 0 4 4 4"));
+        CHECK(diff.metaInfoChanged);
+        CHECK(diff.removedElements.empty());
+        CHECK(diff.addedElements.empty());
+        CHECK(file->metaInfo.title == "Other Title");
+        CHECK(file->elements == oldElements);
+    }
+}
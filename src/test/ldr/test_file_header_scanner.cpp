@@ -0,0 +1,72 @@
+#include "../../ldr/file_header_scanner.h"
+#include "../../ldr/file_reader.h"
+#include "../testing_tools.h"
+#include "catch2/generators/catch_generators_all.hpp"
+
+using namespace bricksim::ldr;
+
+namespace {
+    const std::string PART_CONTENT = "0 ~Brick  2 x  4 Dummy\r\n"
+                                     "0 Name: 3001.dat\r\n"
+                                     "0 Author: AuthorXYZ\r\n"
+                                     "0 !LDRAW_ORG Part UPDATE 2004-03\r\n"
+                                     "0 !LICENSE LicenseXYZ\r\n"
+                                     "\r\n"
+                                     "0 !CATEGORY CategoryXYZ\r\n"
+                                     "0 !KEYWORDS KeywordX, KeywordY\r\n"
+                                     "0 !HISTORY HistoryX\r\n"
+                                     "0 BFC CERTIFY CCW\r\n"
+                                     "1 16 0 0 0 1 0 0 0 1 0 0 0 1 s\\3001s01.dat\r\n"
+                                     "4 16 1 2 3 4 5 6 7 8 9 10 11 12\r\n"
+                                     "0 !KEYWORDS KeywordAfterGeometry\r\n";
+}
+
+TEST_CASE("ldr::scanFileHeader finds the same header as the full parser") {
+    const auto file = readSimpleFile(nullptr, "3001.dat", "", FileType::PART, PART_CONTENT, {});
+    auto metaInfo = scanFileHeader(PART_CONTENT, FileType::PART);
+    CHECK(metaInfo.type == FileType::PART);
+    CHECK(metaInfo.title == file->metaInfo.title);
+    CHECK(metaInfo.name == "3001.dat");
+    CHECK(metaInfo.author == file->metaInfo.author);
+    CHECK(metaInfo.fileTypeLine == file->metaInfo.fileTypeLine);
+    CHECK(metaInfo.license == file->metaInfo.license);
+    CHECK(metaInfo.getCategory() == file->metaInfo.getCategory());
+    CHECK(metaInfo.getUpdateId() == file->metaInfo.getUpdateId());
+    CHECK(metaInfo.history == file->metaInfo.history);
+    //lines after the first geometry line are not read
+    CHECK(metaInfo.keywords == bricksim::oset_t<std::string>({"KeywordX", "KeywordY"}));
+}
+
+TEST_CASE("ldr::FileHeaderScanner with content split into chunks") {
+    const std::size_t chunkSize = GENERATE(1, 2, 7, 64, 4096);
+    FileHeaderScanner scanner(FileType::PART);
+    std::size_t consumed = 0;
+    while (consumed < PART_CONTENT.size() && scanner.addData(std::string_view(PART_CONTENT).substr(consumed, chunkSize))) {
+        consumed += chunkSize;
+    }
+    CHECK(scanner.isComplete());
+    CHECK(consumed < PART_CONTENT.size());
+    scanner.finish();
+    auto& metaInfo = scanner.getMetaInfo();
+    CHECK(metaInfo.title == "~Brick  2 x  4 Dummy");
+    CHECK(metaInfo.getCategory() == "CategoryXYZ");
+    CHECK(metaInfo.getUpdateId() == "2004-03");
+    CHECK(metaInfo.history == std::vector<std::string>({"HistoryX"}));
+}
+
+TEST_CASE("ldr::FileHeaderScanner without geometry and line break at the end") {
+    FileHeaderScanner scanner(FileType::PRIMITIVE);
+    CHECK(scanner.addData("0 Title\n0 !LDRAW_ORG Primitive UPDATE 2021-01"));
+    CHECK_FALSE(scanner.isComplete());
+    scanner.finish();
+    CHECK(scanner.isComplete());
+    CHECK(scanner.getMetaInfo().title == "Title");
+    CHECK(scanner.getMetaInfo().getUpdateId() == "2021-01");
+}
+
+TEST_CASE("ldr::scanFileHeader stops at the second FILE line of an MPD") {
+    auto metaInfo = scanFileHeader("0 FILE main.ldr\n0 Main Title\n0 Name: main.ldr\n0 FILE sub.ldr\n0 Sub Title\n0 Author: SubAuthor\n", FileType::MODEL);
+    CHECK(metaInfo.title == "Main Title");
+    CHECK(metaInfo.name == "main.ldr");
+    CHECK(metaInfo.author.empty());
+}
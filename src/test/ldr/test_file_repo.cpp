@@ -0,0 +1,63 @@
+#include "../../ldr/file_repo.h"
+#include "../file_repo_testing_tools.h"
+#include "../testing_tools.h"
+
+using namespace bricksim::ldr;
+
+namespace {
+    std::filesystem::path createModelDirectory(const std::string& name) {
+        const auto directory = std::filesystem::temp_directory_path() / "bricksim_test_file_repo" / name;
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        return directory;
+    }
+
+    void writeFile(const std::filesystem::path& path, const std::string& content) {
+        std::ofstream(path, std::ios::binary) << content;
+    }
+}
+
+TEST_CASE("ldr::FileRepo::reloadFile") {
+    auto& repo = initializeTestFileRepo();
+    const auto directory = createModelDirectory("reload");
+    const auto fileNamespace = std::make_shared<FileNamespace>("reload", directory);
+    writeFile(directory / "reloadtest.ldr", "0 Old Title\n0 Name: reloadtest.ldr\n2 24 0 0 0 1 1 1\n");
+    const auto oldFile = repo.getFile(fileNamespace, "reloadtest.ldr");
+    REQUIRE(oldFile->metaInfo.title == "Old Title");
+
+    writeFile(directory / "reloadtest.ldr", "0 New Title\n0 Name: reloadtest.ldr\n2 24 0 0 0 1 1 1\n2 24 0 0 0 2 2 2\n");
+    CHECK(repo.getFile(fileNamespace, "reloadtest.ldr") == oldFile);
+
+    const auto newFile = repo.reloadFile(fileNamespace, "reloadtest.ldr");
+    CHECK(newFile != oldFile);
+    CHECK(newFile->metaInfo.title == "New Title");
+    CHECK(newFile->elements.size() == 2);
+    CHECK(oldFile->metaInfo.title == "Old Title");
+    CHECK(repo.getFile(fileNamespace, "reloadtest.ldr") == newFile);
+    CHECK(repo.getFile(fileNamespace, "RELOADTEST.LDR") == newFile);
+}
+
+TEST_CASE("ldr::FileRepo::changeFileName") {
+    auto& repo = initializeTestFileRepo();
+    const auto oldDirectory = createModelDirectory("rename_old");
+    const auto newDirectory = createModelDirectory("rename_new");
+    const auto oldNamespace = std::make_shared<FileNamespace>("rename_old", oldDirectory);
+    const auto newNamespace = std::make_shared<FileNamespace>("rename_new", newDirectory);
+    const auto subFile = repo.addLdrFileWithContent(oldNamespace, "renamesub.ldr", oldDirectory / "renamesub.ldr", FileType::MODEL, "0 Sub\n0 Name: renamesub.ldr\n");
+    const auto file = repo.addLdrFileWithContent(oldNamespace, "renametest.ldr", oldDirectory / "renametest.ldr", FileType::MODEL, "0 Main\n0 Name: renametest.ldr\n1 16 0 0 0 1 0 0 0 1 0 0 0 1 renamesub.ldr\n");
+
+    repo.changeFileName(oldNamespace, file, newNamespace, "renamed.ldr");
+
+    const auto allFiles = repo.getAllFilesInMemory();
+    CHECK_FALSE(allFiles.contains(oldNamespace));
+    CHECK(file->metaInfo.name == "renamed.ldr");
+    CHECK(file->nameSpace == newNamespace);
+    CHECK(subFile->nameSpace == newNamespace);
+    CHECK(repo.getFile(newNamespace, "renamed.ldr") == file);
+
+    //the subfile keeps its location, so it's referenced relative to the new directory
+    const auto subFileReference = std::static_pointer_cast<SubfileReference>(file->elements.back());
+    const auto expectedReference = std::filesystem::relative(oldDirectory / "renamesub.ldr", newDirectory).generic_string();
+    CHECK(subFileReference->filename == expectedReference);
+    CHECK(repo.getFile(newNamespace, expectedReference) == subFile);
+}
@@ -1,5 +1,6 @@
 #include "../../ldr/file_reader.h"
 #include "../../ldr/files.h"
+#include "../../ldr/line_tokenizer.h"
 #include "../testing_tools.h"
 #include "catch2/generators/catch_generators_all.hpp"
 #include <glm/gtx/normal.hpp>
@@ -141,3 +142,63 @@ TEST_CASE("ldr::readSimpleFile with MetaInfo") {
     CHECK(file->elements.size() == 1);
     CHECK(file->elements[0]->getLdrLine()=="0 Content");
 }
+
+TEST_CASE("ldr::readSimpleFile elements outlive file") {
+    auto file = readSimpleFile(nullptr, "filename.dat", "", FileType::PART, "0 Title\n3 16 1 2 3 4 5 6 7 8 9\n2 24 1 2 3 4 5 6", {});
+    REQUIRE(file->elements.size() == 2);
+    const auto triangle = file->elements[0];
+    const auto line = file->elements[1];
+    file = nullptr;
+    CHECK(triangle->getType() == 3);
+    CHECK(line->getType() == 2);
+    CHECK(line->getLdrLine() == "2 24 1 2 3 4 5 6");
+}
+
+TEST_CASE("parse ldr::Triangle and ldr::Quadrilateral with CW winding order") {
+    const auto triangle = Triangle("16 1 2 3 4 5 6 7 8 9", WindingOrder::CW);
+    CHECK(triangle.coords == std::array<float, 9>{1, 2, 3, 7, 8, 9, 4, 5, 6});
+    const auto quad = Quadrilateral("16 1 2 3 4 5 6 7 8 9 10 11 12", WindingOrder::CW);
+    CHECK(quad.coords == std::array<float, 12>{1, 2, 3, 10, 11, 12, 7, 8, 9, 4, 5, 6});
+}
+
+TEST_CASE("ldr::tokenizer::parseColorAndNumbers") {
+    int color = 0;
+    std::array<float, 12> numbers{};
+    SECTION("short line") {
+        const std::string_view line = " 4\t0.5 -1e2   3 x";
+        const auto end = tokenizer::parseColorAndNumbers(line, color, numbers.data(), 3);
+        CHECK(color == 4);
+        CHECK(numbers[0] == Catch::Approx(.5f));
+        CHECK(numbers[1] == Catch::Approx(-100.f));
+        CHECK(numbers[2] == Catch::Approx(3.f));
+        CHECK(line.substr(end) == " x");
+    }
+    SECTION("numbers crossing the 64 byte blocks") {
+        std::string line = "16";
+        for (int i = 0; i < 12; ++i) {
+            line += std::string(static_cast<std::size_t>(i * 3 + 1), ' ') + std::to_string(i) + ".25";
+        }
+        const auto end = tokenizer::parseColorAndNumbers(line, color, numbers.data(), numbers.size());
+        CHECK(color == 16);
+        for (int i = 0; i < 12; ++i) {
+            CHECK(numbers[i] == Catch::Approx(i + .25f));
+        }
+        CHECK(end == line.size());
+    }
+    SECTION("missing numbers are zero") {
+        numbers.fill(7.f);
+        tokenizer::parseColorAndNumbers("2 1", color, numbers.data(), 3);
+        CHECK(color == 2);
+        CHECK(numbers[0] == Catch::Approx(1.f));
+        CHECK(numbers[1] == 0.f);
+        CHECK(numbers[2] == 0.f);
+    }
+}
+
+TEST_CASE("ldr::tokenizer::forEachLine") {
+    std::vector<std::string> lines;
+    tokenizer::forEachLine("first line with more than sixteen characters\r\nsecond\nthird", [&lines](std::string_view line) {
+        lines.emplace_back(line);
+    });
+    CHECK(lines == std::vector<std::string>{"first line with more than sixteen characters", "", "second", "third"});
+}
@@ -0,0 +1,78 @@
+#include "../../ldr/zip_archive_pool.h"
+#include "../testing_tools.h"
+#include <atomic>
+#include <thread>
+
+using namespace bricksim::ldr::file_repo;
+
+namespace {
+    std::filesystem::path getZipPath() {
+        return std::filesystem::temp_directory_path() / "bricksim_test_zip_archive_pool.zip";
+    }
+
+    void writeZip(const std::filesystem::path& path, const std::vector<std::pair<std::string, std::string>>& entries) {
+        int errorCode;
+        zip_t* archive = zip_open(path.string().c_str(), ZIP_CREATE | ZIP_TRUNCATE, &errorCode);
+        REQUIRE(archive != nullptr);
+        for (const auto& [name, content]: entries) {
+            zip_source_t* source = zip_source_buffer(archive, content.data(), content.size(), 0);
+            REQUIRE(source != nullptr);
+            REQUIRE(zip_file_add(archive, name.c_str(), source, ZIP_FL_OVERWRITE | ZIP_FL_ENC_UTF_8) >= 0);
+        }
+        REQUIRE(zip_close(archive) == 0);
+    }
+}
+
+TEST_CASE("ldr::file_repo::ZipArchivePool read") {
+    const auto path = getZipPath();
+    writeZip(path, {{"ldraw/parts/3001.dat", "0 Brick  2 x  4\n"}, {"ldraw/LDConfig.ldr", "0 LDraw.org Configuration File\n"}});
+    ZipArchivePool pool(path);
+    REQUIRE(pool.isValid());
+
+    CHECK(pool.readString("ldraw/parts/3001.dat") == "0 Brick  2 x  4\n");
+    CHECK(pool.readString("LDRAW/PARTS/3001.DAT") == "0 Brick  2 x  4\n");
+    CHECK_FALSE(pool.readString("ldraw/parts/3002.dat").has_value());
+    CHECK(pool.stat("ldraw/LDConfig.ldr")->size == 31);
+
+    std::string firstChunk;
+    CHECK(pool.readChunks("ldraw/parts/3001.dat", [&firstChunk](std::string_view chunk) {
+        firstChunk = chunk;
+        return false;
+    }));
+    CHECK(firstChunk == "0 Brick  2 x  4\n");
+}
+
+TEST_CASE("ldr::file_repo::ZipArchivePool modify while reading") {
+    const auto path = getZipPath();
+    writeZip(path, {{"ldraw/parts/3001.dat", "0 Version 0\n"}});
+    ZipArchivePool pool(path);
+    REQUIRE(pool.isValid());
+
+    std::atomic<bool> done = false;
+    std::atomic<int> failedReads = 0;
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+        readers.emplace_back([&pool, &done, &failedReads]() {
+            while (!done) {
+                const auto content = pool.readString("ldraw/parts/3001.dat");
+                if (!content.has_value() || !content->starts_with("0 Version ")) {
+                    ++failedReads;
+                }
+            }
+        });
+    }
+    for (int i = 1; i <= 20; ++i) {
+        pool.modify([&path, i]() {
+            //the index of the entry changes, so a stale index would read the wrong entry
+            writeZip(path, {{"ldraw/parts/other" + std::to_string(i) + ".dat", "0 Other\n"}, {"ldraw/parts/3001.dat", "0 Version " + std::to_string(i) + "\n"}});
+        });
+    }
+    done = true;
+    for (auto& reader: readers) {
+        reader.join();
+    }
+
+    CHECK(failedReads == 0);
+    CHECK(pool.readString("ldraw/parts/3001.dat") == "0 Version 20\n");
+    CHECK(pool.locate("ldraw/parts/3001.dat") == 1u);
+}
@@ -0,0 +1,140 @@
+#include "../element_tree.h"
+#include "../ldr/file_diff.h"
+#include "../ldr/file_reader.h"
+#include "../ldr/file_repo.h"
+#include "file_repo_testing_tools.h"
+#include "testing_tools.h"
+
+using namespace bricksim;
+
+namespace {
+    std::shared_ptr<ldr::FileNamespace> createNamespace(const std::string& name) {
+        return std::make_shared<ldr::FileNamespace>(name, getTestLibraryPath());
+    }
+
+    std::shared_ptr<etree::ModelNode> openModel(const std::shared_ptr<etree::RootNode>& rootNode, const std::shared_ptr<ldr::FileNamespace>& fileNamespace, const std::string& name, const std::string& content) {
+        auto& repo = initializeTestFileRepo();
+        const auto file = repo.addLdrFileWithContent(fileNamespace, name, getTestLibraryPath() / name, ldr::FileType::MODEL, content);
+        auto modelNode = std::make_shared<etree::ModelNode>(file, 1, rootNode);
+        modelNode->createChildNodes();
+        rootNode->addChild(modelNode);
+        return modelNode;
+    }
+
+    ldr::FileDiff patchModel(const std::shared_ptr<ldr::File>& file, const std::string& newContent) {
+        return ldr::patchFile(file, *ldr::readSimpleFile(nullptr, file->metaInfo.name, "", file->metaInfo.type, newContent, {}));
+    }
+
+    std::vector<std::string> getDisplayNames(const std::shared_ptr<etree::Node>& node) {
+        std::vector<std::string> names;
+        for (const auto& child: node->getChildren()) {
+            names.push_back(child->displayName);
+        }
+        return names;
+    }
+}
+
+TEST_CASE("etree::RootNode::replaceInvalidatedFiles") {
+    auto& repo = initializeTestFileRepo();
+    const auto oldPart = repo.addLdrFileWithContent(nullptr, "invalidationtest.dat", "", ldr::FileType::PART, "0 Old Part\n0 Name: invalidationtest.dat\n2 24 0 0 0 1 1 1\n");
+    const auto rootNode = std::make_shared<etree::RootNode>();
+    const auto modelNode = openModel(rootNode, createNamespace("invalidationtest.ldr"), "invalidationtest.ldr", "0 Model\n1 16 0 0 0 1 0 0 0 1 0 0 0 1 invalidationtest.dat\n");
+    REQUIRE(modelNode->getChildren().size() == 1);
+    const auto partNode = std::dynamic_pointer_cast<etree::PartNode>(modelNode->getChildren()[0]);
+    REQUIRE(partNode != nullptr);
+    CHECK(partNode->ldrFile == oldPart);
+
+    //the library file is changed while the model is open
+    const auto invalidatedFiles = repo.invalidateLibraryFiles({"parts/invalidationtest.dat"});
+    CHECK(invalidatedFiles == std::vector<std::shared_ptr<ldr::File>>{oldPart});
+    const auto newPart = repo.addLdrFileWithContent(nullptr, "invalidationtest.dat", "", ldr::FileType::PART, "0 New Part\n0 Name: invalidationtest.dat\n2 24 0 0 0 2 2 2\n");
+    const auto versionBefore = rootNode->getVersion();
+    rootNode->replaceInvalidatedFiles({invalidatedFiles.cbegin(), invalidatedFiles.cend()});
+
+    REQUIRE(modelNode->getChildren().size() == 1);
+    CHECK(modelNode->getChildren()[0] == partNode);
+    CHECK(partNode->ldrFile == newPart);
+    CHECK(partNode->displayName == "New Part");
+    CHECK(partNode->getMeshIdentifier() == newPart->getHash());
+    CHECK(rootNode->getVersion() != versionBefore);
+}
+
+TEST_CASE("etree::LdrNode::applyFileDiff") {
+    auto& repo = initializeTestFileRepo();
+    repo.addLdrFileWithContent(nullptr, "difftesta.dat", "", ldr::FileType::PART, "0 Part A\n0 Name: difftesta.dat\n2 24 0 0 0 1 1 1\n");
+    repo.addLdrFileWithContent(nullptr, "difftestb.dat", "", ldr::FileType::PART, "0 Part B\n0 Name: difftestb.dat\n2 24 0 0 0 1 1 1\n");
+    repo.addLdrFileWithContent(nullptr, "difftestc.dat", "", ldr::FileType::PART, "0 Part C\n0 Name: difftestc.dat\n2 24 0 0 0 1 1 1\n");
+    const auto rootNode = std::make_shared<etree::RootNode>();
+    const auto modelNode = openModel(rootNode, createNamespace("difftest.ldr"), "difftest.ldr",
+                                     "0 Model\n"
+                                     "1 16 0 0 0 1 0 0 0 1 0 0 0 1 difftesta.dat\n"
+                                     "1 16 10 0 0 1 0 0 0 1 0 0 0 1 difftestb.dat\n"
+                                     "2 24 0 0 0 1 1 1\n");
+    REQUIRE(getDisplayNames(modelNode) == std::vector<std::string>{"Part A", "Part B"});
+    const auto oldChildren = modelNode->getChildren();
+    const auto versionBefore = modelNode->getVersion();
+
+    SECTION("inserted line") {
+        const auto diff = patchModel(modelNode->ldrFile,
+                                     "0 Model\n"
+                                     "1 16 0 0 0 1 0 0 0 1 0 0 0 1 difftesta.dat\n"
+                                     "1 16 20 0 0 1 0 0 0 1 0 0 0 1 difftestc.dat\n"
+                                     "1 16 10 0 0 1 0 0 0 1 0 0 0 1 difftestb.dat\n"
+                                     "2 24 0 0 0 1 1 1\n");
+        CHECK_FALSE(modelNode->applyFileDiff(diff));
+        CHECK(getDisplayNames(modelNode) == std::vector<std::string>{"Part A", "Part C", "Part B"});
+        CHECK(modelNode->getChildren()[0] == oldChildren[0]);
+        CHECK(modelNode->getChildren()[2] == oldChildren[1]);
+        CHECK(modelNode->getVersion() != versionBefore);
+    }
+    SECTION("deleted line") {
+        const auto diff = patchModel(modelNode->ldrFile,
+                                     "0 Model\n"
+                                     "1 16 10 0 0 1 0 0 0 1 0 0 0 1 difftestb.dat\n"
+                                     "2 24 0 0 0 1 1 1\n");
+        CHECK_FALSE(modelNode->applyFileDiff(diff));
+        REQUIRE(modelNode->getChildren().size() == 1);
+        CHECK(modelNode->getChildren()[0] == oldChildren[1]);
+    }
+    SECTION("modified reference line") {
+        const auto diff = patchModel(modelNode->ldrFile,
+                                     "0 Model\n"
+                                     "1 16 0 0 0 1 0 0 0 1 0 0 0 1 difftesta.dat\n"
+                                     "1 4 10 0 0 1 0 0 0 1 0 0 0 1 difftestb.dat\n"
+                                     "2 24 0 0 0 1 1 1\n");
+        CHECK_FALSE(modelNode->applyFileDiff(diff));
+        REQUIRE(modelNode->getChildren().size() == 2);
+        CHECK(modelNode->getChildren()[0] == oldChildren[0]);
+        CHECK(modelNode->getChildren()[1] != oldChildren[1]);
+        CHECK(std::dynamic_pointer_cast<etree::PartNode>(modelNode->getChildren()[1])->getElementColor().code == 4);
+    }
+    SECTION("modified line without its own node") {
+        const auto diff = patchModel(modelNode->ldrFile,
+                                     "0 Model\n"
+                                     "1 16 0 0 0 1 0 0 0 1 0 0 0 1 difftesta.dat\n"
+                                     "1 16 10 0 0 1 0 0 0 1 0 0 0 1 difftestb.dat\n"
+                                     "2 24 0 0 0 2 2 2\n");
+        CHECK(modelNode->applyFileDiff(diff));
+        CHECK(modelNode->getChildren() == oldChildren);
+    }
+}
+
+TEST_CASE("etree::RootNode::applyFileDiffs with a part inside of the model file") {
+    auto& repo = initializeTestFileRepo();
+    const auto fileNamespace = createNamespace("mpddifftest.mpd");
+    const auto subPart = repo.addLdrFileWithContent(fileNamespace, "mpddifftestpart.dat", getTestLibraryPath() / "mpddifftestpart.dat", ldr::FileType::PART, "0 MPD Part\n0 Name: mpddifftestpart.dat\n2 24 0 0 0 1 1 1\n");
+    const auto rootNode = std::make_shared<etree::RootNode>();
+    const auto modelNode = openModel(rootNode, fileNamespace, "mpddifftest.mpd", "0 Model\n1 16 0 0 0 1 0 0 0 1 0 0 0 1 mpddifftestpart.dat\n");
+    REQUIRE(modelNode->getChildren().size() == 1);
+    const auto partNode = std::dynamic_pointer_cast<etree::PartNode>(modelNode->getChildren()[0]);
+    REQUIRE(partNode != nullptr);
+    REQUIRE(partNode->ldrFile == subPart);
+
+    const auto diff = patchModel(subPart, "0 MPD Part\n0 Name: mpddifftestpart.dat\n2 24 0 0 0 5 5 5\n");
+    REQUIRE_FALSE(diff.empty());
+    const auto changedMeshes = rootNode->applyFileDiffs({diff});
+
+    CHECK(changedMeshes.contains(partNode->getMeshIdentifier()));
+    CHECK_FALSE(changedMeshes.contains(modelNode->getMeshIdentifier()));
+    CHECK(modelNode->getChildren()[0] == partNode);
+}
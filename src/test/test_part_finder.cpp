@@ -0,0 +1,59 @@
+#include "../part_finder.h"
+#include "testing_tools.h"
+
+using namespace bricksim;
+
+namespace {
+    std::vector<db::fileList::Entry> getEntries() {
+        return {
+                {"3001.dat", "Brick  2 x  4", "Brick", "Basic, Wall"},
+                {"3002.dat", "Brick  2 x  3", "Brick", ""},
+                {"3001p01.dat", "Brick  2 x  4 with Star Wars Pattern", "Brick", "Star Wars"},
+                {"3022.dat", "Plate  2 x  2", "Plate", ""},
+                {"32524.dat", "Technic Beam  7", "Technic", "Liftarm"},
+                {"s/3001s01.dat", "~Brick  2 x  4 without Front Face", "Brick", ""},
+        };
+    }
+}
+
+TEST_CASE("part_finder::SearchIndex") {
+    const part_finder::SearchIndex index(getEntries());
+    CHECK(index.getDocumentCount() == 6);
+
+    SECTION("empty query returns all files of the category") {
+        CHECK(index.search("", "Plate") == std::vector<std::string>{"3022.dat"});
+        CHECK(index.search("", "").size() == 6);
+    }
+    SECTION("unknown category") {
+        CHECK(index.search("brick", "Slope").empty());
+    }
+    SECTION("substring in name") {
+        CHECK(index.search("2524", "") == std::vector<std::string>{"32524.dat"});
+    }
+    SECTION("keywords are searched") {
+        CHECK(index.search("liftarm", "") == std::vector<std::string>{"32524.dat"});
+        CHECK(index.search("wall", "") == std::vector<std::string>{"3001.dat"});
+    }
+    SECTION("case insensitive") {
+        CHECK(index.search("TECHNIC beam", "") == std::vector<std::string>{"32524.dat"});
+    }
+    SECTION("all tokens have to match") {
+        CHECK(index.search("pattern brick", "") == std::vector<std::string>{"3001p01.dat"});
+        CHECK(index.search("brick zzz", "").empty());
+    }
+    SECTION("short tokens only match the beginning of a word") {
+        CHECK(index.search("ea", "").empty());
+        CHECK(index.search("be", "") == std::vector<std::string>{"32524.dat"});
+    }
+    SECTION("category filter") {
+        CHECK(index.search("2 x", "Plate") == std::vector<std::string>{"3022.dat"});
+    }
+    SECTION("exact title ranks before longer titles") {
+        const auto result = index.search("brick 2 x 4", "Brick");
+        REQUIRE(result.size() == 3);
+        CHECK(result[0] == "3001.dat");
+    }
+    SECTION("maxResults") {
+        CHECK(index.search("brick", "", 2).size() == 2);
+    }
+}
@@ -0,0 +1,67 @@
+#include "../transform_table.h"
+#include "testing_tools.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+using namespace bricksim::etree;
+
+namespace {
+    ///transposed like the transformations in etree::Node
+    glm::mat4 translation(float x, float y, float z) {
+        return glm::transpose(glm::translate(glm::mat4(1.f), {x, y, z}));
+    }
+}
+
+TEST_CASE("etree::TransformTable") {
+    TransformTable table;
+    const auto root = table.allocate(TransformTable::NO_ID, glm::mat4(1.f));
+    const auto a = table.allocate(root, translation(1, 0, 0));
+    const auto b = table.allocate(a, translation(0, 2, 0));
+    CHECK(table.size() == 3);
+    CHECK(table.getAbsolute(b) == translation(1, 2, 0));
+
+    SECTION("changing a parent updates the children") {
+        table.setRelative(a, translation(5, 0, 0));
+        CHECK(table.getAbsolute(b) == translation(5, 2, 0));
+        CHECK(table.getAbsolute(a) == translation(5, 0, 0));
+    }
+    SECTION("versions are incremented up to the root") {
+        table.incrementVersion(b);
+        CHECK(table.getVersion(b) == 1);
+        CHECK(table.getVersion(a) == 1);
+        CHECK(table.getVersion(root) == 1);
+        table.incrementVersion(a);
+        CHECK(table.getVersion(b) == 1);
+        CHECK(table.getVersion(root) == 2);
+    }
+    SECTION("setParent before the parent's position") {
+        const auto c = table.allocate(root, translation(0, 0, 3));
+        table.setParent(a, c);
+        CHECK(table.getAbsolute(a) == translation(1, 0, 3));
+        CHECK(table.getAbsolute(b) == translation(1, 2, 3));
+        table.setRelative(c, translation(0, 0, 4));
+        CHECK(table.getAbsolute(b) == translation(1, 2, 4));
+    }
+    SECTION("released ids are reused and the table is compacted") {
+        std::vector<TransformTable::id_t> ids;
+        for (int i = 0; i < 100; ++i) {
+            ids.push_back(table.allocate(a, translation(0, 0, static_cast<float>(i))));
+        }
+        for (int i = 0; i < 90; ++i) {
+            table.release(ids[i]);
+        }
+        CHECK(table.size() == 13);
+        CHECK(table.getAbsolute(ids[95]) == translation(1, 0, 95));
+        CHECK(table.getAbsolute(b) == translation(1, 2, 0));
+        const auto reused = table.allocate(b, translation(0, 0, 1));
+        CHECK(reused == ids[89]);
+        CHECK(table.getAbsolute(reused) == translation(1, 2, 1));
+    }
+    SECTION("children of a released entry become roots when the table is compacted") {
+        table.release(a);
+        for (int i = 0; i < 10; ++i) {
+            table.release(table.allocate(root, glm::mat4(1.f)));
+        }
+        table.update();
+        CHECK(table.getAbsolute(b) == translation(0, 2, 0));
+    }
+}
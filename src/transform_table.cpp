@@ -0,0 +1,188 @@
+#include "transform_table.h"
+#include <algorithm>
+#include <palanteer.h>
+
+namespace bricksim::etree {
+    TransformTable::id_t TransformTable::allocate(id_t parent, const glm::mat4& relative, version_t version) {
+        const auto position = static_cast<position_t>(parents.size());
+        //a new entry is always after its parent because the parent already exists
+        parents.push_back(parent != NO_ID ? positions[parent] : NO_POSITION);
+        relatives.push_back(relative);
+        absolutes.push_back(relative);
+        versions.push_back(version);
+        dirty.push_back(0);
+
+        id_t id;
+        if (freeIds.empty()) {
+            id = static_cast<id_t>(positions.size());
+            positions.push_back(position);
+        } else {
+            id = freeIds.back();
+            freeIds.pop_back();
+            positions[id] = position;
+        }
+        ids.push_back(id);
+        markDirty(position);
+        return id;
+    }
+
+    void TransformTable::release(id_t id) {
+        //the position stays in the arrays until the next reorder, so children which are still alive keep their parent for now
+        ids[positions[id]] = NO_ID;
+        positions[id] = NO_POSITION;
+        freeIds.push_back(id);
+        ++freePositionCount;
+        if (static_cast<float>(freePositionCount) > MAX_FREE_FRACTION * static_cast<float>(parents.size())) {
+            needsUpdate.store(true, std::memory_order_release);
+        }
+    }
+
+    void TransformTable::setParent(id_t id, id_t parent) {
+        const auto position = positions[id];
+        const auto parentPosition = parent != NO_ID ? positions[parent] : NO_POSITION;
+        parents[position] = parentPosition;
+        if (parentPosition != NO_POSITION && parentPosition > position) {
+            ordered = false;
+        }
+        markDirty(position);
+    }
+
+    void TransformTable::setRelative(id_t id, const glm::mat4& relative) {
+        const auto position = positions[id];
+        relatives[position] = relative;
+        markDirty(position);
+    }
+
+    glm::mat4 TransformTable::getAbsolute(id_t id) {
+        if (needsUpdate.load(std::memory_order_acquire)) {
+            update();
+        }
+        return absolutes[positions[id]];
+    }
+
+    TransformTable::version_t TransformTable::getVersion(id_t id) const {
+        return versions[positions[id]];
+    }
+
+    void TransformTable::incrementVersion(id_t id) {
+        for (auto position = positions[id]; position != NO_POSITION; position = parents[position]) {
+            ++versions[position];
+        }
+    }
+
+    void TransformTable::update() {
+        plFunction();
+        std::scoped_lock<std::mutex> lg(updateMtx);
+        if (!needsUpdate.load(std::memory_order_relaxed)) {
+            return;
+        }
+        if (!ordered || static_cast<float>(freePositionCount) > MAX_FREE_FRACTION * static_cast<float>(parents.size())) {
+            reorder();
+        }
+
+        const auto size = static_cast<position_t>(parents.size());
+        for (position_t position = firstDirty; position < size; ++position) {
+            const auto parent = parents[position];
+            if (parent == NO_POSITION) {
+                if (dirty[position]) {
+                    absolutes[position] = relatives[position];
+                }
+            } else if (dirty[position] || dirty[parent]) {
+                //the parent is always before the child, so its absolute transformation is already updated
+                dirty[position] = 1;
+                absolutes[position] = relatives[position] * absolutes[parent];
+            }
+        }
+        std::fill(dirty.begin() + firstDirty, dirty.end(), 0);
+        firstDirty = size;
+        needsUpdate.store(false, std::memory_order_release);
+    }
+
+    std::size_t TransformTable::size() const {
+        return parents.size() - freePositionCount;
+    }
+
+    void TransformTable::markDirty(position_t position) {
+        dirty[position] = 1;
+        firstDirty = std::min(firstDirty, position);
+        needsUpdate.store(true, std::memory_order_release);
+    }
+
+    void TransformTable::reorder() {
+        plFunction();
+        constexpr auto UNKNOWN_DEPTH = std::numeric_limits<uint32_t>::max();
+        const auto oldSize = static_cast<position_t>(parents.size());
+        std::vector<uint32_t> depths(oldSize, UNKNOWN_DEPTH);
+        std::vector<position_t> order;
+        order.reserve(oldSize - freePositionCount);
+        std::vector<position_t> chain;
+        for (position_t position = 0; position < oldSize; ++position) {
+            if (ids[position] == NO_ID) {
+                continue;
+            }
+            order.push_back(position);
+            chain.clear();
+            auto current = position;
+            uint32_t depth = 0;
+            while (depths[current] == UNKNOWN_DEPTH) {
+                chain.push_back(current);
+                if (parents[current] != NO_POSITION && ids[parents[current]] == NO_ID) {
+                    //the parent was released before this entry, so this entry becomes a root
+                    parents[current] = NO_POSITION;
+                    dirty[current] = 1;
+                }
+                if (parents[current] == NO_POSITION) {
+                    break;
+                }
+                current = parents[current];
+                if (depths[current] != UNKNOWN_DEPTH) {
+                    depth = depths[current] + 1;
+                }
+            }
+            for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+                depths[*it] = depth++;
+            }
+        }
+        //sorting by depth puts every parent before its children
+        std::stable_sort(order.begin(), order.end(), [&depths](position_t a, position_t b) { return depths[a] < depths[b]; });
+
+        std::vector<position_t> newPositions(oldSize, NO_POSITION);
+        for (position_t newPosition = 0; newPosition < order.size(); ++newPosition) {
+            newPositions[order[newPosition]] = newPosition;
+        }
+        std::vector<position_t> newParents;
+        std::vector<glm::mat4> newRelatives;
+        std::vector<glm::mat4> newAbsolutes;
+        std::vector<version_t> newVersions;
+        std::vector<uint8_t> newDirty;
+        std::vector<id_t> newIds;
+        newParents.reserve(order.size());
+        newRelatives.reserve(order.size());
+        newAbsolutes.reserve(order.size());
+        newVersions.reserve(order.size());
+        newDirty.reserve(order.size());
+        newIds.reserve(order.size());
+        firstDirty = static_cast<position_t>(order.size());
+        for (const auto oldPosition: order) {
+            const auto parent = parents[oldPosition];
+            newParents.push_back(parent != NO_POSITION ? newPositions[parent] : NO_POSITION);
+            newRelatives.push_back(relatives[oldPosition]);
+            newAbsolutes.push_back(absolutes[oldPosition]);
+            newVersions.push_back(versions[oldPosition]);
+            newDirty.push_back(dirty[oldPosition]);
+            newIds.push_back(ids[oldPosition]);
+            positions[ids[oldPosition]] = newPositions[oldPosition];
+            if (dirty[oldPosition]) {
+                firstDirty = std::min(firstDirty, newPositions[oldPosition]);
+            }
+        }
+        parents = std::move(newParents);
+        relatives = std::move(newRelatives);
+        absolutes = std::move(newAbsolutes);
+        versions = std::move(newVersions);
+        dirty = std::move(newDirty);
+        ids = std::move(newIds);
+        freePositionCount = 0;
+        ordered = true;
+    }
+}
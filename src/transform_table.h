@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace bricksim::etree {
+    /**
+     * the transformations and versions of all nodes of an element tree in flat arrays.
+     * every node has a stable id, the data is stored at a position which can change when the table is reordered.
+     * the positions are in topological order (the parent of an entry is always before the entry),
+     * so the absolute transformations of all changed subtrees are recalculated in one linear pass in update().
+     * the transformations are stored like in etree::Node: absolute = relative * parentAbsolute.
+     * changing the structure (allocate, release, setParent) must not happen concurrently with anything else,
+     * getAbsolute can be called from multiple threads
+     */
+    class TransformTable {
+    public:
+        using id_t = uint32_t;
+        using version_t = uint64_t;
+        static constexpr id_t NO_ID = std::numeric_limits<id_t>::max();
+
+        TransformTable() = default;
+        TransformTable(const TransformTable&) = delete;
+        TransformTable& operator=(const TransformTable&) = delete;
+
+        ///@param parent NO_ID for a root entry
+        id_t allocate(id_t parent, const glm::mat4& relative, version_t version = 0);
+        void release(id_t id);
+        void setParent(id_t id, id_t parent);
+        void setRelative(id_t id, const glm::mat4& relative);
+        ///updates the dirty entries first if there are any
+        [[nodiscard]] glm::mat4 getAbsolute(id_t id);
+
+        [[nodiscard]] version_t getVersion(id_t id) const;
+        ///increments the version of the entry and all its ancestors
+        void incrementVersion(id_t id);
+
+        /**
+         * recalculates the absolute transformations of all entries whose relative transformation or one of whose ancestors' changed.
+         * call this before reading many transformations from multiple threads
+         */
+        void update();
+
+        [[nodiscard]] std::size_t size() const;
+
+    private:
+        using position_t = uint32_t;
+        static constexpr position_t NO_POSITION = std::numeric_limits<position_t>::max();
+        ///the table is compacted when more than this fraction of the positions is free
+        static constexpr float MAX_FREE_FRACTION = .5f;
+
+        //indexed by position
+        std::vector<position_t> parents;
+        std::vector<glm::mat4> relatives;
+        std::vector<glm::mat4> absolutes;
+        std::vector<version_t> versions;
+        std::vector<uint8_t> dirty;
+        ///NO_ID for free positions
+        std::vector<id_t> ids;
+
+        ///indexed by id, NO_POSITION for free ids
+        std::vector<position_t> positions;
+        std::vector<id_t> freeIds;
+        std::size_t freePositionCount = 0;
+
+        ///first position which has to be recalculated, size() if there is none
+        position_t firstDirty = 0;
+        ///false if setParent moved an entry before its parent
+        bool ordered = true;
+        std::atomic<bool> needsUpdate = false;
+        std::mutex updateMtx;
+
+        void markDirty(position_t position);
+        ///sorts the positions topologically and removes the free ones
+        void reorder();
+    };
+}
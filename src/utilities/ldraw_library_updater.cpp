@@ -200,7 +200,7 @@ namespace bricksim::ldraw_library_updater {
             const auto fraction = .5f * progress + .5f;
             std::fill(incrementalUpdateProgress.begin(), incrementalUpdateProgress.end(), fraction);
         };
-        ldr::file_repo::get().updateLibraryFiles(sourceDir, progressFunc, extractedFiles.size());
+        invalidatedFiles = ldr::file_repo::get().updateLibraryFiles(sourceDir, progressFunc, extractedFiles.size());
 
         std::filesystem::remove_all(tmpDirectory);
         step = Step::FINISHED;
@@ -266,7 +266,7 @@ namespace bricksim::ldraw_library_updater {
             }
         }
 
-        ldr::file_repo::get().replaceLibraryFiles(fileOrDirectoryForReplacement, [this](float progress){completeUpdateProgress = .5+.5*progress;}, numEntries);
+        invalidatedFiles = ldr::file_repo::get().replaceLibraryFiles(fileOrDirectoryForReplacement, [this](float progress){completeUpdateProgress = .5+.5*progress;}, numEntries);
 
         std::filesystem::remove_all(tmpDirectory);
         step = Step::FINISHED;
@@ -3,6 +3,7 @@
 #include "../errors/exceptions.h"
 #include "../helpers/stringutil.h"
 #include "../ldr/config.h"
+#include "../ldr/files.h"
 #include "pugixml.hpp"
 #include <chrono>
 
@@ -43,6 +44,9 @@ namespace bricksim::ldraw_library_updater {
         std::optional<Distribution> completeDistribution;
         std::optional<float> completeUpdateProgress;
 
+        ///the library files which were in memory and changed with the update. their meshes are deleted on the main thread when the update is finished
+        std::vector<std::shared_ptr<ldr::File>> invalidatedFiles;
+
         std::size_t getIncrementalUpdateTotalSize() const;
 
         void initialize();